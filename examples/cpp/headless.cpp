@@ -0,0 +1,45 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include <utility>
+#include <vector>
+
+#include "absl/time/clock.h"
+#include "gamma/common/log.hpp"
+#include "gamma/engine/engine.hpp"
+#include "gamma/engine/engine_settings.pb.h"
+#include "gamma/engine/init.hpp"
+
+int main() {
+  y::EngineSettings engine_settings;
+  engine_settings.set_headless(true);
+  engine_settings.set_fixed_timestep_us(16667);
+  engine_settings.set_max_frames(600);
+
+  y::Initialize(engine_settings);
+
+  std::vector<y::Engine::StartupTask> startup_tasks(1);
+  startup_tasks[0].name = "warm up";
+  startup_tasks[0].run = []() { absl::SleepFor(absl::Milliseconds(5)); };
+
+  y::Engine engine(engine_settings, std::move(startup_tasks));
+  engine.setTimeout([]() { YLOG << "ten simulated seconds elapsed"; },
+                    absl::Seconds(10) - absl::Microseconds(1));
+  engine.runMainLoop();
+  return 0;
+}
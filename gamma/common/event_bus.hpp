@@ -0,0 +1,277 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_COMMON_EVENT_BUS_HPP_
+#define GAMMA_COMMON_EVENT_BUS_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "gamma/common/function.hpp"
+#include "gamma/common/log.hpp"
+
+namespace y {
+
+// A typed publish/subscribe channel for decoupled communication between
+// subsystems.
+//
+// Any thread may `post()` events of any type without taking locks. Events are
+// held in a separate queue per type until `dispatch()`, which hands every
+// subscriber of a type all of its pending events at once as one contiguous
+// span, in posting order for events posted from the same thread.
+//
+// `subscribe()` and `dispatch()` must be called from a single thread, usually
+// once per frame from the main loop. A subscriber may `post()` events; they are
+// delivered on the following `dispatch()`. It may also `subscribe()`, and the
+// new subscriber sees events from the following `dispatch()` on.
+class EventBus {
+ public:
+  static constexpr int kMaxEventTypes = 128;
+
+  EventBus() = default;
+  EventBus(const EventBus&) = delete;
+  EventBus& operator=(const EventBus&) = delete;
+  ~EventBus();
+
+  template <typename T>
+  void post(T event);
+
+  template <typename T>
+  void subscribe(Function<void(absl::Span<const T>)> f);
+
+  void dispatch();
+
+ private:
+  class QueueBase {
+   public:
+    virtual ~QueueBase() = default;
+    virtual void dispatch() = 0;
+  };
+
+  template <typename T>
+  class Queue;
+
+  template <typename T>
+  Queue<T>* queue();
+
+  std::atomic<QueueBase*> queues_[kMaxEventTypes] = {};
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+}  // namespace y
+
+namespace y_internal {
+
+int NextEventTypeId();
+
+template <typename T>
+int EventTypeId() {
+  static const int id = NextEventTypeId();
+  return id;
+}
+
+}  // namespace y_internal
+
+namespace y {
+
+// Multi-producer, single-consumer queue made of fixed size blocks. Producers
+// claim a slot in the head block with a single atomic increment and push a new
+// head block when it is full. The consumer swaps in an empty head, closes the
+// blocks it took, waits for in-flight writes to land and recycles the blocks.
+// Blocks are only freed on destruction, so a producer holding a stale head
+// pointer never touches freed memory.
+template <typename T>
+class EventBus::Queue : public QueueBase {
+ public:
+  Queue();
+  ~Queue() override;
+
+  void post(T&& event);
+  void subscribe(Function<void(absl::Span<const T>)> f);
+  void dispatch() override;
+
+ private:
+  static constexpr size_t kBlockSize =
+      4096 / sizeof(T) > 16 ? 4096 / sizeof(T) : 16;
+
+  struct Block {
+    T* at(size_t i) { return reinterpret_cast<T*>(storage) + i; }
+
+    std::atomic<size_t> reserved{0};
+    std::atomic<size_t> committed{0};
+    Block* next = nullptr;
+    alignas(T) unsigned char storage[kBlockSize * sizeof(T)];
+  };
+
+  // Closes `block` to producers and returns the number of events written to it
+  // once they are all visible.
+  static size_t close(Block* block);
+
+  std::atomic<Block*> head_;
+  std::vector<Block*> free_blocks_;
+  std::vector<Block*> chain_;
+  std::vector<T> batch_;
+  // A deque, so that subscribing from a subscriber does not move the one
+  // that is running.
+  std::deque<Function<void(absl::Span<const T>)>> subscribers_;
+};
+
+template <typename T>
+EventBus::Queue<T>::Queue() : head_(new Block) {}
+
+template <typename T>
+EventBus::Queue<T>::~Queue() {
+  Block* block = head_.load(std::memory_order_acquire);
+  while (block != nullptr) {
+    size_t count = close(block);
+    for (size_t i = 0; i < count; ++i) block->at(i)->~T();
+    Block* next = block->next;
+    delete block;
+    block = next;
+  }
+  for (Block* free_block : free_blocks_) delete free_block;
+}
+
+template <typename T>
+void EventBus::Queue<T>::post(T&& event) {
+  Block* block = head_.load(std::memory_order_acquire);
+  while (true) {
+    size_t index = block->reserved.fetch_add(1, std::memory_order_acq_rel);
+    if (index < kBlockSize) {
+      ::new (block->at(index)) T(std::move(event));
+      block->committed.fetch_add(1, std::memory_order_release);
+      return;
+    }
+    // The block is full or closed; push a new head unless someone else already
+    // replaced it, in which case retry with the current head.
+    Block* expected = block;
+    Block* fresh = new Block;
+    fresh->next = block;
+    if (head_.compare_exchange_strong(expected, fresh,
+                                      std::memory_order_acq_rel)) {
+      block = fresh;
+    } else {
+      delete fresh;
+      block = expected;
+    }
+  }
+}
+
+template <typename T>
+void EventBus::Queue<T>::subscribe(Function<void(absl::Span<const T>)> f) {
+  subscribers_.push_back(std::move(f));
+}
+
+template <typename T>
+size_t EventBus::Queue<T>::close(Block* block) {
+  size_t reserved =
+      block->reserved.fetch_add(kBlockSize, std::memory_order_acq_rel);
+  size_t count = reserved < kBlockSize ? reserved : kBlockSize;
+  while (block->committed.load(std::memory_order_acquire) != count) {
+    std::this_thread::yield();
+  }
+  return count;
+}
+
+template <typename T>
+void EventBus::Queue<T>::dispatch() {
+  Block* fresh;
+  if (free_blocks_.empty()) {
+    fresh = new Block;
+  } else {
+    fresh = free_blocks_.back();
+    free_blocks_.pop_back();
+    fresh->next = nullptr;
+    fresh->committed.store(0, std::memory_order_relaxed);
+    fresh->reserved.store(0, std::memory_order_release);
+  }
+
+  chain_.clear();
+  for (Block* block = head_.exchange(fresh, std::memory_order_acq_rel);
+       block != nullptr; block = block->next) {
+    chain_.push_back(block);
+  }
+
+  // The chain runs from newest to oldest block.
+  batch_.clear();
+  for (auto it = chain_.rbegin(); it != chain_.rend(); ++it) {
+    Block* block = *it;
+    size_t count = close(block);
+    for (size_t i = 0; i < count; ++i) {
+      batch_.push_back(std::move(*block->at(i)));
+      block->at(i)->~T();
+    }
+    free_blocks_.push_back(block);
+  }
+
+  if (batch_.empty()) return;
+  // By index, since a subscriber may subscribe. Subscribers added during the
+  // loop start with the next dispatch.
+  size_t num_subscribers = subscribers_.size();
+  for (size_t i = 0; i < num_subscribers; ++i) {
+    subscribers_[i](absl::Span<const T>(batch_));
+  }
+}
+
+inline EventBus::~EventBus() {
+  for (auto& queue : queues_) delete queue.load(std::memory_order_acquire);
+}
+
+template <typename T>
+EventBus::Queue<T>* EventBus::queue() {
+  int id = y_internal::EventTypeId<T>();
+  YERR_IF(id >= kMaxEventTypes) << "too many event types";
+
+  QueueBase* queue = queues_[id].load(std::memory_order_acquire);
+  if (queue == nullptr) {
+    QueueBase* created = new Queue<T>();
+    if (queues_[id].compare_exchange_strong(queue, created,
+                                            std::memory_order_acq_rel)) {
+      queue = created;
+    } else {
+      delete created;
+    }
+  }
+  return static_cast<Queue<T>*>(queue);
+}
+
+template <typename T>
+void EventBus::post(T event) {
+  queue<T>()->post(std::move(event));
+}
+
+template <typename T>
+void EventBus::subscribe(Function<void(absl::Span<const T>)> f) {
+  queue<T>()->subscribe(std::move(f));
+}
+
+inline void EventBus::dispatch() {
+  for (auto& queue : queues_) {
+    QueueBase* q = queue.load(std::memory_order_acquire);
+    if (q != nullptr) q->dispatch();
+  }
+}
+
+}  // namespace y
+#endif  // GAMMA_COMMON_EVENT_BUS_HPP_
@@ -0,0 +1,186 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/common/event_bus.hpp"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+struct Collision {
+  int a;
+  int b;
+};
+
+TEST(EventBusTest, DeliversBatchOnDispatch) {
+  EventBus bus;
+  std::vector<int> received;
+  int calls = 0;
+  bus.subscribe<int>([&received, &calls](absl::Span<const int> events) {
+    received.insert(received.end(), events.begin(), events.end());
+    ++calls;
+  });
+
+  bus.post(1);
+  bus.post(2);
+  bus.post(3);
+  EXPECT_TRUE(received.empty());
+
+  bus.dispatch();
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), received);
+  EXPECT_EQ(1, calls);
+
+  bus.dispatch();
+  EXPECT_EQ(1, calls);
+}
+
+TEST(EventBusTest, SeparatesTypes) {
+  EventBus bus;
+  int ints = 0;
+  int collisions = 0;
+  bus.subscribe<int>(
+      [&ints](absl::Span<const int> events) { ints += events.size(); });
+  bus.subscribe<Collision>([&collisions](absl::Span<const Collision> events) {
+    collisions += events.size();
+  });
+
+  bus.post(Collision{1, 2});
+  bus.post(5);
+  bus.post(Collision{3, 4});
+  bus.dispatch();
+
+  EXPECT_EQ(1, ints);
+  EXPECT_EQ(2, collisions);
+}
+
+TEST(EventBusTest, MultipleSubscribersSeeSameBatch) {
+  EventBus bus;
+  const int* first = nullptr;
+  const int* second = nullptr;
+  bus.subscribe<int>(
+      [&first](absl::Span<const int> events) { first = events.data(); });
+  bus.subscribe<int>(
+      [&second](absl::Span<const int> events) { second = events.data(); });
+  bus.post(1);
+  bus.dispatch();
+  EXPECT_NE(nullptr, first);
+  EXPECT_EQ(first, second);
+}
+
+TEST(EventBusTest, ManyEventsKeepOrder) {
+  EventBus bus;
+  std::vector<int> received;
+  bus.subscribe<int>([&received](absl::Span<const int> events) {
+    received.insert(received.end(), events.begin(), events.end());
+  });
+
+  for (int frame = 0; frame < 3; ++frame) {
+    received.clear();
+    for (int i = 0; i < 10000; ++i) bus.post(i);
+    bus.dispatch();
+    ASSERT_EQ(10000, received.size());
+    for (int i = 0; i < 10000; ++i) ASSERT_EQ(i, received[i]);
+  }
+}
+
+TEST(EventBusTest, PostFromSubscriberDeliveredNextDispatch) {
+  EventBus bus;
+  int strings = 0;
+  bus.subscribe<int>([&bus](absl::Span<const int> events) {
+    for (int i : events) bus.post(std::to_string(i));
+  });
+  bus.subscribe<std::string>(
+      [&strings](absl::Span<const std::string> events) {
+        strings += events.size();
+      });
+
+  bus.post(1);
+  bus.post(2);
+  bus.dispatch();
+  bus.dispatch();
+  EXPECT_EQ(2, strings);
+}
+
+TEST(EventBusTest, SubscribeFromSubscriberStartsNextDispatch) {
+  EventBus bus;
+  int calls = 0;
+  // Subscribes several times per dispatch, so the subscriber vector
+  // reallocates while it is being walked.
+  bus.subscribe<int>([&bus, &calls](absl::Span<const int> events) {
+    ++calls;
+    for (int i = 0; i < 8; ++i) {
+      bus.subscribe<int>([&calls](absl::Span<const int>) { ++calls; });
+    }
+  });
+
+  bus.post(1);
+  bus.dispatch();
+  EXPECT_EQ(1, calls);
+
+  bus.post(2);
+  bus.dispatch();
+  EXPECT_EQ(1 + 9, calls);
+}
+
+TEST(EventBusTest, UndispatchedEventsAreDestroyed) {
+  auto shared = std::make_shared<int>(0);
+  {
+    EventBus bus;
+    for (int i = 0; i < 100; ++i) bus.post(shared);
+    EXPECT_EQ(101, shared.use_count());
+  }
+  EXPECT_EQ(1, shared.use_count());
+}
+
+TEST(EventBusTest, ConcurrentPosting) {
+  constexpr int kThreads = 4;
+  constexpr int kEventsPerThread = 20000;
+
+  EventBus bus;
+  std::vector<Collision> received;
+  bus.subscribe<Collision>([&received](absl::Span<const Collision> events) {
+    received.insert(received.end(), events.begin(), events.end());
+  });
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&bus, t]() {
+      for (int i = 0; i < kEventsPerThread; ++i) bus.post(Collision{t, i});
+    });
+  }
+  // Dispatch concurrently with posting.
+  while (received.size() < kThreads * kEventsPerThread) bus.dispatch();
+  for (std::thread& thread : threads) thread.join();
+  bus.dispatch();
+
+  ASSERT_EQ(kThreads * kEventsPerThread, received.size());
+  std::vector<int> next(kThreads, 0);
+  for (const Collision& c : received) {
+    ASSERT_EQ(next[c.a], c.b);
+    ++next[c.a];
+  }
+}
+
+}  // namespace
+}  // namespace y
@@ -0,0 +1,143 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/common/file_watcher.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+
+#include "absl/memory/memory.h"
+#include "absl/time/clock.h"
+#include "gamma/common/log.hpp"
+
+namespace y {
+namespace {
+
+constexpr uint32_t kDirectoryEvents =
+    IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+void SplitPath(const std::string& path, std::string* directory,
+               std::string* name) {
+  size_t slash = path.find_last_of('/');
+  if (slash == std::string::npos) {
+    *directory = ".";
+    *name = path;
+  } else {
+    *directory = slash == 0 ? "/" : path.substr(0, slash);
+    *name = path.substr(slash + 1);
+  }
+}
+
+}  // namespace
+
+FileWatcher::FileWatcher(absl::Duration debounce)
+    : debounce_(debounce),
+      inotify_fd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)),
+      wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      stop_(false) {
+  YERR_IF(inotify_fd_ < 0) << "failed to initialize inotify";
+  YERR_IF(wake_fd_ < 0) << "failed to create eventfd";
+  thread_ = std::thread([this]() { run(); });
+}
+
+FileWatcher::~FileWatcher() {
+  stop_.store(true, std::memory_order_relaxed);
+  uint64_t one = 1;
+  YERR_IF(write(wake_fd_, &one, sizeof(one)) != sizeof(one));
+  thread_.join();
+  close(wake_fd_);
+  close(inotify_fd_);
+}
+
+void FileWatcher::watch(const std::string& path, Function<void()> on_change) {
+  std::string directory, name;
+  SplitPath(path, &directory, &name);
+  int wd = inotify_add_watch(inotify_fd_, directory.c_str(), kDirectoryEvents);
+  YERR_IF(wd < 0) << "failed to watch directory '" << directory << "'";
+
+  absl::MutexLock lock(&mutex_);
+  files_.push_back(absl::make_unique<WatchedFile>(
+      WatchedFile{wd, std::move(name), std::move(on_change),
+                  absl::InfiniteFuture()}));
+}
+
+void FileWatcher::run() {
+  pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+  while (!stop_.load(std::memory_order_relaxed)) {
+    int ready = poll(fds, 2, pollTimeoutMillis());
+    if (ready > 0 && (fds[0].revents & POLLIN)) readEvents();
+    runDueCallbacks();
+  }
+}
+
+void FileWatcher::readEvents() {
+  alignas(inotify_event) char buffer[4096];
+  absl::Time deadline = absl::Now() + debounce_;
+  ssize_t length;
+  while ((length = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+    absl::MutexLock lock(&mutex_);
+    for (char* p = buffer; p < buffer + length;) {
+      const auto* event = reinterpret_cast<const inotify_event*>(p);
+      p += sizeof(inotify_event) + event->len;
+      if (event->len == 0) continue;
+      for (const auto& file : files_) {
+        if (file->directory == event->wd && file->name == event->name) {
+          file->deadline = deadline;
+        }
+      }
+    }
+  }
+}
+
+void FileWatcher::runDueCallbacks() {
+  absl::Time now = absl::Now();
+  std::vector<Function<void()>*> due;
+  {
+    absl::MutexLock lock(&mutex_);
+    for (const auto& file : files_) {
+      if (file->deadline <= now) {
+        file->deadline = absl::InfiniteFuture();
+        due.push_back(&file->on_change);
+      }
+    }
+  }
+  for (Function<void()>* on_change : due) (*on_change)();
+}
+
+// Wait for the earliest pending debounce deadline, or indefinitely if there is
+// none.
+int FileWatcher::pollTimeoutMillis() {
+  absl::Time earliest = absl::InfiniteFuture();
+  {
+    absl::MutexLock lock(&mutex_);
+    for (const auto& file : files_) {
+      earliest = std::min(earliest, file->deadline);
+    }
+  }
+  if (earliest == absl::InfiniteFuture()) return -1;
+  return static_cast<int>(std::max<int64_t>(
+      0, absl::ToInt64Milliseconds(absl::Ceil(earliest - absl::Now(),
+                                              absl::Milliseconds(1)))));
+}
+
+}  // namespace y
@@ -0,0 +1,81 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_COMMON_FILE_WATCHER_HPP_
+#define GAMMA_COMMON_FILE_WATCHER_HPP_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "gamma/common/function.hpp"
+
+namespace y {
+
+// Watches files for changes on a background thread, using inotify.
+//
+// Changes are debounced: a callback runs once its file has gone `debounce`
+// without further modification, so editors that save in several steps trigger
+// a single notification. Files are tracked by name within their directory, so
+// saves that replace the file through a rename are also detected.
+//
+// Callbacks run on the watcher thread, outside of the watcher's lock, so they
+// may call `watch()`.
+class FileWatcher {
+ public:
+  explicit FileWatcher(absl::Duration debounce = absl::Milliseconds(50));
+  FileWatcher(const FileWatcher&) = delete;
+  FileWatcher& operator=(const FileWatcher&) = delete;
+  ~FileWatcher();
+
+  // Call `on_change` whenever the file at `path` is modified, created or
+  // replaced. The file's directory must exist. Thread-safe.
+  void watch(const std::string& path, Function<void()> on_change);
+
+ private:
+  struct WatchedFile {
+    int directory;
+    std::string name;
+    Function<void()> on_change;
+    absl::Time deadline;
+  };
+
+  void run();
+  void readEvents();
+  void runDueCallbacks();
+  int pollTimeoutMillis();
+
+  const absl::Duration debounce_;
+  const int inotify_fd_;
+  const int wake_fd_;
+  std::atomic<bool> stop_;
+
+  absl::Mutex mutex_;
+  // Never removed, so that callbacks can run without holding `mutex_`.
+  std::vector<std::unique_ptr<WatchedFile>> files_;
+
+  std::thread thread_;
+};
+
+}  // namespace y
+#endif  // GAMMA_COMMON_FILE_WATCHER_HPP_
@@ -0,0 +1,122 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/common/file_watcher.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+std::string TempPath(const std::string& name) {
+  const char* dir = std::getenv("TEST_TMPDIR");
+  return std::string(dir != nullptr ? dir : "/tmp") + "/" + name;
+}
+
+void WriteFile(const std::string& path, const std::string& contents) {
+  FILE* file = fopen(path.c_str(), "w");
+  ASSERT_NE(nullptr, file);
+  fputs(contents.c_str(), file);
+  fclose(file);
+}
+
+TEST(FileWatcherTest, DetectsModification) {
+  std::string path = TempPath("file_watcher_modify.txt");
+  WriteFile(path, "a");
+
+  FileWatcher watcher(absl::Milliseconds(10));
+  absl::Notification changed;
+  watcher.watch(path, [&changed]() { changed.Notify(); });
+
+  WriteFile(path, "b");
+  EXPECT_TRUE(changed.WaitForNotificationWithTimeout(absl::Seconds(5)));
+}
+
+TEST(FileWatcherTest, DetectsReplacementByRename) {
+  std::string path = TempPath("file_watcher_rename.txt");
+  std::string temp = TempPath("file_watcher_rename.txt.tmp");
+  WriteFile(path, "a");
+
+  FileWatcher watcher(absl::Milliseconds(10));
+  absl::Notification changed;
+  watcher.watch(path, [&changed]() { changed.Notify(); });
+
+  WriteFile(temp, "b");
+  ASSERT_EQ(0, rename(temp.c_str(), path.c_str()));
+  EXPECT_TRUE(changed.WaitForNotificationWithTimeout(absl::Seconds(5)));
+}
+
+TEST(FileWatcherTest, DebouncesBursts) {
+  std::string path = TempPath("file_watcher_burst.txt");
+  WriteFile(path, "");
+
+  std::atomic<int> calls(0);
+  {
+    FileWatcher watcher(absl::Milliseconds(200));
+    watcher.watch(path, [&calls]() { ++calls; });
+    for (int i = 0; i < 10; ++i) WriteFile(path, std::to_string(i));
+    absl::SleepFor(absl::Seconds(1));
+  }
+  EXPECT_EQ(1, calls.load());
+}
+
+TEST(FileWatcherTest, CallbacksMayWatch) {
+  std::string first = TempPath("file_watcher_first.txt");
+  std::string second = TempPath("file_watcher_second.txt");
+  WriteFile(first, "a");
+  WriteFile(second, "a");
+
+  // Notified when each file has changed.
+  absl::Notification changed[2];
+  FileWatcher watcher(absl::Milliseconds(10));
+  watcher.watch(first, [&watcher, &changed]() {
+    if (changed[0].HasBeenNotified()) return;
+    watcher.watch(TempPath("file_watcher_second.txt"),
+                  [&changed]() { changed[1].Notify(); });
+    changed[0].Notify();
+  });
+
+  WriteFile(first, "b");
+  ASSERT_TRUE(changed[0].WaitForNotificationWithTimeout(absl::Seconds(5)));
+  WriteFile(second, "b");
+  EXPECT_TRUE(changed[1].WaitForNotificationWithTimeout(absl::Seconds(5)));
+}
+
+TEST(FileWatcherTest, IgnoresOtherFiles) {
+  std::string path = TempPath("file_watcher_watched.txt");
+  std::string other = TempPath("file_watcher_other.txt");
+  WriteFile(path, "");
+
+  std::atomic<int> calls(0);
+  {
+    FileWatcher watcher(absl::Milliseconds(10));
+    watcher.watch(path, [&calls]() { ++calls; });
+    WriteFile(other, "x");
+    absl::SleepFor(absl::Milliseconds(200));
+  }
+  EXPECT_EQ(0, calls.load());
+}
+
+}  // namespace
+}  // namespace y
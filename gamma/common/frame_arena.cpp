@@ -0,0 +1,80 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/common/frame_arena.hpp"
+
+#include <algorithm>
+
+#include "absl/memory/memory.h"
+#include "gamma/common/log.hpp"
+
+namespace y {
+
+LinearArena::LinearArena(size_t capacity) {
+  if (capacity > 0) grow(capacity);
+}
+
+void LinearArena::grow(size_t min_size) {
+  block_size_ = std::max({min_size, 2 * block_size_, size_t(4096)});
+  blocks_.emplace_back(new char[block_size_]);
+  capacity_ += block_size_;
+  cursor_ = blocks_.back().get();
+  end_ = cursor_ + block_size_;
+}
+
+void LinearArena::reset() {
+  high_water_mark_ = highWaterMark();
+  used_ = 0;
+  if (blocks_.size() > 1) {
+    // Last cycle overflowed, consolidate into a single block that fits it.
+    // Alignment padding depends on placement, so leave some slack.
+    blocks_.clear();
+    capacity_ = 0;
+    block_size_ = 0;
+    grow(high_water_mark_ + high_water_mark_ / 8);
+  }
+  if (!blocks_.empty()) cursor_ = blocks_.front().get();
+}
+
+size_t FrameArena::ArenaSet::used() const {
+  size_t total = main->used();
+  for (const auto& worker : workers) total += worker->used();
+  return total;
+}
+
+FrameArena::FrameArena(size_t bytes_per_arena, int num_workers) {
+  YERR_IF(num_workers < 0);
+  for (ArenaSet& set : sets_) {
+    set.main = absl::make_unique<LinearArena>(bytes_per_arena);
+    for (int i = 0; i < num_workers; ++i) {
+      set.workers.push_back(absl::make_unique<LinearArena>(bytes_per_arena));
+    }
+  }
+}
+
+void FrameArena::beginFrame() {
+  last_frame_bytes_ = sets_[current_].used();
+  high_water_mark_ = std::max(high_water_mark_, last_frame_bytes_);
+
+  current_ ^= 1;
+  ArenaSet& set = sets_[current_];
+  set.main->reset();
+  for (auto& worker : set.workers) worker->reset();
+}
+
+}  // namespace y
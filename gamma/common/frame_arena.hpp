@@ -0,0 +1,210 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_COMMON_FRAME_ARENA_HPP_
+#define GAMMA_COMMON_FRAME_ARENA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "gamma/common/job_pool.hpp"
+#include "gamma/common/log.hpp"
+
+namespace y {
+
+// Bump-pointer allocator for short-lived data. Individual allocations are
+// never freed; `reset()` releases all of them at once.
+//
+// If a cycle between resets needs more than the current capacity, additional
+// blocks are chained on and the next `reset()` replaces everything with a
+// single block large enough for the high-water mark, so a steady workload
+// settles into one block and O(1) resets.
+//
+// Not thread-safe. Destructors of objects placed in the arena are not run.
+class LinearArena {
+ public:
+  explicit LinearArena(size_t capacity);
+  LinearArena(const LinearArena&) = delete;
+  LinearArena& operator=(const LinearArena&) = delete;
+
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  // Uninitialized storage for `n` objects of type `T`.
+  template <typename T>
+  absl::Span<T> allocateArray(size_t n);
+
+  void reset();
+
+  // Bytes allocated since the last reset, including alignment padding.
+  size_t used() const;
+  // Largest `used()` seen at any point.
+  size_t highWaterMark() const;
+  size_t capacity() const;
+
+ private:
+  void grow(size_t min_size);
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  size_t block_size_ = 0;
+  size_t capacity_ = 0;
+  char* cursor_ = nullptr;
+  char* end_ = nullptr;
+  size_t used_ = 0;
+  size_t high_water_mark_ = 0;
+};
+
+// Standard library allocator that places elements in a `LinearArena`.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  explicit ArenaAllocator(LinearArena* arena) : arena_(arena) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T*, size_t) {}
+
+  LinearArena* arena() const { return arena_; }
+
+ private:
+  LinearArena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return !(a == b);
+}
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Scratch memory for data that lives for one or two frames.
+//
+// Holds two sets of arenas and alternates between them on `beginFrame()`, so
+// memory allocated during frame N stays valid until the start of frame N + 2.
+// This lets a renderer that trails simulation by one frame read data that
+// simulation allocated for it. Each set has an arena for the thread that runs
+// the main loop and one per job worker, so workers can allocate without
+// synchronization.
+class FrameArena {
+ public:
+  FrameArena(size_t bytes_per_arena, int num_workers);
+
+  // Reset the arenas used two frames ago and make them current.
+  void beginFrame();
+
+  // Arena for the main loop thread.
+  LinearArena& main();
+  // Arena for job worker `index`, which must only be used by that worker.
+  LinearArena& worker(int index);
+  // Arena for the calling thread, which is how jobs should get theirs: the
+  // worker's own when called from a worker of the `JobPool` the arenas were
+  // made for, and `main()` otherwise, since `JobPool::wait()` and
+  // `parallelFor()` also run jobs on the main loop thread. Must not be called
+  // from other threads.
+  LinearArena& local();
+  int numWorkers() const;
+
+  // Total bytes allocated during the previous frame, across all its arenas.
+  size_t lastFrameBytes() const;
+  // Largest `lastFrameBytes()` seen so far.
+  size_t highWaterMark() const;
+
+ private:
+  struct ArenaSet {
+    size_t used() const;
+
+    std::unique_ptr<LinearArena> main;
+    std::vector<std::unique_ptr<LinearArena>> workers;
+  };
+
+  ArenaSet sets_[2];
+  int current_ = 0;
+  size_t last_frame_bytes_ = 0;
+  size_t high_water_mark_ = 0;
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline void* LinearArena::allocate(size_t size, size_t alignment) {
+  uintptr_t cursor = reinterpret_cast<uintptr_t>(cursor_);
+  uintptr_t aligned = (cursor + alignment - 1) & ~(uintptr_t(alignment) - 1);
+  if (aligned + size > reinterpret_cast<uintptr_t>(end_)) {
+    grow(size + alignment);
+    cursor = reinterpret_cast<uintptr_t>(cursor_);
+    aligned = (cursor + alignment - 1) & ~(uintptr_t(alignment) - 1);
+  }
+  cursor_ = reinterpret_cast<char*>(aligned + size);
+  used_ += aligned + size - cursor;
+  return reinterpret_cast<void*>(aligned);
+}
+
+template <typename T>
+absl::Span<T> LinearArena::allocateArray(size_t n) {
+  static_assert(std::is_trivially_destructible<T>::value,
+                "arena objects are never destroyed");
+  return absl::Span<T>(static_cast<T*>(allocate(n * sizeof(T), alignof(T))),
+                       n);
+}
+
+inline size_t LinearArena::used() const { return used_; }
+
+inline size_t LinearArena::highWaterMark() const {
+  return high_water_mark_ > used_ ? high_water_mark_ : used_;
+}
+
+inline size_t LinearArena::capacity() const { return capacity_; }
+
+inline LinearArena& FrameArena::main() { return *sets_[current_].main; }
+
+inline LinearArena& FrameArena::worker(int index) {
+  YERR_IF(index < 0 || index >= numWorkers())
+      << "no arena for worker " << index;
+  return *sets_[current_].workers[index];
+}
+
+inline LinearArena& FrameArena::local() {
+  int index = JobPool::CurrentWorkerIndex();
+  return index < 0 ? main() : worker(index);
+}
+
+inline int FrameArena::numWorkers() const {
+  return static_cast<int>(sets_[0].workers.size());
+}
+
+inline size_t FrameArena::lastFrameBytes() const { return last_frame_bytes_; }
+
+inline size_t FrameArena::highWaterMark() const { return high_water_mark_; }
+
+}  // namespace y
+#endif  // GAMMA_COMMON_FRAME_ARENA_HPP_
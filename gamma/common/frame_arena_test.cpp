@@ -0,0 +1,159 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/common/frame_arena.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "gamma/common/job_pool.hpp"
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+bool IsAligned(const void* p, size_t alignment) {
+  return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+TEST(LinearArenaTest, AllocationsAreAlignedAndDistinct) {
+  LinearArena arena(1024);
+  void* a = arena.allocate(3, 1);
+  void* b = arena.allocate(8, 8);
+  void* c = arena.allocate(16, 64);
+  EXPECT_TRUE(IsAligned(b, 8));
+  EXPECT_TRUE(IsAligned(c, 64));
+  EXPECT_LT(a, b);
+  EXPECT_LT(b, c);
+  EXPECT_GE(arena.used(), 3 + 8 + 16);
+}
+
+TEST(LinearArenaTest, ResetReusesMemory) {
+  LinearArena arena(1024);
+  void* first = arena.allocate(100);
+  arena.reset();
+  EXPECT_EQ(0, arena.used());
+  EXPECT_EQ(first, arena.allocate(100));
+}
+
+TEST(LinearArenaTest, GrowsAndConsolidates) {
+  LinearArena arena(4096);
+  for (int i = 0; i < 100; ++i) arena.allocate(1000);
+  EXPECT_GE(arena.used(), 100000);
+  EXPECT_GE(arena.capacity(), 100000);
+
+  arena.reset();
+  EXPECT_GE(arena.highWaterMark(), 100000);
+  size_t capacity = arena.capacity();
+  EXPECT_GE(capacity, arena.highWaterMark());
+
+  // The same workload now fits without growing.
+  for (int i = 0; i < 100; ++i) arena.allocate(1000);
+  EXPECT_EQ(capacity, arena.capacity());
+}
+
+TEST(LinearArenaTest, AllocateArray) {
+  LinearArena arena(64);
+  absl::Span<double> values = arena.allocateArray<double>(1000);
+  EXPECT_EQ(1000, values.size());
+  EXPECT_TRUE(IsAligned(values.data(), alignof(double)));
+  for (size_t i = 0; i < values.size(); ++i) values[i] = i;
+  EXPECT_EQ(999, values.back());
+}
+
+TEST(ArenaAllocatorTest, Vector) {
+  LinearArena arena(256);
+  ArenaVector<int> values{ArenaAllocator<int>(&arena)};
+  for (int i = 0; i < 1000; ++i) values.push_back(i);
+  EXPECT_EQ(999, values.back());
+  EXPECT_GE(arena.used(), 1000 * sizeof(int));
+}
+
+TEST(ArenaAllocatorTest, String) {
+  using ArenaString =
+      std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+  LinearArena arena(256);
+  ArenaString s("a string long enough to not fit inline",
+                ArenaAllocator<char>(&arena));
+  EXPECT_GT(arena.used(), 0);
+}
+
+TEST(FrameArenaTest, DataLivesForOneExtraFrame) {
+  FrameArena arenas(1024, 2);
+  EXPECT_EQ(2, arenas.numWorkers());
+
+  arenas.beginFrame();
+  int* a = arenas.main().allocateArray<int>(1).data();
+  *a = 42;
+  arenas.worker(1).allocate(10);
+
+  arenas.beginFrame();
+  int* b = arenas.main().allocateArray<int>(1).data();
+  *b = 7;
+  EXPECT_NE(a, b);
+  EXPECT_EQ(42, *a);
+
+  // The first frame's arenas are reset and reused.
+  arenas.beginFrame();
+  EXPECT_EQ(0, arenas.main().used());
+  EXPECT_EQ(0, arenas.worker(1).used());
+  EXPECT_EQ(a, arenas.main().allocateArray<int>(1).data());
+}
+
+TEST(FrameArenaTest, HighWaterMark) {
+  FrameArena arenas(1024, 1);
+  arenas.beginFrame();
+  arenas.main().allocate(100, 1);
+  arenas.worker(0).allocate(50, 1);
+  arenas.beginFrame();
+  EXPECT_EQ(150, arenas.lastFrameBytes());
+  arenas.main().allocate(10, 1);
+  arenas.beginFrame();
+  EXPECT_EQ(10, arenas.lastFrameBytes());
+  EXPECT_EQ(150, arenas.highWaterMark());
+}
+
+TEST(FrameArenaTest, LocalArenaOfEachThread) {
+  JobPool pool(3);
+  FrameArena arenas(1024, pool.numWorkers());
+  EXPECT_EQ(&arenas.local(), &arenas.main());
+
+  std::atomic<int> mismatches(0);
+  JobGroup group;
+  for (int i = 0; i < 64; ++i) {
+    pool.schedule(&group, [&arenas, &mismatches]() {
+      int index = JobPool::CurrentWorkerIndex();
+      LinearArena* expected =
+          index < 0 ? &arenas.main() : &arenas.worker(index);
+      if (&arenas.local() != expected) ++mismatches;
+    });
+  }
+  // Jobs the main thread picks up while waiting use the main arena.
+  pool.wait(&group);
+  EXPECT_EQ(mismatches.load(), 0);
+}
+
+TEST(FrameArenaTest, OutOfRangeWorkerDies) {
+  FrameArena arenas(1024, 2);
+  EXPECT_DEATH_IF_SUPPORTED(arenas.worker(2), "");
+  EXPECT_DEATH_IF_SUPPORTED(arenas.worker(-1), "");
+}
+
+}  // namespace
+}  // namespace y
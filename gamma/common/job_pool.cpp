@@ -0,0 +1,101 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/common/job_pool.hpp"
+
+#include "gamma/common/log.hpp"
+
+namespace y {
+namespace {
+
+thread_local int current_worker_index = -1;
+
+}  // namespace
+
+JobPool::JobPool(int num_workers) {
+  YERR_IF(num_workers < 0);
+  for (int i = 0; i < num_workers; ++i) {
+    workers_.emplace_back([this, i]() { workerLoop(i); });
+  }
+}
+
+JobPool::~JobPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopping_ = true;
+  }
+  for (std::thread& worker : workers_) worker.join();
+
+  // Without workers nothing else would run the remaining jobs.
+  absl::MutexLock lock(&mutex_);
+  while (!queue_.empty()) runFrontJob();
+}
+
+int JobPool::CurrentWorkerIndex() { return current_worker_index; }
+
+void JobPool::schedule(Function<void()> job) {
+  absl::MutexLock lock(&mutex_);
+  queue_.push_back(Job{std::move(job), nullptr});
+}
+
+void JobPool::schedule(JobGroup* group, Function<void()> job) {
+  absl::MutexLock lock(&mutex_);
+  ++group->pending_;
+  queue_.push_back(Job{std::move(job), group});
+}
+
+void JobPool::wait(JobGroup* group) {
+  WaitState state = {this, group};
+  absl::MutexLock lock(&mutex_);
+  while (group->pending_ > 0) {
+    mutex_.Await(absl::Condition(&JobPool::GroupDoneOrJobQueued, &state));
+    if (group->pending_ > 0) runFrontJob();
+  }
+}
+
+bool JobPool::GroupDoneOrJobQueued(WaitState* state) {
+  return state->group->pending_ == 0 || !state->pool->queue_.empty();
+}
+
+void JobPool::workerLoop(int index) {
+  current_worker_index = index;
+  absl::MutexLock lock(&mutex_);
+  while (true) {
+    mutex_.Await(absl::Condition(this, &JobPool::jobQueuedOrStopping));
+    if (queue_.empty()) return;
+    runFrontJob();
+  }
+}
+
+bool JobPool::jobQueuedOrStopping() const {
+  return !queue_.empty() || stopping_;
+}
+
+void JobPool::runFrontJob() {
+  Job job = std::move(queue_.front());
+  queue_.pop_front();
+
+  mutex_.Unlock();
+  job.function();
+  job.function.clear();
+  mutex_.Lock();
+
+  if (job.group != nullptr) --job.group->pending_;
+}
+
+}  // namespace y
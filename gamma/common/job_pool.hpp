@@ -0,0 +1,136 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_COMMON_JOB_POOL_HPP_
+#define GAMMA_COMMON_JOB_POOL_HPP_
+
+#include <cstddef>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "gamma/common/function.hpp"
+
+namespace y {
+
+// Tracks a set of jobs scheduled on a `JobPool` so they can be waited on.
+class JobGroup {
+ public:
+  JobGroup() = default;
+  JobGroup(const JobGroup&) = delete;
+  JobGroup& operator=(const JobGroup&) = delete;
+
+ private:
+  friend class JobPool;
+
+  // Guarded by the mutex of the pool the jobs were scheduled on.
+  int pending_ = 0;
+};
+
+// A fixed set of worker threads running jobs from a shared FIFO queue.
+//
+// Each worker has an index in [0, numWorkers()), which can be used to give
+// workers their own resources, such as `FrameArena::local()`. Threads that
+// wait on a group help by running queued jobs, so waiting from inside a job
+// does not deadlock.
+//
+// All member functions are thread-safe. Destruction runs any jobs that are
+// still queued before joining the workers.
+class JobPool {
+ public:
+  explicit JobPool(int num_workers);
+  JobPool(const JobPool&) = delete;
+  JobPool& operator=(const JobPool&) = delete;
+  ~JobPool();
+
+  int numWorkers() const;
+
+  // Index of the pool worker running the calling thread, or -1 if the calling
+  // thread is not a pool worker.
+  static int CurrentWorkerIndex();
+
+  void schedule(Function<void()> job);
+  void schedule(JobGroup* group, Function<void()> job);
+
+  // Block until all jobs scheduled in `group` have finished.
+  void wait(JobGroup* group);
+
+  // Call `f(begin, end)` on consecutive ranges of at most `grain` elements
+  // covering [0, n), in parallel, and return once all calls have finished.
+  // The first range runs on the calling thread.
+  template <typename F>
+  void parallelFor(size_t n, size_t grain, const F& f);
+
+ private:
+  struct Job {
+    Function<void()> function;
+    JobGroup* group;
+  };
+
+  struct WaitState {
+    JobPool* pool;
+    JobGroup* group;
+  };
+
+  static bool GroupDoneOrJobQueued(WaitState* state);
+
+  void workerLoop(int index);
+  bool jobQueuedOrStopping() const;
+  // Pops and runs the front job. The mutex must be held and the queue must be
+  // non-empty; the mutex is released while the job runs.
+  void runFrontJob();
+
+  absl::Mutex mutex_;
+  std::deque<Job> queue_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline int JobPool::numWorkers() const {
+  return static_cast<int>(workers_.size());
+}
+
+template <typename F>
+void JobPool::parallelFor(size_t n, size_t grain, const F& f) {
+  if (n == 0) return;
+  if (grain == 0) grain = 1;
+
+  struct Range {
+    const F* f;
+    size_t n;
+    size_t grain;
+  };
+  const Range range = {&f, n, grain};
+
+  JobGroup group;
+  for (size_t begin = grain; begin < n; begin += grain) {
+    schedule(&group, [&range, begin]() {
+      size_t end = begin + range.grain;
+      (*range.f)(begin, end < range.n ? end : range.n);
+    });
+  }
+  f(size_t{0}, grain < n ? grain : n);
+  wait(&group);
+}
+
+}  // namespace y
+#endif  // GAMMA_COMMON_JOB_POOL_HPP_
@@ -0,0 +1,114 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/common/job_pool.hpp"
+
+#include <atomic>
+#include <vector>
+
+#include "absl/synchronization/notification.h"
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+TEST(JobPoolTest, RunsScheduledJobs) {
+  JobPool pool(4);
+  EXPECT_EQ(pool.numWorkers(), 4);
+
+  std::atomic<int> count(0);
+  JobGroup group;
+  for (int i = 0; i < 100; ++i) {
+    pool.schedule(&group, [&count]() { ++count; });
+  }
+  pool.wait(&group);
+  EXPECT_EQ(count.load(), 100);
+}
+
+TEST(JobPoolTest, WaitWithoutWorkersRunsJobsInline) {
+  JobPool pool(0);
+  int count = 0;
+  JobGroup group;
+  pool.schedule(&group, [&count]() { ++count; });
+  pool.schedule(&group, [&count]() { ++count; });
+  pool.wait(&group);
+  EXPECT_EQ(count, 2);
+}
+
+TEST(JobPoolTest, DestructionRunsUngroupedJobs) {
+  std::atomic<int> count(0);
+  {
+    JobPool pool(2);
+    for (int i = 0; i < 10; ++i) pool.schedule([&count]() { ++count; });
+  }
+  EXPECT_EQ(count.load(), 10);
+}
+
+TEST(JobPoolTest, NestedWaitDoesNotDeadlock) {
+  JobPool pool(1);
+  std::atomic<int> count(0);
+  JobGroup outer;
+  for (int i = 0; i < 4; ++i) {
+    pool.schedule(&outer, [&pool, &count]() {
+      JobGroup inner;
+      for (int j = 0; j < 4; ++j) {
+        pool.schedule(&inner, [&count]() { ++count; });
+      }
+      pool.wait(&inner);
+    });
+  }
+  pool.wait(&outer);
+  EXPECT_EQ(count.load(), 16);
+}
+
+TEST(JobPoolTest, CurrentWorkerIndex) {
+  JobPool pool(3);
+  EXPECT_EQ(JobPool::CurrentWorkerIndex(), -1);
+
+  absl::Notification done;
+  int index = -2;
+  pool.schedule([&index, &done]() {
+    index = JobPool::CurrentWorkerIndex();
+    done.Notify();
+  });
+  done.WaitForNotification();
+  EXPECT_GE(index, 0);
+  EXPECT_LT(index, 3);
+}
+
+TEST(JobPoolTest, ParallelForCoversRangeOnce) {
+  JobPool pool(4);
+  std::vector<std::atomic<int>> hits(1003);
+  for (auto& hit : hits) hit = 0;
+
+  pool.parallelFor(hits.size(), 64, [&hits](size_t begin, size_t end) {
+    EXPECT_LE(end - begin, 64u);
+    for (size_t i = begin; i < end; ++i) ++hits[i];
+  });
+  for (auto& hit : hits) EXPECT_EQ(hit.load(), 1);
+}
+
+TEST(JobPoolTest, ParallelForEmptyRange) {
+  JobPool pool(1);
+  bool called = false;
+  pool.parallelFor(0, 16, [&called](size_t, size_t) { called = true; });
+  EXPECT_FALSE(called);
+}
+
+}  // namespace
+}  // namespace y
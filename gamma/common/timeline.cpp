@@ -0,0 +1,67 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/common/timeline.hpp"
+
+#include <algorithm>
+
+#include "absl/strings/str_format.h"
+
+namespace y {
+
+Timeline::Timeline() : Timeline(absl::Now()) {}
+
+Timeline::Timeline(absl::Time origin) : origin_(origin) {}
+
+void Timeline::record(std::string name, absl::Time start, absl::Time end) {
+  std::thread::id id = std::this_thread::get_id();
+  absl::MutexLock lock(&mutex_);
+  auto it = std::find(threads_.begin(), threads_.end(), id);
+  int thread = static_cast<int>(it - threads_.begin());
+  if (it == threads_.end()) threads_.push_back(id);
+  spans_.push_back(Span{std::move(name), start - origin_, end - start, thread});
+}
+
+std::vector<Timeline::Span> Timeline::spans() const {
+  std::vector<Span> spans;
+  {
+    absl::MutexLock lock(&mutex_);
+    spans = spans_;
+  }
+  std::stable_sort(
+      spans.begin(), spans.end(),
+      [](const Span& a, const Span& b) { return a.start < b.start; });
+  return spans;
+}
+
+std::string Timeline::report() const {
+  std::string report;
+  absl::Duration total;
+  for (const Span& span : spans()) {
+    absl::StrAppendFormat(&report, "%9.3fms +%9.3fms  [thread %d]  %s\n",
+                          absl::ToDoubleMilliseconds(span.start),
+                          absl::ToDoubleMilliseconds(span.duration),
+                          span.thread, span.name);
+    total = std::max(total, span.start + span.duration);
+  }
+  absl::StrAppendFormat(&report, "total %.3fms",
+                        absl::ToDoubleMilliseconds(total));
+  return report;
+}
+
+}  // namespace y
@@ -0,0 +1,101 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_COMMON_TIMELINE_HPP_
+#define GAMMA_COMMON_TIMELINE_HPP_
+
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace y {
+
+// Records named spans of wall time from any thread, relative to an origin, by
+// default the time the timeline was created, and formats them into a human
+// readable report. Meant
+// for coarse one-off phases like engine startup, not per-frame profiling.
+class Timeline {
+ public:
+  struct Span {
+    std::string name;
+    // Offset from the origin of the timeline.
+    absl::Duration start;
+    absl::Duration duration;
+    // Threads are numbered in the order they first recorded a span.
+    int thread;
+  };
+
+  // Records the span from construction to destruction of the scope, unless
+  // `timeline` is null.
+  class Scope {
+   public:
+    Scope(Timeline* timeline, std::string name);
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    ~Scope();
+
+   private:
+    Timeline* timeline_;
+    std::string name_;
+    absl::Time start_;
+  };
+
+  Timeline();
+  explicit Timeline(absl::Time origin);
+  Timeline(const Timeline&) = delete;
+  Timeline& operator=(const Timeline&) = delete;
+
+  absl::Time origin() const;
+
+  void record(std::string name, absl::Time start, absl::Time end);
+
+  // Spans sorted by start time.
+  std::vector<Span> spans() const;
+
+  // One line per span with its start offset, duration and thread, followed by
+  // the total time covered.
+  std::string report() const;
+
+ private:
+  const absl::Time origin_;
+  mutable absl::Mutex mutex_;
+  std::vector<Span> spans_;
+  std::vector<std::thread::id> threads_;
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline Timeline::Scope::Scope(Timeline* timeline, std::string name)
+    : timeline_(timeline), name_(std::move(name)), start_(absl::Now()) {}
+
+inline Timeline::Scope::~Scope() {
+  if (timeline_ != nullptr) {
+    timeline_->record(std::move(name_), start_, absl::Now());
+  }
+}
+
+inline absl::Time Timeline::origin() const { return origin_; }
+
+}  // namespace y
+#endif  // GAMMA_COMMON_TIMELINE_HPP_
@@ -0,0 +1,87 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/common/timeline.hpp"
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+TEST(TimelineTest, RecordsSpansRelativeToOrigin) {
+  Timeline timeline;
+  absl::Time origin = timeline.origin();
+  timeline.record("b", origin + absl::Milliseconds(5),
+                  origin + absl::Milliseconds(7));
+  timeline.record("a", origin + absl::Milliseconds(1),
+                  origin + absl::Milliseconds(4));
+
+  auto spans = timeline.spans();
+  ASSERT_EQ(spans.size(), 2u);
+  EXPECT_EQ(spans[0].name, "a");
+  EXPECT_EQ(spans[0].start, absl::Milliseconds(1));
+  EXPECT_EQ(spans[0].duration, absl::Milliseconds(3));
+  EXPECT_EQ(spans[1].name, "b");
+  EXPECT_EQ(spans[1].start, absl::Milliseconds(5));
+  EXPECT_EQ(spans[1].duration, absl::Milliseconds(2));
+}
+
+TEST(TimelineTest, ExplicitOrigin) {
+  absl::Time origin = absl::Now() - absl::Seconds(1);
+  Timeline timeline(origin);
+  EXPECT_EQ(timeline.origin(), origin);
+  timeline.record("earlier", origin, origin + absl::Milliseconds(3));
+  EXPECT_EQ(timeline.spans()[0].start, absl::ZeroDuration());
+}
+
+TEST(TimelineTest, ScopeWithoutTimelineRecordsNothing) {
+  Timeline::Scope scope(nullptr, "ignored");
+}
+
+TEST(TimelineTest, NumbersThreadsInOrderOfFirstSpan) {
+  Timeline timeline;
+  { Timeline::Scope scope(&timeline, "main"); }
+  std::thread([&timeline]() {
+    Timeline::Scope scope(&timeline, "other");
+  }).join();
+  { Timeline::Scope scope(&timeline, "main again"); }
+
+  auto spans = timeline.spans();
+  ASSERT_EQ(spans.size(), 3u);
+  EXPECT_EQ(spans[0].thread, 0);
+  EXPECT_EQ(spans[1].thread, 1);
+  EXPECT_EQ(spans[2].thread, 0);
+}
+
+TEST(TimelineTest, Report) {
+  Timeline timeline;
+  absl::Time origin = timeline.origin();
+  timeline.record("load scripts", origin, origin + absl::Milliseconds(2));
+  timeline.record("create window", origin + absl::Milliseconds(1),
+                  origin + absl::Milliseconds(10));
+
+  EXPECT_EQ(timeline.report(),
+            "    0.000ms +    2.000ms  [thread 0]  load scripts\n"
+            "    1.000ms +    9.000ms  [thread 0]  create window\n"
+            "total 10.000ms");
+}
+
+}  // namespace
+}  // namespace y
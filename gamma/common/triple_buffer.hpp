@@ -0,0 +1,90 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_COMMON_TRIPLE_BUFFER_HPP_
+#define GAMMA_COMMON_TRIPLE_BUFFER_HPP_
+
+#include <atomic>
+#include <cstdint>
+
+namespace y {
+
+// Lock-free handoff of values from a single writer thread to a single reader
+// thread.
+//
+// The writer fills `back()` and calls `publish()`; the reader calls `acquire()`
+// and, if it returns true, reads the newest published value from `front()`.
+// Neither side ever waits on the other, and each side keeps exclusive access to
+// its own buffer until its next `publish()` or `acquire()`. If the writer
+// publishes more than once between two acquisitions, only the newest value is
+// observed.
+template <typename T>
+class TripleBuffer {
+ public:
+  TripleBuffer() = default;
+  TripleBuffer(const TripleBuffer&) = delete;
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  // Writer side.
+  T& back();
+  void publish();
+
+  // Reader side. Returns true if a value was published since the last call.
+  bool acquire();
+  const T& front() const;
+
+ private:
+  static constexpr uint8_t kIndexMask = 0x3;
+  static constexpr uint8_t kFreshBit = 0x4;
+
+  T buffers_[3];
+  uint8_t back_ = 0;
+  uint8_t front_ = 1;
+  std::atomic<uint8_t> middle_{2};
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+template <typename T>
+T& TripleBuffer<T>::back() {
+  return buffers_[back_];
+}
+
+template <typename T>
+void TripleBuffer<T>::publish() {
+  uint8_t previous =
+      middle_.exchange(back_ | kFreshBit, std::memory_order_acq_rel);
+  back_ = previous & kIndexMask;
+}
+
+template <typename T>
+bool TripleBuffer<T>::acquire() {
+  if ((middle_.load(std::memory_order_acquire) & kFreshBit) == 0) return false;
+  uint8_t previous = middle_.exchange(front_, std::memory_order_acq_rel);
+  front_ = previous & kIndexMask;
+  return true;
+}
+
+template <typename T>
+const T& TripleBuffer<T>::front() const {
+  return buffers_[front_];
+}
+
+}  // namespace y
+#endif  // GAMMA_COMMON_TRIPLE_BUFFER_HPP_
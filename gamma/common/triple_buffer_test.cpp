@@ -0,0 +1,81 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/common/triple_buffer.hpp"
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+TEST(TripleBufferTest, NothingPublished) {
+  TripleBuffer<int> buffer;
+  EXPECT_FALSE(buffer.acquire());
+}
+
+TEST(TripleBufferTest, PublishThenAcquire) {
+  TripleBuffer<int> buffer;
+  buffer.back() = 5;
+  buffer.publish();
+  EXPECT_TRUE(buffer.acquire());
+  EXPECT_EQ(5, buffer.front());
+  EXPECT_FALSE(buffer.acquire());
+  EXPECT_EQ(5, buffer.front());
+}
+
+TEST(TripleBufferTest, AcquireSeesNewestValue) {
+  TripleBuffer<int> buffer;
+  for (int i = 0; i < 10; ++i) {
+    buffer.back() = i;
+    buffer.publish();
+  }
+  EXPECT_TRUE(buffer.acquire());
+  EXPECT_EQ(9, buffer.front());
+}
+
+TEST(TripleBufferTest, ConcurrentValuesAreMonotonic) {
+  struct Value {
+    int a = 0;
+    int b = 0;
+  };
+  constexpr int kCount = 100000;
+  TripleBuffer<Value> buffer;
+
+  std::thread writer([&buffer]() {
+    for (int i = 1; i <= kCount; ++i) {
+      buffer.back().a = i;
+      buffer.back().b = -i;
+      buffer.publish();
+    }
+  });
+
+  int last = 0;
+  while (last < kCount) {
+    if (!buffer.acquire()) continue;
+    const Value& value = buffer.front();
+    ASSERT_EQ(value.a, -value.b);
+    ASSERT_GT(value.a, last);
+    last = value.a;
+  }
+  writer.join();
+}
+
+}  // namespace
+}  // namespace y
@@ -0,0 +1,39 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/access.hpp"
+
+#include "gamma/common/log.hpp"
+
+namespace y_internal {
+
+const y::ComponentAccess*& CurrentComponentAccess() {
+  thread_local const y::ComponentAccess* access = nullptr;
+  return access;
+}
+
+void FailComponentAccess(int type, bool write) {
+  YERR << (write ? "write to" : "read of") << " component type " << type
+       << " not declared in the access of the running system";
+}
+
+void FailStructuralChange() {
+  YERR << "structural change to World while a system is running";
+}
+
+}  // namespace y_internal
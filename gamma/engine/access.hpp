@@ -0,0 +1,123 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_ENGINE_ACCESS_HPP_
+#define GAMMA_ENGINE_ACCESS_HPP_
+
+#include <type_traits>
+
+#include "gamma/engine/component.hpp"
+
+namespace y {
+
+// The component types a system reads and writes. Systems whose accesses do
+// not conflict can run concurrently.
+struct ComponentAccess {
+  ComponentMask reads;
+  ComponentMask writes;
+
+  // Const types are read, others are written.
+  template <typename... Ts>
+  static ComponentAccess Of();
+
+  bool conflictsWith(const ComponentAccess& other) const;
+};
+
+// While in scope, `World` accesses made on the calling thread are checked
+// against `access` in debug builds: touching an undeclared component type or
+// making a structural change is a fatal error. Scopes nest.
+class ComponentAccessScope {
+ public:
+  explicit ComponentAccessScope(const ComponentAccess* access);
+  ComponentAccessScope(const ComponentAccessScope&) = delete;
+  ComponentAccessScope& operator=(const ComponentAccessScope&) = delete;
+  ~ComponentAccessScope();
+
+ private:
+  const ComponentAccess* previous_;
+};
+
+// Used by `World` to check accesses. No-ops when `NDEBUG` is defined.
+void CheckComponentAccess(int type, bool write);
+void CheckStructuralChange();
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+}  // namespace y
+
+namespace y_internal {
+
+// The access of the innermost `ComponentAccessScope` on this thread, or null.
+const y::ComponentAccess*& CurrentComponentAccess();
+
+void FailComponentAccess(int type, bool write);
+void FailStructuralChange();
+
+}  // namespace y_internal
+
+namespace y {
+
+template <typename... Ts>
+ComponentAccess ComponentAccess::Of() {
+  ComponentAccess access;
+  const int types[] = {0, ComponentTypeId<Ts>()...};
+  const bool writes[] = {false, !std::is_const<Ts>::value...};
+  for (size_t i = 1; i < sizeof(types) / sizeof(types[0]); ++i) {
+    (writes[i] ? access.writes : access.reads).set(types[i]);
+  }
+  return access;
+}
+
+inline bool ComponentAccess::conflictsWith(const ComponentAccess& other) const {
+  return (writes & (other.reads | other.writes)).any() ||
+         (reads & other.writes).any();
+}
+
+inline ComponentAccessScope::ComponentAccessScope(
+    const ComponentAccess* access)
+    : previous_(y_internal::CurrentComponentAccess()) {
+  y_internal::CurrentComponentAccess() = access;
+}
+
+inline ComponentAccessScope::~ComponentAccessScope() {
+  y_internal::CurrentComponentAccess() = previous_;
+}
+
+inline void CheckComponentAccess(int type, bool write) {
+#ifndef NDEBUG
+  const ComponentAccess* access = y_internal::CurrentComponentAccess();
+  if (access == nullptr) return;
+  bool allowed = access->writes[type] || (!write && access->reads[type]);
+  if (!allowed) y_internal::FailComponentAccess(type, write);
+#else
+  (void)type;
+  (void)write;
+#endif
+}
+
+inline void CheckStructuralChange() {
+#ifndef NDEBUG
+  if (y_internal::CurrentComponentAccess() != nullptr) {
+    y_internal::FailStructuralChange();
+  }
+#endif
+}
+
+}  // namespace y
+#endif  // GAMMA_ENGINE_ACCESS_HPP_
@@ -0,0 +1,242 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/archetype.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "gamma/common/log.hpp"
+
+namespace y {
+namespace {
+
+size_t AlignUp(size_t offset, size_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+constexpr size_t Archetype::kChunkBytes;
+constexpr size_t Archetype::kChunkAlignment;
+
+Archetype::Archetype(const ComponentMask& mask) : mask_(mask) {
+  initColumns();
+
+  // Start from the number of rows that fit without padding and shrink until
+  // the padded layout fits in a chunk.
+  size_t row_bytes = sizeof(Entity);
+  for (const Column& column : columns_) row_bytes += column.info->size;
+  capacity_ = static_cast<uint32_t>(kChunkBytes / row_bytes);
+  for (;; --capacity_) {
+    YERR_IF(capacity_ == 0) << "components too large to fit in a chunk";
+    size_t offset = capacity_ * sizeof(Entity);
+    for (Column& column : columns_) {
+      offset = AlignUp(offset, column.info->alignment);
+      column.offset = offset;
+      offset += capacity_ * column.info->size;
+    }
+    if (offset <= kChunkBytes) break;
+  }
+}
+
+Archetype::Archetype(const ComponentMask& mask, uint32_t capacity,
+                     const std::vector<size_t>& offsets)
+    : mask_(mask), capacity_(capacity) {
+  initColumns();
+  YERR_IF(offsets.size() != columns_.size()) << "wrong number of columns";
+  YERR_IF(capacity_ == 0 || capacity_ * sizeof(Entity) > kChunkBytes)
+      << "invalid chunk capacity";
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    Column& column = columns_[i];
+    column.offset = offsets[i];
+    YERR_IF(column.offset < capacity_ * sizeof(Entity) ||
+            column.offset % column.info->alignment != 0 ||
+            column.offset + capacity_ * column.info->size > kChunkBytes)
+        << "invalid chunk layout";
+  }
+}
+
+void Archetype::initColumns() {
+  column_of_.fill(-1);
+  for (int type = 0; type < kMaxComponentTypes; ++type) {
+    if (!mask_[type]) continue;
+    const ComponentInfo& info = GetComponentInfo(type);
+    YERR_IF(info.alignment > kChunkAlignment)
+        << "component alignment exceeds chunk alignment";
+    column_of_[type] = static_cast<int16_t>(types_.size());
+    types_.push_back(type);
+    columns_.push_back(Column{type, 0, &info});
+  }
+}
+
+Archetype::~Archetype() {
+  for (Chunk& chunk : chunks_) {
+    for (const Column& column : columns_) {
+      if (column.info->trivially_copyable) continue;
+      uint8_t* data = chunk.data + column.offset;
+      for (uint32_t i = 0; i < chunk.size; ++i) {
+        column.info->destroy(data + i * column.info->size);
+      }
+    }
+    if (chunk.owned) std::free(chunk.data);
+  }
+  std::free(spare_chunk_);
+}
+
+Archetype::Row Archetype::pushBack(Entity entity, uint32_t version) {
+  if (chunks_.empty() || chunks_.back().size == capacity_) {
+    chunks_.push_back(Chunk{allocateChunk(), 0, true});
+    versions_.resize(versions_.size() + 2 * columns_.size(), 0);
+  }
+  Row row = {static_cast<uint32_t>(chunks_.size() - 1), chunks_.back().size};
+  ++chunks_.back().size;
+  ++size_;
+  entities(row.chunk)[row.index] = entity;
+  for (int i = 0; i < static_cast<int>(columns_.size()); ++i) {
+    markChanged(row.chunk, i, version);
+  }
+  return row;
+}
+
+void Archetype::reserve(size_t rows) {
+  size_t free_rows = chunks_.empty() ? 0 : capacity_ - chunks_.back().size;
+  if (rows <= free_rows) return;
+  size_t num_chunks =
+      chunks_.size() + (rows - free_rows + capacity_ - 1) / capacity_;
+  chunks_.reserve(num_chunks);
+  versions_.reserve(num_chunks * 2 * columns_.size());
+}
+
+Archetype::Row Archetype::appendRows(size_t count, uint32_t version,
+                                     uint32_t* appended) {
+  if (chunks_.empty() || chunks_.back().size == capacity_) {
+    chunks_.push_back(Chunk{allocateChunk(), 0, true});
+    versions_.resize(versions_.size() + 2 * columns_.size(), 0);
+  }
+  Chunk& chunk = chunks_.back();
+  Row row = {static_cast<uint32_t>(chunks_.size() - 1), chunk.size};
+  *appended = static_cast<uint32_t>(
+      std::min<size_t>(count, capacity_ - chunk.size));
+  chunk.size += *appended;
+  size_ += *appended;
+  for (int i = 0; i < static_cast<int>(columns_.size()); ++i) {
+    markAdded(row.chunk, i, version);
+  }
+  return row;
+}
+
+Entity Archetype::erase(Row row, uint32_t version) {
+  for (int i = 0; i < static_cast<int>(columns_.size()); ++i) {
+    const ComponentInfo* info = columns_[i].info;
+    if (!info->trivially_copyable) info->destroy(component(row, i));
+  }
+  return fillHole(row, version);
+}
+
+Archetype::Row Archetype::moveFrom(Archetype* from, Row row, uint32_t version,
+                                   Entity* moved) {
+  Row to = pushBack(from->entity(row), version);
+  for (int i = 0; i < static_cast<int>(columns_.size()); ++i) {
+    if (from->column(columns_[i].type) < 0) markAdded(to.chunk, i, version);
+  }
+  for (int i = 0; i < static_cast<int>(from->columns_.size()); ++i) {
+    const ComponentInfo* info = from->columns_[i].info;
+    void* src = from->component(row, i);
+    int to_column = column(from->columns_[i].type);
+    if (to_column < 0) {
+      if (!info->trivially_copyable) info->destroy(src);
+    } else if (info->trivially_copyable) {
+      std::memcpy(component(to, to_column), src, info->size);
+    } else {
+      info->relocate(component(to, to_column), src);
+    }
+  }
+  *moved = from->fillHole(row, version);
+  return to;
+}
+
+size_t Archetype::appendChunk(uint8_t* data, uint32_t size, bool copy,
+                              uint32_t version) {
+  YERR_IF(!chunks_.empty() && chunks_.back().size != capacity_)
+      << "appending a chunk after a partial one";
+  YERR_IF(size == 0 || size > capacity_) << "invalid chunk size";
+  if (copy) {
+    uint8_t* owned = allocateChunk();
+    std::memcpy(owned, data, kChunkBytes);
+    data = owned;
+  }
+  chunks_.push_back(Chunk{data, size, copy});
+  versions_.resize(versions_.size() + 2 * columns_.size(), 0);
+  size_ += size;
+  for (int i = 0; i < static_cast<int>(columns_.size()); ++i) {
+    markAdded(chunks_.size() - 1, i, version);
+  }
+  return chunks_.size() - 1;
+}
+
+// Moves the last row into `row`, whose components have already been destroyed
+// or moved out.
+Entity Archetype::fillHole(Row row, uint32_t version) {
+  Row last = {static_cast<uint32_t>(chunks_.size() - 1),
+              chunks_.back().size - 1};
+  Entity moved;
+  if (row.chunk != last.chunk || row.index != last.index) {
+    for (int i = 0; i < static_cast<int>(columns_.size()); ++i) {
+      const ComponentInfo* info = columns_[i].info;
+      if (info->trivially_copyable) {
+        std::memcpy(component(row, i), component(last, i), info->size);
+      } else {
+        info->relocate(component(row, i), component(last, i));
+      }
+    }
+    moved = entity(last);
+    entities(row.chunk)[row.index] = moved;
+    for (int i = 0; i < static_cast<int>(columns_.size()); ++i) {
+      markChanged(row.chunk, i, version);
+    }
+  }
+
+  --size_;
+  if (--chunks_.back().size == 0) releaseLastChunk();
+  return moved;
+}
+
+uint8_t* Archetype::allocateChunk() {
+  if (spare_chunk_ != nullptr) {
+    uint8_t* data = spare_chunk_;
+    spare_chunk_ = nullptr;
+    return data;
+  }
+  void* data = nullptr;
+  YERR_IF(posix_memalign(&data, kChunkAlignment, kChunkBytes) != 0)
+      << "failed to allocate chunk";
+  return static_cast<uint8_t*>(data);
+}
+
+void Archetype::releaseLastChunk() {
+  if (chunks_.back().owned) {
+    std::free(spare_chunk_);
+    spare_chunk_ = chunks_.back().data;
+  }
+  chunks_.pop_back();
+  versions_.resize(versions_.size() - 2 * columns_.size());
+}
+
+}  // namespace y
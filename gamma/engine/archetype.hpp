@@ -0,0 +1,222 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_ENGINE_ARCHETYPE_HPP_
+#define GAMMA_ENGINE_ARCHETYPE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gamma/engine/component.hpp"
+#include "gamma/engine/entity.hpp"
+
+namespace y {
+
+// Storage for all entities that have exactly the same set of component types.
+//
+// Entities are stored in fixed-size chunks. A chunk holds up to `capacity()`
+// entities as parallel arrays, one of entity handles and one per component
+// type, so iterating over a component touches only tightly packed memory.
+// Rows are kept dense: every chunk but the last is full, and erasing a row
+// moves the last row of the archetype into its place.
+//
+// Each chunk also records, per column, the world version at which a component
+// was last added to it and at which one last changed, which lets queries skip
+// chunks that have not changed. Adding a row or moving one into a hole counts
+// as a change.
+class Archetype {
+ public:
+  static constexpr size_t kChunkBytes = 16 * 1024;
+  static constexpr size_t kChunkAlignment = 64;
+
+  struct Chunk {
+    uint8_t* data;
+    uint32_t size;
+    // False for chunks in memory owned elsewhere, such as a mapped snapshot.
+    bool owned;
+  };
+
+  struct Row {
+    uint32_t chunk;
+    uint32_t index;
+  };
+
+  explicit Archetype(const ComponentMask& mask);
+  // Use a given chunk layout, such as one read from a snapshot, in which the
+  // array of column `i` starts at `offsets[i]`.
+  Archetype(const ComponentMask& mask, uint32_t capacity,
+            const std::vector<size_t>& offsets);
+  Archetype(const Archetype&) = delete;
+  Archetype& operator=(const Archetype&) = delete;
+  ~Archetype();
+
+  const ComponentMask& mask() const;
+
+  // Component type ids in increasing order. Component arrays in a chunk are
+  // indexed by position in this list, called the column.
+  const std::vector<int>& types() const;
+
+  // Column of component type `type`, or -1 if it is not part of the archetype.
+  int column(int type) const;
+
+  // Maximum number of entities per chunk.
+  uint32_t capacity() const;
+
+  // Number of entities.
+  size_t size() const;
+
+  size_t numChunks() const;
+  const Chunk& chunk(size_t i) const;
+
+  Entity* entities(size_t chunk) const;
+  // Offset of the array of `column` from the start of a chunk.
+  size_t columnOffset(int column) const;
+  void* columnData(size_t chunk, int column) const;
+  void* component(Row row, int column) const;
+  Entity entity(Row row) const;
+
+  uint32_t changedVersion(size_t chunk, int column) const;
+  uint32_t addedVersion(size_t chunk, int column) const;
+  void markChanged(size_t chunk, int column, uint32_t version);
+  // Also marks the column changed.
+  void markAdded(size_t chunk, int column, uint32_t version);
+
+  // Append a row for `entity`, leaving its components uninitialized.
+  Row pushBack(Entity entity, uint32_t version);
+
+  // Make room in the chunk list for `rows` more rows.
+  void reserve(size_t rows);
+
+  // Append up to `count` rows to the last chunk, or to a new chunk if it is
+  // full, marking their components added. Their entities and components are
+  // left uninitialized. Returns the first row and sets `appended` to the
+  // number of rows.
+  Row appendRows(size_t count, uint32_t version, uint32_t* appended);
+
+  // Destroy the components at `row` and fill the hole. Returns the entity that
+  // was moved into `row`, or a null entity if `row` was the last row.
+  Entity erase(Row row, uint32_t version);
+
+  // Move the entity at `row` of `from` into a new row of this archetype.
+  // Components that are not part of this archetype are destroyed, and ones
+  // that are not part of `from` are left uninitialized and marked added. Sets
+  // `moved` to the entity that was moved into `row` of `from`, as by
+  // `erase()`.
+  Row moveFrom(Archetype* from, Row row, uint32_t version, Entity* moved);
+
+  // Append a chunk of `size` rows laid out as by this archetype, marking its
+  // components added, and return its index. All existing chunks must be full.
+  // If `copy` is false the chunk is used in place and never freed, so `data`
+  // must outlive the archetype.
+  size_t appendChunk(uint8_t* data, uint32_t size, bool copy,
+                     uint32_t version);
+
+ private:
+  struct Column {
+    int type;
+    size_t offset;
+    const ComponentInfo* info;
+  };
+
+  void initColumns();
+  Entity fillHole(Row row, uint32_t version);
+  uint32_t& version(size_t chunk, int column, bool added);
+  uint8_t* allocateChunk();
+  void releaseLastChunk();
+
+  ComponentMask mask_;
+  std::vector<int> types_;
+  std::vector<Column> columns_;
+  std::array<int16_t, kMaxComponentTypes> column_of_;
+  uint32_t capacity_;
+  size_t size_ = 0;
+  std::vector<Chunk> chunks_;
+  // For each chunk, the changed versions of its columns followed by the added
+  // versions.
+  std::vector<uint32_t> versions_;
+  // An emptied chunk is kept for reuse, so that an archetype whose size keeps
+  // crossing a chunk boundary does not repeatedly allocate.
+  uint8_t* spare_chunk_ = nullptr;
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline const ComponentMask& Archetype::mask() const { return mask_; }
+
+inline const std::vector<int>& Archetype::types() const { return types_; }
+
+inline int Archetype::column(int type) const { return column_of_[type]; }
+
+inline uint32_t Archetype::capacity() const { return capacity_; }
+
+inline size_t Archetype::size() const { return size_; }
+
+inline size_t Archetype::numChunks() const { return chunks_.size(); }
+
+inline const Archetype::Chunk& Archetype::chunk(size_t i) const {
+  return chunks_[i];
+}
+
+inline Entity* Archetype::entities(size_t chunk) const {
+  return reinterpret_cast<Entity*>(chunks_[chunk].data);
+}
+
+inline size_t Archetype::columnOffset(int column) const {
+  return columns_[column].offset;
+}
+
+inline void* Archetype::columnData(size_t chunk, int column) const {
+  return chunks_[chunk].data + columns_[column].offset;
+}
+
+inline void* Archetype::component(Row row, int column) const {
+  return static_cast<uint8_t*>(columnData(row.chunk, column)) +
+         row.index * columns_[column].info->size;
+}
+
+inline Entity Archetype::entity(Row row) const {
+  return entities(row.chunk)[row.index];
+}
+
+inline uint32_t& Archetype::version(size_t chunk, int column, bool added) {
+  return versions_[(chunk * 2 + added) * columns_.size() + column];
+}
+
+inline uint32_t Archetype::changedVersion(size_t chunk, int column) const {
+  return const_cast<Archetype*>(this)->version(chunk, column, false);
+}
+
+inline uint32_t Archetype::addedVersion(size_t chunk, int column) const {
+  return const_cast<Archetype*>(this)->version(chunk, column, true);
+}
+
+inline void Archetype::markChanged(size_t chunk, int column,
+                                   uint32_t version) {
+  this->version(chunk, column, false) = version;
+}
+
+inline void Archetype::markAdded(size_t chunk, int column, uint32_t version) {
+  this->version(chunk, column, false) = version;
+  this->version(chunk, column, true) = version;
+}
+
+}  // namespace y
+#endif  // GAMMA_ENGINE_ARCHETYPE_HPP_
@@ -0,0 +1,155 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/archetype.hpp"
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+struct Small {
+  uint8_t value;
+};
+
+struct alignas(32) Aligned {
+  float values[8];
+};
+
+ComponentMask MaskOf(std::initializer_list<int> types) {
+  ComponentMask mask;
+  for (int type : types) mask.set(type);
+  return mask;
+}
+
+TEST(ArchetypeTest, LayoutFitsInChunk) {
+  int small = ComponentTypeId<Small>();
+  int aligned = ComponentTypeId<Aligned>();
+  Archetype archetype(MaskOf({small, aligned}));
+
+  ASSERT_EQ(archetype.types().size(), 2u);
+  EXPECT_GE(archetype.column(small), 0);
+  EXPECT_GE(archetype.column(aligned), 0);
+  EXPECT_EQ(archetype.column(ComponentTypeId<std::string>()), -1);
+
+  uint32_t capacity = archetype.capacity();
+  EXPECT_GT(capacity, 0u);
+  EXPECT_LE(capacity * (sizeof(Entity) + sizeof(Small) + sizeof(Aligned)),
+            Archetype::kChunkBytes);
+
+  archetype.pushBack(Entity{1, 1}, 1);
+  auto address = reinterpret_cast<uintptr_t>(
+      archetype.columnData(0, archetype.column(aligned)));
+  EXPECT_EQ(address % alignof(Aligned), 0u);
+  auto end = reinterpret_cast<uintptr_t>(archetype.component(
+      Archetype::Row{0, capacity - 1}, archetype.column(aligned)));
+  EXPECT_LE(end + sizeof(Aligned) -
+                reinterpret_cast<uintptr_t>(archetype.chunk(0).data),
+            Archetype::kChunkBytes);
+}
+
+TEST(ArchetypeTest, ChunksStayDense) {
+  int small = ComponentTypeId<Small>();
+  Archetype archetype(MaskOf({small}));
+  uint32_t capacity = archetype.capacity();
+  int column = archetype.column(small);
+
+  for (uint32_t i = 0; i < capacity + 1; ++i) {
+    Archetype::Row row = archetype.pushBack(Entity{i + 1, 1}, 1);
+    static_cast<Small*>(archetype.component(row, column))->value =
+        static_cast<uint8_t>(i);
+  }
+  EXPECT_EQ(archetype.numChunks(), 2u);
+  EXPECT_EQ(archetype.chunk(0).size, capacity);
+  EXPECT_EQ(archetype.chunk(1).size, 1u);
+
+  // Erasing the first row moves the last entity into its place and frees the
+  // second chunk.
+  Entity moved = archetype.erase(Archetype::Row{0, 0}, 1);
+  EXPECT_EQ(moved, (Entity{capacity + 1, 1}));
+  EXPECT_EQ(archetype.numChunks(), 1u);
+  EXPECT_EQ(archetype.size(), capacity);
+  EXPECT_EQ(archetype.entity(Archetype::Row{0, 0}), moved);
+  EXPECT_EQ(static_cast<Small*>(archetype.component({0, 0}, column))->value,
+            static_cast<uint8_t>(capacity));
+
+  // Erasing the last row moves nothing.
+  EXPECT_EQ(archetype.erase(Archetype::Row{0, capacity - 1}, 1), Entity());
+}
+
+TEST(ArchetypeTest, MoveFromRelocatesSharedComponents) {
+  int small = ComponentTypeId<Small>();
+  int text = ComponentTypeId<std::string>();
+  Archetype from(MaskOf({small, text}));
+  Archetype to(MaskOf({text}));
+
+  for (uint32_t i = 0; i < 2; ++i) {
+    Archetype::Row row = from.pushBack(Entity{i + 1, 1}, 1);
+    new (from.component(row, from.column(small))) Small{0};
+    new (from.component(row, from.column(text)))
+        std::string(100, static_cast<char>('a' + i));
+  }
+
+  Entity moved;
+  Archetype::Row row = to.moveFrom(&from, Archetype::Row{0, 0}, 1, &moved);
+  EXPECT_EQ(moved, (Entity{2, 1}));
+  EXPECT_EQ(to.entity(row), (Entity{1, 1}));
+  auto* moved_text =
+      static_cast<std::string*>(to.component(row, to.column(text)));
+  EXPECT_EQ(*moved_text, std::string(100, 'a'));
+  auto* remaining_text =
+      static_cast<std::string*>(from.component({0, 0}, from.column(text)));
+  EXPECT_EQ(*remaining_text, std::string(100, 'b'));
+}
+
+TEST(ArchetypeTest, TracksVersionsPerChunk) {
+  int small = ComponentTypeId<Small>();
+  int text = ComponentTypeId<std::string>();
+  Archetype from(MaskOf({small}));
+  Archetype to(MaskOf({small, text}));
+  uint32_t capacity = to.capacity();
+
+  for (uint32_t i = 0; i < capacity + 1; ++i) from.pushBack({i + 1, 1}, 1);
+  Entity moved;
+  for (uint32_t i = 0; i < capacity; ++i) {
+    to.moveFrom(&from, Archetype::Row{0, 0}, 2, &moved);
+    new (to.component({0, i}, to.column(text))) std::string();
+  }
+  to.moveFrom(&from, Archetype::Row{0, 0}, 3, &moved);
+  new (to.component({1, 0}, to.column(text))) std::string();
+
+  // Only the newly added component type counts as added.
+  EXPECT_EQ(to.changedVersion(0, to.column(small)), 2u);
+  EXPECT_EQ(to.addedVersion(0, to.column(small)), 0u);
+  EXPECT_EQ(to.addedVersion(0, to.column(text)), 2u);
+  EXPECT_EQ(to.addedVersion(1, to.column(text)), 3u);
+
+  // Filling a hole changes the chunk it is in.
+  to.erase(Archetype::Row{0, 0}, 4);
+  EXPECT_EQ(to.changedVersion(0, to.column(text)), 4u);
+  EXPECT_EQ(to.addedVersion(0, to.column(text)), 2u);
+
+  to.markChanged(0, to.column(small), 5);
+  EXPECT_EQ(to.changedVersion(0, to.column(small)), 5u);
+  EXPECT_EQ(to.changedVersion(0, to.column(text)), 4u);
+}
+
+}  // namespace
+}  // namespace y
@@ -0,0 +1,171 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/command_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "absl/memory/memory.h"
+#include "gamma/common/job_pool.hpp"
+#include "gamma/common/log.hpp"
+
+namespace y {
+namespace {
+
+constexpr size_t kComponentBytes = 16 * 1024;
+
+}  // namespace
+
+CommandBuffer::CommandBuffer(World* world)
+    : world_(world), components_(kComponentBytes) {}
+
+CommandBuffer::~CommandBuffer() { clear(); }
+
+void CommandBuffer::destroy(Entity entity) {
+  commands_.push_back(Command{entity, 0, Kind::kDestroy, nullptr});
+}
+
+void CommandBuffer::clear() {
+  for (const Command& command : commands_) {
+    if (command.component == nullptr) continue;
+    const ComponentInfo& info = GetComponentInfo(command.type);
+    if (!info.trivially_copyable) info.destroy(command.component);
+  }
+  commands_.clear();
+  components_.reset();
+}
+
+CommandQueue::CommandQueue(World* world, int num_workers) : world_(world) {
+  for (int i = 0; i < num_workers + 1; ++i) {
+    buffers_.push_back(absl::make_unique<CommandBuffer>(world));
+  }
+}
+
+CommandBuffer& CommandQueue::local() {
+  // Threads that are not pool workers have index -1 and share buffer 0.
+  int index = JobPool::CurrentWorkerIndex() + 1;
+  YERR_IF(index >= int(buffers_.size()))
+      << "no command buffer for worker " << index - 1;
+  return *buffers_[index];
+}
+
+void CommandQueue::playback() {
+  world_->materializeReserved();
+
+  commands_.clear();
+  for (const auto& buffer : buffers_) {
+    for (Command& command : buffer->commands_) commands_.push_back(&command);
+  }
+  std::stable_sort(commands_.begin(), commands_.end(),
+                   [](const Command* a, const Command* b) {
+                     return a->entity.index < b->entity.index;
+                   });
+
+  adds_.clear();
+  moves_.clear();
+  for (size_t begin = 0, end = 0; begin < commands_.size(); begin = end) {
+    end = begin + 1;
+    while (end < commands_.size() &&
+           commands_[end]->entity.index == commands_[begin]->entity.index) {
+      ++end;
+    }
+    foldEntityCommands(&commands_[begin], commands_.data() + end);
+  }
+
+  std::stable_sort(moves_.begin(), moves_.end(),
+                   [](const Move& a, const Move& b) {
+                     return a.from != b.from ? a.from < b.from : a.to < b.to;
+                   });
+  for (const Move& move : moves_) applyMove(move);
+
+  for (const auto& buffer : buffers_) buffer->clear();
+}
+
+// Reduces the commands for one entity index to the archetype the entity ends
+// up in and the components that must be moved into it.
+void CommandQueue::foldEntityCommands(Command** begin, Command** end) {
+  Entity entity;
+  for (Command** it = begin; it != end; ++it) {
+    if (world_->alive((*it)->entity)) entity = (*it)->entity;
+  }
+  if (entity == Entity()) return;
+
+  uint32_t from = world_->record(entity).archetype;
+  ComponentMask mask = world_->archetypes_[from]->mask();
+  size_t adds_begin = adds_.size();
+  bool destroy = false;
+  for (Command** it = begin; it != end && !destroy; ++it) {
+    Command* command = *it;
+    if (command->entity != entity) continue;
+
+    // A later add or remove of the same type supersedes an earlier add.
+    if (command->kind != CommandBuffer::Kind::kDestroy) {
+      adds_.erase(std::remove_if(adds_.begin() + adds_begin, adds_.end(),
+                                 [command](const Command* add) {
+                                   return add->type == command->type;
+                                 }),
+                  adds_.end());
+    }
+    switch (command->kind) {
+      case CommandBuffer::Kind::kAdd:
+        mask.set(command->type);
+        adds_.push_back(command);
+        break;
+      case CommandBuffer::Kind::kRemove:
+        mask.reset(command->type);
+        break;
+      case CommandBuffer::Kind::kDestroy:
+        destroy = true;
+        break;
+    }
+  }
+
+  if (destroy) {
+    adds_.resize(adds_begin);
+    moves_.push_back(Move{entity, from, from, true, adds_begin, adds_begin});
+  } else {
+    uint32_t to = world_->findOrCreateArchetype(mask);
+    if (to == from && adds_.size() == adds_begin) return;
+    moves_.push_back(Move{entity, from, to, false, adds_begin, adds_.size()});
+  }
+}
+
+void CommandQueue::applyMove(const Move& move) {
+  if (move.destroy) {
+    world_->destroy(move.entity);
+    return;
+  }
+  if (move.to != move.from) world_->moveEntity(move.entity, move.to);
+
+  const ComponentMask& had = world_->archetypes_[move.from]->mask();
+  for (size_t i = move.adds_begin; i < move.adds_end; ++i) {
+    Command* add = adds_[i];
+    const ComponentInfo& info = GetComponentInfo(add->type);
+    void* destination = world_->findChanged(move.entity, add->type);
+    if (info.trivially_copyable) {
+      std::memcpy(destination, add->component, info.size);
+    } else {
+      if (had[add->type]) info.destroy(destination);
+      info.relocate(destination, add->component);
+    }
+    add->component = nullptr;
+  }
+}
+
+}  // namespace y
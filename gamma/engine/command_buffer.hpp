@@ -0,0 +1,161 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_ENGINE_COMMAND_BUFFER_HPP_
+#define GAMMA_ENGINE_COMMAND_BUFFER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "gamma/common/frame_arena.hpp"
+#include "gamma/engine/component.hpp"
+#include "gamma/engine/entity.hpp"
+#include "gamma/engine/world.hpp"
+
+namespace y {
+
+// Records structural changes to a `World` so that systems can request them
+// while other systems iterate. The changes are applied by
+// `CommandQueue::playback()`.
+//
+// Not thread-safe; each thread records into its own buffer.
+class CommandBuffer {
+ public:
+  explicit CommandBuffer(World* world);
+  CommandBuffer(const CommandBuffer&) = delete;
+  CommandBuffer& operator=(const CommandBuffer&) = delete;
+  ~CommandBuffer();
+
+  // The returned handle is valid immediately, but the entity only comes to
+  // life with its components on playback.
+  template <typename... Ts>
+  Entity create(Ts&&... components);
+
+  void destroy(Entity entity);
+
+  template <typename T>
+  void add(Entity entity, T component);
+
+  template <typename T>
+  void remove(Entity entity);
+
+  // Number of recorded commands.
+  size_t size() const;
+
+  // Discard all recorded commands.
+  void clear();
+
+ private:
+  friend class CommandQueue;
+
+  enum class Kind : uint8_t { kAdd, kRemove, kDestroy };
+
+  struct Command {
+    Entity entity;
+    int type;
+    Kind kind;
+    // Component to add, or null once it has been moved into the world.
+    void* component;
+  };
+
+  World* world_;
+  std::vector<Command> commands_;
+  LinearArena components_;
+};
+
+// A `CommandBuffer` for each job pool worker and one for all other threads,
+// which must not record concurrently, played back together.
+class CommandQueue {
+ public:
+  CommandQueue(World* world, int num_workers);
+  CommandQueue(const CommandQueue&) = delete;
+  CommandQueue& operator=(const CommandQueue&) = delete;
+
+  // The buffer of the calling thread. Pool workers must be among the first
+  // `num_workers` of their pool.
+  CommandBuffer& local();
+
+  // Apply all recorded commands and clear the buffers. Must not run while
+  // anything else accesses the world.
+  //
+  // Commands are applied in the order they were recorded in each buffer, and
+  // in buffer order across buffers. All commands for an entity are folded so
+  // that it moves at most once, and moves are sorted by source and
+  // destination archetype so that consecutive moves touch the same chunks.
+  // Commands for entities that are no longer alive are dropped.
+  void playback();
+
+ private:
+  using Command = CommandBuffer::Command;
+
+  struct Move {
+    Entity entity;
+    uint32_t from;
+    uint32_t to;
+    bool destroy;
+    // Range of `adds_` to move into the entity after it has moved.
+    size_t adds_begin;
+    size_t adds_end;
+  };
+
+  void foldEntityCommands(Command** begin, Command** end);
+  void applyMove(const Move& move);
+
+  World* world_;
+  std::vector<std::unique_ptr<CommandBuffer>> buffers_;
+
+  // Scratch space reused across playbacks.
+  std::vector<Command*> commands_;
+  std::vector<Command*> adds_;
+  std::vector<Move> moves_;
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline size_t CommandBuffer::size() const { return commands_.size(); }
+
+template <typename... Ts>
+Entity CommandBuffer::create(Ts&&... components) {
+  Entity entity = world_->reserve();
+  const int expand[] = {0, (add(entity, std::forward<Ts>(components)), 0)...};
+  (void)expand;
+  return entity;
+}
+
+template <typename T>
+void CommandBuffer::add(Entity entity, T component) {
+  void* address = components_.allocate(sizeof(T), alignof(T));
+  new (address) T(std::move(component));
+  commands_.push_back(
+      Command{entity, ComponentTypeId<T>(), Kind::kAdd, address});
+}
+
+template <typename T>
+void CommandBuffer::remove(Entity entity) {
+  commands_.push_back(
+      Command{entity, ComponentTypeId<T>(), Kind::kRemove, nullptr});
+}
+
+}  // namespace y
+#endif  // GAMMA_ENGINE_COMMAND_BUFFER_HPP_
@@ -0,0 +1,180 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/command_buffer.hpp"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gamma/common/job_pool.hpp"
+#include "gamma/engine/scheduler.hpp"
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+struct Position {
+  float x;
+};
+
+struct Velocity {
+  float x;
+};
+
+struct Name {
+  std::string value;
+};
+
+TEST(CommandQueueTest, CreateIsDeferredUntilPlayback) {
+  World world;
+  CommandQueue commands(&world, 0);
+  Entity a = commands.local().create(Position{1}, Name{"a"});
+  Entity b = commands.local().create();
+  EXPECT_FALSE(world.alive(a));
+  EXPECT_EQ(world.size(), 0u);
+
+  commands.playback();
+  ASSERT_TRUE(world.alive(a));
+  ASSERT_TRUE(world.alive(b));
+  EXPECT_EQ(world.size(), 2u);
+  EXPECT_EQ(world.get<Position>(a)->x, 1);
+  EXPECT_EQ(world.get<Name>(a)->value, "a");
+  EXPECT_EQ(commands.local().size(), 0u);
+}
+
+TEST(CommandQueueTest, ReservedHandlesSurviveDirectCreation) {
+  World world;
+  CommandQueue commands(&world, 0);
+  Entity deferred = commands.local().create(Position{1});
+  Entity direct = world.create(Position{2});
+  EXPECT_NE(deferred.index, direct.index);
+
+  commands.playback();
+  EXPECT_EQ(world.get<Position>(deferred)->x, 1);
+  EXPECT_EQ(world.get<Position>(direct)->x, 2);
+}
+
+TEST(CommandQueueTest, FoldsCommandsPerEntity) {
+  World world;
+  Entity a = world.create(Position{1});
+  Entity b = world.create(Position{2}, Velocity{3});
+  Entity c = world.create(Name{"c"});
+  CommandQueue commands(&world, 0);
+  CommandBuffer& buffer = commands.local();
+
+  buffer.add(a, Velocity{10});
+  buffer.add(a, Velocity{11});
+  buffer.add(a, Name{"a"});
+  buffer.remove<Position>(a);
+  buffer.remove<Velocity>(b);
+  buffer.add(b, Position{20});
+  buffer.add(c, Name{"replaced"});
+  buffer.destroy(c);
+  buffer.add(c, Position{});
+
+  commands.playback();
+  EXPECT_FALSE(world.has<Position>(a));
+  EXPECT_EQ(world.get<Velocity>(a)->x, 11);
+  EXPECT_EQ(world.get<Name>(a)->value, "a");
+  EXPECT_EQ(world.get<Position>(b)->x, 20);
+  EXPECT_FALSE(world.has<Velocity>(b));
+  EXPECT_FALSE(world.alive(c));
+  EXPECT_EQ(world.size(), 2u);
+}
+
+TEST(CommandQueueTest, ReplacesNonTrivialComponentsInPlace) {
+  World world;
+  auto first = std::make_shared<int>(1);
+  auto second = std::make_shared<int>(2);
+  Entity entity = world.create(std::shared_ptr<int>(first));
+
+  CommandQueue commands(&world, 0);
+  commands.local().add(entity, std::shared_ptr<int>(second));
+  commands.playback();
+  EXPECT_EQ(first.use_count(), 1);
+  EXPECT_EQ(second.use_count(), 2);
+  EXPECT_EQ(world.get<std::shared_ptr<int>>(entity)->get(), second.get());
+}
+
+TEST(CommandQueueTest, DropsCommandsForDeadEntities) {
+  World world;
+  Entity entity = world.create(Position{});
+  world.destroy(entity);
+  auto pointer = std::make_shared<int>(0);
+
+  CommandQueue commands(&world, 0);
+  commands.local().add(entity, std::shared_ptr<int>(pointer));
+  commands.local().destroy(entity);
+  commands.playback();
+  EXPECT_EQ(world.size(), 0u);
+  EXPECT_EQ(pointer.use_count(), 1);
+}
+
+TEST(CommandQueueTest, UnplayedCommandsAreDestroyed) {
+  World world;
+  auto pointer = std::make_shared<int>(0);
+  {
+    CommandQueue commands(&world, 0);
+    commands.local().create(std::shared_ptr<int>(pointer));
+    EXPECT_EQ(pointer.use_count(), 2);
+  }
+  EXPECT_EQ(pointer.use_count(), 1);
+}
+
+TEST(CommandQueueTest, SchedulerPlaysBackAfterSystems) {
+  World world;
+  for (int i = 0; i < 10000; ++i) world.create(Position{float(i)});
+
+  JobPool pool(3);
+  SystemScheduler scheduler(&world, &pool);
+  CommandQueue* commands = &scheduler.commands();
+  scheduler.addQuerySystem<const Position>(
+      "split", [commands](const Query<const Position>::ChunkView& view) {
+        CommandBuffer& buffer = commands->local();
+        for (size_t i = 0; i < view.size(); ++i) {
+          if (int(view.get<const Position>()[i].x) % 2 == 0) {
+            buffer.add(view.entities()[i], Velocity{1});
+          } else {
+            buffer.create(Velocity{2});
+          }
+        }
+      },
+      1);
+  scheduler.run();
+
+  EXPECT_EQ(world.size(), 15000u);
+  EXPECT_EQ((world.query<Position, Velocity>().size()), 5000u);
+  EXPECT_EQ(world.query<Velocity>().size(), 10000u);
+}
+
+TEST(CommandQueueTest, WorkerWithoutBufferDies) {
+  World world;
+  CommandQueue commands(&world, 0);
+  EXPECT_DEATH_IF_SUPPORTED(
+      {
+        JobPool pool(1);
+        pool.schedule([&commands]() { commands.local(); });
+        for (;;) std::this_thread::yield();
+      },
+      "");
+}
+
+}  // namespace
+}  // namespace y
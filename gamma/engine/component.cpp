@@ -0,0 +1,60 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/component.hpp"
+
+#include "absl/synchronization/mutex.h"
+#include "gamma/common/log.hpp"
+
+namespace y {
+namespace {
+
+struct ComponentRegistry {
+  absl::Mutex mutex;
+  int size = 0;
+  ComponentInfo infos[kMaxComponentTypes];
+};
+
+ComponentRegistry& GetRegistry() {
+  static ComponentRegistry* registry = new ComponentRegistry();
+  return *registry;
+}
+
+}  // namespace
+
+// Infos are written once, before their id is handed out, so reads need no
+// lock.
+const ComponentInfo& GetComponentInfo(int id) {
+  return GetRegistry().infos[id];
+}
+
+}  // namespace y
+
+namespace y_internal {
+
+int RegisterComponentType(const y::ComponentInfo& info) {
+  y::ComponentRegistry& registry = y::GetRegistry();
+  absl::MutexLock lock(&registry.mutex);
+  YERR_IF(registry.size == y::kMaxComponentTypes)
+      << "too many component types";
+  int id = registry.size++;
+  registry.infos[id] = info;
+  return id;
+}
+
+}  // namespace y_internal
@@ -0,0 +1,118 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_ENGINE_COMPONENT_HPP_
+#define GAMMA_ENGINE_COMPONENT_HPP_
+
+#include <bitset>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace y {
+
+// Upper bound on the number of distinct component types in a program.
+constexpr int kMaxComponentTypes = 128;
+
+// The set of component types stored by an archetype, indexed by type id.
+using ComponentMask = std::bitset<kMaxComponentTypes>;
+
+// Type-erased operations on a component type, used to move components between
+// archetypes without knowing their static type.
+struct ComponentInfo {
+  size_t size;
+  size_t alignment;
+  // Components that are trivially copyable are moved with memcpy and are
+  // never destroyed.
+  bool trivially_copyable;
+  // Move-construct into `dst` from `src`, then destroy `src`.
+  void (*relocate)(void* dst, void* src);
+  void (*destroy)(void* component);
+  // Copy-construct into `dst` from `src`. Null if the type is not copy
+  // constructible.
+  void (*copy)(void* dst, const void* src);
+};
+
+// Dense id of component type `T`, assigned on first use. References and
+// cv-qualifiers are ignored. Components must be nothrow move constructible.
+template <typename T>
+int ComponentTypeId();
+
+const ComponentInfo& GetComponentInfo(int id);
+
+}  // namespace y
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+namespace y_internal {
+
+int RegisterComponentType(const y::ComponentInfo& info);
+
+template <typename T>
+void RelocateComponent(void* dst, void* src) {
+  T* from = static_cast<T*>(src);
+  new (dst) T(std::move(*from));
+  from->~T();
+}
+
+template <typename T>
+void DestroyComponent(void* component) {
+  static_cast<T*>(component)->~T();
+}
+
+template <typename T>
+void CopyComponent(void* dst, const void* src) {
+  new (dst) T(*static_cast<const T*>(src));
+}
+
+using CopyComponentFunction = void (*)(void*, const void*);
+
+template <typename T>
+CopyComponentFunction GetCopyComponent(std::true_type /* copyable */) {
+  return &CopyComponent<T>;
+}
+
+template <typename T>
+CopyComponentFunction GetCopyComponent(std::false_type /* copyable */) {
+  return nullptr;
+}
+
+template <typename T>
+int ComponentTypeIdImpl() {
+  static_assert(std::is_nothrow_move_constructible<T>::value,
+                "components must be nothrow move constructible");
+  static const int id = RegisterComponentType(y::ComponentInfo{
+      sizeof(T), alignof(T), std::is_trivially_copyable<T>::value,
+      &RelocateComponent<T>, &DestroyComponent<T>,
+      GetCopyComponent<T>(std::is_copy_constructible<T>())});
+  return id;
+}
+
+}  // namespace y_internal
+
+namespace y {
+
+template <typename T>
+int ComponentTypeId() {
+  return y_internal::ComponentTypeIdImpl<typename std::decay<T>::type>();
+}
+
+}  // namespace y
+#endif  // GAMMA_ENGINE_COMPONENT_HPP_
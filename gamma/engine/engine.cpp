@@ -18,39 +18,269 @@
 
 #include "gamma/engine/engine.hpp"
 
+#include <algorithm>
+#include <random>
+#include <thread>
+
 #include "absl/memory/memory.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "gamma/common/log.hpp"
 #include "gamma/common/watch.hpp"
+#include "gamma/engine/init.hpp"
 
 namespace y {
 namespace {
 
-const WindowSettings& GetWindowSettings(const EngineSettings& settings) {
+constexpr size_t kDefaultFrameArenaBytes = 1 << 20;
+
+size_t GetFrameArenaBytes(const EngineSettings& settings) {
+  return settings.frame_arena_bytes() > 0 ? settings.frame_arena_bytes()
+                                          : kDefaultFrameArenaBytes;
+}
+
+int GetNumWorkers(const EngineSettings& settings) {
+  if (settings.num_job_workers() > 0) {
+    return static_cast<int>(settings.num_job_workers());
+  }
+  return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+uint64_t MakeRandomSeed() {
+  std::random_device device;
+  return (uint64_t{device()} << 32) | device();
+}
+
+// Startup is timed from graphics initialization, when `Initialize()` has done
+// it for a windowed engine.
+absl::Time StartupOrigin(const EngineSettings& settings) {
+  absl::Time start, end;
+  y_internal::GetGraphicsInitializeSpan(&start, &end);
+  absl::Time now = absl::Now();
+  return settings.headless() ? now : std::min(start, now);
+}
+
+std::unique_ptr<Window> MakeWindow(const EngineSettings& settings,
+                                   Timeline* timeline) {
+  if (settings.headless()) return nullptr;
   YERR_IF(!settings.has_window_settings());
-  return settings.window_settings();
+  return absl::make_unique<Window>(settings.window_settings(), timeline);
 }
 
 }  // namespace
 
 Engine::Engine(const EngineSettings& settings)
-    : window_(GetWindowSettings(settings)), should_exit_loop_(false) {}
+    : Engine(settings, std::vector<StartupTask>()) {}
+
+Engine::Engine(const EngineSettings& settings,
+               std::vector<StartupTask> startup_tasks)
+    : startup_timeline_(StartupOrigin(settings)),
+      fixed_timestep_(absl::Microseconds(settings.fixed_timestep_us())),
+      max_frames_(settings.max_frames()),
+      pipelined_(settings.pipelined()),
+      should_exit_loop_(false),
+      frame_arena_(GetFrameArenaBytes(settings), GetNumWorkers(settings)),
+      job_pool_(GetNumWorkers(settings)) {
+  YERR_IF(fixed_timestep_ < absl::ZeroDuration());
+  YERR_IF(!settings.record_path().empty() && !settings.replay_path().empty())
+      << "cannot record and replay at the same time";
+
+  if (!settings.headless()) {
+    absl::Time start, end;
+    y_internal::GetGraphicsInitializeSpan(&start, &end);
+    if (end < absl::InfiniteFuture()) {
+      startup_timeline_.record("glfw init", start, end);
+    }
+  }
+
+  // Window and graphics context creation stays on this thread, since GLFW
+  // requires it, and the startup tasks overlap with it. The window and each
+  // part of the context get their own span.
+  JobGroup startup_group;
+  for (StartupTask& task : startup_tasks) {
+    StartupTask* startup_task = &task;
+    job_pool_.schedule(&startup_group, [this, startup_task]() {
+      Timeline::Scope scope(&startup_timeline_, startup_task->name);
+      startup_task->run();
+    });
+  }
+  window_ = MakeWindow(settings, &startup_timeline_);
+
+  if (!settings.replay_path().empty()) {
+    replay_ = absl::make_unique<ReplayReader>(settings.replay_path());
+    random_seed_ = replay_->seed();
+  } else {
+    random_seed_ = settings.random_seed() != 0 ? settings.random_seed()
+                                               : MakeRandomSeed();
+  }
+
+  if (!settings.record_path().empty()) {
+    recorder_ =
+        absl::make_unique<ReplayWriter>(settings.record_path(), random_seed_);
+    subscribe<InputEvent>([this](absl::Span<const InputEvent> events) {
+      frame_input_.insert(frame_input_.end(), events.begin(), events.end());
+    });
+  }
+
+  job_pool_.wait(&startup_group);
+}
 
 void Engine::runMainLoop() {
+  if (pipelined()) {
+    runPipelinedLoop();
+  } else {
+    absl::Time start = absl::Now();
+    Watch watch;
+    for (uint64_t frame = 0; !shouldExitLoop(frame); ++frame) {
+      simulate(nextTimestep(&watch));
+      if (!headless()) render();
+      if (frame == 0) finishStartup(start);
+    }
+  }
+  YLOG << "frame arena high-water mark: " << frame_arena_.highWaterMark()
+       << " bytes";
+}
+
+bool Engine::shouldExitLoop(uint64_t frame) const {
+  if (should_exit_loop_.load(std::memory_order_relaxed)) return true;
+  return max_frames_ > 0 && frame >= max_frames_;
+}
+
+absl::Duration Engine::nextTimestep(Watch* watch) const {
+  absl::Duration dt = watch->lap();
+  return fixed_timestep_ > absl::ZeroDuration() ? fixed_timestep_ : dt;
+}
+
+void Engine::simulate(absl::Duration dt) {
+  frame_arena_.beginFrame();
+
+  frame_input_.clear();
+  if (replay_ != nullptr) {
+    if (!replay_->readFrame(&dt, &frame_input_)) {
+      signalLoopExit();
+      return;
+    }
+    for (const InputEvent& event : frame_input_) event_bus_.post(event);
+  }
+
+  event_bus_.dispatch();
+  if (recorder_ != nullptr) recorder_->writeFrame(dt, frame_input_);
+  function_queue_.update(dt);
+}
+
+void Engine::render() {
+  absl::SleepFor(absl::Milliseconds(16));
+  window_->display();
+  pollInput();
+  if (window_->shouldClose()) signalLoopExit();
+}
+
+// Window input is delivered through the event bus on the next simulated frame,
+// unless a recording is being replayed, in which case it is ignored.
+void Engine::pollInput() {
+  Window::PollEvents();
+  window_->takeInputEvents(&polled_input_);
+  if (replay_ != nullptr) return;
+  for (const InputEvent& event : polled_input_) event_bus_.post(event);
+}
+
+// Rendering and event polling stay on the calling thread, since GLFW requires
+// them to happen on the main thread, while simulation moves to a new thread.
+void Engine::runPipelinedLoop() {
+  absl::Time start = absl::Now();
+  absl::Duration total_latency;
+  pipeline_stats_ = PipelineStats();
+
+  std::thread simulation_thread([this]() { runSimulationThread(); });
+  while (acquireSnapshot()) {
+    render();
+    absl::Duration latency = absl::Now() - snapshots_.front().published;
+    total_latency += latency;
+    pipeline_stats_.max_latency =
+        std::max(pipeline_stats_.max_latency, latency);
+    if (pipeline_stats_.frames == 0) finishStartup(start);
+    ++pipeline_stats_.frames;
+  }
+  simulation_thread.join();
+
+  pipeline_stats_.wall_time = absl::Now() - start;
+  if (pipeline_stats_.frames > 0) {
+    pipeline_stats_.mean_latency = total_latency / pipeline_stats_.frames;
+  }
+  YLOG << "pipelined loop: " << pipeline_stats_.frames << " frames in "
+       << absl::FormatDuration(pipeline_stats_.wall_time)
+       << ", mean latency "
+       << absl::FormatDuration(pipeline_stats_.mean_latency)
+       << ", max latency " << absl::FormatDuration(pipeline_stats_.max_latency);
+}
+
+void Engine::runSimulationThread() {
   Watch watch;
-  while (!should_exit_loop_.load(std::memory_order_relaxed) &&
-         !window_.shouldClose()) {
-    absl::Duration dt = watch.lap();
-    function_queue_.update(dt);
-    absl::SleepFor(absl::Milliseconds(16));
-    window_.display();
-    Window::PollEvents();
+  absl::Duration simulation_time;
+  for (uint64_t frame = 0; !shouldExitLoop(frame); ++frame) {
+    absl::Duration dt = nextTimestep(&watch);
+    simulate(dt);
+    simulation_time += dt;
+
+    RenderSnapshot& snapshot = snapshots_.back();
+    snapshot.frame = frame;
+    snapshot.simulation_time = simulation_time;
+    snapshot.published = absl::Now();
+    snapshots_.publish();
+
+    absl::MutexLock lock(&handoff_mutex_);
+    ++snapshots_published_;
+    handoff_mutex_.Await(
+        absl::Condition(this, &Engine::snapshotConsumedOrExiting));
+  }
+  absl::MutexLock lock(&handoff_mutex_);
+  simulation_finished_ = true;
+}
+
+// Blocks until there is a new snapshot to render. Returns false once
+// simulation has finished and every snapshot has been rendered.
+bool Engine::acquireSnapshot() {
+  absl::MutexLock lock(&handoff_mutex_);
+  handoff_mutex_.Await(
+      absl::Condition(this, &Engine::snapshotPendingOrFinished));
+  if (!snapshots_.acquire()) return false;
+  snapshots_consumed_ = snapshots_published_;
+  return true;
+}
+
+bool Engine::snapshotPendingOrFinished() const {
+  return snapshots_published_ > snapshots_consumed_ || simulation_finished_;
+}
+
+bool Engine::snapshotConsumedOrExiting() const {
+  return snapshots_consumed_ == snapshots_published_ ||
+         should_exit_loop_.load(std::memory_order_relaxed);
+}
+
+// The timeline ends once the first frame has been simulated and displayed,
+// so its total is the time to first frame.
+void Engine::finishStartup(absl::Time loop_start) {
+  startup_timeline_.record("first frame", loop_start, absl::Now());
+  YLOG << "startup timeline:\n" << startup_timeline_.report();
+}
+
+void Engine::hotReload(const std::string& path,
+                       Function<Function<void()>(const std::string&)> load) {
+  if (file_watcher_ == nullptr) {
+    file_watcher_ = absl::make_unique<FileWatcher>();
   }
+  hot_reloads_.push_back(HotReload{path, std::move(load)});
+  HotReload* reload = &hot_reloads_.back();
+  file_watcher_->watch(path, [this, reload]() {
+    Function<void()> swap = reload->load(reload->path);
+    if (swap) setTimeout(std::move(swap), absl::ZeroDuration());
+  });
 }
 
 void Engine::signalLoopExit() {
   should_exit_loop_.store(true, std::memory_order_relaxed);
+  // Wake the pipelined loop threads so they can observe the exit request.
+  absl::MutexLock lock(&handoff_mutex_);
 }
 
 }  // namespace y
@@ -20,9 +20,27 @@
 #define GAMMA_ENGINE_ENGINE_HPP_
 
 #include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
 
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "gamma/common/event_bus.hpp"
+#include "gamma/common/file_watcher.hpp"
+#include "gamma/common/frame_arena.hpp"
 #include "gamma/common/function_queue.hpp"
+#include "gamma/common/job_pool.hpp"
+#include "gamma/common/timeline.hpp"
+#include "gamma/common/triple_buffer.hpp"
+#include "gamma/common/watch.hpp"
 #include "gamma/engine/engine_settings.pb.h"
+#include "gamma/engine/render_snapshot.hpp"
+#include "gamma/engine/replay.hpp"
+#include "gamma/graphics/input.hpp"
 #include "gamma/graphics/vk/glfw.hpp"
 #include "gamma/graphics/window.hpp"
 
@@ -30,30 +48,171 @@ namespace y {
 
 class Engine {
  public:
-  enum class Event {};
+  // Measurements of the last pipelined `runMainLoop()`.
+  struct PipelineStats {
+    uint64_t frames = 0;
+    absl::Duration wall_time;
+    // Time from a snapshot being published to its frame being displayed.
+    absl::Duration mean_latency;
+    absl::Duration max_latency;
+  };
 
+  // Independent work, such as compiling shaders, loading scripts or indexing
+  // assets, that runs on job workers while the engine creates its window and
+  // graphics context.
+  struct StartupTask {
+    std::string name;
+    Function<void()> run;
+  };
+
+  // In headless mode no window or graphics context is created and
+  // `InitializeGraphics()` does not need to have been called.
   explicit Engine(const EngineSettings& settings);
 
+  // Returns once all `startup_tasks` have finished. Each task's duration is
+  // recorded in the startup timeline, which is logged after the first frame.
+  Engine(const EngineSettings& settings,
+         std::vector<StartupTask> startup_tasks);
+
   void runMainLoop();
 
   void signalLoopExit();
 
-  // void setEventCallback(Event event, Function f);
+  bool headless() const;
+
+  bool pipelined() const;
+
+  const PipelineStats& pipelineStats() const;
+
+  // Seed for gameplay randomness. Recordings store it and replays restore it,
+  // so that replayed runs are reproducible.
+  uint64_t randomSeed() const;
+
+  // Post an event of any type from any thread. It is delivered to subscribers
+  // at the start of the next simulated frame.
+  template <typename T>
+  void postEvent(T event);
+
+  // Register `f` to receive, once per frame on the simulation thread, all
+  // events of type `T` posted since the previous frame. Must be called before
+  // `runMainLoop()` or from the simulation thread.
+  template <typename T>
+  void subscribe(Function<void(absl::Span<const T>)> f);
 
   void setTimeout(Function<void()> f, absl::Duration delay);
 
+  // Reload an asset whenever the file at `path` changes on disk.
+  //
+  // Once changes settle, `load` is called with `path` on a background thread
+  // to do the expensive work, e.g. `CompileGLSLFile()` or `LuaCompileFile()`.
+  // It returns a function that swaps the result in, which runs on the
+  // simulation thread at the start of the next frame, or an empty function to
+  // skip the reload and keep the current asset, e.g. when those compile
+  // functions log an error and return an empty result. The main loop never
+  // waits for a reload. Must not be called from within `load`.
+  void hotReload(const std::string& path,
+                 Function<Function<void()>(const std::string&)> load);
+
+  // Scratch memory for the current frame, reset at the start of every frame
+  // after next. Only use from the simulation thread and job workers.
+  FrameArena& frameArena();
+
+  // Workers for parallel simulation work. Jobs get their scratch arena with
+  // `frameArena().local()`.
+  JobPool& jobPool();
+
+  // Graphics initialization, construction steps, startup tasks and the first
+  // frame, timed from the start of `Initialize()` for windowed engines and
+  // from the start of construction for headless ones.
+  const Timeline& startupTimeline() const;
+
  private:
-  Window window_;
+  bool shouldExitLoop(uint64_t frame) const;
+  absl::Duration nextTimestep(Watch* watch) const;
+  void simulate(absl::Duration dt);
+  void render();
+  void pollInput();
+
+  void runPipelinedLoop();
+  void runSimulationThread();
+  bool acquireSnapshot();
+  bool snapshotPendingOrFinished() const;
+  bool snapshotConsumedOrExiting() const;
+  void finishStartup(absl::Time loop_start);
+
+  Timeline startup_timeline_;
+  std::unique_ptr<Window> window_;
+  absl::Duration fixed_timestep_;
+  uint64_t max_frames_;
+  bool pipelined_;
   std::atomic<bool> should_exit_loop_;
   FunctionQueue function_queue_;
+  EventBus event_bus_;
+  FrameArena frame_arena_;
+
+  uint64_t random_seed_;
+  std::unique_ptr<ReplayWriter> recorder_;
+  std::unique_ptr<ReplayReader> replay_;
+  // Input delivered in the current frame, used only by the simulation thread.
+  std::vector<InputEvent> frame_input_;
+  // Input received from the window, used only by the rendering thread.
+  std::vector<InputEvent> polled_input_;
+
+  struct HotReload {
+    std::string path;
+    Function<Function<void()>(const std::string&)> load;
+  };
+  // A deque keeps elements in place, so the watcher thread can hold on to them.
+  std::deque<HotReload> hot_reloads_;
+  std::unique_ptr<FileWatcher> file_watcher_;
+
+  // Pipelined loop handoff. At most one published snapshot is waiting to be
+  // rendered at any time, so simulation runs at most one frame ahead.
+  TripleBuffer<RenderSnapshot> snapshots_;
+  absl::Mutex handoff_mutex_;
+  uint64_t snapshots_published_ = 0;
+  uint64_t snapshots_consumed_ = 0;
+  bool simulation_finished_ = false;
+  PipelineStats pipeline_stats_;
+
+  // Last, so that it is destroyed first and no job outlives the state it uses.
+  JobPool job_pool_;
 };
 
 // -----------------------------------------------------------------------------
 //                      Implementation Details Follow
 
+inline bool Engine::headless() const { return window_ == nullptr; }
+
+inline bool Engine::pipelined() const { return pipelined_ && !headless(); }
+
+inline const Engine::PipelineStats& Engine::pipelineStats() const {
+  return pipeline_stats_;
+}
+
+inline uint64_t Engine::randomSeed() const { return random_seed_; }
+
+template <typename T>
+void Engine::postEvent(T event) {
+  event_bus_.post(std::move(event));
+}
+
+template <typename T>
+void Engine::subscribe(Function<void(absl::Span<const T>)> f) {
+  event_bus_.subscribe<T>(std::move(f));
+}
+
 inline void Engine::setTimeout(Function<void()> f, absl::Duration delay) {
   function_queue_.setTimeout(std::move(f), delay);
 }
 
+inline FrameArena& Engine::frameArena() { return frame_arena_; }
+
+inline JobPool& Engine::jobPool() { return job_pool_; }
+
+inline const Timeline& Engine::startupTimeline() const {
+  return startup_timeline_;
+}
+
 }  // namespace y
 #endif  // GAMMA_ENGINE_ENGINE_HPP_
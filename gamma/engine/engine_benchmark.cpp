@@ -0,0 +1,341 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+// Runs the engine main loop headlessly under synthetic load and prints
+// frame time statistics as a single JSON object, for comparing commits.
+//
+// Flags, all optional:
+//   --frames=N         frames to run (default 2000)
+//   --warmup_frames=N  frames to run before measuring (default 100)
+//   --timers=N         timers re-armed every frame (default 256)
+//   --lua_callbacks=N  Lua function calls per frame (default 256)
+//   --jobs=N           jobs fanned out to the job pool per frame (default 64)
+//   --job_work=N       loop iterations per job (default 2000)
+//   --workers=N        job pool workers (default: one per hardware thread)
+//   --output=PATH      write the JSON here instead of stdout
+//
+// Engine logs also go to stdout, where the JSON is always the last line.
+//
+// `allocations_per_frame` counts calls to the replaceable C++ operator new,
+// including its array and aligned forms, on any thread; direct malloc calls
+// are not counted. `lua_allocations_per_frame` counts allocations and resizes
+// by the Lua allocator of the benchmark's Lua state.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gamma/common/log.hpp"
+#include "gamma/engine/engine.hpp"
+#include "gamma/engine/engine_settings.pb.h"
+#include "gamma/engine/init.hpp"
+#include "gamma/scripting/lua/call.hpp"
+#include "gamma/scripting/lua/function.hpp"
+#include "gamma/scripting/lua/run.hpp"
+#include "gamma/scripting/lua/state.hpp"
+
+namespace {
+
+std::atomic<uint64_t> allocation_count(0);
+
+}  // namespace
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* p = std::malloc(size != 0 ? size : 1);
+  if (p == nullptr) std::abort();
+  return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  // aligned_alloc() takes a nonzero multiple of the alignment.
+  size_t align = static_cast<size_t>(alignment);
+  size_t rounded = (std::max<size_t>(size, 1) + align - 1) / align * align;
+  void* p = std::aligned_alloc(align, rounded);
+  if (p == nullptr) std::abort();
+  return p;
+}
+
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+#endif  // __cpp_aligned_new
+
+namespace y {
+namespace {
+
+struct Options {
+  uint64_t frames = 2000;
+  uint64_t warmup_frames = 100;
+  uint64_t timers = 256;
+  uint64_t lua_callbacks = 256;
+  uint64_t jobs = 64;
+  uint64_t job_work = 2000;
+  uint64_t workers = 0;
+  std::string output;
+};
+
+Options ParseOptions(int argc, char** argv) {
+  Options options;
+  struct {
+    const char* name;
+    uint64_t* value;
+  } const numeric[] = {
+      {"frames", &options.frames},
+      {"warmup_frames", &options.warmup_frames},
+      {"timers", &options.timers},
+      {"lua_callbacks", &options.lua_callbacks},
+      {"jobs", &options.jobs},
+      {"job_work", &options.job_work},
+      {"workers", &options.workers},
+  };
+
+  for (int i = 1; i < argc; ++i) {
+    absl::string_view arg = argv[i];
+    YERR_IF(!absl::ConsumePrefix(&arg, "--")) << "unexpected argument " << arg;
+    size_t equals = arg.find('=');
+    YERR_IF(equals == absl::string_view::npos) << "expected --name=value";
+    absl::string_view name = arg.substr(0, equals);
+    absl::string_view value = arg.substr(equals + 1);
+
+    if (name == "output") {
+      options.output = std::string(value);
+      continue;
+    }
+    bool found = false;
+    for (const auto& flag : numeric) {
+      if (name != flag.name) continue;
+      YERR_IF(!absl::SimpleAtoi(value, flag.value))
+          << "invalid value for --" << name;
+      found = true;
+    }
+    YERR_IF(!found) << "unknown flag --" << name;
+  }
+  YERR_IF(options.frames == 0);
+  return options;
+}
+
+// Integer busy work that the compiler cannot remove.
+uint64_t Spin(uint64_t seed, uint64_t iterations) {
+  uint64_t x = seed | 1;
+  for (uint64_t i = 0; i < iterations; ++i) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+  }
+  return x;
+}
+
+class Benchmark {
+ public:
+  Benchmark(const Options& options, Engine* engine);
+
+  // Called once per frame by a re-arming timer.
+  void onFrame();
+
+  std::string json() const;
+
+ private:
+  // Wraps the allocator of `lua_` to count its allocations.
+  struct LuaAllocator {
+    lua_Alloc alloc = nullptr;
+    void* ud = nullptr;
+    uint64_t count = 0;
+  };
+  static void* CountLuaAllocation(void* ud, void* ptr, size_t old_size,
+                                  size_t new_size);
+
+  void armTimer(uint64_t* counter);
+  void runLuaCallbacks();
+  void runJobs();
+
+  const Options& options_;
+  Engine* engine_;
+  // Outlives `lua_`, which frees through it on close.
+  LuaAllocator lua_allocator_;
+  LuaState lua_;
+  LuaFunction lua_on_frame_;
+  std::vector<uint64_t> timer_counters_;
+  std::atomic<uint64_t> job_result_;
+
+  uint64_t frame_ = 0;
+  absl::Time last_frame_;
+  absl::Time measure_start_;
+  absl::Time measure_end_;
+  uint64_t measure_start_allocations_ = 0;
+  uint64_t measure_end_allocations_ = 0;
+  uint64_t measure_start_lua_allocations_ = 0;
+  uint64_t measure_end_lua_allocations_ = 0;
+  std::vector<absl::Duration> frame_times_;
+};
+
+Benchmark::Benchmark(const Options& options, Engine* engine)
+    : options_(options),
+      engine_(engine),
+      lua_(LuaState::Open()),
+      timer_counters_(options.timers),
+      job_result_(0) {
+  lua_State* L = lua_.get();
+  lua_allocator_.alloc = lua_getallocf(L, &lua_allocator_.ud);
+  lua_setallocf(L, &CountLuaAllocation, &lua_allocator_);
+  LuaRunSource(L, "engine_benchmark",
+               "total = 0\n"
+               "function on_frame(dt) total = total + dt end\n");
+  lua_getglobal(L, "on_frame");
+  lua_on_frame_ = LuaFunction(L);
+
+  for (uint64_t& counter : timer_counters_) armTimer(&counter);
+  frame_times_.reserve(options.frames);
+  last_frame_ = absl::Now();
+  engine_->setTimeout([this]() { onFrame(); }, absl::ZeroDuration());
+}
+
+void* Benchmark::CountLuaAllocation(void* ud, void* ptr, size_t old_size,
+                                    size_t new_size) {
+  LuaAllocator* allocator = static_cast<LuaAllocator*>(ud);
+  if (new_size != 0) ++allocator->count;
+  return allocator->alloc(allocator->ud, ptr, old_size, new_size);
+}
+
+void Benchmark::armTimer(uint64_t* counter) {
+  engine_->setTimeout(
+      [this, counter]() {
+        ++*counter;
+        armTimer(counter);
+      },
+      absl::ZeroDuration());
+}
+
+void Benchmark::runLuaCallbacks() {
+  lua_State* L = lua_.get();
+  for (uint64_t i = 0; i < options_.lua_callbacks; ++i) {
+    lua_on_frame_.push();
+    lua_pushnumber(L, 1.0 / 60.0);
+    LuaPCall(L, 1);
+  }
+}
+
+void Benchmark::runJobs() {
+  engine_->jobPool().parallelFor(options_.jobs, 1, [this](size_t begin,
+                                                          size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      job_result_.fetch_xor(Spin(i, options_.job_work),
+                            std::memory_order_relaxed);
+    }
+  });
+}
+
+void Benchmark::onFrame() {
+  runLuaCallbacks();
+  runJobs();
+
+  absl::Time now = absl::Now();
+  if (frame_ == options_.warmup_frames) {
+    measure_start_ = now;
+    measure_start_allocations_ = allocation_count.load();
+    measure_start_lua_allocations_ = lua_allocator_.count;
+  } else if (frame_ > options_.warmup_frames) {
+    frame_times_.push_back(now - last_frame_);
+  }
+  last_frame_ = now;
+
+  ++frame_;
+  if (frame_times_.size() == options_.frames) {
+    measure_end_ = now;
+    measure_end_allocations_ = allocation_count.load();
+    measure_end_lua_allocations_ = lua_allocator_.count;
+    engine_->signalLoopExit();
+    return;
+  }
+  engine_->setTimeout([this]() { onFrame(); }, absl::ZeroDuration());
+}
+
+std::string Benchmark::json() const {
+  std::vector<absl::Duration> sorted = frame_times_;
+  std::sort(sorted.begin(), sorted.end());
+  auto percentile = [&sorted](double p) {
+    size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return absl::ToDoubleMilliseconds(sorted[i]);
+  };
+
+  double frames = static_cast<double>(frame_times_.size());
+  absl::Duration wall_time = measure_end_ - measure_start_;
+  return absl::StrFormat(
+      "{\"frames\": %d, \"timers\": %d, \"lua_callbacks\": %d, "
+      "\"jobs\": %d, \"job_work\": %d, \"workers\": %d, "
+      "\"wall_seconds\": %.6f, \"fps\": %.3f, "
+      "\"frame_ms\": {\"mean\": %.6f, \"p50\": %.6f, \"p99\": %.6f, "
+      "\"max\": %.6f}, \"allocations_per_frame\": %.3f, "
+      "\"lua_allocations_per_frame\": %.3f}\n",
+      frame_times_.size(), options_.timers, options_.lua_callbacks,
+      options_.jobs, options_.job_work, engine_->jobPool().numWorkers(),
+      absl::ToDoubleSeconds(wall_time),
+      frames / absl::ToDoubleSeconds(wall_time),
+      absl::ToDoubleMilliseconds(wall_time) / frames, percentile(0.5),
+      percentile(0.99), absl::ToDoubleMilliseconds(sorted.back()),
+      (measure_end_allocations_ - measure_start_allocations_) / frames,
+      (measure_end_lua_allocations_ - measure_start_lua_allocations_) /
+          frames);
+}
+
+}  // namespace
+}  // namespace y
+
+int main(int argc, char** argv) {
+  y::Options options = y::ParseOptions(argc, argv);
+
+  y::EngineSettings settings;
+  settings.set_headless(true);
+  settings.set_fixed_timestep_us(16667);
+  settings.set_num_job_workers(static_cast<uint32_t>(options.workers));
+
+  y::Initialize(settings);
+  y::Engine engine(settings);
+  y::Benchmark benchmark(options, &engine);
+  engine.runMainLoop();
+
+  std::string json = benchmark.json();
+  if (options.output.empty()) {
+    std::fputs(json.c_str(), stdout);
+  } else {
+    FILE* file = std::fopen(options.output.c_str(), "w");
+    YERR_IF(file == nullptr) << "failed to open " << options.output;
+    std::fputs(json.c_str(), file);
+    std::fclose(file);
+  }
+  return 0;
+}
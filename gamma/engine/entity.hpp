@@ -0,0 +1,42 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_ENGINE_ENTITY_HPP_
+#define GAMMA_ENGINE_ENTITY_HPP_
+
+#include <cstdint>
+
+namespace y {
+
+// Handle to an entity in a `World`. The index identifies a slot that is reused
+// after the entity is destroyed, and the generation tells apart the entities
+// that have used the slot, so stale handles are detected rather than aliasing
+// a newer entity. A default constructed handle never refers to an entity.
+struct Entity {
+  uint32_t index = 0;
+  uint32_t generation = 0;
+};
+
+inline bool operator==(const Entity& a, const Entity& b) {
+  return a.index == b.index && a.generation == b.generation;
+}
+
+inline bool operator!=(const Entity& a, const Entity& b) { return !(a == b); }
+
+}  // namespace y
+#endif  // GAMMA_ENGINE_ENTITY_HPP_
@@ -18,10 +18,34 @@
 
 #include "gamma/engine/init.hpp"
 
+#include "absl/time/clock.h"
 #include "gamma/graphics/init.hpp"
 
 namespace y {
+namespace {
 
-void Initialize() { InitializeGraphics(); }
+absl::Time graphics_start = absl::InfiniteFuture();
+absl::Time graphics_end = absl::InfiniteFuture();
+
+}  // namespace
+
+void Initialize() {
+  graphics_start = absl::Now();
+  InitializeGraphics();
+  graphics_end = absl::Now();
+}
+
+void Initialize(const EngineSettings& settings) {
+  if (!settings.headless()) Initialize();
+}
 
 }  // namespace y
+
+namespace y_internal {
+
+void GetGraphicsInitializeSpan(absl::Time* start, absl::Time* end) {
+  *start = y::graphics_start;
+  *end = y::graphics_end;
+}
+
+}  // namespace y_internal
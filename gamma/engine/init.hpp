@@ -19,9 +19,24 @@
 #ifndef GAMMA_ENGINE_INIT_HPP_
 #define GAMMA_ENGINE_INIT_HPP_
 
+#include "absl/time/time.h"
+#include "gamma/engine/engine_settings.pb.h"
+
 namespace y {
 
 void Initialize();
 
+// Same as `Initialize()`, but skips initializing graphics for headless engines.
+void Initialize(const EngineSettings& settings);
+
 }  // namespace y
+
+namespace y_internal {
+
+// When the last call to `y::Initialize()` started and finished initializing
+// graphics, for the startup timeline of the engine created next. Both are
+// `absl::InfiniteFuture()` if graphics have not been initialized.
+void GetGraphicsInitializeSpan(absl::Time* start, absl::Time* end);
+
+}  // namespace y_internal
 #endif  // GAMMA_ENGINE_INIT_HPP_
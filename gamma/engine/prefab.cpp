@@ -0,0 +1,115 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/prefab.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace y {
+namespace {
+
+size_t AlignUp(size_t offset, size_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+Prefab::Prefab(Prefab&& other) noexcept
+    : mask_(other.mask_),
+      entries_(std::move(other.entries_)),
+      data_(other.data_) {
+  other.mask_.reset();
+  other.entries_.clear();
+  other.data_ = nullptr;
+}
+
+Prefab& Prefab::operator=(Prefab&& other) noexcept {
+  if (this != &other) {
+    clear();
+    mask_ = other.mask_;
+    entries_ = std::move(other.entries_);
+    data_ = other.data_;
+    other.mask_.reset();
+    other.entries_.clear();
+    other.data_ = nullptr;
+  }
+  return *this;
+}
+
+Prefab::~Prefab() { clear(); }
+
+const void* Prefab::component(int type) const {
+  for (const Entry& entry : entries_) {
+    if (entry.type == type) return data_ + entry.offset;
+  }
+  return nullptr;
+}
+
+void Prefab::copyTo(int type, void* components, size_t count) const {
+  const ComponentInfo& info = GetComponentInfo(type);
+  const void* prototype = component(type);
+  YERR_IF(prototype == nullptr) << "component type is not part of the prefab";
+  auto* bytes = static_cast<uint8_t*>(components);
+  if (!info.trivially_copyable) {
+    for (size_t i = 0; i < count; ++i) {
+      info.copy(bytes + i * info.size, prototype);
+    }
+    return;
+  }
+  if (count == 0) return;
+  // Doubling the copied prefix keeps the number of memcpy calls logarithmic.
+  std::memcpy(bytes, prototype, info.size);
+  for (size_t copied = 1; copied < count;) {
+    size_t n = std::min(copied, count - copied);
+    std::memcpy(bytes + copied * info.size, bytes, n * info.size);
+    copied += n;
+  }
+}
+
+void Prefab::allocate(const int* types, size_t num_types) {
+  size_t size = 0;
+  size_t alignment = alignof(void*);
+  for (size_t i = 0; i < num_types; ++i) {
+    const ComponentInfo& info = GetComponentInfo(types[i]);
+    YERR_IF(mask_[types[i]]) << "duplicate component type";
+    mask_.set(types[i]);
+    size = AlignUp(size, info.alignment);
+    entries_.push_back(Entry{types[i], size});
+    size += info.size;
+    alignment = std::max(alignment, info.alignment);
+  }
+  void* data = nullptr;
+  YERR_IF(posix_memalign(&data, alignment, std::max<size_t>(size, 1)) != 0)
+      << "failed to allocate prefab";
+  data_ = static_cast<uint8_t*>(data);
+}
+
+void Prefab::clear() {
+  for (const Entry& entry : entries_) {
+    const ComponentInfo& info = GetComponentInfo(entry.type);
+    if (!info.trivially_copyable) info.destroy(data_ + entry.offset);
+  }
+  entries_.clear();
+  mask_.reset();
+  std::free(data_);
+  data_ = nullptr;
+}
+
+}  // namespace y
@@ -0,0 +1,117 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_ENGINE_PREFAB_HPP_
+#define GAMMA_ENGINE_PREFAB_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "gamma/common/log.hpp"
+#include "gamma/engine/component.hpp"
+
+namespace y {
+
+// A set of default components from which `World::instantiate()` creates
+// entities in bulk.
+//
+// Components are stored once, packed in a single allocation. Trivially
+// copyable ones are copied into new entities with memcpy, and others are
+// copy-constructed, so every component type must be copy constructible.
+class Prefab {
+ public:
+  // Components must be of distinct types.
+  template <typename... Ts>
+  explicit Prefab(Ts... components);
+  Prefab(Prefab&& other) noexcept;
+  Prefab& operator=(Prefab&& other) noexcept;
+  Prefab(const Prefab&) = delete;
+  Prefab& operator=(const Prefab&) = delete;
+  ~Prefab();
+
+  const ComponentMask& mask() const;
+
+  // The default component of type `type`, or null.
+  const void* component(int type) const;
+
+  // The default component of type `T`, or null. Changing it affects entities
+  // instantiated afterwards.
+  template <typename T>
+  T* get();
+
+  // Copy the default component of type `type` into the array `components` of
+  // length `count`, which is uninitialized.
+  void copyTo(int type, void* components, size_t count) const;
+
+ private:
+  struct Entry {
+    int type;
+    size_t offset;
+  };
+
+  void allocate(const int* types, size_t num_types);
+  void clear();
+
+  ComponentMask mask_;
+  std::vector<Entry> entries_;
+  uint8_t* data_ = nullptr;
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+}  // namespace y
+
+namespace y_internal {
+
+template <bool...>
+struct BoolPack;
+
+template <bool... Bs>
+using AllTrue = std::is_same<BoolPack<true, Bs...>, BoolPack<Bs..., true>>;
+
+}  // namespace y_internal
+
+namespace y {
+
+template <typename... Ts>
+Prefab::Prefab(Ts... components) {
+  static_assert(
+      y_internal::AllTrue<std::is_copy_constructible<Ts>::value...>::value,
+      "prefab components must be copy constructible");
+  const int types[] = {0, ComponentTypeId<Ts>()...};
+  allocate(types + 1, sizeof...(Ts));
+  size_t i = 0;
+  const int expand[] = {
+      0, (new (data_ + entries_[i++].offset) Ts(std::move(components)), 0)...};
+  (void)expand;
+}
+
+inline const ComponentMask& Prefab::mask() const { return mask_; }
+
+template <typename T>
+T* Prefab::get() {
+  return static_cast<T*>(const_cast<void*>(component(ComponentTypeId<T>())));
+}
+
+}  // namespace y
+#endif  // GAMMA_ENGINE_PREFAB_HPP_
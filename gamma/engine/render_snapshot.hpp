@@ -0,0 +1,41 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_ENGINE_RENDER_SNAPSHOT_HPP_
+#define GAMMA_ENGINE_RENDER_SNAPSHOT_HPP_
+
+#include <cstdint>
+
+#include "absl/time/time.h"
+
+namespace y {
+
+// Immutable result of one simulation frame, handed from the simulation to the
+// renderer. The renderer must only read state through a snapshot, never from
+// live simulation objects, since in the pipelined main loop simulation of the
+// next frame runs concurrently with rendering.
+struct RenderSnapshot {
+  uint64_t frame = 0;
+  // Total simulated time at the end of `frame`.
+  absl::Duration simulation_time;
+  // Wall time at which the snapshot was handed off, for latency reporting.
+  absl::Time published;
+};
+
+}  // namespace y
+#endif  // GAMMA_ENGINE_RENDER_SNAPSHOT_HPP_
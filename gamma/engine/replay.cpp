@@ -0,0 +1,163 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/replay.hpp"
+
+#include <cstring>
+
+#include "gamma/common/log.hpp"
+
+namespace y {
+namespace {
+
+constexpr char kMagic[4] = {'Y', 'R', 'P', 'L'};
+constexpr uint8_t kVersion = 1;
+constexpr size_t kFlushThreshold = 1 << 16;
+
+void AppendVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+template <typename T>
+void AppendRaw(const T& value, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+bool HasButtonFields(InputEvent::Type type) {
+  return type == InputEvent::Type::kKey ||
+         type == InputEvent::Type::kMouseButton;
+}
+
+}  // namespace
+
+ReplayWriter::ReplayWriter(const std::string& path, uint64_t seed)
+    : file_(fopen(path.c_str(), "wb")) {
+  YERR_IF(file_ == nullptr) << "failed to open '" << path << "'";
+  buffer_.append(kMagic, sizeof(kMagic));
+  buffer_.push_back(static_cast<char>(kVersion));
+  AppendRaw(seed, &buffer_);
+}
+
+ReplayWriter::~ReplayWriter() {
+  flush();
+  fclose(file_);
+}
+
+void ReplayWriter::writeFrame(absl::Duration dt,
+                              absl::Span<const InputEvent> events) {
+  YERR_IF(dt < absl::ZeroDuration());
+  AppendVarint(absl::ToInt64Nanoseconds(dt), &buffer_);
+  AppendVarint(events.size(), &buffer_);
+  for (const InputEvent& event : events) {
+    buffer_.push_back(static_cast<char>(event.type));
+    if (HasButtonFields(event.type)) {
+      AppendVarint(ZigZagEncode(event.code), &buffer_);
+      buffer_.push_back(static_cast<char>(event.action));
+      buffer_.push_back(static_cast<char>(event.mods));
+    } else {
+      AppendRaw(event.x, &buffer_);
+      AppendRaw(event.y, &buffer_);
+    }
+  }
+  if (buffer_.size() >= kFlushThreshold) flush();
+}
+
+void ReplayWriter::flush() {
+  YERR_IF(fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size());
+  buffer_.clear();
+}
+
+ReplayReader::ReplayReader(const std::string& path) {
+  FILE* file = fopen(path.c_str(), "rb");
+  YERR_IF(file == nullptr) << "failed to open '" << path << "'";
+  char chunk[1 << 16];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) data_.append(chunk, n);
+  fclose(file);
+
+  char magic[sizeof(kMagic)];
+  uint8_t version;
+  YERR_IF(!readBytes(magic, sizeof(magic)) ||
+          memcmp(magic, kMagic, sizeof(kMagic)) != 0)
+      << "'" << path << "' is not a replay file";
+  YERR_IF(!readBytes(&version, 1) || version != kVersion)
+      << "unsupported replay version in '" << path << "'";
+  YERR_IF(!readBytes(&seed_, sizeof(seed_))) << "truncated replay header";
+}
+
+bool ReplayReader::readFrame(absl::Duration* dt,
+                             std::vector<InputEvent>* events) {
+  events->clear();
+  if (position_ == data_.size()) return false;
+
+  *dt = absl::Nanoseconds(readVarint());
+  uint64_t count = readVarint();
+  for (uint64_t i = 0; i < count; ++i) {
+    InputEvent event;
+    uint8_t type;
+    YERR_IF(!readBytes(&type, 1)) << "truncated replay frame";
+    YERR_IF(type > static_cast<uint8_t>(InputEvent::Type::kScroll))
+        << "corrupt replay frame";
+    event.type = static_cast<InputEvent::Type>(type);
+    if (HasButtonFields(event.type)) {
+      event.code = static_cast<int32_t>(ZigZagDecode(readVarint()));
+      YERR_IF(!readBytes(&event.action, 1) || !readBytes(&event.mods, 1))
+          << "truncated replay frame";
+    } else {
+      YERR_IF(!readBytes(&event.x, sizeof(event.x)) ||
+              !readBytes(&event.y, sizeof(event.y)))
+          << "truncated replay frame";
+    }
+    events->push_back(event);
+  }
+  return true;
+}
+
+uint64_t ReplayReader::readVarint() {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    YERR_IF(position_ == data_.size()) << "truncated replay frame";
+    uint8_t byte = static_cast<uint8_t>(data_[position_++]);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) return value;
+  }
+  YERR << "corrupt replay varint";
+  return 0;
+}
+
+bool ReplayReader::readBytes(void* out, size_t n) {
+  if (data_.size() - position_ < n) return false;
+  memcpy(out, data_.data() + position_, n);
+  position_ += n;
+  return true;
+}
+
+}  // namespace y
@@ -0,0 +1,83 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_ENGINE_REPLAY_HPP_
+#define GAMMA_ENGINE_REPLAY_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "gamma/graphics/input.hpp"
+
+namespace y {
+
+// Binary recording of everything that makes a run of the main loop
+// nondeterministic: the session random seed, and each frame's timestep and
+// input events.
+//
+// The stream starts with a header (magic, version, seed) followed by one
+// record per frame. Timesteps, counts and key codes are varints; cursor and
+// scroll values are stored as raw doubles so replay is bit-exact.
+class ReplayWriter {
+ public:
+  ReplayWriter(const std::string& path, uint64_t seed);
+  ReplayWriter(const ReplayWriter&) = delete;
+  ReplayWriter& operator=(const ReplayWriter&) = delete;
+  ~ReplayWriter();
+
+  void writeFrame(absl::Duration dt, absl::Span<const InputEvent> events);
+
+ private:
+  void flush();
+
+  FILE* file_;
+  std::string buffer_;
+};
+
+class ReplayReader {
+ public:
+  explicit ReplayReader(const std::string& path);
+  ReplayReader(const ReplayReader&) = delete;
+  ReplayReader& operator=(const ReplayReader&) = delete;
+
+  uint64_t seed() const;
+
+  // Read the next frame, replacing the contents of `events`. Returns false at
+  // the end of the recording.
+  bool readFrame(absl::Duration* dt, std::vector<InputEvent>* events);
+
+ private:
+  uint64_t readVarint();
+  bool readBytes(void* out, size_t n);
+
+  std::string data_;
+  size_t position_ = 0;
+  uint64_t seed_ = 0;
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline uint64_t ReplayReader::seed() const { return seed_; }
+
+}  // namespace y
+#endif  // GAMMA_ENGINE_REPLAY_HPP_
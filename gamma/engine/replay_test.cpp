@@ -0,0 +1,127 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/replay.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+std::string TempPath(const std::string& name) {
+  const char* dir = std::getenv("TEST_TMPDIR");
+  return std::string(dir != nullptr ? dir : "/tmp") + "/" + name;
+}
+
+InputEvent Key(int code, uint8_t action, uint8_t mods) {
+  InputEvent event;
+  event.type = InputEvent::Type::kKey;
+  event.code = code;
+  event.action = action;
+  event.mods = mods;
+  return event;
+}
+
+InputEvent Cursor(double x, double y) {
+  InputEvent event;
+  event.type = InputEvent::Type::kCursorPosition;
+  event.x = x;
+  event.y = y;
+  return event;
+}
+
+TEST(ReplayTest, EmptyRecording) {
+  std::string path = TempPath("empty.replay");
+  { ReplayWriter writer(path, 1234); }
+
+  ReplayReader reader(path);
+  EXPECT_EQ(1234, reader.seed());
+  absl::Duration dt;
+  std::vector<InputEvent> events;
+  EXPECT_FALSE(reader.readFrame(&dt, &events));
+}
+
+TEST(ReplayTest, RoundTripIsExact) {
+  std::string path = TempPath("round_trip.replay");
+  std::vector<absl::Duration> dts = {absl::Nanoseconds(16666667),
+                                     absl::ZeroDuration(), absl::Seconds(3),
+                                     absl::Nanoseconds(1)};
+  std::vector<std::vector<InputEvent>> frames = {
+      {},
+      {Key(65, 1, 0), Key(-1, 0, 0xff)},
+      {Cursor(0.1, -123.456789), Cursor(1e300, 5e-324)},
+      {Key(348, 2, 3)},
+  };
+  InputEvent scroll;
+  scroll.type = InputEvent::Type::kScroll;
+  scroll.y = -1;
+  frames[3].push_back(scroll);
+
+  {
+    ReplayWriter writer(path, ~uint64_t{0});
+    for (size_t i = 0; i < dts.size(); ++i) {
+      writer.writeFrame(dts[i], frames[i]);
+    }
+  }
+
+  ReplayReader reader(path);
+  EXPECT_EQ(~uint64_t{0}, reader.seed());
+  absl::Duration dt;
+  std::vector<InputEvent> events;
+  for (size_t i = 0; i < dts.size(); ++i) {
+    ASSERT_TRUE(reader.readFrame(&dt, &events));
+    EXPECT_EQ(dts[i], dt);
+    EXPECT_EQ(frames[i], events);
+  }
+  EXPECT_FALSE(reader.readFrame(&dt, &events));
+}
+
+TEST(ReplayTest, ManyFrames) {
+  std::string path = TempPath("many_frames.replay");
+  {
+    ReplayWriter writer(path, 0);
+    for (int i = 0; i < 100000; ++i) {
+      writer.writeFrame(absl::Microseconds(i), {Cursor(i, -i)});
+    }
+  }
+  ReplayReader reader(path);
+  absl::Duration dt;
+  std::vector<InputEvent> events;
+  for (int i = 0; i < 100000; ++i) {
+    ASSERT_TRUE(reader.readFrame(&dt, &events));
+    ASSERT_EQ(absl::Microseconds(i), dt);
+    ASSERT_EQ(1, events.size());
+    ASSERT_EQ(Cursor(i, -i), events[0]);
+  }
+  EXPECT_FALSE(reader.readFrame(&dt, &events));
+}
+
+TEST(ReplayTest, RejectsOtherFiles) {
+  std::string path = TempPath("not_a.replay");
+  FILE* file = fopen(path.c_str(), "wb");
+  fputs("hello", file);
+  fclose(file);
+  EXPECT_DEATH_IF_SUPPORTED(ReplayReader reader(path), "");
+}
+
+}  // namespace
+}  // namespace y
@@ -0,0 +1,103 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/scheduler.hpp"
+
+namespace y {
+
+class SystemScheduler::FunctionSystem : public System {
+ public:
+  FunctionSystem(std::string name, const ComponentAccess& access,
+                 World* world, Function<void(World&)> run)
+      : System(std::move(name), access), world_(world), run_(std::move(run)) {}
+
+  size_t prepare() override { return 1; }
+
+  void runJob(size_t /* job */) override { run_(*world_); }
+
+ private:
+  World* world_;
+  Function<void(World&)> run_;
+};
+
+SystemScheduler::SystemScheduler(World* world, JobPool* pool)
+    : world_(world), pool_(pool), commands_(world, pool->numWorkers()) {}
+
+void SystemScheduler::addSystem(std::string name,
+                                const ComponentAccess& access,
+                                Function<void(World&)> run) {
+  add(absl::make_unique<FunctionSystem>(std::move(name), access, world_,
+                                        std::move(run)));
+}
+
+void SystemScheduler::add(std::unique_ptr<System> system) {
+  systems_.push_back(std::move(system));
+  batches_built_ = false;
+}
+
+void SystemScheduler::run() {
+  if (!batches_built_) buildBatches();
+
+  for (const std::vector<System*>& batch : batches_) {
+    // Chunk lists are gathered before any system of the batch runs.
+    std::vector<size_t> num_jobs;
+    for (System* system : batch) num_jobs.push_back(system->prepare());
+
+    JobGroup group;
+    for (size_t i = 0; i < batch.size(); ++i) {
+      System* system = batch[i];
+      for (size_t job = 0; job < num_jobs[i]; ++job) {
+        pool_->schedule(&group, [system, job]() {
+          ComponentAccessScope scope(&system->access());
+          system->runJob(job);
+        });
+      }
+    }
+    pool_->wait(&group);
+  }
+  commands_.playback();
+}
+
+std::vector<std::vector<std::string>> SystemScheduler::batches() {
+  if (!batches_built_) buildBatches();
+  std::vector<std::vector<std::string>> names;
+  for (const std::vector<System*>& batch : batches_) {
+    names.emplace_back();
+    for (System* system : batch) names.back().push_back(system->name());
+  }
+  return names;
+}
+
+void SystemScheduler::buildBatches() {
+  batches_.clear();
+  std::vector<size_t> batch_of(systems_.size());
+  for (size_t i = 0; i < systems_.size(); ++i) {
+    size_t batch = 0;
+    for (size_t j = 0; j < i; ++j) {
+      if (systems_[i]->access().conflictsWith(systems_[j]->access())) {
+        batch = std::max(batch, batch_of[j] + 1);
+      }
+    }
+    batch_of[i] = batch;
+    if (batch == batches_.size()) batches_.emplace_back();
+    batches_[batch].push_back(systems_[i].get());
+  }
+  batches_built_ = true;
+}
+
+}  // namespace y
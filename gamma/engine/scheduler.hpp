@@ -0,0 +1,172 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_ENGINE_SCHEDULER_HPP_
+#define GAMMA_ENGINE_SCHEDULER_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "gamma/common/function.hpp"
+#include "gamma/common/job_pool.hpp"
+#include "gamma/engine/access.hpp"
+#include "gamma/engine/command_buffer.hpp"
+#include "gamma/engine/world.hpp"
+
+namespace y {
+
+// Runs systems over a `World`, concurrently where their declared component
+// accesses allow.
+//
+// Systems are grouped into batches. A system goes into the batch after the
+// last one holding an earlier system it conflicts with, so conflicting
+// systems keep the order they were added in while independent ones share a
+// batch. Batches run one after another, each as jobs on the job pool. Query
+// systems are split into jobs over ranges of chunks.
+//
+// Systems must only touch the component types they declare and must not make
+// structural changes to the world directly; debug builds check both.
+// Structural changes are instead recorded with `commands().local()` and
+// played back once all batches have run.
+class SystemScheduler {
+ public:
+  SystemScheduler(World* world, JobPool* pool);
+  SystemScheduler(const SystemScheduler&) = delete;
+  SystemScheduler& operator=(const SystemScheduler&) = delete;
+
+  // Add a system that runs as a single job.
+  void addSystem(std::string name, const ComponentAccess& access,
+                 Function<void(World&)> run);
+
+  // Add a system that calls `f(const Query<Ts...>::ChunkView&)` for every
+  // chunk matched by `Query<Ts...>`, in jobs of up to `chunks_per_job`
+  // chunks. Its access follows from `Ts`. Returns the system's query, on which
+  // filters can be set to skip unchanged chunks.
+  template <typename... Ts, typename F>
+  Query<Ts...>& addQuerySystem(std::string name, F f,
+                               size_t chunks_per_job = 4);
+
+  // Run every system once, wait for all of them to finish, then play back
+  // recorded commands.
+  void run();
+
+  CommandQueue& commands();
+
+  // Names of the systems in each batch, in the order the batches run.
+  std::vector<std::vector<std::string>> batches();
+
+ private:
+  class System {
+   public:
+    System(std::string name, const ComponentAccess& access);
+    virtual ~System() = default;
+
+    const std::string& name() const;
+    const ComponentAccess& access() const;
+
+    // Called before the system's batch runs. Returns the number of jobs.
+    virtual size_t prepare() = 0;
+    virtual void runJob(size_t job) = 0;
+
+   private:
+    std::string name_;
+    ComponentAccess access_;
+  };
+
+  class FunctionSystem;
+
+  template <typename F, typename... Ts>
+  class QuerySystem;
+
+  void add(std::unique_ptr<System> system);
+  void buildBatches();
+
+  World* world_;
+  JobPool* pool_;
+  std::vector<std::unique_ptr<System>> systems_;
+  std::vector<std::vector<System*>> batches_;
+  bool batches_built_ = false;
+  CommandQueue commands_;
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline CommandQueue& SystemScheduler::commands() { return commands_; }
+
+inline SystemScheduler::System::System(std::string name,
+                                       const ComponentAccess& access)
+    : name_(std::move(name)), access_(access) {}
+
+inline const std::string& SystemScheduler::System::name() const {
+  return name_;
+}
+
+inline const ComponentAccess& SystemScheduler::System::access() const {
+  return access_;
+}
+
+template <typename F, typename... Ts>
+class SystemScheduler::QuerySystem : public System {
+ public:
+  QuerySystem(std::string name, World* world, F f, size_t chunks_per_job)
+      : System(std::move(name), ComponentAccess::Of<Ts...>()),
+        query_(world),
+        f_(std::move(f)),
+        chunks_per_job_(chunks_per_job > 0 ? chunks_per_job : 1) {}
+
+  size_t prepare() override {
+    chunks_.clear();
+    query_.forEachChunk([this](const typename Query<Ts...>::ChunkView& view) {
+      chunks_.push_back(view);
+    });
+    return (chunks_.size() + chunks_per_job_ - 1) / chunks_per_job_;
+  }
+
+  Query<Ts...>& query() { return query_; }
+
+  void runJob(size_t job) override {
+    size_t begin = job * chunks_per_job_;
+    size_t end = std::min(begin + chunks_per_job_, chunks_.size());
+    for (size_t i = begin; i < end; ++i) f_(chunks_[i]);
+  }
+
+ private:
+  Query<Ts...> query_;
+  F f_;
+  size_t chunks_per_job_;
+  std::vector<typename Query<Ts...>::ChunkView> chunks_;
+};
+
+template <typename... Ts, typename F>
+Query<Ts...>& SystemScheduler::addQuerySystem(std::string name, F f,
+                                              size_t chunks_per_job) {
+  auto system = absl::make_unique<QuerySystem<F, Ts...>>(
+      std::move(name), world_, std::move(f), chunks_per_job);
+  Query<Ts...>& query = system->query();
+  add(std::move(system));
+  return query;
+}
+
+}  // namespace y
+#endif  // GAMMA_ENGINE_SCHEDULER_HPP_
@@ -0,0 +1,204 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/scheduler.hpp"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+struct Position {
+  float x;
+};
+
+struct Velocity {
+  float x;
+};
+
+struct Health {
+  int value;
+};
+
+using Batches = std::vector<std::vector<std::string>>;
+
+TEST(ComponentAccessTest, Conflicts) {
+  auto read_position = ComponentAccess::Of<const Position>();
+  auto write_position = ComponentAccess::Of<Position, const Velocity>();
+  auto write_health = ComponentAccess::Of<Health>();
+
+  EXPECT_FALSE(read_position.conflictsWith(read_position));
+  EXPECT_TRUE(read_position.conflictsWith(write_position));
+  EXPECT_TRUE(write_position.conflictsWith(read_position));
+  EXPECT_TRUE(write_position.conflictsWith(write_position));
+  EXPECT_FALSE(write_position.conflictsWith(write_health));
+}
+
+TEST(SystemSchedulerTest, BatchesKeepConflictingSystemsInOrder) {
+  World world;
+  JobPool pool(2);
+  SystemScheduler scheduler(&world, &pool);
+  auto noop = [](World&) {};
+
+  scheduler.addSystem("move", ComponentAccess::Of<Position, const Velocity>(),
+                      noop);
+  scheduler.addSystem("regen", ComponentAccess::Of<Health>(), noop);
+  scheduler.addSystem("draw", ComponentAccess::Of<const Position>(), noop);
+  scheduler.addSystem("log", ComponentAccess::Of<const Health>(), noop);
+  scheduler.addSystem("audio", ComponentAccess::Of<const Position>(), noop);
+  scheduler.addSystem("accelerate", ComponentAccess::Of<Velocity>(), noop);
+
+  EXPECT_EQ(scheduler.batches(),
+            (Batches{{"move", "regen"},
+                     {"draw", "log", "audio", "accelerate"}}));
+}
+
+TEST(SystemSchedulerTest, RunsQuerySystemsOverAllChunks) {
+  World world;
+  for (int i = 0; i < 100000; ++i) {
+    world.create(Position{0}, Velocity{1}, Health{100});
+  }
+  for (int i = 0; i < 5000; ++i) world.create(Position{0});
+
+  JobPool pool(3);
+  SystemScheduler scheduler(&world, &pool);
+  scheduler.addQuerySystem<Position, const Velocity>(
+      "move", [](const Query<Position, const Velocity>::ChunkView& view) {
+        Position* positions = view.get<Position>();
+        const Velocity* velocities = view.get<const Velocity>();
+        for (size_t i = 0; i < view.size(); ++i) {
+          positions[i].x += velocities[i].x;
+        }
+      });
+  scheduler.addQuerySystem<Health>(
+      "damage",
+      [](const Query<Health>::ChunkView& view) {
+        for (size_t i = 0; i < view.size(); ++i) view.get<Health>()[i].value--;
+      },
+      1);
+  std::atomic<int> moved(0);
+  scheduler.addQuerySystem<const Position>(
+      "count", [&moved](const Query<const Position>::ChunkView& view) {
+        const Position* positions = view.get<const Position>();
+        for (size_t i = 0; i < view.size(); ++i) {
+          if (positions[i].x > 0) ++moved;
+        }
+      });
+
+  scheduler.run();
+  scheduler.run();
+  EXPECT_EQ(moved.load(), 100000 + 100000);
+
+  float sum = 0;
+  int health = 0;
+  world.query<const Position, const Health>().forEach(
+      [&](const Position& p, const Health& h) {
+        sum += p.x;
+        health += h.value;
+      });
+  EXPECT_EQ(sum, 200000);
+  EXPECT_EQ(health, 98 * 100000);
+}
+
+TEST(SystemSchedulerTest, FilteredQuerySystemsSkipUnchangedChunks) {
+  World world;
+  std::vector<Entity> entities;
+  for (int i = 0; i < 10000; ++i) {
+    entities.push_back(world.create(Position{0}, Velocity{1}));
+  }
+
+  JobPool pool(2);
+  SystemScheduler scheduler(&world, &pool);
+  std::atomic<int> visited(0);
+  scheduler
+      .addQuerySystem<Position, const Velocity>(
+          "move",
+          [&visited](const Query<Position, const Velocity>::ChunkView& view) {
+            visited += static_cast<int>(view.size());
+          })
+      .filter(Changed<Velocity>());
+
+  scheduler.run();
+  EXPECT_EQ(visited.load(), 10000);
+  scheduler.run();
+  EXPECT_EQ(visited.load(), 10000);
+
+  world.get<Velocity>(entities[0])->x = 2;
+  scheduler.run();
+  EXPECT_GT(visited.load(), 10000);
+  EXPECT_LT(visited.load(), 20000);
+}
+
+TEST(SystemSchedulerTest, FunctionSystemsUseWorldAccessors) {
+  World world;
+  Entity entity = world.create(Position{1}, Velocity{2});
+  JobPool pool(1);
+  SystemScheduler scheduler(&world, &pool);
+  float seen = 0;
+  scheduler.addSystem(
+      "read", ComponentAccess::Of<const Position, const Velocity>(),
+      [entity, &seen](World& w) {
+        const World& read_only = w;
+        seen = read_only.get<Position>(entity)->x +
+               read_only.get<Velocity>(entity)->x;
+      });
+  scheduler.run();
+  EXPECT_EQ(seen, 3);
+}
+
+#ifndef NDEBUG
+
+TEST(SystemSchedulerDeathTest, UndeclaredWrite) {
+  World world;
+  Entity entity = world.create(Position{1});
+  JobPool pool(0);
+  SystemScheduler scheduler(&world, &pool);
+  scheduler.addSystem("bad", ComponentAccess::Of<const Position>(),
+                      [entity](World& w) { w.get<Position>(entity)->x = 2; });
+  EXPECT_DEATH_IF_SUPPORTED(scheduler.run(), "");
+}
+
+TEST(SystemSchedulerDeathTest, UndeclaredQuery) {
+  World world;
+  world.create(Position{1}, Velocity{1});
+  JobPool pool(0);
+  SystemScheduler scheduler(&world, &pool);
+  scheduler.addSystem("bad", ComponentAccess::Of<Position>(), [](World& w) {
+    w.query<Position, const Velocity>().forEach(
+        [](Position&, const Velocity&) {});
+  });
+  EXPECT_DEATH_IF_SUPPORTED(scheduler.run(), "");
+}
+
+TEST(SystemSchedulerDeathTest, StructuralChange) {
+  World world;
+  JobPool pool(0);
+  SystemScheduler scheduler(&world, &pool);
+  scheduler.addSystem("bad", ComponentAccess(),
+                      [](World& w) { w.create(Position{1}); });
+  EXPECT_DEATH_IF_SUPPORTED(scheduler.run(), "");
+}
+
+#endif  // NDEBUG
+
+}  // namespace
+}  // namespace y
@@ -0,0 +1,322 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/snapshot.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "gamma/common/log.hpp"
+
+namespace y {
+namespace {
+
+constexpr char kMagic[4] = {'Y', 'S', 'N', 'P'};
+constexpr uint32_t kVersion = 1;
+// Chunk images start on a page boundary, so that writing to one copies no
+// pages of another.
+constexpr size_t kPageBytes = 4096;
+// Position of the data offset in the header.
+constexpr size_t kDataOffsetPosition = sizeof(kMagic) + sizeof(uint32_t);
+
+template <typename T>
+void AppendRaw(const T& value, std::string* out) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+size_t AlignUp(size_t offset, size_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+class HeaderReader {
+ public:
+  HeaderReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  template <typename T>
+  T read() {
+    T value;
+    readBytes(&value, sizeof(T));
+    return value;
+  }
+
+  std::string readString() {
+    std::string value(read<uint32_t>(), '\0');
+    readBytes(&value[0], value.size());
+    return value;
+  }
+
+ private:
+  void readBytes(void* out, size_t n) {
+    YERR_IF(size_ - position_ < n) << "truncated snapshot header";
+    std::memcpy(out, data_ + position_, n);
+    position_ += n;
+  }
+
+  const uint8_t* data_;
+  size_t size_;
+  size_t position_ = 0;
+};
+
+}  // namespace
+
+void SnapshotSchema::add(int type, std::string name,
+                         Function<void(void*, size_t)> fixup) {
+  YERR_IF(find(type) != nullptr || find(name) != nullptr)
+      << "component '" << name << "' is already part of the schema";
+  entries_.push_back(Entry{type, std::move(name), std::move(fixup)});
+}
+
+const SnapshotSchema::Entry* SnapshotSchema::find(int type) const {
+  for (const Entry& entry : entries_) {
+    if (entry.type == type) return &entry;
+  }
+  return nullptr;
+}
+
+const SnapshotSchema::Entry* SnapshotSchema::find(
+    const std::string& name) const {
+  for (const Entry& entry : entries_) {
+    if (entry.name == name) return &entry;
+  }
+  return nullptr;
+}
+
+void SaveSnapshot(World* world, const SnapshotSchema& schema,
+                  const std::string& path) {
+  world->materializeReserved();
+
+  std::vector<const Archetype*> archetypes;
+  std::vector<int> file_types;
+  std::array<int, kMaxComponentTypes> file_type_of;
+  file_type_of.fill(-1);
+  for (const auto& archetype : world->archetypes_) {
+    if (archetype->numChunks() == 0) continue;
+    archetypes.push_back(archetype.get());
+    for (int type : archetype->types()) {
+      if (file_type_of[type] >= 0) continue;
+      YERR_IF(schema.find(type) == nullptr)
+          << "component type " << type << " is not part of the schema";
+      file_type_of[type] = static_cast<int>(file_types.size());
+      file_types.push_back(type);
+    }
+  }
+
+  std::string header(kMagic, sizeof(kMagic));
+  AppendRaw(kVersion, &header);
+  AppendRaw(uint64_t{0}, &header);
+  AppendRaw(static_cast<uint32_t>(Archetype::kChunkBytes), &header);
+
+  AppendRaw(static_cast<uint32_t>(file_types.size()), &header);
+  for (int type : file_types) {
+    const std::string& name = schema.find(type)->name;
+    const ComponentInfo& info = GetComponentInfo(type);
+    AppendRaw(static_cast<uint32_t>(name.size()), &header);
+    header.append(name);
+    AppendRaw(static_cast<uint32_t>(info.size), &header);
+    AppendRaw(static_cast<uint32_t>(info.alignment), &header);
+  }
+
+  AppendRaw(static_cast<uint32_t>(world->records_.size()), &header);
+  for (const World::EntityRecord& record : world->records_) {
+    AppendRaw(record.generation, &header);
+  }
+  AppendRaw(static_cast<uint32_t>(world->free_indices_.size()), &header);
+  for (uint32_t index : world->free_indices_) AppendRaw(index, &header);
+
+  AppendRaw(static_cast<uint32_t>(archetypes.size()), &header);
+  for (const Archetype* archetype : archetypes) {
+    AppendRaw(static_cast<uint32_t>(archetype->types().size()), &header);
+    AppendRaw(archetype->capacity(), &header);
+    for (size_t i = 0; i < archetype->types().size(); ++i) {
+      AppendRaw(static_cast<uint32_t>(file_type_of[archetype->types()[i]]),
+                &header);
+      AppendRaw(static_cast<uint32_t>(
+                    archetype->columnOffset(static_cast<int>(i))),
+                &header);
+    }
+    AppendRaw(static_cast<uint32_t>(archetype->numChunks()), &header);
+    for (size_t i = 0; i < archetype->numChunks(); ++i) {
+      AppendRaw(archetype->chunk(i).size, &header);
+    }
+  }
+
+  auto data_offset = static_cast<uint64_t>(AlignUp(header.size(), kPageBytes));
+  std::memcpy(&header[kDataOffsetPosition], &data_offset, sizeof(data_offset));
+  header.resize(data_offset, '\0');
+
+  FILE* file = fopen(path.c_str(), "wb");
+  YERR_IF(file == nullptr) << "failed to open '" << path << "'";
+  YERR_IF(fwrite(header.data(), 1, header.size(), file) != header.size())
+      << "failed to write '" << path << "'";
+
+  // Rows past the end of a chunk are written as zeros rather than whatever
+  // the chunk happens to hold.
+  std::vector<uint8_t> image(Archetype::kChunkBytes);
+  for (const Archetype* archetype : archetypes) {
+    for (size_t i = 0; i < archetype->numChunks(); ++i) {
+      uint32_t size = archetype->chunk(i).size;
+      std::fill(image.begin(), image.end(), 0);
+      std::memcpy(image.data(), archetype->entities(i), size * sizeof(Entity));
+      for (size_t column = 0; column < archetype->types().size(); ++column) {
+        int c = static_cast<int>(column);
+        const ComponentInfo& info = GetComponentInfo(archetype->types()[c]);
+        std::memcpy(image.data() + archetype->columnOffset(c),
+                    archetype->columnData(i, c), size * info.size);
+      }
+      YERR_IF(fwrite(image.data(), 1, image.size(), file) != image.size())
+          << "failed to write '" << path << "'";
+    }
+  }
+  YERR_IF(fclose(file) != 0) << "failed to write '" << path << "'";
+}
+
+void LoadSnapshot(const SnapshotSchema& schema, const std::string& path,
+                  World* world) {
+  YERR_IF(!world->records_.empty() || world->num_reserved_ != 0)
+      << "snapshots must be loaded into a new world";
+
+  int fd = open(path.c_str(), O_RDONLY);
+  YERR_IF(fd < 0) << "failed to open '" << path << "'";
+  struct stat file_stat;
+  YERR_IF(fstat(fd, &file_stat) != 0) << "failed to stat '" << path << "'";
+  auto file_size = static_cast<size_t>(file_stat.st_size);
+  YERR_IF(file_size == 0) << "'" << path << "' is not a snapshot";
+  // Private mapping, so that components can be written without changing the
+  // file.
+  void* mapping = mmap(nullptr, file_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE, fd, 0);
+  close(fd);
+  YERR_IF(mapping == MAP_FAILED) << "failed to map '" << path << "'";
+  world->mapping_ = std::shared_ptr<void>(
+      mapping, [file_size](void* data) { munmap(data, file_size); });
+  auto* data = static_cast<uint8_t*>(mapping);
+
+  HeaderReader reader(data, file_size);
+  char magic[sizeof(kMagic)];
+  for (char& c : magic) c = reader.read<char>();
+  YERR_IF(std::memcmp(magic, kMagic, sizeof(kMagic)) != 0)
+      << "'" << path << "' is not a snapshot";
+  YERR_IF(reader.read<uint32_t>() != kVersion)
+      << "unsupported snapshot version in '" << path << "'";
+  auto data_offset = reader.read<uint64_t>();
+  YERR_IF(reader.read<uint32_t>() != Archetype::kChunkBytes ||
+          data_offset % kPageBytes != 0 || data_offset > file_size)
+      << "incompatible snapshot '" << path << "'";
+
+  std::vector<const SnapshotSchema::Entry*> entries(reader.read<uint32_t>());
+  for (const SnapshotSchema::Entry*& entry : entries) {
+    std::string name = reader.readString();
+    entry = schema.find(name);
+    YERR_IF(entry == nullptr)
+        << "component '" << name << "' is not part of the schema";
+    const ComponentInfo& info = GetComponentInfo(entry->type);
+    YERR_IF(reader.read<uint32_t>() != info.size ||
+            reader.read<uint32_t>() != info.alignment)
+        << "component '" << name << "' changed layout";
+  }
+
+  uint32_t num_records = reader.read<uint32_t>();
+  world->records_.resize(num_records, World::EntityRecord{0, 0, {0, 0}});
+  for (World::EntityRecord& record : world->records_) {
+    record.generation = reader.read<uint32_t>();
+  }
+  world->free_indices_.resize(reader.read<uint32_t>());
+  for (uint32_t& index : world->free_indices_) {
+    index = reader.read<uint32_t>();
+    YERR_IF(index >= num_records) << "corrupt snapshot '" << path << "'";
+  }
+
+  uint32_t num_archetypes = reader.read<uint32_t>();
+  size_t next_chunk = 0;
+  for (uint32_t a = 0; a < num_archetypes; ++a) {
+    std::vector<std::pair<int, size_t>> columns(reader.read<uint32_t>());
+    uint32_t capacity = reader.read<uint32_t>();
+    ComponentMask mask;
+    bool has_fixups = false;
+    for (std::pair<int, size_t>& column : columns) {
+      uint32_t file_type = reader.read<uint32_t>();
+      YERR_IF(file_type >= entries.size() || mask[entries[file_type]->type])
+          << "corrupt snapshot '" << path << "'";
+      column.first = entries[file_type]->type;
+      column.second = reader.read<uint32_t>();
+      mask.set(column.first);
+      has_fixups |= static_cast<bool>(entries[file_type]->fixup);
+    }
+    // Columns are ordered by type id, which differs between runs.
+    std::sort(columns.begin(), columns.end());
+    std::vector<size_t> offsets;
+    for (const std::pair<int, size_t>& column : columns) {
+      offsets.push_back(column.second);
+    }
+
+    uint32_t index;
+    auto it = world->archetype_index_.find(mask);
+    if (it != world->archetype_index_.end()) {
+      index = it->second;
+      const Archetype& existing = *world->archetypes_[index];
+      bool same_layout = existing.capacity() == capacity;
+      for (size_t i = 0; i < offsets.size(); ++i) {
+        same_layout &= existing.columnOffset(static_cast<int>(i)) == offsets[i];
+      }
+      YERR_IF(!same_layout) << "incompatible snapshot '" << path << "'";
+    } else {
+      index = static_cast<uint32_t>(world->archetypes_.size());
+      world->archetypes_.push_back(
+          absl::make_unique<Archetype>(mask, capacity, offsets));
+      world->archetype_index_.emplace(mask, index);
+    }
+    Archetype& archetype = *world->archetypes_[index];
+
+    uint32_t num_chunks = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < num_chunks; ++i) {
+      uint32_t size = reader.read<uint32_t>();
+      size_t offset = data_offset + next_chunk++ * Archetype::kChunkBytes;
+      YERR_IF(offset + Archetype::kChunkBytes > file_size)
+          << "truncated snapshot '" << path << "'";
+      size_t chunk = archetype.appendChunk(data + offset, size, has_fixups,
+                                           world->version());
+      for (const std::pair<int, size_t>& column : columns) {
+        const SnapshotSchema::Entry* entry = schema.find(column.first);
+        if (!entry->fixup) continue;
+        entry->fixup(archetype.columnData(chunk, archetype.column(entry->type)),
+                     size_t{size});
+      }
+      for (uint32_t row = 0; row < size; ++row) {
+        Entity entity = archetype.entities(chunk)[row];
+        YERR_IF(entity.index >= num_records ||
+                world->records_[entity.index].generation != entity.generation)
+            << "corrupt snapshot '" << path << "'";
+        world->records_[entity.index].archetype = index;
+        world->records_[entity.index].row =
+            Archetype::Row{static_cast<uint32_t>(chunk), row};
+      }
+      world->size_ += size;
+    }
+  }
+}
+
+}  // namespace y
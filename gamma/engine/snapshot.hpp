@@ -0,0 +1,108 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_ENGINE_SNAPSHOT_HPP_
+#define GAMMA_ENGINE_SNAPSHOT_HPP_
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "gamma/common/function.hpp"
+#include "gamma/engine/component.hpp"
+#include "gamma/engine/world.hpp"
+
+namespace y {
+
+// The component types that can be stored in world snapshots, each under a
+// name that stays the same across builds, unlike component type ids.
+//
+// Components are saved as the raw bytes of their chunk arrays, so they must
+// be trivially copyable. A type with a fixup, for example to re-resolve
+// pointers, has its arrays copied out of the snapshot on load and the fixup
+// applied to the copy.
+class SnapshotSchema {
+ public:
+  template <typename T>
+  void add(std::string name);
+  template <typename T>
+  void add(std::string name, void (*fixup)(T* components, size_t count));
+
+ private:
+  friend void SaveSnapshot(World* world, const SnapshotSchema& schema,
+                           const std::string& path);
+  friend void LoadSnapshot(const SnapshotSchema& schema,
+                           const std::string& path, World* world);
+
+  struct Entry {
+    int type;
+    std::string name;
+    // Null if the type has no fixup.
+    mutable Function<void(void*, size_t)> fixup;
+  };
+
+  void add(int type, std::string name, Function<void(void*, size_t)> fixup);
+  // Entry for component type `type`, or null.
+  const Entry* find(int type) const;
+  const Entry* find(const std::string& name) const;
+
+  std::vector<Entry> entries_;
+};
+
+// Write the entities and components of `world` to `path`. Every component
+// type in `world` must be part of `schema`. Reserved entities are created
+// first.
+//
+// The file holds a header describing entities and archetypes, followed by
+// page-aligned chunk images with the same layout as in memory.
+void SaveSnapshot(World* world, const SnapshotSchema& schema,
+                  const std::string& path);
+
+// Load the snapshot at `path` into `world`, which must not have had any
+// entities created in it. Entity handles keep their values.
+//
+// The file is mapped privately, and chunks of component types without fixups
+// are used in place, so loading does not copy them. Pages are copied by the
+// kernel only once written to.
+void LoadSnapshot(const SnapshotSchema& schema, const std::string& path,
+                  World* world);
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+template <typename T>
+void SnapshotSchema::add(std::string name) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "snapshot components must be trivially copyable");
+  add(ComponentTypeId<T>(), std::move(name), nullptr);
+}
+
+template <typename T>
+void SnapshotSchema::add(std::string name,
+                         void (*fixup)(T* components, size_t count)) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "snapshot components must be trivially copyable");
+  add(ComponentTypeId<T>(), std::move(name),
+      [fixup](void* components, size_t count) {
+        fixup(static_cast<T*>(components), count);
+      });
+}
+
+}  // namespace y
+#endif  // GAMMA_ENGINE_SNAPSHOT_HPP_
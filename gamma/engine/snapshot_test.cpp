@@ -0,0 +1,182 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/snapshot.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+std::string TempPath(const std::string& name) {
+  const char* dir = std::getenv("TEST_TMPDIR");
+  return std::string(dir != nullptr ? dir : "/tmp") + "/" + name;
+}
+
+struct Position {
+  float x, y, z;
+};
+
+struct Velocity {
+  float x, y, z;
+};
+
+// Refers to an entry of `kMaterials` by pointer, which has to be restored
+// from the index on load.
+struct Material {
+  uint32_t index;
+  const char* const* name;
+};
+
+const char* const kMaterials[] = {"stone", "wood", "glass"};
+
+void FixupMaterials(Material* materials, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    materials[i].name = &kMaterials[materials[i].index];
+  }
+}
+
+SnapshotSchema MakeSchema() {
+  SnapshotSchema schema;
+  schema.add<Position>("position");
+  schema.add<Velocity>("velocity");
+  schema.add<Material>("material", &FixupMaterials);
+  return schema;
+}
+
+TEST(SnapshotTest, RoundTrip) {
+  SnapshotSchema schema = MakeSchema();
+  World world;
+  std::vector<Entity> entities;
+  for (int i = 0; i < 3000; ++i) {
+    Entity entity = world.create(Position{float(i), 0, 0});
+    if (i % 3 == 0) world.add(entity, Velocity{0, float(i), 0});
+    if (i % 5 == 0) {
+      uint32_t material = i % 3;
+      world.add(entity, Material{material, &kMaterials[material]});
+    }
+    entities.push_back(entity);
+  }
+  for (int i = 0; i < 3000; i += 7) world.destroy(entities[i]);
+  world.create();
+  std::string path = TempPath("round_trip.snapshot");
+  SaveSnapshot(&world, schema, path);
+
+  World loaded;
+  LoadSnapshot(schema, path, &loaded);
+  EXPECT_EQ(loaded.size(), world.size());
+  for (int i = 0; i < 3000; ++i) {
+    Entity entity = entities[i];
+    ASSERT_EQ(loaded.alive(entity), world.alive(entity));
+    if (!world.alive(entity)) continue;
+    EXPECT_EQ(loaded.get<Position>(entity)->x, float(i));
+    EXPECT_EQ(loaded.has<Velocity>(entity), i % 3 == 0);
+    if (i % 3 == 0) {
+      EXPECT_EQ(loaded.get<Velocity>(entity)->y, float(i));
+    }
+    EXPECT_EQ(loaded.has<Material>(entity), i % 5 == 0);
+    if (i % 5 == 0) {
+      EXPECT_EQ(*loaded.get<Material>(entity)->name, kMaterials[i % 3]);
+    }
+  }
+  EXPECT_EQ(loaded.query<const Position>().size(),
+            world.query<const Position>().size());
+
+  // Destroyed indices are reused in the same order.
+  EXPECT_EQ(loaded.create(), world.create());
+}
+
+TEST(SnapshotTest, MapsChunksWithoutFixups) {
+  SnapshotSchema schema = MakeSchema();
+  std::string path = TempPath("mapped.snapshot");
+  std::vector<Entity> entities;
+  {
+    World world;
+    for (int i = 0; i < 2000; ++i) {
+      entities.push_back(world.create(Position{1, 2, 3}));
+    }
+    world.create(Position{}, Material{2, nullptr});
+    SaveSnapshot(&world, schema, path);
+  }
+
+  World loaded;
+  LoadSnapshot(schema, path, &loaded);
+  for (size_t i = 0; i < loaded.numArchetypes(); ++i) {
+    const Archetype& archetype = loaded.archetype(i);
+    bool has_fixups = archetype.column(ComponentTypeId<Material>()) >= 0;
+    for (size_t c = 0; c < archetype.numChunks(); ++c) {
+      EXPECT_EQ(archetype.chunk(c).owned, has_fixups);
+    }
+  }
+
+  // Mapped components can be written, and the loaded world changed, without
+  // affecting the file.
+  loaded.get<Position>(entities[0])->x = 10;
+  for (int i = 0; i < 1000; ++i) loaded.destroy(entities[i]);
+  Entity created = loaded.create(Position{4, 5, 6});
+  EXPECT_EQ(loaded.get<Position>(created)->x, 4);
+  EXPECT_EQ(loaded.get<Position>(entities[1999])->z, 3);
+
+  World reloaded;
+  LoadSnapshot(schema, path, &reloaded);
+  EXPECT_EQ(reloaded.get<Position>(entities[0])->x, 1);
+  EXPECT_EQ(reloaded.size(), 2001u);
+}
+
+TEST(SnapshotTest, LoadedChunksCountAsAdded) {
+  SnapshotSchema schema = MakeSchema();
+  std::string path = TempPath("added.snapshot");
+  {
+    World world;
+    for (int i = 0; i < 10; ++i) world.create(Position{});
+    SaveSnapshot(&world, schema, path);
+  }
+  World loaded;
+  auto added = loaded.query<const Position>();
+  added.filter(Added<Position>());
+  LoadSnapshot(schema, path, &loaded);
+  size_t count = 0;
+  added.forEach([&count](const Position&) { ++count; });
+  EXPECT_EQ(count, 10u);
+}
+
+TEST(SnapshotDeathTest, RequiresSchemaForEveryComponent) {
+  SnapshotSchema schema;
+  schema.add<Position>("position");
+  World world;
+  world.create(Position{}, Velocity{});
+  EXPECT_DEATH_IF_SUPPORTED(
+      SaveSnapshot(&world, schema, TempPath("unknown.snapshot")), "");
+}
+
+TEST(SnapshotDeathTest, RejectsOtherFiles) {
+  std::string path = TempPath("not_a.snapshot");
+  FILE* file = fopen(path.c_str(), "wb");
+  fputs("definitely not a snapshot", file);
+  fclose(file);
+  SnapshotSchema schema = MakeSchema();
+  World world;
+  EXPECT_DEATH_IF_SUPPORTED(LoadSnapshot(schema, path, &world), "");
+}
+
+}  // namespace
+}  // namespace y
@@ -0,0 +1,213 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/transform_hierarchy.hpp"
+
+#include <algorithm>
+
+#include "gamma/math/glm_interop.hpp"
+
+namespace y {
+namespace {
+
+template <typename T>
+void Permute(const std::vector<uint32_t>& order, std::vector<T>* values) {
+  std::vector<T> permuted;
+  permuted.reserve(order.size());
+  for (uint32_t i : order) permuted.push_back((*values)[i]);
+  values->swap(permuted);
+}
+
+}  // namespace
+
+TransformId TransformHierarchy::create(TransformId parent,
+                                       const glm::mat4& local) {
+  uint32_t parent_slot = parent == kNoTransform ? kNoTransform : slot(parent);
+  TransformId id;
+  if (!free_ids_.empty()) {
+    id = free_ids_.back();
+    free_ids_.pop_back();
+  } else {
+    id = static_cast<TransformId>(slots_.size());
+    slots_.push_back(kNoTransform);
+  }
+  // Appending keeps parents before their children.
+  slots_[id] = static_cast<uint32_t>(ids_.size());
+  parents_.push_back(parent_slot);
+  locals_.push_back(local);
+  worlds_.push_back(local);
+  dirty_.push_back(1);
+  ids_.push_back(id);
+  roots_of_.push_back(0);
+  order_stale_ = true;
+  return id;
+}
+
+void TransformHierarchy::destroy(TransformId id) {
+  if (order_stale_) rebuildOrder();
+  uint32_t destroyed = slot(id);
+
+  // Descendants come after `destroyed`, and after their parents.
+  size_t n = ids_.size();
+  std::vector<uint32_t> new_slots(n, kNoTransform);
+  uint32_t next = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    uint32_t parent = parents_[i];
+    bool removed = i == destroyed || (parent != kNoTransform && i > destroyed &&
+                                      new_slots[parent] == kNoTransform);
+    if (removed) {
+      slots_[ids_[i]] = kNoTransform;
+      free_ids_.push_back(ids_[i]);
+      continue;
+    }
+    new_slots[i] = next;
+    parents_[next] = parent == kNoTransform ? kNoTransform : new_slots[parent];
+    locals_[next] = locals_[i];
+    worlds_[next] = worlds_[i];
+    dirty_[next] = dirty_[i];
+    ids_[next] = ids_[i];
+    slots_[ids_[i]] = next;
+    ++next;
+  }
+  parents_.resize(next);
+  locals_.resize(next);
+  worlds_.resize(next);
+  dirty_.resize(next);
+  ids_.resize(next);
+  roots_of_.resize(next);
+  order_stale_ = true;
+}
+
+void TransformHierarchy::setParent(TransformId id, TransformId parent) {
+  uint32_t child = slot(id);
+  uint32_t parent_slot = parent == kNoTransform ? kNoTransform : slot(parent);
+  for (uint32_t ancestor = parent_slot; ancestor != kNoTransform;
+       ancestor = parents_[ancestor]) {
+    YERR_IF(ancestor == child) << "transform parent would create a cycle";
+  }
+  parents_[child] = parent_slot;
+  dirty_[child] = 1;
+  order_stale_ = true;
+}
+
+void TransformHierarchy::setLocal(TransformId id, const glm::mat4& local) {
+  uint32_t i = slot(id);
+  locals_[i] = local;
+  markDirty(i);
+}
+
+void TransformHierarchy::markDirty(uint32_t slot) {
+  dirty_[slot] = 1;
+  // A stale order gets its roots recomputed, dirty flags included.
+  if (!order_stale_) roots_[roots_of_[slot]].dirty = true;
+}
+
+void TransformHierarchy::update() {
+  if (order_stale_) rebuildOrder();
+  for (Root& root : roots_) updateRoot(&root);
+}
+
+void TransformHierarchy::update(JobPool* pool) {
+  if (order_stale_) rebuildOrder();
+  size_t grain = std::max<size_t>(
+      1, roots_.size() / (4 * static_cast<size_t>(pool->numWorkers() + 1)));
+  pool->parallelFor(roots_.size(), grain, [this](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) updateRoot(&roots_[i]);
+  });
+}
+
+size_t TransformHierarchy::numUpdated() const {
+  size_t num_updated = 0;
+  for (const Root& root : roots_) num_updated += root.num_updated;
+  return num_updated;
+}
+
+void TransformHierarchy::updateRoot(Root* root) {
+  root->num_updated = 0;
+  if (!root->dirty) return;
+  if (dirty_[root->begin]) {
+    worlds_[root->begin] = locals_[root->begin];
+    ++root->num_updated;
+  }
+  for (uint32_t i = root->begin + 1; i < root->end; ++i) {
+    uint32_t parent = parents_[i];
+    dirty_[i] |= dirty_[parent];
+    if (!dirty_[i]) continue;
+    worlds_[i] = ToGlm(FromGlm(worlds_[parent]) * FromGlm(locals_[i]));
+    ++root->num_updated;
+  }
+  std::fill(dirty_.begin() + root->begin, dirty_.begin() + root->end, 0);
+  root->dirty = false;
+}
+
+void TransformHierarchy::rebuildOrder() {
+  size_t n = ids_.size();
+
+  // Children of every slot, grouped by parent, via a counting sort.
+  std::vector<uint32_t> children_begin(n + 1, 0);
+  for (uint32_t parent : parents_) {
+    if (parent != kNoTransform) ++children_begin[parent + 1];
+  }
+  for (size_t i = 0; i < n; ++i) children_begin[i + 1] += children_begin[i];
+  std::vector<uint32_t> children(children_begin[n]);
+  std::vector<uint32_t> children_end(children_begin.begin(),
+                                     children_begin.end() - 1);
+  for (uint32_t i = 0; i < n; ++i) {
+    if (parents_[i] != kNoTransform) children[children_end[parents_[i]]++] = i;
+  }
+
+  // Each root followed by its subtree, breadth first.
+  std::vector<uint32_t> order;
+  order.reserve(n);
+  roots_.clear();
+  for (uint32_t i = 0; i < n; ++i) {
+    if (parents_[i] != kNoTransform) continue;
+    auto begin = static_cast<uint32_t>(order.size());
+    order.push_back(i);
+    for (size_t next = begin; next < order.size(); ++next) {
+      uint32_t node = order[next];
+      order.insert(order.end(), children.begin() + children_begin[node],
+                   children.begin() + children_begin[node + 1]);
+    }
+    roots_.push_back(
+        Root{begin, static_cast<uint32_t>(order.size()), 0, false});
+  }
+
+  std::vector<uint32_t> new_slots(n);
+  for (uint32_t i = 0; i < n; ++i) new_slots[order[i]] = i;
+  Permute(order, &parents_);
+  for (uint32_t& parent : parents_) {
+    if (parent != kNoTransform) parent = new_slots[parent];
+  }
+  Permute(order, &locals_);
+  Permute(order, &worlds_);
+  Permute(order, &dirty_);
+  Permute(order, &ids_);
+
+  for (uint32_t r = 0; r < roots_.size(); ++r) {
+    Root& root = roots_[r];
+    for (uint32_t i = root.begin; i < root.end; ++i) {
+      slots_[ids_[i]] = i;
+      roots_of_[i] = r;
+      if (dirty_[i]) root.dirty = true;
+    }
+  }
+  order_stale_ = false;
+}
+
+}  // namespace y
@@ -0,0 +1,146 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_ENGINE_TRANSFORM_HIERARCHY_HPP_
+#define GAMMA_ENGINE_TRANSFORM_HIERARCHY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gamma/common/job_pool.hpp"
+#include "gamma/common/log.hpp"
+#include "glm/glm.hpp"
+
+namespace y {
+
+// Identifies a node of a `TransformHierarchy`. Ids of destroyed nodes are
+// reused.
+using TransformId = uint32_t;
+constexpr TransformId kNoTransform = 0xffffffff;
+
+// Local and world transforms of a forest of nodes.
+//
+// Nodes are stored in arrays in which the subtree of each root is contiguous
+// and laid out breadth first, so every parent comes before its children.
+// `update()` computes world matrices in one linear pass per root subtree,
+// skipping subtrees in which no local transform changed, and independent
+// root subtrees can be updated in parallel. Creating, destroying and
+// reparenting nodes leaves the order stale until the next update rebuilds it.
+//
+// Matrices are column-major, as in glm, and the world matrix of a node is the
+// world matrix of its parent times its local matrix.
+//
+// Not thread-safe.
+class TransformHierarchy {
+ public:
+  TransformHierarchy() = default;
+  TransformHierarchy(const TransformHierarchy&) = delete;
+  TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+  TransformId create(TransformId parent = kNoTransform,
+                     const glm::mat4& local = glm::mat4(1.0f));
+
+  // Destroy `id` and all of its descendants.
+  void destroy(TransformId id);
+
+  bool alive(TransformId id) const;
+
+  // Number of live nodes.
+  size_t size() const;
+
+  // The following require `id` to be alive.
+
+  TransformId parent(TransformId id) const;
+  // `parent` must not be `id` or one of its descendants.
+  void setParent(TransformId id, TransformId parent);
+
+  const glm::mat4& local(TransformId id) const;
+  void setLocal(TransformId id, const glm::mat4& local);
+
+  // World matrix as of the last update.
+  const glm::mat4& world(TransformId id) const;
+
+  // Recompute the world matrices of nodes whose local matrix, or that of an
+  // ancestor, changed since the last update, and of nodes created or
+  // reparented since then.
+  void update();
+  // As `update()`, spreading root subtrees over the jobs of `pool`.
+  void update(JobPool* pool);
+
+  // Number of world matrices computed by the last update.
+  size_t numUpdated() const;
+
+ private:
+  struct Root {
+    uint32_t begin;
+    uint32_t end;
+    uint32_t num_updated;
+    bool dirty;
+  };
+
+  uint32_t slot(TransformId id) const;
+  void markDirty(uint32_t slot);
+  void rebuildOrder();
+  void updateRoot(Root* root);
+
+  // Indexed by slot, in hierarchy order.
+  std::vector<uint32_t> parents_;
+  std::vector<glm::mat4> locals_;
+  std::vector<glm::mat4> worlds_;
+  std::vector<uint8_t> dirty_;
+  std::vector<TransformId> ids_;
+  std::vector<uint32_t> roots_of_;
+
+  // Slot of every id, or `kNoTransform` for free ids.
+  std::vector<uint32_t> slots_;
+  std::vector<TransformId> free_ids_;
+
+  std::vector<Root> roots_;
+  bool order_stale_ = false;
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline bool TransformHierarchy::alive(TransformId id) const {
+  return id < slots_.size() && slots_[id] != kNoTransform;
+}
+
+inline size_t TransformHierarchy::size() const { return ids_.size(); }
+
+inline uint32_t TransformHierarchy::slot(TransformId id) const {
+  YERR_IF(!alive(id)) << "transform is not alive";
+  return slots_[id];
+}
+
+inline TransformId TransformHierarchy::parent(TransformId id) const {
+  uint32_t parent = parents_[slot(id)];
+  return parent == kNoTransform ? kNoTransform : ids_[parent];
+}
+
+inline const glm::mat4& TransformHierarchy::local(TransformId id) const {
+  return locals_[slot(id)];
+}
+
+inline const glm::mat4& TransformHierarchy::world(TransformId id) const {
+  return worlds_[slot(id)];
+}
+
+}  // namespace y
+#endif  // GAMMA_ENGINE_TRANSFORM_HIERARCHY_HPP_
@@ -0,0 +1,167 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/transform_hierarchy.hpp"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+glm::mat4 Translation(float x, float y, float z) {
+  glm::mat4 m(1.0f);
+  m[3] = glm::vec4(x, y, z, 1.0f);
+  return m;
+}
+
+glm::mat4 Scale(float s) {
+  glm::mat4 m(s);
+  m[3][3] = 1.0f;
+  return m;
+}
+
+void ExpectMat4Near(const glm::mat4& actual, const glm::mat4& expected) {
+  for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_NEAR(actual[j][i], expected[j][i], 1e-4f) << j << ", " << i;
+    }
+  }
+}
+
+// World matrix computed by walking up the hierarchy.
+glm::mat4 ExpectedWorld(const TransformHierarchy& hierarchy, TransformId id) {
+  TransformId parent = hierarchy.parent(id);
+  if (parent == kNoTransform) return hierarchy.local(id);
+  return ExpectedWorld(hierarchy, parent) * hierarchy.local(id);
+}
+
+TEST(TransformHierarchyTest, ComposesParentAndLocal) {
+  TransformHierarchy hierarchy;
+  TransformId root = hierarchy.create(kNoTransform, Translation(1, 0, 0));
+  TransformId child = hierarchy.create(root, Scale(2));
+  TransformId grandchild = hierarchy.create(child, Translation(0, 1, 0));
+  hierarchy.update();
+
+  EXPECT_EQ(hierarchy.size(), 3u);
+  EXPECT_EQ(hierarchy.parent(grandchild), child);
+  EXPECT_EQ(hierarchy.numUpdated(), 3u);
+  glm::vec4 origin = hierarchy.world(grandchild) * glm::vec4(0, 0, 0, 1);
+  EXPECT_FLOAT_EQ(origin.x, 1);
+  EXPECT_FLOAT_EQ(origin.y, 2);
+  EXPECT_FLOAT_EQ(origin.z, 0);
+}
+
+TEST(TransformHierarchyTest, SkipsCleanSubtrees) {
+  TransformHierarchy hierarchy;
+  TransformId a = hierarchy.create();
+  TransformId b = hierarchy.create();
+  TransformId a_child = hierarchy.create(a);
+  TransformId b_child = hierarchy.create(b);
+  hierarchy.create(b_child);
+  hierarchy.update();
+  EXPECT_EQ(hierarchy.numUpdated(), 5u);
+
+  hierarchy.update();
+  EXPECT_EQ(hierarchy.numUpdated(), 0u);
+
+  // Changing a node updates it and its descendants only.
+  hierarchy.setLocal(b_child, Translation(0, 0, 3));
+  hierarchy.update();
+  EXPECT_EQ(hierarchy.numUpdated(), 2u);
+
+  hierarchy.setLocal(a_child, Translation(0, 0, 3));
+  hierarchy.setLocal(b, Translation(1, 0, 0));
+  hierarchy.update();
+  EXPECT_EQ(hierarchy.numUpdated(), 4u);
+  ExpectMat4Near(hierarchy.world(b_child), Translation(1, 0, 3));
+}
+
+TEST(TransformHierarchyTest, ReparentAndDestroy) {
+  TransformHierarchy hierarchy;
+  TransformId a = hierarchy.create(kNoTransform, Translation(1, 0, 0));
+  TransformId b = hierarchy.create(kNoTransform, Translation(0, 1, 0));
+  TransformId child = hierarchy.create(a, Translation(0, 0, 1));
+  TransformId grandchild = hierarchy.create(child);
+  hierarchy.update();
+  ExpectMat4Near(hierarchy.world(grandchild), Translation(1, 0, 1));
+
+  hierarchy.setParent(child, b);
+  hierarchy.update();
+  EXPECT_EQ(hierarchy.numUpdated(), 2u);
+  ExpectMat4Near(hierarchy.world(grandchild), Translation(0, 1, 1));
+
+  hierarchy.destroy(b);
+  EXPECT_EQ(hierarchy.size(), 1u);
+  EXPECT_TRUE(hierarchy.alive(a));
+  EXPECT_FALSE(hierarchy.alive(b));
+  EXPECT_FALSE(hierarchy.alive(child));
+  EXPECT_FALSE(hierarchy.alive(grandchild));
+
+  // Destroyed ids are reused.
+  TransformId reused = hierarchy.create(a);
+  EXPECT_TRUE(reused == b || reused == child || reused == grandchild);
+  hierarchy.update();
+  ExpectMat4Near(hierarchy.world(reused), Translation(1, 0, 0));
+}
+
+TEST(TransformHierarchyTest, ParentCreatedAfterChild) {
+  TransformHierarchy hierarchy;
+  TransformId child = hierarchy.create(kNoTransform, Translation(0, 0, 1));
+  TransformId parent = hierarchy.create(kNoTransform, Scale(3));
+  hierarchy.setParent(child, parent);
+  hierarchy.update();
+  ExpectMat4Near(hierarchy.world(child), Scale(3) * Translation(0, 0, 1));
+}
+
+TEST(TransformHierarchyTest, ParallelUpdateMatchesReference) {
+  TransformHierarchy hierarchy;
+  std::vector<TransformId> ids;
+  for (int i = 0; i < 2000; ++i) {
+    // Every tenth node is a root, the others hang off a recent node.
+    TransformId parent = i % 10 == 0 ? kNoTransform : ids[i - 1 - i % 10 / 4];
+    ids.push_back(hierarchy.create(
+        parent, Translation(0.01f * i, 1, 0) * Scale(1.0f + 0.0001f * i)));
+  }
+  JobPool pool(3);
+  hierarchy.update(&pool);
+  EXPECT_EQ(hierarchy.numUpdated(), ids.size());
+  for (TransformId id : ids) {
+    ExpectMat4Near(hierarchy.world(id), ExpectedWorld(hierarchy, id));
+  }
+
+  for (size_t i = 0; i < ids.size(); i += 7) {
+    hierarchy.setLocal(ids[i], Translation(0, 0, 0.5f * i));
+  }
+  hierarchy.update(&pool);
+  EXPECT_LT(hierarchy.numUpdated(), ids.size());
+  for (TransformId id : ids) {
+    ExpectMat4Near(hierarchy.world(id), ExpectedWorld(hierarchy, id));
+  }
+}
+
+TEST(TransformHierarchyDeathTest, RejectsCycles) {
+  TransformHierarchy hierarchy;
+  TransformId a = hierarchy.create();
+  TransformId b = hierarchy.create(a);
+  EXPECT_DEATH_IF_SUPPORTED(hierarchy.setParent(a, b), "");
+}
+
+}  // namespace
+}  // namespace y
@@ -0,0 +1,98 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/transform_system.hpp"
+
+#include "gamma/common/log.hpp"
+
+namespace y {
+
+TransformSystem::TransformSystem(World* world)
+    : world_(world), changed_locals_(world), worlds_(world) {
+  changed_locals_.filter(Changed<LocalTransform>());
+}
+
+void TransformSystem::attach(Entity entity, Entity parent) {
+  YERR_IF(attached(entity)) << "entity is already attached";
+  TransformId parent_node =
+      parent == Entity() ? kNoTransform : node(parent);
+  const LocalTransform* local = world_->get<const LocalTransform>(entity);
+  if (local == nullptr) local = &world_->add(entity, LocalTransform());
+  TransformId id = hierarchy_.create(parent_node, local->matrix);
+
+  if (id >= entities_.size()) entities_.resize(id + 1);
+  entities_[id] = entity;
+  world_->add(entity, TransformNode{id});
+  world_->add(entity, WorldTransform());
+}
+
+void TransformSystem::detach(Entity entity) {
+  hierarchy_.destroy(node(entity));
+  for (TransformId id = 0; id < entities_.size(); ++id) {
+    if (entities_[id] == Entity() || hierarchy_.alive(id)) continue;
+    if (world_->alive(entities_[id])) {
+      world_->remove<TransformNode>(entities_[id]);
+      world_->remove<WorldTransform>(entities_[id]);
+    }
+    entities_[id] = Entity();
+  }
+}
+
+bool TransformSystem::attached(Entity entity) const {
+  return world_->has<TransformNode>(entity);
+}
+
+Entity TransformSystem::parent(Entity entity) const {
+  TransformId parent = hierarchy_.parent(node(entity));
+  return parent == kNoTransform ? Entity() : entities_[parent];
+}
+
+void TransformSystem::setParent(Entity entity, Entity parent) {
+  hierarchy_.setParent(node(entity),
+                       parent == Entity() ? kNoTransform : node(parent));
+}
+
+void TransformSystem::update(JobPool* pool) {
+  // Chunks are marked changed as a whole, so only copy matrices that differ
+  // to keep untouched subtrees clean.
+  changed_locals_.forEach(
+      [this](const TransformNode& node, const LocalTransform& local) {
+        if (hierarchy_.local(node.id) != local.matrix) {
+          hierarchy_.setLocal(node.id, local.matrix);
+        }
+      });
+
+  if (pool != nullptr) {
+    hierarchy_.update(pool);
+  } else {
+    hierarchy_.update();
+  }
+  if (hierarchy_.numUpdated() == 0) return;
+
+  worlds_.forEach([this](const TransformNode& node, WorldTransform& world) {
+    world.matrix = hierarchy_.world(node.id);
+  });
+}
+
+TransformId TransformSystem::node(Entity entity) const {
+  const TransformNode* node = world_->get<const TransformNode>(entity);
+  YERR_IF(node == nullptr) << "entity has no transform";
+  return node->id;
+}
+
+}  // namespace y
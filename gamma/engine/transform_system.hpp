@@ -0,0 +1,111 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_ENGINE_TRANSFORM_SYSTEM_HPP_
+#define GAMMA_ENGINE_TRANSFORM_SYSTEM_HPP_
+
+#include <vector>
+
+#include "gamma/common/job_pool.hpp"
+#include "gamma/engine/entity.hpp"
+#include "gamma/engine/transform_hierarchy.hpp"
+#include "gamma/engine/world.hpp"
+#include "glm/glm.hpp"
+
+namespace y {
+
+// Transform of an entity relative to its parent, written by game code.
+struct LocalTransform {
+  glm::mat4 matrix = glm::mat4(1.0f);
+};
+
+// Transform of an entity relative to the world, as of the last
+// `TransformSystem::update()`. Read-only for game code.
+struct WorldTransform {
+  glm::mat4 matrix = glm::mat4(1.0f);
+};
+
+// The node of an entity in the hierarchy of a `TransformSystem`.
+struct TransformNode {
+  TransformId id;
+};
+
+// Keeps the `WorldTransform` components of a `World` up to date from its
+// `LocalTransform` components, through a `TransformHierarchy`.
+//
+// Attached entities get a node in the hierarchy along with `TransformNode` and
+// `WorldTransform` components. `update()` copies local transforms from chunks
+// in which they changed into the hierarchy, updates it, and copies world
+// matrices back if any were recomputed, so frames in which nothing moved cost
+// a pass over the changed flags only.
+//
+// Attaching, detaching and reparenting make structural changes to the world,
+// and `update()` writes components, so none of them may run while systems do.
+// Attached entities must be detached before they are destroyed.
+class TransformSystem {
+ public:
+  explicit TransformSystem(World* world);
+  TransformSystem(const TransformSystem&) = delete;
+  TransformSystem& operator=(const TransformSystem&) = delete;
+
+  // Give `entity` a node under that of `parent`, which must be attached, or
+  // a root node if `parent` is the default handle. Adds a `LocalTransform`
+  // with the identity matrix if `entity` has none.
+  void attach(Entity entity, Entity parent = Entity());
+
+  // Remove the node of `entity` along with those of its descendants, and
+  // their `TransformNode` and `WorldTransform` components. Linear in the
+  // number of attached entities.
+  void detach(Entity entity);
+
+  bool attached(Entity entity) const;
+
+  // The following require `entity` to be attached.
+
+  // The default handle for a root.
+  Entity parent(Entity entity) const;
+  // `parent` must be attached, or the default handle to make `entity` a root,
+  // and must not be `entity` or one of its descendants.
+  void setParent(Entity entity, Entity parent);
+
+  // Bring the world transforms of attached entities up to date, spreading
+  // root subtrees over the jobs of `pool` if it is not null.
+  void update(JobPool* pool = nullptr);
+
+  const TransformHierarchy& hierarchy() const;
+
+ private:
+  TransformId node(Entity entity) const;
+
+  World* world_;
+  TransformHierarchy hierarchy_;
+  // Indexed by node id.
+  std::vector<Entity> entities_;
+  Query<const TransformNode, const LocalTransform> changed_locals_;
+  Query<const TransformNode, WorldTransform> worlds_;
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline const TransformHierarchy& TransformSystem::hierarchy() const {
+  return hierarchy_;
+}
+
+}  // namespace y
+#endif  // GAMMA_ENGINE_TRANSFORM_SYSTEM_HPP_
@@ -0,0 +1,122 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/transform_system.hpp"
+
+#include "gamma/common/job_pool.hpp"
+#include "gamma/engine/world.hpp"
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+glm::mat4 Translation(float x, float y, float z) {
+  glm::mat4 m(1.0f);
+  m[3] = glm::vec4(x, y, z, 1.0f);
+  return m;
+}
+
+TEST(TransformSystemTest, UpdatesWorldTransforms) {
+  World world;
+  TransformSystem transforms(&world);
+  Entity root = world.create(LocalTransform{Translation(1, 0, 0)});
+  Entity child = world.create(LocalTransform{Translation(0, 2, 0)});
+  transforms.attach(root);
+  transforms.attach(child, root);
+  EXPECT_EQ(transforms.parent(child), root);
+  EXPECT_EQ(transforms.parent(root), Entity());
+
+  transforms.update();
+  EXPECT_EQ(world.get<const WorldTransform>(child)->matrix,
+            Translation(1, 2, 0));
+
+  world.get<LocalTransform>(root)->matrix = Translation(3, 0, 0);
+  transforms.update();
+  EXPECT_EQ(world.get<const WorldTransform>(root)->matrix,
+            Translation(3, 0, 0));
+  EXPECT_EQ(world.get<const WorldTransform>(child)->matrix,
+            Translation(3, 2, 0));
+}
+
+TEST(TransformSystemTest, AttachAddsMissingLocalTransform) {
+  World world;
+  TransformSystem transforms(&world);
+  Entity entity = world.create();
+  transforms.attach(entity);
+  EXPECT_TRUE(transforms.attached(entity));
+  ASSERT_NE(world.get<const LocalTransform>(entity), nullptr);
+  EXPECT_EQ(world.get<const LocalTransform>(entity)->matrix, glm::mat4(1.0f));
+}
+
+TEST(TransformSystemTest, SkipsUnchangedSubtrees) {
+  World world;
+  TransformSystem transforms(&world);
+  Entity a = world.create(LocalTransform{Translation(1, 0, 0)});
+  Entity b = world.create(LocalTransform{Translation(2, 0, 0)});
+  transforms.attach(a);
+  transforms.attach(b);
+  transforms.update();
+  EXPECT_EQ(transforms.hierarchy().numUpdated(), 2u);
+
+  // Both entities share a chunk, but only one of them moved.
+  world.get<LocalTransform>(a)->matrix = Translation(5, 0, 0);
+  transforms.update();
+  EXPECT_EQ(transforms.hierarchy().numUpdated(), 1u);
+  EXPECT_EQ(world.get<const WorldTransform>(a)->matrix,
+            Translation(5, 0, 0));
+
+  transforms.update();
+  EXPECT_EQ(transforms.hierarchy().numUpdated(), 0u);
+}
+
+TEST(TransformSystemTest, DetachRemovesSubtree) {
+  World world;
+  TransformSystem transforms(&world);
+  Entity root = world.create(LocalTransform{});
+  Entity child = world.create(LocalTransform{});
+  Entity other = world.create(LocalTransform{});
+  transforms.attach(root);
+  transforms.attach(child, root);
+  transforms.attach(other);
+
+  transforms.detach(root);
+  EXPECT_FALSE(transforms.attached(root));
+  EXPECT_FALSE(transforms.attached(child));
+  EXPECT_FALSE(world.has<WorldTransform>(child));
+  EXPECT_TRUE(world.has<LocalTransform>(child));
+  EXPECT_TRUE(transforms.attached(other));
+  EXPECT_EQ(transforms.hierarchy().size(), 1u);
+}
+
+TEST(TransformSystemTest, SetParentAndParallelUpdate) {
+  World world;
+  TransformSystem transforms(&world);
+  Entity a = world.create(LocalTransform{Translation(1, 0, 0)});
+  Entity b = world.create(LocalTransform{Translation(0, 1, 0)});
+  transforms.attach(a);
+  transforms.attach(b);
+  transforms.setParent(b, a);
+
+  JobPool pool(3);
+  transforms.update(&pool);
+  EXPECT_EQ(world.get<const WorldTransform>(b)->matrix,
+            Translation(1, 1, 0));
+}
+
+}  // namespace
+}  // namespace y
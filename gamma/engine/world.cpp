@@ -0,0 +1,181 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/world.hpp"
+
+#include <algorithm>
+
+#include "absl/memory/memory.h"
+
+namespace y {
+
+World::World() {
+  // Entities without components live in archetype 0.
+  findOrCreateArchetype(ComponentMask());
+}
+
+void World::instantiate(const Prefab& prefab, size_t count,
+                        std::vector<Entity>* created) {
+  CheckStructuralChange();
+  uint32_t archetype = findOrCreateArchetype(prefab.mask());
+  Archetype& storage = *archetypes_[archetype];
+  materializeReserved();
+  size_t num_fresh = count - std::min(count, free_indices_.size());
+  records_.reserve(records_.size() + num_fresh);
+  storage.reserve(count);
+  if (created != nullptr) created->reserve(created->size() + count);
+
+  while (count > 0) {
+    uint32_t n;
+    Archetype::Row first = storage.appendRows(count, version(), &n);
+    Entity* entities = storage.entities(first.chunk) + first.index;
+    for (uint32_t i = 0; i < n; ++i) {
+      Entity entity = allocateEntity();
+      records_[entity.index].archetype = archetype;
+      records_[entity.index].row = {first.chunk, first.index + i};
+      entities[i] = entity;
+    }
+    if (created != nullptr) {
+      created->insert(created->end(), entities, entities + n);
+    }
+    for (int column = 0; column < static_cast<int>(storage.types().size());
+         ++column) {
+      prefab.copyTo(storage.types()[column], storage.component(first, column),
+                    n);
+    }
+    count -= n;
+  }
+}
+
+void World::destroy(Entity entity) {
+  CheckStructuralChange();
+  materializeReserved();
+  EntityRecord& entity_record = record(entity);
+  Archetype::Row row = entity_record.row;
+  Entity moved = archetypes_[entity_record.archetype]->erase(row, version());
+  if (moved != Entity()) updateMovedRecord(moved, row);
+  releaseEntity(entity);
+}
+
+void World::releaseEntity(Entity entity) {
+  EntityRecord& entity_record = records_[entity.index];
+  // Wrapping around to generation 0 would make the slot match null handles.
+  if (++entity_record.generation == 0) entity_record.generation = 1;
+  free_indices_.push_back(entity.index);
+  --size_;
+}
+
+bool World::moveChunkFrom(World* other, std::vector<Entity>* created) {
+  CheckStructuralChange();
+  YERR_IF(other == this) << "moving chunks within a world";
+  other->materializeReserved();
+  for (size_t i = other->archetypes_.size(); i-- > 0;) {
+    Archetype* from = other->archetypes_[i].get();
+    if (from->numChunks() == 0) continue;
+    uint32_t archetype = findOrCreateArchetype(from->mask());
+    Archetype& to = *archetypes_[archetype];
+    auto chunk = static_cast<uint32_t>(from->numChunks() - 1);
+    // Rows are taken from the back, so no other rows of `from` move.
+    for (uint32_t index = from->chunk(chunk).size; index-- > 0;) {
+      Archetype::Row from_row = {chunk, index};
+      other->releaseEntity(from->entity(from_row));
+      Entity entity = allocateEntity();
+      Entity moved;
+      Archetype::Row row = to.moveFrom(from, from_row, version(), &moved);
+      to.entities(row.chunk)[row.index] = entity;
+      for (int column = 0; column < static_cast<int>(to.types().size());
+           ++column) {
+        to.markAdded(row.chunk, column, version());
+      }
+      records_[entity.index].archetype = archetype;
+      records_[entity.index].row = row;
+      created->push_back(entity);
+    }
+    return true;
+  }
+  return false;
+}
+
+Entity World::reserve() {
+  uint32_t offset = num_reserved_.fetch_add(1, std::memory_order_relaxed);
+  return Entity{static_cast<uint32_t>(records_.size()) + offset, 1};
+}
+
+void World::materializeReserved() {
+  if (num_reserved_.load(std::memory_order_relaxed) == 0) return;
+  uint32_t num_reserved = num_reserved_.exchange(0, std::memory_order_relaxed);
+  for (uint32_t i = 0; i < num_reserved; ++i) {
+    Entity entity = {static_cast<uint32_t>(records_.size()), 1};
+    Archetype::Row row = archetypes_[0]->pushBack(entity, version());
+    records_.push_back(EntityRecord{1, 0, row});
+  }
+  size_ += num_reserved;
+}
+
+Entity World::allocateEntity() {
+  ++size_;
+  if (!free_indices_.empty()) {
+    uint32_t index = free_indices_.back();
+    free_indices_.pop_back();
+    return Entity{index, records_[index].generation};
+  }
+  // Fresh indices are handed out after the reserved ones.
+  materializeReserved();
+  // Generations start at 1, so that a null handle is never alive.
+  records_.push_back(EntityRecord{1, 0, {0, 0}});
+  return Entity{static_cast<uint32_t>(records_.size() - 1), 1};
+}
+
+uint32_t World::findOrCreateArchetype(const ComponentMask& mask) {
+  auto it = archetype_index_.find(mask);
+  if (it != archetype_index_.end()) return it->second;
+  uint32_t index = static_cast<uint32_t>(archetypes_.size());
+  archetypes_.push_back(absl::make_unique<Archetype>(mask));
+  archetype_index_.emplace(mask, index);
+  return index;
+}
+
+uint32_t World::neighbourArchetype(uint32_t archetype, int type, bool add) {
+  uint64_t key = uint64_t{archetype} << 32 | uint64_t(type) << 1 | add;
+  auto it = neighbours_.find(key);
+  if (it != neighbours_.end()) return it->second;
+
+  ComponentMask mask = archetypes_[archetype]->mask();
+  mask.set(type, add);
+  uint32_t neighbour = findOrCreateArchetype(mask);
+  neighbours_.emplace(key, neighbour);
+  return neighbour;
+}
+
+Archetype::Row World::moveEntity(Entity entity, uint32_t archetype) {
+  EntityRecord& entity_record = record(entity);
+  Archetype::Row from_row = entity_record.row;
+  Entity moved;
+  Archetype::Row row = archetypes_[archetype]->moveFrom(
+      archetypes_[entity_record.archetype].get(), from_row, version(), &moved);
+  entity_record.archetype = archetype;
+  entity_record.row = row;
+  if (moved != Entity()) updateMovedRecord(moved, from_row);
+  return row;
+}
+
+void World::updateMovedRecord(Entity moved, Archetype::Row row) {
+  records_[moved.index].row = row;
+}
+
+}  // namespace y
@@ -16,12 +16,568 @@
 //    misrepresented as being the original software.
 // 3. This notice may not be removed or altered from any source distribution.
 
-#ifndef GAMMA_APP_WORLD_HPP_
-#define GAMMA_APP_WORLD_HPP_
+#ifndef GAMMA_ENGINE_WORLD_HPP_
+#define GAMMA_ENGINE_WORLD_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "gamma/common/log.hpp"
+#include "gamma/engine/access.hpp"
+#include "gamma/engine/archetype.hpp"
+#include "gamma/engine/component.hpp"
+#include "gamma/engine/entity.hpp"
+#include "gamma/engine/prefab.hpp"
+
+namespace y {
+
+class CommandQueue;
+class SnapshotSchema;
+
+template <typename... Ts>
+class Query;
+
+// Query filters that match chunks in which a component of type `T` was changed
+// or added since the query last iterated.
+template <typename T>
+struct Changed {};
+template <typename T>
+struct Added {};
+
+// Entity and component storage.
+//
+// An entity is a handle to a set of components, at most one of each type.
+// Entities with the same set of component types share an `Archetype`, which
+// stores their components in contiguous arrays, and queries iterate over
+// those arrays for every archetype that has the requested types.
+//
+// Adding or removing components moves an entity to another archetype, which
+// invalidates pointers to its components and to components of the entity
+// that takes its old place. Structural changes, meaning creating and
+// destroying entities and adding and removing components, must not happen
+// while a query is iterating.
+//
+// Not thread-safe, except that component reads and writes may run
+// concurrently when they do not conflict, as arranged by `SystemScheduler`.
+// Inside a `ComponentAccessScope`, debug builds check that component access
+// matches the declared access and that no structural changes are made.
+//
+// Changes are tracked per chunk and component type against a version counter
+// that every query iteration advances. Creating an entity, adding a component,
+// and moving a row within an archetype mark the chunk's columns added or
+// changed, as do mutable `get()` and mutable query iteration, whether or not
+// the component is actually written.
+class World {
+ public:
+  World();
+  World(const World&) = delete;
+  World& operator=(const World&) = delete;
+
+  // Create an entity with the given components, which must be of distinct
+  // types.
+  template <typename... Ts>
+  Entity create(Ts&&... components);
+
+  // Create `count` entities with the components of `prefab`, appending their
+  // handles to `created` if it is not null. Storage is filled a chunk at a
+  // time.
+  void instantiate(const Prefab& prefab, size_t count,
+                   std::vector<Entity>* created = nullptr);
+
+  void destroy(Entity entity);
+
+  // Reserve a handle for an entity without creating it. The entity comes to
+  // life, without components, at the next structural change, meaning a call
+  // that creates or destroys entities or adds or removes a component type,
+  // or at command playback. Until then it is not alive. Thread-safe with
+  // respect to other calls to `reserve()` and to component access.
+  Entity reserve();
+
+  bool alive(Entity entity) const;
+
+  // Number of live entities.
+  size_t size() const;
+
+  // The following require `entity` to be alive.
+
+  template <typename T>
+  bool has(Entity entity) const;
+
+  // Returns null if `entity` has no component of type `T`.
+  template <typename T>
+  T* get(Entity entity);
+  template <typename T>
+  const T* get(Entity entity) const;
+
+  // Add `component` to `entity`, replacing any existing component of the same
+  // type.
+  template <typename T>
+  T& add(Entity entity, T component);
+
+  // Does nothing if `entity` has no component of type `T`.
+  template <typename T>
+  void remove(Entity entity);
+
+  // Move the entities in the last chunk of `other`, another world, into this
+  // one, appending their new handles to `created`. Handles stored in their
+  // components are not remapped. Returns false if `other` has no entities.
+  bool moveChunkFrom(World* other, std::vector<Entity>* created);
+
+  // Iterate over all entities that have components of types `Ts`. Read-only
+  // access to a component can be requested with a const type.
+  template <typename... Ts>
+  Query<Ts...> query();
+
+  // Archetypes are never destroyed, and new ones are appended.
+  size_t numArchetypes() const;
+  Archetype& archetype(size_t i) const;
+
+  // The version that changes are currently marked with.
+  uint32_t version() const;
+  // Increment the version, returning the previous one. Thread-safe.
+  uint32_t advanceVersion();
+
+ private:
+  friend class CommandQueue;
+  friend void SaveSnapshot(World* world, const SnapshotSchema& schema,
+                           const std::string& path);
+  friend void LoadSnapshot(const SnapshotSchema& schema,
+                           const std::string& path, World* world);
+
+  struct EntityRecord {
+    uint32_t generation;
+    uint32_t archetype;
+    Archetype::Row row;
+  };
+
+  EntityRecord& record(Entity entity);
+  const EntityRecord& record(Entity entity) const;
+  // Address of the component of `type`, or null.
+  void* find(Entity entity, int type) const;
+  // As `find()`, also marking the component changed.
+  void* findChanged(Entity entity, int type);
+
+  Entity allocateEntity();
+  // Free the index of `entity`, whose row has already been removed.
+  void releaseEntity(Entity entity);
+  void materializeReserved();
+  uint32_t findOrCreateArchetype(const ComponentMask& mask);
+  // The archetype with `type` added to or removed from `archetype`.
+  uint32_t neighbourArchetype(uint32_t archetype, int type, bool add);
+  // Move `entity` to `archetype`, returning its new row.
+  Archetype::Row moveEntity(Entity entity, uint32_t archetype);
+  void updateMovedRecord(Entity moved, Archetype::Row row);
+
+  template <typename T>
+  void construct(uint32_t archetype, Archetype::Row row, T&& component);
+
+  std::vector<EntityRecord> records_;
+  std::vector<uint32_t> free_indices_;
+  // Reserved entities take the indices following `records_`.
+  std::atomic<uint32_t> num_reserved_{0};
+  size_t size_ = 0;
+  std::atomic<uint32_t> version_{1};
+
+  // Snapshot file mapping that loaded chunks may point into. Declared before
+  // the archetypes so that it outlives them.
+  std::shared_ptr<void> mapping_;
+  std::vector<std::unique_ptr<Archetype>> archetypes_;
+  std::unordered_map<ComponentMask, uint32_t> archetype_index_;
+  // Keyed by archetype, component type and whether it is added or removed.
+  std::unordered_map<uint64_t, uint32_t> neighbours_;
+};
+
+// Iterates over the entities of a `World` that have all of the component types
+// `Ts`, chunk by chunk. Archetypes created after the query are picked up by
+// the next iteration.
+//
+// With filters set, only chunks in which all of the filtered components were
+// changed or added since the previous iteration of this query are visited.
+// The first iteration visits every chunk. Iterating marks the mutable
+// components of every visited chunk changed, but a query does not see its own
+// changes on its next iteration.
+template <typename... Ts>
+class Query {
+  static_assert(sizeof...(Ts) <= 32, "too many component types");
+
+ public:
+  // The components of the query's entities in one chunk.
+  class ChunkView {
+   public:
+    size_t size() const;
+    const Entity* entities() const;
+
+    // Array of `size()` components. `T` must be one of `Ts`, with the same
+    // qualification.
+    template <typename T>
+    T* get() const;
+
+   private:
+    friend class Query;
+
+    size_t size_;
+    const Entity* entities_;
+    std::array<void*, sizeof...(Ts)> columns_;
+  };
+
+  explicit Query(World* world);
+
+  // Only visit chunks in which a component of type `T` changed, or was added,
+  // since the previous iteration. `T` must be one of `Ts`, ignoring const.
+  template <typename T>
+  Query& filter(Changed<T>);
+  template <typename T>
+  Query& filter(Added<T>);
+
+  // Number of matching entities, ignoring filters.
+  size_t size();
+
+  // Call `f(const ChunkView&)` for every non-empty matching chunk.
+  template <typename F>
+  void forEachChunk(F&& f);
+
+  // Call `f(Ts&...)` for every matching entity.
+  template <typename F>
+  void forEach(F&& f);
+
+  // Call `f(Entity, Ts&...)` for every matching entity.
+  template <typename F>
+  void forEachEntity(F&& f);
+
+ private:
+  struct Match {
+    Archetype* archetype;
+    std::array<int, sizeof...(Ts)> columns;
+  };
+
+  void update();
+  bool passesFilters(const Match& match, size_t chunk, uint32_t since) const;
+  ChunkView view(const Match& match, size_t chunk) const;
+
+  template <typename F, size_t... Is>
+  static void ForEachRow(const ChunkView& view, F& f,
+                         std::index_sequence<Is...>);
+  template <typename F, size_t... Is>
+  static void ForEachEntityRow(const ChunkView& view, F& f,
+                               std::index_sequence<Is...>);
+
+  World* world_;
+  ComponentMask mask_;
+  size_t archetypes_seen_ = 0;
+  std::vector<Match> matches_;
+  // Bits indexed like `Ts`.
+  uint32_t changed_filter_ = 0;
+  uint32_t added_filter_ = 0;
+  uint32_t last_version_ = 0;
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+}  // namespace y
+
+namespace y_internal {
+
+template <typename T, typename... Ts>
+struct TypeIndex;
+
+template <typename T, typename... Ts>
+struct TypeIndex<T, T, Ts...> : std::integral_constant<size_t, 0> {};
+
+template <typename T, typename U, typename... Ts>
+struct TypeIndex<T, U, Ts...>
+    : std::integral_constant<size_t, 1 + TypeIndex<T, Ts...>::value> {};
+
+}  // namespace y_internal
 
 namespace y {
 
-class World {};
+inline bool World::alive(Entity entity) const {
+  return entity.index < records_.size() &&
+         records_[entity.index].generation == entity.generation;
+}
+
+inline size_t World::size() const { return size_; }
+
+inline size_t World::numArchetypes() const { return archetypes_.size(); }
+
+inline Archetype& World::archetype(size_t i) const { return *archetypes_[i]; }
+
+inline uint32_t World::version() const {
+  return version_.load(std::memory_order_relaxed);
+}
+
+inline uint32_t World::advanceVersion() {
+  return version_.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline World::EntityRecord& World::record(Entity entity) {
+  YERR_IF(!alive(entity)) << "entity is not alive";
+  return records_[entity.index];
+}
+
+inline const World::EntityRecord& World::record(Entity entity) const {
+  YERR_IF(!alive(entity)) << "entity is not alive";
+  return records_[entity.index];
+}
+
+inline void* World::find(Entity entity, int type) const {
+  const EntityRecord& entity_record = record(entity);
+  const Archetype& archetype = *archetypes_[entity_record.archetype];
+  int column = archetype.column(type);
+  if (column < 0) return nullptr;
+  return archetype.component(entity_record.row, column);
+}
+
+inline void* World::findChanged(Entity entity, int type) {
+  const EntityRecord& entity_record = record(entity);
+  Archetype& archetype = *archetypes_[entity_record.archetype];
+  int column = archetype.column(type);
+  if (column < 0) return nullptr;
+  archetype.markChanged(entity_record.row.chunk, column, version());
+  return archetype.component(entity_record.row, column);
+}
+
+template <typename... Ts>
+Entity World::create(Ts&&... components) {
+  CheckStructuralChange();
+  materializeReserved();
+  // Leading zero so the array is never empty.
+  const int types[] = {0, ComponentTypeId<Ts>()...};
+  ComponentMask mask;
+  for (size_t i = 1; i < sizeof(types) / sizeof(types[0]); ++i) {
+    YERR_IF(mask[types[i]]) << "duplicate component type";
+    mask.set(types[i]);
+  }
+
+  Entity entity = allocateEntity();
+  EntityRecord& entity_record = records_[entity.index];
+  entity_record.archetype = findOrCreateArchetype(mask);
+  Archetype& archetype = *archetypes_[entity_record.archetype];
+  entity_record.row = archetype.pushBack(entity, version());
+  for (int i = 0; i < static_cast<int>(archetype.types().size()); ++i) {
+    archetype.markAdded(entity_record.row.chunk, i, version());
+  }
+
+  const int expand[] = {0, (construct(entity_record.archetype,
+                                      entity_record.row,
+                                      std::forward<Ts>(components)),
+                            0)...};
+  (void)expand;
+  return entity;
+}
+
+template <typename T>
+bool World::has(Entity entity) const {
+  return archetypes_[record(entity).archetype]->column(ComponentTypeId<T>()) >=
+         0;
+}
+
+template <typename T>
+T* World::get(Entity entity) {
+  int type = ComponentTypeId<T>();
+  CheckComponentAccess(type, !std::is_const<T>::value);
+  if (std::is_const<T>::value) return static_cast<T*>(find(entity, type));
+  return static_cast<T*>(findChanged(entity, type));
+}
+
+template <typename T>
+const T* World::get(Entity entity) const {
+  int type = ComponentTypeId<T>();
+  CheckComponentAccess(type, false);
+  return static_cast<const T*>(find(entity, type));
+}
+
+template <typename T>
+T& World::add(Entity entity, T component) {
+  if (T* existing = get<T>(entity)) {
+    *existing = std::move(component);
+    return *existing;
+  }
+  CheckStructuralChange();
+  materializeReserved();
+  uint32_t archetype = neighbourArchetype(record(entity).archetype,
+                                          ComponentTypeId<T>(), true);
+  Archetype::Row row = moveEntity(entity, archetype);
+  construct(archetype, row, std::move(component));
+  return *static_cast<T*>(find(entity, ComponentTypeId<T>()));
+}
+
+template <typename T>
+void World::remove(Entity entity) {
+  if (!has<T>(entity)) return;
+  CheckStructuralChange();
+  materializeReserved();
+  moveEntity(entity, neighbourArchetype(record(entity).archetype,
+                                        ComponentTypeId<T>(), false));
+}
+
+template <typename... Ts>
+Query<Ts...> World::query() {
+  return Query<Ts...>(this);
+}
+
+template <typename T>
+void World::construct(uint32_t archetype, Archetype::Row row, T&& component) {
+  using Component = typename std::decay<T>::type;
+  const Archetype& storage = *archetypes_[archetype];
+  void* address =
+      storage.component(row, storage.column(ComponentTypeId<Component>()));
+  new (address) Component(std::forward<T>(component));
+}
+
+template <typename... Ts>
+size_t Query<Ts...>::ChunkView::size() const {
+  return size_;
+}
+
+template <typename... Ts>
+const Entity* Query<Ts...>::ChunkView::entities() const {
+  return entities_;
+}
+
+template <typename... Ts>
+template <typename T>
+T* Query<Ts...>::ChunkView::get() const {
+  return static_cast<T*>(columns_[y_internal::TypeIndex<T, Ts...>::value]);
+}
+
+template <typename... Ts>
+Query<Ts...>::Query(World* world) : world_(world) {
+  const int types[] = {0, ComponentTypeId<Ts>()...};
+  for (size_t i = 1; i < sizeof(types) / sizeof(types[0]); ++i) {
+    mask_.set(types[i]);
+  }
+}
+
+template <typename... Ts>
+template <typename T>
+Query<Ts...>& Query<Ts...>::filter(Changed<T>) {
+  changed_filter_ |= 1u << y_internal::TypeIndex<const T, const Ts...>::value;
+  return *this;
+}
+
+template <typename... Ts>
+template <typename T>
+Query<Ts...>& Query<Ts...>::filter(Added<T>) {
+  added_filter_ |= 1u << y_internal::TypeIndex<const T, const Ts...>::value;
+  return *this;
+}
+
+template <typename... Ts>
+void Query<Ts...>::update() {
+  for (; archetypes_seen_ < world_->numArchetypes(); ++archetypes_seen_) {
+    Archetype& archetype = world_->archetype(archetypes_seen_);
+    if ((archetype.mask() & mask_) != mask_) continue;
+    matches_.push_back(
+        Match{&archetype, {{archetype.column(ComponentTypeId<Ts>())...}}});
+  }
+}
+
+template <typename... Ts>
+bool Query<Ts...>::passesFilters(const Match& match, size_t chunk,
+                                 uint32_t since) const {
+  for (size_t i = 0; i < sizeof...(Ts); ++i) {
+    if ((changed_filter_ >> i & 1) &&
+        match.archetype->changedVersion(chunk, match.columns[i]) <= since) {
+      return false;
+    }
+    if ((added_filter_ >> i & 1) &&
+        match.archetype->addedVersion(chunk, match.columns[i]) <= since) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename... Ts>
+typename Query<Ts...>::ChunkView Query<Ts...>::view(const Match& match,
+                                                     size_t chunk) const {
+  ChunkView view;
+  view.size_ = match.archetype->chunk(chunk).size;
+  view.entities_ = match.archetype->entities(chunk);
+  for (size_t i = 0; i < sizeof...(Ts); ++i) {
+    view.columns_[i] = match.archetype->columnData(chunk, match.columns[i]);
+  }
+  return view;
+}
+
+template <typename... Ts>
+size_t Query<Ts...>::size() {
+  update();
+  size_t size = 0;
+  for (const Match& match : matches_) size += match.archetype->size();
+  return size;
+}
+
+template <typename... Ts>
+template <typename F>
+void Query<Ts...>::forEachChunk(F&& f) {
+  const int expand[] = {0, (CheckComponentAccess(ComponentTypeId<Ts>(),
+                                                 !std::is_const<Ts>::value),
+                            0)...};
+  (void)expand;
+  const bool is_mutable[] = {false, !std::is_const<Ts>::value...};
+  update();
+  uint32_t since = last_version_;
+  last_version_ = world_->advanceVersion();
+  for (const Match& match : matches_) {
+    for (size_t i = 0; i < match.archetype->numChunks(); ++i) {
+      if (!passesFilters(match, i, since)) continue;
+      for (size_t j = 0; j < sizeof...(Ts); ++j) {
+        if (is_mutable[j + 1]) {
+          match.archetype->markChanged(i, match.columns[j], last_version_);
+        }
+      }
+      f(view(match, i));
+    }
+  }
+}
+
+template <typename... Ts>
+template <typename F>
+void Query<Ts...>::forEach(F&& f) {
+  forEachChunk([&f](const ChunkView& view) {
+    ForEachRow(view, f, std::index_sequence_for<Ts...>());
+  });
+}
+
+template <typename... Ts>
+template <typename F>
+void Query<Ts...>::forEachEntity(F&& f) {
+  forEachChunk([&f](const ChunkView& view) {
+    ForEachEntityRow(view, f, std::index_sequence_for<Ts...>());
+  });
+}
+
+template <typename... Ts>
+template <typename F, size_t... Is>
+void Query<Ts...>::ForEachRow(const ChunkView& view, F& f,
+                              std::index_sequence<Is...>) {
+  std::tuple<Ts*...> columns(view.template get<Ts>()...);
+  for (size_t row = 0; row < view.size(); ++row) {
+    f(std::get<Is>(columns)[row]...);
+  }
+}
+
+template <typename... Ts>
+template <typename F, size_t... Is>
+void Query<Ts...>::ForEachEntityRow(const ChunkView& view, F& f,
+                                    std::index_sequence<Is...>) {
+  std::tuple<Ts*...> columns(view.template get<Ts>()...);
+  for (size_t row = 0; row < view.size(); ++row) {
+    f(view.entities()[row], std::get<Is>(columns)[row]...);
+  }
+}
 
 }  // namespace y
-#endif GAMMA_APP_WORLD_HPP_
+#endif  // GAMMA_ENGINE_WORLD_HPP_
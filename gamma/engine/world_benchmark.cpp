@@ -0,0 +1,245 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+// ECS microbenchmarks at 10k, 100k and 1M entities. For results that can be
+// tracked across commits, pass --benchmark_format=json, or
+// --benchmark_out=<file> to write JSON to a file.
+
+#include <cmath>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "gamma/common/job_pool.hpp"
+#include "gamma/engine/scheduler.hpp"
+#include "gamma/engine/world.hpp"
+
+namespace y {
+namespace {
+
+struct Position {
+  float x, y, z;
+};
+
+struct Velocity {
+  float x, y, z;
+};
+
+struct Acceleration {
+  float x, y, z;
+};
+
+struct Mass {
+  float value;
+};
+
+void EntityCounts(benchmark::internal::Benchmark* benchmark) {
+  benchmark->RangeMultiplier(10)->Range(10000, 1000000);
+}
+
+// A world of `n` entities with all four component types.
+void Populate(World* world, int64_t n, std::vector<Entity>* entities) {
+  for (int64_t i = 0; i < n; ++i) {
+    Entity entity = world->create(Position{}, Velocity{1, 1, 1},
+                                  Acceleration{0, -1, 0}, Mass{1});
+    if (entities != nullptr) entities->push_back(entity);
+  }
+}
+
+void BM_Create(benchmark::State& state) {
+  for (auto _ : state) {
+    World world;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      world.create(Position{}, Velocity{1, 1, 1});
+    }
+    benchmark::DoNotOptimize(world.size());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Create)->Apply(EntityCounts)->Unit(benchmark::kMillisecond);
+
+void BM_Instantiate(benchmark::State& state) {
+  Prefab prefab(Position{}, Velocity{1, 1, 1});
+  for (auto _ : state) {
+    World world;
+    world.instantiate(prefab, state.range(0));
+    benchmark::DoNotOptimize(world.size());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Instantiate)->Apply(EntityCounts)->Unit(benchmark::kMillisecond);
+
+// Creating and destroying entities in a world whose storage is already
+// allocated, so index and chunk reuse is measured rather than allocation.
+void BM_CreateDestroy(benchmark::State& state) {
+  World world;
+  std::vector<Entity> entities(state.range(0));
+  for (Entity& entity : entities) entity = world.create(Position{});
+  for (Entity entity : entities) world.destroy(entity);
+  for (auto _ : state) {
+    for (Entity& entity : entities) {
+      entity = world.create(Position{}, Velocity{1, 1, 1});
+    }
+    for (Entity entity : entities) world.destroy(entity);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CreateDestroy)
+    ->Apply(EntityCounts)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_Iterate1(benchmark::State& state) {
+  World world;
+  Populate(&world, state.range(0), nullptr);
+  auto query = world.query<Position>();
+  for (auto _ : state) {
+    query.forEach([](Position& p) { p.y -= 1; });
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Iterate1)->Apply(EntityCounts);
+
+void BM_Iterate2(benchmark::State& state) {
+  World world;
+  Populate(&world, state.range(0), nullptr);
+  auto query = world.query<Position, const Velocity>();
+  for (auto _ : state) {
+    query.forEach([](Position& p, const Velocity& v) {
+      p.x += v.x;
+      p.y += v.y;
+      p.z += v.z;
+    });
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Iterate2)->Apply(EntityCounts);
+
+void Integrate(Position& p, Velocity& v, const Acceleration& a,
+               const Mass& m) {
+  float inverse_mass = 1 / m.value;
+  v.x += a.x * inverse_mass;
+  v.y += a.y * inverse_mass;
+  v.z += a.z * inverse_mass;
+  p.x += v.x;
+  p.y += v.y;
+  p.z += v.z;
+}
+
+void BM_Iterate4(benchmark::State& state) {
+  World world;
+  Populate(&world, state.range(0), nullptr);
+  auto query =
+      world.query<Position, Velocity, const Acceleration, const Mass>();
+  for (auto _ : state) {
+    query.forEach(Integrate);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Iterate4)->Apply(EntityCounts);
+
+// Baseline for `BM_Iterate2`: the same update over two plain arrays.
+void BM_IterateArrays(benchmark::State& state) {
+  std::vector<Position> positions(state.range(0));
+  std::vector<Velocity> velocities(state.range(0), Velocity{1, 1, 1});
+  for (auto _ : state) {
+    for (size_t i = 0; i < positions.size(); ++i) {
+      positions[i].x += velocities[i].x;
+      positions[i].y += velocities[i].y;
+      positions[i].z += velocities[i].z;
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_IterateArrays)->Apply(EntityCounts);
+
+void BM_GetByHandle(benchmark::State& state) {
+  World world;
+  std::vector<Entity> entities;
+  Populate(&world, state.range(0), &entities);
+  // A fixed stride visits entities in an order unrelated to storage.
+  size_t stride = 7919;
+  for (auto _ : state) {
+    float sum = 0;
+    for (size_t i = 0, j = 0; i < entities.size(); ++i) {
+      sum += world.get<const Position>(entities[j])->x;
+      j = (j + stride) % entities.size();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetByHandle)->Apply(EntityCounts);
+
+// Adding and then removing a component on every entity, each of which moves
+// the entity between archetypes.
+void BM_AddRemove(benchmark::State& state) {
+  World world;
+  std::vector<Entity> entities;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    entities.push_back(world.create(Position{}, Velocity{1, 1, 1}));
+  }
+  for (auto _ : state) {
+    for (Entity entity : entities) world.add(entity, Mass{1});
+    for (Entity entity : entities) world.remove<Mass>(entity);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * 2);
+}
+BENCHMARK(BM_AddRemove)->Apply(EntityCounts)->Unit(benchmark::kMillisecond);
+
+using IntegrateQuery =
+    Query<Position, Velocity, const Acceleration, const Mass>;
+
+void IntegrateChunk(const IntegrateQuery::ChunkView& view) {
+  Position* positions = view.get<Position>();
+  Velocity* velocities = view.get<Velocity>();
+  const Acceleration* accelerations = view.get<const Acceleration>();
+  const Mass* masses = view.get<const Mass>();
+  for (size_t i = 0; i < view.size(); ++i) {
+    Integrate(positions[i], velocities[i], accelerations[i], masses[i]);
+    velocities[i].x = std::sqrt(std::abs(velocities[i].x));
+  }
+}
+
+void EntityCountsAndWorkers(benchmark::internal::Benchmark* benchmark) {
+  for (int64_t entities : {10000, 100000, 1000000}) {
+    for (int64_t workers : {0, 1, 2, 4, 8}) {
+      benchmark->Args({entities, workers});
+    }
+  }
+}
+
+// `BM_Iterate4` as a query system run by the scheduler on a pool of
+// `state.range(1)` workers, with a square root per entity so that scaling is
+// not bound by memory bandwidth alone.
+void BM_ParallelQuery(benchmark::State& state) {
+  World world;
+  Populate(&world, state.range(0), nullptr);
+  JobPool pool(static_cast<int>(state.range(1)));
+  SystemScheduler scheduler(&world, &pool);
+  scheduler.addQuerySystem<Position, Velocity, const Acceleration,
+                           const Mass>("integrate", &IntegrateChunk);
+  for (auto _ : state) scheduler.run();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParallelQuery)->Apply(EntityCountsAndWorkers)->UseRealTime();
+
+}  // namespace
+}  // namespace y
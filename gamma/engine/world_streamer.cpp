@@ -0,0 +1,228 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/world_streamer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "gamma/common/log.hpp"
+#include "gamma/common/watch.hpp"
+
+namespace y {
+namespace {
+
+// Entities destroyed between checks of the unload budget.
+constexpr size_t kDestroysPerCheck = 64;
+
+}  // namespace
+
+WorldStreamer::WorldStreamer(World* world, JobPool* pool,
+                             const Options& options, Decoder decode)
+    : world_(world),
+      pool_(pool),
+      options_(options),
+      decode_(std::move(decode)) {
+  YERR_IF(options_.cell_size <= 0) << "cell size must be positive";
+  YERR_IF(options_.unload_radius < options_.load_radius)
+      << "unload radius must be at least the load radius";
+}
+
+WorldStreamer::~WorldStreamer() { pool_->wait(&decoding_); }
+
+void WorldStreamer::update(absl::Span<const glm::vec3> observers) {
+  collectDecoded();
+
+  for (auto it = cells_.begin(); it != cells_.end();) {
+    Cell* cell = it->second.get();
+    if (cell->state == CellState::kUnloading) {
+      ++it;
+      continue;
+    }
+    bool in_range = false;
+    for (const glm::vec3& observer : observers) {
+      in_range |= distance(cell->coord, observer) <= options_.unload_radius;
+    }
+    if (in_range) {
+      cell->cancelled = false;
+      ++it;
+    } else if (cell->state == CellState::kDecoding) {
+      cell->cancelled = true;
+      ++it;
+    } else {
+      unload(cell);
+      ++it;
+    }
+  }
+
+  // Cells in range that are not loaded, nearest first.
+  std::vector<std::pair<float, CellCoord>> wanted;
+  auto reach = static_cast<int32_t>(
+      std::ceil(options_.load_radius / options_.cell_size));
+  for (const glm::vec3& observer : observers) {
+    CellCoord center = cellAt(observer);
+    for (int32_t z = center.z - reach; z <= center.z + reach; ++z) {
+      for (int32_t y = center.y - reach; y <= center.y + reach; ++y) {
+        for (int32_t x = center.x - reach; x <= center.x + reach; ++x) {
+          CellCoord coord = {x, y, z};
+          float d = distance(coord, observer);
+          if (d > options_.load_radius) continue;
+          if (cells_.count(coord) == 0) wanted.emplace_back(d, coord);
+        }
+      }
+    }
+  }
+  std::stable_sort(wanted.begin(), wanted.end(),
+                   [](const std::pair<float, CellCoord>& a,
+                      const std::pair<float, CellCoord>& b) {
+                     return a.first < b.first;
+                   });
+  for (const std::pair<float, CellCoord>& entry : wanted) {
+    // Cells near several observers are wanted more than once.
+    if (cells_.count(entry.second) != 0) continue;
+    auto cell = absl::make_unique<Cell>(
+        Cell{entry.second, CellState::kDecoding, false, nullptr, {}});
+    Cell* decoding = cell.get();
+    cells_.emplace(entry.second, std::move(cell));
+    pool_->schedule(&decoding_, [this, decoding]() { decode(decoding); });
+  }
+
+  absl::Duration elapsed = unloadQueued(options_.merge_budget);
+  mergeQueued(options_.merge_budget - elapsed);
+}
+
+void WorldStreamer::flush() {
+  pool_->wait(&decoding_);
+  collectDecoded();
+  unloadQueued(absl::InfiniteDuration());
+  mergeQueued(absl::InfiniteDuration());
+}
+
+WorldStreamer::CellState WorldStreamer::state(const CellCoord& coord) const {
+  auto it = cells_.find(coord);
+  return it == cells_.end() ? CellState::kUnloaded : it->second->state;
+}
+
+const std::vector<Entity>* WorldStreamer::entities(
+    const CellCoord& coord) const {
+  auto it = cells_.find(coord);
+  if (it == cells_.end() || it->second->state == CellState::kDecoding) {
+    return nullptr;
+  }
+  return &it->second->entities;
+}
+
+CellCoord WorldStreamer::cellAt(const glm::vec3& position) const {
+  return CellCoord{
+      static_cast<int32_t>(std::floor(position.x / options_.cell_size)),
+      static_cast<int32_t>(std::floor(position.y / options_.cell_size)),
+      static_cast<int32_t>(std::floor(position.z / options_.cell_size))};
+}
+
+void WorldStreamer::decode(Cell* cell) {
+  auto staging = absl::make_unique<World>();
+  decode_(cell->coord, staging.get());
+  absl::MutexLock lock(&mutex_);
+  cell->staging = std::move(staging);
+  decoded_.push_back(cell);
+}
+
+void WorldStreamer::collectDecoded() {
+  std::vector<Cell*> decoded;
+  {
+    absl::MutexLock lock(&mutex_);
+    decoded.swap(decoded_);
+  }
+  for (Cell* cell : decoded) {
+    if (cell->cancelled) {
+      cells_.erase(cell->coord);
+      continue;
+    }
+    cell->state = CellState::kMerging;
+    merge_queue_.push_back(cell);
+  }
+}
+
+void WorldStreamer::mergeQueued(absl::Duration budget) {
+  Watch watch;
+  absl::Duration elapsed;
+  while (!merge_queue_.empty()) {
+    Cell* cell = merge_queue_.front();
+    bool moved = world_->moveChunkFrom(cell->staging.get(), &cell->entities);
+    if (cell->staging->size() == 0) {
+      cell->staging.reset();
+      cell->state = CellState::kLoaded;
+      ++num_loaded_;
+      merge_queue_.pop_front();
+    }
+    if (moved) {
+      elapsed += watch.lap();
+      if (elapsed >= budget) break;
+    }
+  }
+}
+
+absl::Duration WorldStreamer::unloadQueued(absl::Duration budget) {
+  Watch watch;
+  absl::Duration elapsed;
+  while (!unload_queue_.empty()) {
+    Cell* cell = unload_queue_.front();
+    std::vector<Entity>& entities = cell->entities;
+    for (size_t i = 0; i < kDestroysPerCheck && !entities.empty(); ++i) {
+      // Gameplay may have destroyed some of the cell's entities already.
+      if (world_->alive(entities.back())) world_->destroy(entities.back());
+      entities.pop_back();
+    }
+    if (entities.empty()) {
+      unload_queue_.pop_front();
+      cells_.erase(cell->coord);
+    }
+    elapsed += watch.lap();
+    if (elapsed >= budget) break;
+  }
+  return elapsed;
+}
+
+void WorldStreamer::unload(Cell* cell) {
+  if (cell->state == CellState::kMerging) {
+    merge_queue_.erase(
+        std::find(merge_queue_.begin(), merge_queue_.end(), cell));
+    cell->staging.reset();
+  } else {
+    --num_loaded_;
+  }
+  cell->state = CellState::kUnloading;
+  unload_queue_.push_back(cell);
+}
+
+float WorldStreamer::distance(const CellCoord& coord,
+                              const glm::vec3& position) const {
+  const int32_t cell[] = {coord.x, coord.y, coord.z};
+  float squared = 0;
+  for (int i = 0; i < 3; ++i) {
+    float min = cell[i] * options_.cell_size;
+    float d = std::max(
+        {min - position[i], position[i] - (min + options_.cell_size), 0.0f});
+    squared += d * d;
+  }
+  return std::sqrt(squared);
+}
+
+}  // namespace y
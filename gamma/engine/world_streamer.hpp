@@ -0,0 +1,185 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_ENGINE_WORLD_STREAMER_HPP_
+#define GAMMA_ENGINE_WORLD_STREAMER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "gamma/common/function.hpp"
+#include "gamma/common/job_pool.hpp"
+#include "gamma/engine/entity.hpp"
+#include "gamma/engine/world.hpp"
+#include "glm/glm.hpp"
+
+namespace y {
+
+// Integer coordinates of a cell of a `WorldStreamer` grid.
+struct CellCoord {
+  int32_t x, y, z;
+};
+
+bool operator==(const CellCoord& a, const CellCoord& b);
+bool operator!=(const CellCoord& a, const CellCoord& b);
+
+// Streams the entities of a large world in and out of a `World` by grid cell.
+//
+// Space is divided into cubes of `cell_size`. Cells that come within
+// `load_radius` of an observer are decoded by a user function on job workers,
+// each into a staging world of its own, and queued. At every frame boundary
+// `update()` merges queued cells into the streamed world, one chunk at a
+// time, until `merge_budget` is used up, so a large cell is spread over
+// several frames rather than causing a hitch. Cells that are farther than
+// `unload_radius` from every observer have their entities destroyed, under
+// the same budget and before any merging; the gap between the two radii keeps
+// cells near the edge from thrashing.
+//
+// Entities get new handles when merged, so components of a cell should not
+// refer to each other by handle. Decoding a cell may for example call
+// `LoadSnapshot()` on its staging world.
+class WorldStreamer {
+ public:
+  struct Options {
+    float cell_size = 64;
+    float load_radius = 192;
+    // At least `load_radius`.
+    float unload_radius = 256;
+    // Time spent unloading and merging per update. At least a few entities
+    // are destroyed, and one chunk is merged, per update while cells are
+    // queued for either.
+    absl::Duration merge_budget = absl::Milliseconds(1);
+  };
+
+  enum class CellState {
+    kUnloaded,
+    // Being decoded by a worker.
+    kDecoding,
+    // Decoded and queued, possibly partially merged.
+    kMerging,
+    kLoaded,
+    // Out of range and queued, possibly partially destroyed. The cell is not
+    // loaded again until it is fully unloaded.
+    kUnloading,
+  };
+
+  // Fills a staging world with the entities of a cell. Called on job workers,
+  // possibly concurrently, and must not touch the streamed world.
+  using Decoder = Function<void(const CellCoord&, World*)>;
+
+  WorldStreamer(World* world, JobPool* pool, const Options& options,
+                Decoder decode);
+  WorldStreamer(const WorldStreamer&) = delete;
+  WorldStreamer& operator=(const WorldStreamer&) = delete;
+  // Waits for cells being decoded. Merged entities stay in the world.
+  ~WorldStreamer();
+
+  // Start loading cells near `observers`, unload cells far from all of them,
+  // and merge decoded cells within the budget. Makes structural changes to
+  // the world, so it must not run while systems do.
+  void update(absl::Span<const glm::vec3> observers);
+
+  // Wait for all cells being decoded, unload every cell queued for it, and
+  // merge every queued cell, regardless of the budget, for example behind a
+  // loading screen.
+  void flush();
+
+  CellState state(const CellCoord& coord) const;
+
+  // Cells whose entities are fully merged.
+  size_t numLoaded() const;
+
+  // Entities merged so far from a cell that is merging or loaded, or not yet
+  // destroyed from one that is unloading, or null.
+  const std::vector<Entity>* entities(const CellCoord& coord) const;
+
+  CellCoord cellAt(const glm::vec3& position) const;
+
+ private:
+  struct Cell {
+    CellCoord coord;
+    CellState state;
+    // Set when a decoding cell goes out of range; it is dropped once decoded.
+    bool cancelled;
+    // Decoded entities that are not merged yet.
+    std::unique_ptr<World> staging;
+    std::vector<Entity> entities;
+  };
+
+  struct CellCoordHash {
+    size_t operator()(const CellCoord& coord) const;
+  };
+
+  void decode(Cell* cell);
+  void collectDecoded();
+  // Returns the time spent.
+  absl::Duration unloadQueued(absl::Duration budget);
+  void mergeQueued(absl::Duration budget);
+  void unload(Cell* cell);
+  // Distance from `position` to the nearest point of the cell at `coord`.
+  float distance(const CellCoord& coord, const glm::vec3& position) const;
+
+  World* world_;
+  JobPool* pool_;
+  Options options_;
+  Decoder decode_;
+
+  std::unordered_map<CellCoord, std::unique_ptr<Cell>, CellCoordHash> cells_;
+  // Decoded cells in the order they are merged. Cells removed from the map
+  // while queued are removed from here too.
+  std::deque<Cell*> merge_queue_;
+  // Cells whose entities are being destroyed, in the order they left range.
+  std::deque<Cell*> unload_queue_;
+  size_t num_loaded_ = 0;
+
+  JobGroup decoding_;
+  absl::Mutex mutex_;
+  // Cells finished decoding, not yet seen by `update()`. Guarded by `mutex_`.
+  std::vector<Cell*> decoded_;
+};
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline bool operator==(const CellCoord& a, const CellCoord& b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+inline bool operator!=(const CellCoord& a, const CellCoord& b) {
+  return !(a == b);
+}
+
+inline size_t WorldStreamer::numLoaded() const { return num_loaded_; }
+
+inline size_t WorldStreamer::CellCoordHash::operator()(
+    const CellCoord& coord) const {
+  uint64_t h = static_cast<uint32_t>(coord.x);
+  h = h * 0x9e3779b97f4a7c15 ^ static_cast<uint32_t>(coord.y);
+  h = h * 0x9e3779b97f4a7c15 ^ static_cast<uint32_t>(coord.z);
+  return static_cast<size_t>(h * 0x9e3779b97f4a7c15 >> 16);
+}
+
+}  // namespace y
+#endif  // GAMMA_ENGINE_WORLD_STREAMER_HPP_
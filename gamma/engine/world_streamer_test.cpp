@@ -0,0 +1,179 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/world_streamer.hpp"
+
+#include <vector>
+
+#include "absl/synchronization/notification.h"
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+struct CellTag {
+  CellCoord coord;
+};
+
+WorldStreamer::Options SmallCells() {
+  WorldStreamer::Options options;
+  options.cell_size = 10;
+  options.load_radius = 5;
+  options.unload_radius = 15;
+  return options;
+}
+
+// Decoder that creates `count` entities tagged with their cell.
+WorldStreamer::Decoder TaggedEntities(int count) {
+  return [count](const CellCoord& coord, World* staging) {
+    for (int i = 0; i < count; ++i) staging->create(CellTag{coord});
+  };
+}
+
+TEST(WorldStreamerTest, LoadsCellsNearObservers) {
+  World world;
+  JobPool pool(2);
+  WorldStreamer streamer(&world, &pool, SmallCells(), TaggedEntities(10));
+
+  // The observer's cell and the six that share a face with it are in range.
+  std::vector<glm::vec3> observers = {glm::vec3(5, 5, 5)};
+  streamer.update(observers);
+  streamer.flush();
+  EXPECT_EQ(streamer.numLoaded(), 7u);
+  EXPECT_EQ(world.size(), 70u);
+  EXPECT_EQ(streamer.state({1, 0, 0}), WorldStreamer::CellState::kLoaded);
+  EXPECT_EQ(streamer.state({1, 1, 0}), WorldStreamer::CellState::kUnloaded);
+
+  const std::vector<Entity>* entities = streamer.entities({0, -1, 0});
+  ASSERT_NE(entities, nullptr);
+  ASSERT_EQ(entities->size(), 10u);
+  for (Entity entity : *entities) {
+    EXPECT_EQ(world.get<CellTag>(entity)->coord, (CellCoord{0, -1, 0}));
+  }
+
+  // Moving within the unload radius keeps cells loaded.
+  observers[0] = glm::vec3(14, 5, 5);
+  streamer.update(observers);
+  streamer.flush();
+  EXPECT_EQ(streamer.state({-1, 0, 0}), WorldStreamer::CellState::kLoaded);
+  EXPECT_EQ(streamer.state({1, 1, 0}), WorldStreamer::CellState::kLoaded);
+
+  // Moving far away unloads every cell.
+  observers[0] = glm::vec3(1005, 5, 5);
+  streamer.update(observers);
+  EXPECT_EQ(streamer.state({0, 0, 0}), WorldStreamer::CellState::kUnloaded);
+  streamer.flush();
+  EXPECT_EQ(streamer.numLoaded(), 7u);
+  EXPECT_EQ(world.size(), 70u);
+  world.query<const CellTag>().forEach(
+      [](const CellTag& tag) { EXPECT_GE(tag.coord.x, 99); });
+}
+
+TEST(WorldStreamerTest, MergesWithinBudget) {
+  World world;
+  JobPool pool(1);
+  WorldStreamer::Options options = SmallCells();
+  options.load_radius = 0;
+  options.merge_budget = absl::ZeroDuration();
+  WorldStreamer streamer(&world, &pool, options, TaggedEntities(5000));
+
+  const glm::vec3 observer(5, 5, 5);
+  const CellCoord cell = {0, 0, 0};
+  streamer.update({&observer, 1});
+  while (streamer.state(cell) == WorldStreamer::CellState::kDecoding) {
+    absl::SleepFor(absl::Milliseconds(1));
+    streamer.update({&observer, 1});
+  }
+
+  // One chunk is merged per update.
+  int updates = 1;
+  size_t size = world.size();
+  EXPECT_GT(size, 0u);
+  EXPECT_LT(size, 5000u);
+  while (streamer.state(cell) == WorldStreamer::CellState::kMerging) {
+    streamer.update({&observer, 1});
+    EXPECT_GT(world.size(), size);
+    size = world.size();
+    ++updates;
+  }
+  EXPECT_EQ(streamer.state(cell), WorldStreamer::CellState::kLoaded);
+  EXPECT_EQ(world.size(), 5000u);
+  EXPECT_EQ(static_cast<size_t>(updates),
+            world.archetype(world.numArchetypes() - 1).numChunks());
+}
+
+TEST(WorldStreamerTest, UnloadsWithinBudget) {
+  World world;
+  JobPool pool(1);
+  WorldStreamer::Options options = SmallCells();
+  options.load_radius = 0;
+  options.merge_budget = absl::ZeroDuration();
+  WorldStreamer streamer(&world, &pool, options, TaggedEntities(5000));
+
+  const glm::vec3 near(5, 5, 5);
+  const glm::vec3 far(1005, 5, 5);
+  const CellCoord cell = {0, 0, 0};
+  streamer.update({&near, 1});
+  streamer.flush();
+  ASSERT_EQ(world.size(), 5000u);
+
+  // Each update destroys a few entities rather than the whole cell, and the
+  // cell is not reloaded while it unloads.
+  int updates = 0;
+  size_t size = world.size();
+  do {
+    streamer.update({updates % 2 == 0 ? &far : &near, 1});
+    EXPECT_LT(world.size(), size);
+    EXPECT_GT(world.size() + 1000, size);
+    size = world.size();
+    ++updates;
+  } while (streamer.state(cell) == WorldStreamer::CellState::kUnloading);
+  EXPECT_GT(updates, 5);
+  EXPECT_EQ(streamer.state(cell), WorldStreamer::CellState::kUnloaded);
+  EXPECT_EQ(streamer.numLoaded(), 0u);
+  EXPECT_EQ(world.size(), 0u);
+}
+
+TEST(WorldStreamerTest, DropsCellsThatLeaveRangeWhileDecoding) {
+  World world;
+  JobPool pool(1);
+  absl::Notification release;
+  WorldStreamer::Options options = SmallCells();
+  options.load_radius = 0;
+  WorldStreamer streamer(
+      &world, &pool, options,
+      [&release](const CellCoord& coord, World* staging) {
+        release.WaitForNotification();
+        staging->create(CellTag{coord});
+      });
+
+  const glm::vec3 near(5, 5, 5);
+  const glm::vec3 far(1005, 5, 5);
+  streamer.update({&near, 1});
+  EXPECT_EQ(streamer.state({0, 0, 0}), WorldStreamer::CellState::kDecoding);
+  streamer.update({&far, 1});
+  release.Notify();
+  streamer.flush();
+
+  EXPECT_EQ(streamer.state({0, 0, 0}), WorldStreamer::CellState::kUnloaded);
+  EXPECT_EQ(streamer.state({100, 0, 0}), WorldStreamer::CellState::kLoaded);
+  EXPECT_EQ(world.size(), 1u);
+}
+
+}  // namespace
+}  // namespace y
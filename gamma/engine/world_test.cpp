@@ -0,0 +1,331 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/engine/world.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+struct Position {
+  float x, y, z;
+};
+
+struct Velocity {
+  float x, y, z;
+};
+
+struct Name {
+  std::string value;
+};
+
+TEST(WorldTest, CreateAndGet) {
+  World world;
+  Entity a = world.create(Position{1, 2, 3}, Velocity{4, 5, 6});
+  Entity b = world.create(Position{7, 8, 9});
+
+  EXPECT_EQ(world.size(), 2u);
+  EXPECT_TRUE(world.alive(a));
+  EXPECT_TRUE(world.alive(b));
+  EXPECT_FALSE(world.alive(Entity()));
+
+  ASSERT_NE(world.get<Position>(a), nullptr);
+  EXPECT_EQ(world.get<Position>(a)->x, 1);
+  EXPECT_EQ(world.get<Velocity>(a)->z, 6);
+  EXPECT_EQ(world.get<Position>(b)->y, 8);
+  EXPECT_EQ(world.get<Velocity>(b), nullptr);
+  EXPECT_TRUE(world.has<Velocity>(a));
+  EXPECT_FALSE(world.has<Velocity>(b));
+}
+
+TEST(WorldTest, DestroyedHandlesGoStale) {
+  World world;
+  Entity a = world.create(Position{1, 0, 0});
+  Entity b = world.create(Position{2, 0, 0});
+  world.destroy(a);
+  EXPECT_FALSE(world.alive(a));
+  EXPECT_EQ(world.size(), 1u);
+  EXPECT_EQ(world.get<Position>(b)->x, 2);
+
+  // The slot is reused with a new generation.
+  Entity c = world.create(Position{3, 0, 0});
+  EXPECT_EQ(c.index, a.index);
+  EXPECT_NE(c, a);
+  EXPECT_FALSE(world.alive(a));
+  EXPECT_EQ(world.get<Position>(c)->x, 3);
+}
+
+TEST(WorldTest, ReservedEntitiesComeAliveAtStructuralChanges) {
+  World world;
+  Entity a = world.create(Position{});
+  Entity b = world.create(Position{});
+
+  Entity reserved = world.reserve();
+  EXPECT_FALSE(world.alive(reserved));
+  world.destroy(a);
+  EXPECT_TRUE(world.alive(reserved));
+  EXPECT_EQ(world.size(), 2u);
+
+  // Creating into the freed index.
+  reserved = world.reserve();
+  world.create(Position{});
+  EXPECT_TRUE(world.alive(reserved));
+
+  reserved = world.reserve();
+  world.add(b, Velocity{});
+  EXPECT_TRUE(world.alive(reserved));
+
+  reserved = world.reserve();
+  world.remove<Velocity>(b);
+  EXPECT_TRUE(world.alive(reserved));
+  EXPECT_EQ(world.size(), 6u);
+}
+
+TEST(WorldTest, DeathOnStaleHandle) {
+  World world;
+  Entity a = world.create(Position{});
+  world.destroy(a);
+  EXPECT_DEATH_IF_SUPPORTED(world.get<Position>(a), "");
+}
+
+TEST(WorldTest, AddAndRemoveMoveBetweenArchetypes) {
+  World world;
+  std::vector<Entity> entities;
+  for (int i = 0; i < 1000; ++i) {
+    entities.push_back(world.create(Position{float(i), 0, 0}));
+  }
+  for (int i = 0; i < 1000; i += 2) {
+    world.add(entities[i], Velocity{float(-i), 0, 0});
+  }
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(world.get<Position>(entities[i])->x, float(i));
+    if (i % 2 == 0) {
+      ASSERT_EQ(world.get<Velocity>(entities[i])->x, float(-i));
+    } else {
+      ASSERT_EQ(world.get<Velocity>(entities[i]), nullptr);
+    }
+  }
+
+  // Adding an existing component replaces it.
+  world.add(entities[0], Velocity{42, 0, 0});
+  EXPECT_EQ(world.get<Velocity>(entities[0])->x, 42);
+
+  for (int i = 0; i < 1000; i += 4) world.remove<Position>(entities[i]);
+  for (int i = 0; i < 1000; ++i) {
+    bool removed = i % 4 == 0;
+    ASSERT_EQ(world.has<Position>(entities[i]), !removed);
+    if (!removed) {
+      ASSERT_EQ(world.get<Position>(entities[i])->x, float(i));
+    }
+  }
+  world.remove<Name>(entities[1]);
+  EXPECT_TRUE(world.has<Position>(entities[1]));
+}
+
+TEST(WorldTest, NonTrivialComponents) {
+  World world;
+  std::vector<Entity> entities;
+  for (int i = 0; i < 100; ++i) {
+    entities.push_back(
+        world.create(Name{std::string(50, char('a' + i % 26))}));
+  }
+  for (int i = 0; i < 100; i += 3) world.destroy(entities[i]);
+  for (int i = 1; i < 100; i += 3) world.add(entities[i], Position{});
+  for (int i = 1; i < 100; i += 3) world.remove<Name>(entities[i]);
+  for (int i = 2; i < 100; i += 3) {
+    EXPECT_EQ(world.get<Name>(entities[i])->value,
+              std::string(50, char('a' + i % 26)));
+  }
+
+  auto pointer = std::make_shared<int>(7);
+  Entity owner = world.create(std::shared_ptr<int>(pointer));
+  EXPECT_EQ(pointer.use_count(), 2);
+  world.destroy(owner);
+  EXPECT_EQ(pointer.use_count(), 1);
+}
+
+TEST(WorldTest, QueryIteratesMatchingArchetypes) {
+  World world;
+  for (int i = 0; i < 5000; ++i) world.create(Position{1, 0, 0});
+  for (int i = 0; i < 3000; ++i) {
+    world.create(Position{1, 0, 0}, Velocity{2, 0, 0});
+  }
+  for (int i = 0; i < 100; ++i) world.create(Velocity{3, 0, 0});
+
+  auto moving = world.query<Position, const Velocity>();
+  EXPECT_EQ(moving.size(), 3000u);
+  moving.forEach([](Position& p, const Velocity& v) { p.x += v.x; });
+
+  float sum = 0;
+  size_t chunks = 0;
+  world.query<const Position>().forEachChunk(
+      [&sum, &chunks](const Query<const Position>::ChunkView& view) {
+        const Position* positions = view.get<const Position>();
+        for (size_t i = 0; i < view.size(); ++i) sum += positions[i].x;
+        ++chunks;
+      });
+  EXPECT_EQ(sum, 5000 * 1 + 3000 * 3);
+  EXPECT_GT(chunks, 2u);
+
+  size_t count = 0;
+  world.query<Velocity>().forEachEntity([&](Entity entity, Velocity& v) {
+    EXPECT_EQ(world.get<Velocity>(entity), &v);
+    ++count;
+  });
+  EXPECT_EQ(count, 3100u);
+}
+
+TEST(WorldTest, QueryPicksUpNewArchetypes) {
+  World world;
+  auto query = world.query<Position>();
+  EXPECT_EQ(query.size(), 0u);
+  world.create(Position{}, Name{"x"});
+  EXPECT_EQ(query.size(), 1u);
+  EXPECT_EQ(world.query<>().size(), 1u);
+}
+
+TEST(WorldTest, MoveChunkFromAnotherWorld) {
+  World staging;
+  for (int i = 0; i < 3000; ++i) staging.create(Position{float(i), 0, 0});
+  staging.create(Position{-1, 0, 0}, Name{"named"});
+  World world;
+  Entity existing = world.create(Position{-2, 0, 0});
+
+  std::vector<Entity> created;
+  int chunks = 0;
+  while (world.moveChunkFrom(&staging, &created)) ++chunks;
+  EXPECT_GT(chunks, 2);
+  EXPECT_EQ(staging.size(), 0u);
+  EXPECT_EQ(world.size(), 3002u);
+  ASSERT_EQ(created.size(), 3001u);
+
+  float sum = 0;
+  for (Entity entity : created) sum += world.get<Position>(entity)->x;
+  EXPECT_EQ(sum, 2999 * 3000 / 2 - 1);
+  EXPECT_EQ(world.get<Position>(existing)->x, -2);
+  EXPECT_EQ(world.query<const Name>().size(), 1u);
+  world.query<const Name>().forEach(
+      [](const Name& name) { EXPECT_EQ(name.value, "named"); });
+}
+
+TEST(WorldTest, InstantiatePrefab) {
+  World world;
+  Entity existing = world.create(Position{-1, 0, 0}, Name{"existing"});
+  Entity destroyed = world.create();
+  world.destroy(destroyed);
+
+  Prefab prefab(Position{1, 2, 3}, Name{"prefab"});
+  std::vector<Entity> created;
+  world.instantiate(prefab, 5000, &created);
+  prefab.get<Position>()->x = 7;
+  world.instantiate(prefab, 10);
+
+  EXPECT_EQ(world.size(), 5011u);
+  ASSERT_EQ(created.size(), 5000u);
+  // Destroyed indices are reused first.
+  EXPECT_EQ(created[0].index, destroyed.index);
+  for (Entity entity : created) {
+    ASSERT_EQ(world.get<Position>(entity)->z, 3);
+    ASSERT_EQ(world.get<Name>(entity)->value, "prefab");
+  }
+  EXPECT_EQ(world.get<Name>(existing)->value, "existing");
+
+  float sum = 0;
+  world.query<const Position>().forEach(
+      [&sum](const Position& p) { sum += p.x; });
+  EXPECT_EQ(sum, -1 + 5000 * 1 + 10 * 7);
+
+  world.destroy(created[0]);
+  EXPECT_EQ(world.get<Position>(created[4999])->y, 2);
+}
+
+// Number of entities visited by one iteration of `query`.
+template <typename... Ts>
+size_t CountVisited(Query<Ts...>* query) {
+  size_t count = 0;
+  query->forEachChunk([&count](const typename Query<Ts...>::ChunkView& view) {
+    count += view.size();
+  });
+  return count;
+}
+
+TEST(WorldTest, ChangedFilterSkipsUnchangedChunks) {
+  World world;
+  std::vector<Entity> entities;
+  for (int i = 0; i < 5000; ++i) entities.push_back(world.create(Position{}));
+  uint32_t capacity = world.archetype(1).capacity();
+
+  auto changed = world.query<const Position>();
+  changed.filter(Changed<Position>());
+  EXPECT_EQ(CountVisited(&changed), 5000u);
+  EXPECT_EQ(CountVisited(&changed), 0u);
+
+  world.get<Position>(entities[0])->x = 1;
+  world.get<Position>(entities[4999])->x = 1;
+  EXPECT_EQ(CountVisited(&changed), capacity + 5000 % capacity);
+  EXPECT_EQ(CountVisited(&changed), 0u);
+
+  // Const access does not count as a change.
+  const World& const_world = world;
+  const_world.get<Position>(entities[0]);
+  world.get<const Position>(entities[0]);
+  EXPECT_EQ(CountVisited(&changed), 0u);
+
+  // Mutable iteration by another query does.
+  auto writer = world.query<Position>();
+  EXPECT_EQ(CountVisited(&writer), 5000u);
+  EXPECT_EQ(CountVisited(&changed), 5000u);
+}
+
+TEST(WorldTest, QueryDoesNotSeeItsOwnChanges) {
+  World world;
+  for (int i = 0; i < 10; ++i) world.create(Position{});
+  auto query = world.query<Position>();
+  query.filter(Changed<Position>());
+  EXPECT_EQ(CountVisited(&query), 10u);
+  EXPECT_EQ(CountVisited(&query), 0u);
+}
+
+TEST(WorldTest, AddedFilterMatchesNewComponents) {
+  World world;
+  Entity a = world.create(Position{});
+  Entity b = world.create(Position{});
+
+  auto added = world.query<const Position, const Velocity>();
+  added.filter(Added<Velocity>());
+  EXPECT_EQ(CountVisited(&added), 0u);
+
+  world.add(a, Velocity{});
+  EXPECT_EQ(CountVisited(&added), 1u);
+  EXPECT_EQ(CountVisited(&added), 0u);
+
+  // Replacing a component changes it but does not add it.
+  world.add(a, Velocity{1, 0, 0});
+  EXPECT_EQ(CountVisited(&added), 0u);
+
+  world.add(b, Velocity{});
+  EXPECT_EQ(CountVisited(&added), 2u);
+}
+
+}  // namespace
+}  // namespace y
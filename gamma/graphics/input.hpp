@@ -0,0 +1,63 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_GRAPHICS_INPUT_HPP_
+#define GAMMA_GRAPHICS_INPUT_HPP_
+
+#include <cstdint>
+
+namespace y {
+
+// A single input event as reported by the windowing system.
+struct InputEvent {
+  enum class Type : uint8_t {
+    kKey = 0,
+    kMouseButton = 1,
+    kCursorPosition = 2,
+    kScroll = 3,
+  };
+
+  Type type = Type::kKey;
+  // GLFW key or mouse button, for kKey and kMouseButton.
+  int32_t code = 0;
+  // GLFW_PRESS, GLFW_RELEASE or GLFW_REPEAT, for kKey and kMouseButton.
+  uint8_t action = 0;
+  // Bit field of GLFW_MOD_* flags, for kKey and kMouseButton.
+  uint8_t mods = 0;
+  // Cursor position for kCursorPosition, offsets for kScroll.
+  double x = 0;
+  double y = 0;
+};
+
+bool operator==(const InputEvent& a, const InputEvent& b);
+bool operator!=(const InputEvent& a, const InputEvent& b);
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline bool operator==(const InputEvent& a, const InputEvent& b) {
+  return a.type == b.type && a.code == b.code && a.action == b.action &&
+         a.mods == b.mods && a.x == b.x && a.y == b.y;
+}
+
+inline bool operator!=(const InputEvent& a, const InputEvent& b) {
+  return !(a == b);
+}
+
+}  // namespace y
+#endif  // GAMMA_GRAPHICS_INPUT_HPP_
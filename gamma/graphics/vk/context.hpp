@@ -19,6 +19,10 @@
 #ifndef GAMMA_GRAPHICS_VK_CONTEXT_HPP_
 #define GAMMA_GRAPHICS_VK_CONTEXT_HPP_
 
+#include <memory>
+
+#include "absl/memory/memory.h"
+#include "gamma/common/timeline.hpp"
 #include "gamma/graphics/vk/device.hpp"
 #include "gamma/graphics/vk/instance.hpp"
 #include "gamma/graphics/vk/surface.hpp"
@@ -28,26 +32,43 @@ namespace y {
 
 class VulkanContext {
  public:
-  explicit VulkanContext(GLFWwindow* window);
+  // Records the creation of each part in `timeline`, if it is not null.
+  explicit VulkanContext(GLFWwindow* window, Timeline* timeline = nullptr);
   ~VulkanContext();
 
  private:
-  VulkanInstance instance_;
-  VulkanSurface surface_;
-  VulkanDevice device_;
-  VulkanSwapchain swapchain_;
+  // Held by pointer so that each part is created in its own timeline scope.
+  std::unique_ptr<VulkanInstance> instance_;
+  std::unique_ptr<VulkanSurface> surface_;
+  std::unique_ptr<VulkanDevice> device_;
+  std::unique_ptr<VulkanSwapchain> swapchain_;
 };
 
 // -----------------------------------------------------------------------------
 //                      Implementation Details Follow
 
-inline VulkanContext::VulkanContext(GLFWwindow* window)
-    : surface_(instance_, window),
-      device_(instance_, surface_),
-      swapchain_(device_, surface_, window) {}
+inline VulkanContext::VulkanContext(GLFWwindow* window, Timeline* timeline) {
+  {
+    Timeline::Scope scope(timeline, "vulkan instance");
+    instance_ = absl::make_unique<VulkanInstance>();
+  }
+  {
+    Timeline::Scope scope(timeline, "vulkan surface");
+    surface_ = absl::make_unique<VulkanSurface>(*instance_, window);
+  }
+  {
+    Timeline::Scope scope(timeline, "vulkan device");
+    device_ = absl::make_unique<VulkanDevice>(*instance_, *surface_);
+  }
+  {
+    Timeline::Scope scope(timeline, "vulkan swapchain");
+    swapchain_ =
+        absl::make_unique<VulkanSwapchain>(*device_, *surface_, window);
+  }
+}
 
 inline VulkanContext::~VulkanContext() {
-  vkDeviceWaitIdle(device_.logicalHandle());
+  vkDeviceWaitIdle(device_->logicalHandle());
 }
 
 }  // namespace y
@@ -22,7 +22,6 @@
 
 #include "shaderc/shaderc.hpp"
 
-#include "absl/container/fixed_array.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/match.h"
 #include "gamma/common/log.hpp"
@@ -42,25 +41,8 @@ shaderc_shader_kind ToShadercKind(VkShaderStageFlagBits stage) {
   return shaderc_compute_shader;
 }
 
-void CheckCompilationResult(const shaderc::SpvCompilationResult& result) {
-  shaderc_compilation_status status = result.GetCompilationStatus();
-  if (status == shaderc_compilation_status_success) return;
-
-  std::string error_message = result.GetErrorMessage();
-  YERR_IF(status == shaderc_compilation_status_invalid_stage) << error_message;
-  YERR_IF(status == shaderc_compilation_status_compilation_error)
-      << error_message;
-  YERR_IF(status == shaderc_compilation_status_internal_error) << error_message;
-  YERR_IF(status == shaderc_compilation_status_null_result_object)
-      << error_message;
-  YERR_IF(status == shaderc_compilation_status_invalid_assembly)
-      << error_message;
-  YERR_IF(status == shaderc_compilation_status_validation_error)
-      << error_message;
-  YERR_IF(status == shaderc_compilation_status_transformation_error)
-      << error_message;
-}
-
+// Logs the compiler's messages and returns empty byte code if compilation
+// fails.
 std::vector<uint32_t> TranslateGLSLToSPIRV(shaderc_shader_kind kind,
                                            const std::string& source_name,
                                            absl::string_view source) {
@@ -71,25 +53,33 @@ std::vector<uint32_t> TranslateGLSLToSPIRV(shaderc_shader_kind kind,
   shaderc::Compiler compiler;
   shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(
       source.data(), source.size(), kind, source_name.c_str(), options);
-  CheckCompilationResult(result);
+  if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+    YLOG << "failed to compile '" << source_name << "':\n"
+         << result.GetErrorMessage();
+    return {};
+  }
   return std::vector<uint32_t>(result.begin(), result.end());
 }
 
-absl::FixedArray<char> ReadFile(const std::string& path) {
+// Logs and returns false if the file cannot be read.
+bool ReadFile(const std::string& path, std::string* contents) {
   FILE* file = fopen(path.c_str(), "r");
-  YERR_IF(file == nullptr) << "failed to open '" << path << "'";
+  if (file == nullptr) {
+    YLOG << "failed to open '" << path << "'";
+    return false;
+  }
 
   size_t nchars = 0;
   while (fgetc(file) != EOF) ++nchars;
 
   fseek(file, 0, SEEK_SET);
 
-  absl::FixedArray<char> buffer(nchars + 1);
-  YERR_IF(fread(buffer.data(), sizeof(char), nchars, file) != nchars);
+  contents->resize(nchars);
+  bool read = fread(&(*contents)[0], sizeof(char), nchars, file) == nchars;
   fclose(file);
 
-  buffer[nchars] = '\0';
-  return buffer;
+  YLOG_IF(!read) << "failed to read '" << path << "'";
+  return read;
 }
 
 VkShaderStageFlagBits GetShaderStageFromFilePath(absl::string_view path) {
@@ -109,21 +99,37 @@ VkShaderStageFlagBits GetShaderStageFromFilePath(absl::string_view path) {
 
 }  // namespace
 
+SPIRVShader CompileGLSLSource(const std::string& source_name,
+                              absl::string_view source) {
+  VkShaderStageFlagBits stage = GetShaderStageFromFilePath(source_name);
+  return SPIRVShader{
+      stage, TranslateGLSLToSPIRV(ToShadercKind(stage), source_name, source)};
+}
+
+SPIRVShader CompileGLSLFile(const std::string& path) {
+  std::string source;
+  if (!ReadFile(path, &source)) {
+    return SPIRVShader{GetShaderStageFromFilePath(path), {}};
+  }
+  return CompileGLSLSource(path, source);
+}
+
+VulkanShaderModule MakeVulkanShaderFromSPIRV(VkDevice logical_device,
+                                             const SPIRVShader& shader) {
+  YERR_IF(shader.byte_code.empty()) << "no SPIR-V byte code";
+  return VulkanShaderModule(logical_device, shader.stage, shader.byte_code);
+}
+
 VulkanShaderModule MakeVulkanShaderFromGLSLSource(
     VkDevice logical_device, const std::string& source_name,
     absl::string_view source) {
-  VkShaderStageFlagBits stage = GetShaderStageFromFilePath(source_name);
-  std::vector<uint32_t> byte_code =
-      TranslateGLSLToSPIRV(ToShadercKind(stage), source_name, source);
-  return VulkanShaderModule(logical_device, stage, byte_code);
+  return MakeVulkanShaderFromSPIRV(logical_device,
+                                   CompileGLSLSource(source_name, source));
 }
 
 VulkanShaderModule MakeVulkanShaderFromGLSLFile(VkDevice logical_device,
                                                 const std::string& path) {
-  absl::FixedArray<char> file_data = ReadFile(path);
-  return MakeVulkanShaderFromGLSLSource(
-      logical_device, path,
-      absl::string_view(file_data.data(), file_data.size()));
+  return MakeVulkanShaderFromSPIRV(logical_device, CompileGLSLFile(path));
 }
 
 }  // namespace y
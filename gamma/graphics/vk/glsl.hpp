@@ -29,6 +29,26 @@
 
 namespace y {
 
+// SPIR-V byte code compiled from GLSL, along with the shader stage inferred
+// from the source name's extension.
+struct SPIRVShader {
+  VkShaderStageFlagBits stage;
+  std::vector<uint32_t> byte_code;
+};
+
+// Compile GLSL without touching any Vulkan objects, so that the expensive part
+// of shader creation can run on any thread, e.g. when hot reloading. Errors
+// reading or compiling the source are logged and give empty byte code, so that
+// a failed reload can keep the previous shader.
+SPIRVShader CompileGLSLSource(const std::string& source_name,
+                              absl::string_view source);
+SPIRVShader CompileGLSLFile(const std::string& path);
+
+// Ends the program if `shader` has no byte code, and so do the functions below
+// if compilation fails.
+VulkanShaderModule MakeVulkanShaderFromSPIRV(VkDevice logical_device,
+                                             const SPIRVShader& shader);
+
 VulkanShaderModule MakeVulkanShaderFromGLSLSource(
     VkDevice logical_device, const std::string& source_name,
     absl::string_view source);
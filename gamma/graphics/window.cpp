@@ -23,10 +23,11 @@
 namespace y {
 namespace {
 
-GLFWwindow* MakeWindow(const WindowSettings& settings) {
+GLFWwindow* MakeWindow(const WindowSettings& settings, Timeline* timeline) {
   YERR_IF(!(settings.width() > 0 && settings.height() > 0))
       << "Only windowed mode currently supported, size required.";
 
+  Timeline::Scope scope(timeline, "window");
   auto* window = glfwCreateWindow(settings.width(), settings.height(),
                                   settings.title().c_str(), nullptr, nullptr);
   YERR_IF(window == nullptr) << "Forgot to initialize graphics?";
@@ -35,8 +36,45 @@ GLFWwindow* MakeWindow(const WindowSettings& settings) {
 
 }  // namespace
 
-Window::Window(const WindowSettings& settings)
-    : glfw_window_(MakeWindow(settings)), vulkan_context_(glfw_window_.get()) {}
+Window::Window(const WindowSettings& settings, Timeline* timeline)
+    : glfw_window_(MakeWindow(settings, timeline)),
+      vulkan_context_(glfw_window_.get(), timeline) {
+  GLFWwindow* window = glfw_window_.get();
+  glfwSetWindowUserPointer(window, this);
+
+  glfwSetKeyCallback(window, [](GLFWwindow* w, int key, int /* scancode */,
+                                int action, int mods) {
+    InputEvent event;
+    event.type = InputEvent::Type::kKey;
+    event.code = key;
+    event.action = static_cast<uint8_t>(action);
+    event.mods = static_cast<uint8_t>(mods);
+    FromGLFW(w)->input_events_.push_back(event);
+  });
+  glfwSetMouseButtonCallback(
+      window, [](GLFWwindow* w, int button, int action, int mods) {
+        InputEvent event;
+        event.type = InputEvent::Type::kMouseButton;
+        event.code = button;
+        event.action = static_cast<uint8_t>(action);
+        event.mods = static_cast<uint8_t>(mods);
+        FromGLFW(w)->input_events_.push_back(event);
+      });
+  glfwSetCursorPosCallback(window, [](GLFWwindow* w, double x, double y) {
+    InputEvent event;
+    event.type = InputEvent::Type::kCursorPosition;
+    event.x = x;
+    event.y = y;
+    FromGLFW(w)->input_events_.push_back(event);
+  });
+  glfwSetScrollCallback(window, [](GLFWwindow* w, double x, double y) {
+    InputEvent event;
+    event.type = InputEvent::Type::kScroll;
+    event.x = x;
+    event.y = y;
+    FromGLFW(w)->input_events_.push_back(event);
+  });
+}
 
 void Window::display() {}
 
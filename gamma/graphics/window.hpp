@@ -20,7 +20,10 @@
 #define GAMMA_GRAPHICS_WINDOW_HPP_
 
 #include <memory>
+#include <vector>
 
+#include "gamma/common/timeline.hpp"
+#include "gamma/graphics/input.hpp"
 #include "gamma/graphics/vk/context.hpp"
 #include "gamma/graphics/vk/glfw.hpp"
 #include "gamma/graphics/window_settings.pb.h"
@@ -31,15 +34,28 @@ class Window {
  public:
   static void PollEvents();
 
-  explicit Window(const WindowSettings& settings);
+  // Records the creation of the window and its graphics context in
+  // `timeline`, if it is not null.
+  explicit Window(const WindowSettings& settings,
+                  Timeline* timeline = nullptr);
+
+  Window(const Window&) = delete;
+  Window& operator=(const Window&) = delete;
 
   bool shouldClose() const;
 
   void display();
 
+  // Move input events received by `PollEvents()` since the last call into
+  // `events`, replacing its contents.
+  void takeInputEvents(std::vector<InputEvent>* events);
+
  private:
+  static Window* FromGLFW(GLFWwindow* glfw_window);
+
   std::unique_ptr<GLFWwindow, GLFWWindowReleaser> glfw_window_;
   VulkanContext vulkan_context_;
+  std::vector<InputEvent> input_events_;
 };
 
 // -----------------------------------------------------------------------------
@@ -51,5 +67,14 @@ inline bool Window::shouldClose() const {
   return glfwWindowShouldClose(glfw_window_.get());
 }
 
+inline void Window::takeInputEvents(std::vector<InputEvent>* events) {
+  events->clear();
+  events->swap(input_events_);
+}
+
+inline Window* Window::FromGLFW(GLFWwindow* glfw_window) {
+  return static_cast<Window*>(glfwGetWindowUserPointer(glfw_window));
+}
+
 }  // namespace y
 #endif  // GAMMA_GRAPHICS_WINDOW_HPP_
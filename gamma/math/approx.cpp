@@ -0,0 +1,75 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/approx.hpp"
+
+#include "gamma/common/log.hpp"
+
+#define GAMMA_MATH_KERNEL_TARGET
+#include "gamma/math/approx_kernels.hpp"
+
+namespace y_internal {
+
+template <>
+ApproxKernels MakeKernels<ApproxKernels, y::SimdLevel::kScalar>() {
+  return y::MakeApproxKernels<y::Float1>();
+}
+
+const ApproxKernels& GetApproxKernels(y::SimdLevel level) {
+  return GetKernels<ApproxKernels>(level);
+}
+
+}  // namespace y_internal
+
+namespace y {
+namespace {
+
+using y_internal::ActiveKernels;
+using y_internal::ApproxKernels;
+
+}  // namespace
+
+void FastSin(absl::Span<const float> in, absl::Span<float> out) {
+  YERR_IF(out.size() != in.size()) << "mismatched batch sizes";
+  ActiveKernels<ApproxKernels>().sin(in.data(), in.size(), out.data());
+}
+
+void FastCos(absl::Span<const float> in, absl::Span<float> out) {
+  YERR_IF(out.size() != in.size()) << "mismatched batch sizes";
+  ActiveKernels<ApproxKernels>().cos(in.data(), in.size(), out.data());
+}
+
+void FastExp(absl::Span<const float> in, absl::Span<float> out) {
+  YERR_IF(out.size() != in.size()) << "mismatched batch sizes";
+  ActiveKernels<ApproxKernels>().exp(in.data(), in.size(), out.data());
+}
+
+void FastSqrt(absl::Span<const float> in, absl::Span<float> out) {
+  YERR_IF(out.size() != in.size()) << "mismatched batch sizes";
+  ActiveKernels<ApproxKernels>().sqrt(in.data(), in.size(), out.data());
+}
+
+void FastAtan2(absl::Span<const float> y, absl::Span<const float> x,
+               absl::Span<float> out) {
+  YERR_IF(x.size() != y.size() || out.size() != y.size())
+      << "mismatched batch sizes";
+  ActiveKernels<ApproxKernels>().atan2(y.data(), x.data(), y.size(),
+                                       out.data());
+}
+
+}  // namespace y
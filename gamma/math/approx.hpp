@@ -0,0 +1,215 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_APPROX_HPP_
+#define GAMMA_MATH_APPROX_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "absl/types/span.h"
+#include "gamma/math/cpu.hpp"
+
+namespace y {
+
+// Polynomial approximations of elementary functions for animation, particles
+// and other code that calls them in tight loops. The scalar forms are inline
+// and branch free; the batched forms process 16, 8 or 4 values at a time, as
+// `ActiveSimdLevel()` allows, with the same polynomials. The error bounds are
+// the largest measured over the stated domain against double precision libm,
+// rounded up, and hold for every form.
+
+// Sine and cosine of `x` radians, within 2.5e-7 absolute for |x| <= 1e5, and
+// FastSin(x) within 2 ulp for |x| < 1. Larger inputs, infinities included,
+// are clamped to [-1e5, 1e5], past which the argument reduction would no
+// longer be exact; their results are in [-1, 1] but otherwise unspecified.
+float FastSin(float x);
+float FastCos(float x);
+
+// e^x within 2 ulp. Inputs are clamped to [-87.33, 88.37], which keeps the
+// result within the range of normal floats instead of going to 0 or
+// infinity.
+float FastExp(float x);
+
+// Angle of (x, y) in [-pi, pi], within 4e-7 absolute for finite inputs, with
+// the signs of zeros handled like std::atan2.
+float FastAtan2(float y, float x);
+
+// Square root of non-negative `x`. The scalar form is std::sqrt, which is
+// already a single instruction; the batched form multiplies by the hardware
+// reciprocal square root estimate and is within 5 ulp, subnormals included,
+// and exact for 0 and infinity.
+float FastSqrt(float x);
+
+// out[i] = f(in[i]). `out` may be `in`, but must not otherwise overlap it,
+// and both must have the same size.
+void FastSin(absl::Span<const float> in, absl::Span<float> out);
+void FastCos(absl::Span<const float> in, absl::Span<float> out);
+void FastExp(absl::Span<const float> in, absl::Span<float> out);
+void FastSqrt(absl::Span<const float> in, absl::Span<float> out);
+
+// out[i] = FastAtan2(y[i], x[i]), with the same size and aliasing rules.
+void FastAtan2(absl::Span<const float> y, absl::Span<const float> x,
+               absl::Span<float> out);
+
+}  // namespace y
+
+namespace y_internal {
+
+// The kernels compiled for one instruction set, without size checks.
+struct ApproxKernels {
+  void (*sin)(const float* in, size_t n, float* out);
+  void (*cos)(const float* in, size_t n, float* out);
+  void (*exp)(const float* in, size_t n, float* out);
+  void (*sqrt)(const float* in, size_t n, float* out);
+  void (*atan2)(const float* y, const float* x, size_t n, float* out);
+};
+
+// Kernels for `level`, which must be no wider than `DetectSimdLevel()`.
+const ApproxKernels& GetApproxKernels(y::SimdLevel level);
+
+// Constants shared by the scalar forms below and approx_kernels.hpp.
+
+constexpr float kHalfPi = 1.57079637f;
+constexpr float kPi = 3.14159274f;
+
+// 2 pi split in three (Cody-Waite) so that k * 2 pi can be subtracted with
+// little rounding: for integral |k| < 2^16 the products with the first two
+// parts, which have 8 significant bits, are exact. Angles are clamped to
+// +-kMaxAngle to keep |k| below that.
+constexpr float kInvTwoPi = 0.159154937f;
+constexpr float kTwoPiHi = 6.28125f;
+constexpr float kTwoPiMid = 1.93786621e-3f;
+constexpr float kTwoPiLo = -2.55903137e-6f;
+constexpr float kMaxAngle = 1e5f;
+
+// Minimax sin(u) = u + u^3 * P(u^2) for |u| <= pi / 2, relative error 1e-8.
+constexpr float kSin[] = {-0.166666611f, 8.33308428e-3f, -1.98099554e-4f,
+                          2.60516628e-6f};
+
+// Minimax e^r = 1 + r + ... + kExp[4] * r^6 for |r| <= ln(2) / 2, relative
+// error 2e-9, and ln(2) split like 2 pi.
+constexpr float kExp[] = {0.499999921f, 0.166664202f, 4.16682256e-2f,
+                          8.3748158e-3f, 1.3836846e-3f};
+constexpr float kExpMin = -87.33f;
+constexpr float kExpMax = 88.37f;
+constexpr float kLog2E = 1.44269502f;
+constexpr float kLn2Hi = 0.693145752f;
+constexpr float kLn2Lo = 1.42860682e-6f;
+
+// Minimax atan(a) = a + a^3 * P(a^2) for 0 <= a <= 1, relative error 1.1e-7.
+constexpr float kAtan[] = {-0.333323916f, 0.199742141f, -0.140413278f,
+                           0.0996847322f, -0.0602031323f, 0.0247340652f,
+                           -4.82253484e-3f};
+
+// Smallest normal float.
+constexpr float kTiny = 1.17549435e-38f;
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+// 2^24, which makes every subnormal normal, and its square root inverted.
+constexpr float kSqrtScaleUp = 16777216.0f;
+constexpr float kSqrtScaleDown = 2.44140625e-4f;
+
+// Adding and subtracting 1.5 * 2^23 rounds |x| < 2^22 to the nearest integer
+// without SSE4.1. The low bits of the sum hold that integer.
+constexpr float kRoundMagic = 12582912.0f;
+
+}  // namespace y_internal
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+namespace y_internal {
+
+inline float RoundToInt(float x) { return (x + kRoundMagic) - kRoundMagic; }
+
+// x - k * 2 pi for the k that brings it into [-pi, pi], give or take the
+// rounding of x / 2 pi, after clamping x to +-kMaxAngle.
+inline float ReduceAngle(float x) {
+  x = std::min(std::max(x, -kMaxAngle), kMaxAngle);
+  float k = RoundToInt(x * kInvTwoPi);
+  float r = x - k * kTwoPiHi;
+  r -= k * kTwoPiMid;
+  return r - k * kTwoPiLo;
+}
+
+inline float SinPoly(float u) {
+  float s = u * u;
+  float p = kSin[3];
+  for (int i = 2; i >= 0; --i) p = p * s + kSin[i];
+  return u + u * s * p;
+}
+
+}  // namespace y_internal
+
+namespace y {
+
+inline float FastSin(float x) {
+  // sin(r) = sign(r) sin(u) with u = min(|r|, pi - |r|), which is at most
+  // pi/2, exact for small |r|, and a little negative if rounding leaves |r|
+  // over pi.
+  float r = y_internal::ReduceAngle(x);
+  float u = std::min(std::fabs(r), y_internal::kPi - std::fabs(r));
+  return std::copysign(1.0f, r) * y_internal::SinPoly(u);
+}
+
+inline float FastCos(float x) {
+  // cos(r) = sin(pi/2 - |r|), with pi/2 - |r| in [-pi/2, pi/2].
+  float r = y_internal::ReduceAngle(x);
+  return y_internal::SinPoly(y_internal::kHalfPi - std::fabs(r));
+}
+
+inline float FastExp(float x) {
+  namespace yi = y_internal;
+  // e^x = 2^n e^r with n = round(x / ln 2), |r| <= ln(2) / 2.
+  x = std::min(std::max(x, yi::kExpMin), yi::kExpMax);
+  float n = yi::RoundToInt(x * yi::kLog2E);
+  float r = x - n * yi::kLn2Hi;
+  r -= n * yi::kLn2Lo;
+  float p = yi::kExp[4];
+  for (int i = 3; i >= 0; --i) p = p * r + yi::kExp[i];
+  p = (p * r + 1.0f) * r + 1.0f;
+  int32_t bits = (static_cast<int32_t>(n) + 127) << 23;
+  float scale;
+  std::memcpy(&scale, &bits, sizeof(scale));
+  return p * scale;
+}
+
+inline float FastAtan2(float y, float x) {
+  namespace yi = y_internal;
+  // atan(a) for the ratio a in [0, 1] of the smaller to the larger magnitude,
+  // then reflected into the right octant. The divisor is kept normal so that
+  // (0, 0) gives 0 rather than NaN.
+  float ax = std::fabs(x), ay = std::fabs(y);
+  float a = std::min(ax, ay) / std::max(std::max(ax, ay), yi::kTiny);
+  float s = a * a;
+  float p = yi::kAtan[6];
+  for (int i = 5; i >= 0; --i) p = p * s + yi::kAtan[i];
+  float angle = a + a * s * p;
+  if (ay > ax) angle = yi::kHalfPi - angle;
+  if (std::signbit(x)) angle = yi::kPi - angle;
+  return std::copysign(angle, y);
+}
+
+inline float FastSqrt(float x) { return std::sqrt(x); }
+
+}  // namespace y
+#endif  // GAMMA_MATH_APPROX_HPP_
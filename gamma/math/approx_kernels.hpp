@@ -0,0 +1,202 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_APPROX_KERNELS_HPP_
+#define GAMMA_MATH_APPROX_KERNELS_HPP_
+
+// Batched approximations as templates over a lane type; see lanes.hpp. Each
+// follows the scalar form of the same name in approx.hpp step by step.
+
+#include <cstddef>
+
+#include "gamma/math/approx.hpp"
+#include "gamma/math/dispatch.hpp"
+#include "gamma/math/lanes.hpp"
+
+namespace y_internal {
+
+// Defined in kernels_*.cpp.
+template <>
+ApproxKernels MakeKernels<ApproxKernels, y::SimdLevel::kSse42>();
+template <>
+ApproxKernels MakeKernels<ApproxKernels, y::SimdLevel::kAvx2>();
+template <>
+ApproxKernels MakeKernels<ApproxKernels, y::SimdLevel::kAvx512>();
+
+}  // namespace y_internal
+
+namespace y {
+namespace {
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline F RoundToInt(F x) {
+  const F magic = F::Splat(y_internal::kRoundMagic);
+  return (x + magic) - magic;
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline F ReduceAngle(F x) {
+  x = Min(Max(x, F::Splat(-y_internal::kMaxAngle)),
+          F::Splat(y_internal::kMaxAngle));
+  F k = RoundToInt(x * F::Splat(y_internal::kInvTwoPi));
+  F r = x - k * F::Splat(y_internal::kTwoPiHi);
+  r = r - k * F::Splat(y_internal::kTwoPiMid);
+  return r - k * F::Splat(y_internal::kTwoPiLo);
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline F SinPoly(F u) {
+  F s = u * u;
+  F p = F::Splat(y_internal::kSin[3]);
+  for (int i = 2; i >= 0; --i) p = MulAdd(p, s, F::Splat(y_internal::kSin[i]));
+  return MulAdd(u * s, p, u);
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline F ApproxSin(F x) {
+  F r = ReduceAngle(x);
+  F u = Min(Abs(r), F::Splat(y_internal::kPi) - Abs(r));
+  return FlipSign(SinPoly(u), r);
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline F ApproxCos(F x) {
+  return SinPoly(F::Splat(y_internal::kHalfPi) - Abs(ReduceAngle(x)));
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline F ApproxExp(F x) {
+  x = Min(Max(x, F::Splat(y_internal::kExpMin)),
+          F::Splat(y_internal::kExpMax));
+  F n = RoundToInt(x * F::Splat(y_internal::kLog2E));
+  F r = x - n * F::Splat(y_internal::kLn2Hi);
+  r = r - n * F::Splat(y_internal::kLn2Lo);
+  F p = F::Splat(y_internal::kExp[4]);
+  for (int i = 3; i >= 0; --i) p = MulAdd(p, r, F::Splat(y_internal::kExp[i]));
+  const F one = F::Splat(1.0f);
+  p = MulAdd(MulAdd(p, r, one), r, one);
+  return p * Pow2(n);
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline F ApproxSqrt(F x) {
+  // The estimate treats subnormals as 0, so they are scaled up by 2^24 first
+  // and the result down by 2^12. 0 and infinity are passed through, since
+  // x * InverseSqrt(x) would be NaN for them.
+  typename F::Mask normal = GreaterEqual(x, F::Splat(y_internal::kTiny));
+  F scaled = Select(normal, x, x * F::Splat(y_internal::kSqrtScaleUp));
+  F root = scaled * InverseSqrt(scaled) *
+           Select(normal, F::Splat(1.0f),
+                  F::Splat(y_internal::kSqrtScaleDown));
+  root = Select(GreaterEqual(F::Splat(0.0f), x), x, root);
+  return Select(GreaterEqual(x, F::Splat(y_internal::kInfinity)), x, root);
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline F ApproxAtan2(F y, F x) {
+  F ax = Abs(x), ay = Abs(y);
+  F a = Min(ax, ay) / Max(Max(ax, ay), F::Splat(y_internal::kTiny));
+  F s = a * a;
+  F p = F::Splat(y_internal::kAtan[6]);
+  for (int i = 5; i >= 0; --i) {
+    p = MulAdd(p, s, F::Splat(y_internal::kAtan[i]));
+  }
+  F angle = MulAdd(a * s, p, a);
+  angle = Select(GreaterEqual(ax, ay), angle,
+                 F::Splat(y_internal::kHalfPi) - angle);
+  const F one = F::Splat(1.0f);
+  angle = Select(GreaterEqual(FlipSign(one, x), F::Splat(0.0f)), angle,
+                 F::Splat(y_internal::kPi) - angle);
+  return FlipSign(angle, y);
+}
+
+// The functions of one argument, as types so that they inline into
+// `MapLanes`.
+
+struct SinOp {
+  template <typename F>
+  GAMMA_MATH_KERNEL_TARGET static F Run(F x) { return ApproxSin(x); }
+};
+
+struct CosOp {
+  template <typename F>
+  GAMMA_MATH_KERNEL_TARGET static F Run(F x) { return ApproxCos(x); }
+};
+
+struct ExpOp {
+  template <typename F>
+  GAMMA_MATH_KERNEL_TARGET static F Run(F x) { return ApproxExp(x); }
+};
+
+struct SqrtOp {
+  template <typename F>
+  GAMMA_MATH_KERNEL_TARGET static F Run(F x) { return ApproxSqrt(x); }
+};
+
+// Each kernel applies its function to whole groups of `F::kWidth` values from
+// `begin` and returns the index of the first value left over.
+
+template <typename F, typename Op>
+GAMMA_MATH_KERNEL_TARGET inline size_t MapLanes(const float* in, size_t n,
+                                                float* out, size_t begin) {
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    Op::template Run<F>(F::Load(in + e)).store(out + e);
+  }
+  return e;
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline size_t Atan2Lanes(const float* y,
+                                                  const float* x, size_t n,
+                                                  float* out, size_t begin) {
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    ApproxAtan2(F::Load(y + e), F::Load(x + e)).store(out + e);
+  }
+  return e;
+}
+
+template <typename F, typename Op>
+GAMMA_MATH_KERNEL_TARGET inline void MapBatch(const float* in, size_t n,
+                                              float* out) {
+  size_t e = MapLanes<F, Op>(in, n, out, 0);
+  MapLanes<Float1, Op>(in, n, out, e);
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline void Atan2Batch(const float* y, const float* x,
+                                                size_t n, float* out) {
+  size_t e = Atan2Lanes<F>(y, x, n, out, 0);
+  Atan2Lanes<Float1>(y, x, n, out, e);
+}
+
+template <typename F>
+y_internal::ApproxKernels MakeApproxKernels() {
+  y_internal::ApproxKernels kernels;
+  kernels.sin = &MapBatch<F, SinOp>;
+  kernels.cos = &MapBatch<F, CosOp>;
+  kernels.exp = &MapBatch<F, ExpOp>;
+  kernels.sqrt = &MapBatch<F, SqrtOp>;
+  kernels.atan2 = &Atan2Batch<F>;
+  return kernels;
+}
+
+}  // namespace
+}  // namespace y
+#endif  // GAMMA_MATH_APPROX_KERNELS_HPP_
@@ -0,0 +1,239 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/approx.hpp"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+// `n` evenly spaced values from `lo` to `hi`.
+std::vector<float> Samples(double lo, double hi, int n) {
+  std::vector<float> samples(n);
+  for (int i = 0; i < n; ++i) {
+    samples[i] = static_cast<float>(lo + (hi - lo) * i / (n - 1));
+  }
+  return samples;
+}
+
+double Ulp(double x) {
+  float f = static_cast<float>(std::fabs(x));
+  return std::nextafter(f, std::numeric_limits<float>::infinity()) - f;
+}
+
+// Largest error of `approx` against `exact` on `in`, absolute or in ulp of the
+// exact result.
+double MaxError(const std::vector<float>& in, const std::vector<float>& approx,
+                double (*exact)(double), bool ulp) {
+  double max_error = 0;
+  for (size_t i = 0; i < in.size(); ++i) {
+    double e = exact(in[i]);
+    double error = std::fabs(approx[i] - e);
+    max_error = std::fmax(max_error, ulp ? error / Ulp(e) : error);
+  }
+  return max_error;
+}
+
+using UnaryKernel = void (*)(const float* in, size_t n, float* out);
+
+// Checks the scalar form and the batched form at every level on `in`.
+void CheckUnary(float (*scalar)(float),
+                UnaryKernel y_internal::ApproxKernels::*batched,
+                double (*exact)(double), const std::vector<float>& in,
+                double bound, bool ulp) {
+  std::vector<float> out(in.size());
+  for (size_t i = 0; i < in.size(); ++i) out[i] = scalar(in[i]);
+  EXPECT_LE(MaxError(in, out, exact, ulp), bound);
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    const y_internal::ApproxKernels& kernels =
+        y_internal::GetApproxKernels(level);
+    (kernels.*batched)(in.data(), in.size(), out.data());
+    EXPECT_LE(MaxError(in, out, exact, ulp), bound);
+  }
+}
+
+double Sin(double x) { return std::sin(x); }
+double Cos(double x) { return std::cos(x); }
+double Exp(double x) { return std::exp(x); }
+double Sqrt(double x) { return std::sqrt(x); }
+
+// The bounds documented in approx.hpp, checked on a dense sample of the
+// primary range and a sparser one of the whole domain.
+
+TEST(ApproxTest, Sin) {
+  CheckUnary(&FastSin, &y_internal::ApproxKernels::sin, &Sin,
+             Samples(-10, 10, 1000003), 2.5e-7, false);
+  CheckUnary(&FastSin, &y_internal::ApproxKernels::sin, &Sin,
+             Samples(-1e5, 1e5, 1000003), 2.5e-7, false);
+}
+
+TEST(ApproxTest, Cos) {
+  CheckUnary(&FastCos, &y_internal::ApproxKernels::cos, &Cos,
+             Samples(-10, 10, 1000003), 2.5e-7, false);
+  CheckUnary(&FastCos, &y_internal::ApproxKernels::cos, &Cos,
+             Samples(-1e5, 1e5, 1000003), 2.5e-7, false);
+}
+
+TEST(ApproxTest, LargeAnglesAreClampedIntoRange) {
+  std::vector<float> in = {1e6f, -1e6f, 1e9f, -3e38f,
+                           std::numeric_limits<float>::infinity()};
+  for (float x : in) {
+    float clamped = std::fmin(std::fmax(x, -1e5f), 1e5f);
+    EXPECT_EQ(FastSin(x), FastSin(clamped)) << x;
+    EXPECT_EQ(FastCos(x), FastCos(clamped)) << x;
+    EXPECT_LE(std::fabs(FastSin(x)), 1.0f) << x;
+    EXPECT_LE(std::fabs(FastCos(x)), 1.0f) << x;
+  }
+  std::vector<float> sin(in.size()), cos(in.size());
+  for (SimdLevel level : SupportedSimdLevels()) {
+    const y_internal::ApproxKernels& kernels =
+        y_internal::GetApproxKernels(level);
+    kernels.sin(in.data(), in.size(), sin.data());
+    kernels.cos(in.data(), in.size(), cos.data());
+    for (size_t i = 0; i < in.size(); ++i) {
+      EXPECT_NEAR(sin[i], FastSin(in[i]), 2.5e-7) << SimdLevelName(level);
+      EXPECT_NEAR(cos[i], FastCos(in[i]), 2.5e-7) << SimdLevelName(level);
+      EXPECT_LE(std::fabs(sin[i]), 1.0f) << SimdLevelName(level);
+      EXPECT_LE(std::fabs(cos[i]), 1.0f) << SimdLevelName(level);
+    }
+  }
+}
+
+TEST(ApproxTest, SinOfSmallAngles) {
+  CheckUnary(&FastSin, &y_internal::ApproxKernels::sin, &Sin,
+             Samples(-1, 1, 1000003), 2, true);
+  EXPECT_EQ(FastSin(0.0f), 0.0f);
+  EXPECT_EQ(FastSin(-1e-20f), -1e-20f);
+}
+
+TEST(ApproxTest, Exp) {
+  CheckUnary(&FastExp, &y_internal::ApproxKernels::exp, &Exp,
+             Samples(-1, 1, 1000003), 2, true);
+  CheckUnary(&FastExp, &y_internal::ApproxKernels::exp, &Exp,
+             Samples(-87.33, 88.37, 1000003), 2, true);
+}
+
+TEST(ApproxTest, ExpClampsToNormalRange) {
+  EXPECT_EQ(FastExp(0.0f), 1.0f);
+  EXPECT_GT(FastExp(-1000.0f), 0.0f);
+  EXPECT_LE(FastExp(-1000.0f), std::exp(-87.0f));
+  EXPECT_TRUE(std::isfinite(FastExp(1000.0f)));
+  EXPECT_GE(FastExp(1000.0f), std::exp(88.0f));
+}
+
+TEST(ApproxTest, Sqrt) {
+  CheckUnary(&FastSqrt, &y_internal::ApproxKernels::sqrt, &Sqrt,
+             Samples(1e-30, 1e-20, 100003), 5, true);
+  CheckUnary(&FastSqrt, &y_internal::ApproxKernels::sqrt, &Sqrt,
+             Samples(0, 1e6, 1000003), 5, true);
+}
+
+TEST(ApproxTest, SqrtOfSubnormals) {
+  CheckUnary(&FastSqrt, &y_internal::ApproxKernels::sqrt, &Sqrt,
+             Samples(std::numeric_limits<float>::denorm_min(), 1.2e-38,
+                     100003),
+             5, true);
+}
+
+TEST(ApproxTest, SqrtOfZeroAndInfinity) {
+  const float inf = std::numeric_limits<float>::infinity();
+  for (SimdLevel level : SupportedSimdLevels()) {
+    std::vector<float> values(17, 0.0f);
+    values[3] = inf;
+    values[16] = inf;
+    y_internal::GetApproxKernels(level).sqrt(values.data(), values.size(),
+                                             values.data());
+    for (size_t i = 0; i < values.size(); ++i) {
+      EXPECT_EQ(values[i], i == 3 || i == 16 ? inf : 0.0f)
+          << SimdLevelName(level) << " " << i;
+    }
+  }
+}
+
+// Points on circles of several radii, and a grid crossing both axes.
+TEST(ApproxTest, Atan2) {
+  std::vector<float> y, x;
+  for (float radius : {1e-30f, 1.0f, 1e30f}) {
+    for (float angle : Samples(-3.2, 3.2, 100003)) {
+      y.push_back(radius * std::sin(angle));
+      x.push_back(radius * std::cos(angle));
+    }
+  }
+  for (float y_i : Samples(-50, 50, 501)) {
+    for (float x_i : Samples(-50, 50, 501)) {
+      y.push_back(y_i);
+      x.push_back(x_i);
+    }
+  }
+  auto max_error = [&](const std::vector<float>& out) {
+    double max_error = 0;
+    for (size_t i = 0; i < out.size(); ++i) {
+      double exact = std::atan2(static_cast<double>(y[i]), x[i]);
+      max_error = std::fmax(max_error, std::fabs(out[i] - exact));
+    }
+    return max_error;
+  };
+  std::vector<float> out(y.size());
+  for (size_t i = 0; i < y.size(); ++i) out[i] = FastAtan2(y[i], x[i]);
+  EXPECT_LE(max_error(out), 4e-7);
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    y_internal::GetApproxKernels(level).atan2(y.data(), x.data(), y.size(),
+                                              out.data());
+    EXPECT_LE(max_error(out), 4e-7);
+  }
+}
+
+TEST(ApproxTest, Atan2OfSignedZeros) {
+  std::vector<float> y = {0.0f, 0.0f, -0.0f, -0.0f, 1.0f, -1.0f};
+  std::vector<float> x = {0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f};
+  std::vector<float> out(y.size());
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    y_internal::GetApproxKernels(level).atan2(y.data(), x.data(), y.size(),
+                                              out.data());
+    for (size_t i = 0; i < y.size(); ++i) {
+      EXPECT_FLOAT_EQ(out[i], std::atan2(y[i], x[i])) << i;
+      EXPECT_EQ(std::signbit(out[i]), std::signbit(y[i])) << i;
+      EXPECT_FLOAT_EQ(FastAtan2(y[i], x[i]), std::atan2(y[i], x[i])) << i;
+    }
+  }
+}
+
+TEST(ApproxTest, BatchedFormsMatchSizes) {
+  std::vector<float> in = Samples(0.5, 1, 37);
+  std::vector<float> out(in.size());
+  FastSin(in, absl::MakeSpan(out));
+  for (size_t i = 0; i < in.size(); ++i) {
+    EXPECT_NEAR(out[i], std::sin(in[i]), 2.5e-7) << i;
+  }
+  FastAtan2(in, in, absl::MakeSpan(out));
+  for (float angle : out) EXPECT_NEAR(angle, 0.785398163, 4e-7);
+  std::vector<float> small(36);
+  EXPECT_DEATH_IF_SUPPORTED(FastExp(in, absl::MakeSpan(small)), "");
+  EXPECT_DEATH_IF_SUPPORTED(FastAtan2(in, small, absl::MakeSpan(out)), "");
+}
+
+}  // namespace
+}  // namespace y
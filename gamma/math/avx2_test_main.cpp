@@ -0,0 +1,35 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+
+// Test main for tests built with AVX2 and FMA enabled, which passes without
+// running the tests on CPUs that lack them.
+
+#include <cstdio>
+
+#include "gamma/math/cpu.hpp"
+#include "gtest/gtest.h"
+
+int main(int argc, char** argv) {
+  if (y::DetectSimdLevel() < y::SimdLevel::kAvx2) {
+    std::printf("Skipped: the CPU does not support AVX2 and FMA.\n");
+    return 0;
+  }
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/batch.hpp"
+
+#include "gamma/common/log.hpp"
+
+#define GAMMA_MATH_KERNEL_TARGET
+#include "gamma/math/batch_kernels.hpp"
+
+namespace y_internal {
+
+template <>
+BatchKernels MakeKernels<BatchKernels, y::SimdLevel::kScalar>() {
+  return y::MakeBatchKernels<y::Float1>();
+}
+
+const BatchKernels& GetBatchKernels(y::SimdLevel level) {
+  return GetKernels<BatchKernels>(level);
+}
+
+}  // namespace y_internal
+
+namespace y {
+namespace {
+
+using y_internal::ActiveKernels;
+using y_internal::BatchKernels;
+
+}  // namespace
+
+void TransformPoints(const Mat4& m, ConstVec3Soa in, Vec3Soa out) {
+  YERR_IF(out.size != in.size) << "mismatched batch sizes";
+  ActiveKernels<BatchKernels>().transform_points(m, in, out);
+}
+
+void ComposeTransforms(ConstMat4Soa parents, ConstMat4Soa children,
+                       Mat4Soa out) {
+  YERR_IF(children.size != parents.size || out.size != parents.size)
+      << "mismatched batch sizes";
+  ActiveKernels<BatchKernels>().compose_transforms(parents, children, out);
+}
+
+void NormalizeQuats(QuatSoa quats) {
+  ActiveKernels<BatchKernels>().normalize_quats(quats);
+}
+
+}  // namespace y
@@ -0,0 +1,63 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_BATCH_HPP_
+#define GAMMA_MATH_BATCH_HPP_
+
+#include "gamma/math/cpu.hpp"
+#include "gamma/math/mat4.hpp"
+#include "gamma/math/soa.hpp"
+
+namespace y {
+
+// Kernels over structure-of-arrays data. Each processes 16, 8 or 4 elements
+// per iteration with AVX-512, AVX2 or SSE4.2 respectively, whichever
+// `ActiveSimdLevel()` picks, and finishes the last few elements one at a
+// time. Outputs may be the same arrays as inputs, but must not otherwise
+// overlap them, and all views passed to one call must have the same size.
+
+// out[i] = m * (in[i], 1), without the perspective divide.
+void TransformPoints(const Mat4& m, ConstVec3Soa in, Vec3Soa out);
+
+// out[i] = parents[i] * children[i].
+void ComposeTransforms(ConstMat4Soa parents, ConstMat4Soa children,
+                       Mat4Soa out);
+
+// Normalizes every quaternion in place. None may be zero.
+void NormalizeQuats(QuatSoa quats);
+
+}  // namespace y
+
+namespace y_internal {
+
+// The kernels compiled for one instruction set, without size checks.
+struct BatchKernels {
+  void (*transform_points)(const y::Mat4& m, const y::ConstVec3Soa& in,
+                           const y::Vec3Soa& out);
+  void (*compose_transforms)(const y::ConstMat4Soa& parents,
+                             const y::ConstMat4Soa& children,
+                             const y::Mat4Soa& out);
+  void (*normalize_quats)(const y::QuatSoa& quats);
+};
+
+// Kernels for `level`, which must be no wider than `DetectSimdLevel()`.
+// Exposed so that tests and benchmarks can run every variant.
+const BatchKernels& GetBatchKernels(y::SimdLevel level);
+
+}  // namespace y_internal
+#endif  // GAMMA_MATH_BATCH_HPP_
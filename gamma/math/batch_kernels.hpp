@@ -0,0 +1,146 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_BATCH_KERNELS_HPP_
+#define GAMMA_MATH_BATCH_KERNELS_HPP_
+
+// Batch kernels as templates over a lane type; see lanes.hpp.
+
+#include <cstddef>
+
+#include "gamma/math/batch.hpp"
+#include "gamma/math/dispatch.hpp"
+#include "gamma/math/lanes.hpp"
+
+namespace y_internal {
+
+// Defined in kernels_*.cpp.
+template <>
+BatchKernels MakeKernels<BatchKernels, y::SimdLevel::kSse42>();
+template <>
+BatchKernels MakeKernels<BatchKernels, y::SimdLevel::kAvx2>();
+template <>
+BatchKernels MakeKernels<BatchKernels, y::SimdLevel::kAvx512>();
+
+}  // namespace y_internal
+
+namespace y {
+namespace {
+
+// Each kernel processes elements from `begin` in whole groups of
+// `F::kWidth`, and returns the index of the first element left over.
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline size_t TransformPointsLanes(
+    const Mat4& m, const ConstVec3Soa& in, const Vec3Soa& out, size_t begin) {
+  F columns[4][3];
+  for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < 3; ++i) columns[j][i] = F::Splat(m[j][i]);
+  }
+  size_t n = in.size;
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    F x = F::Load(in[0] + e);
+    F y = F::Load(in[1] + e);
+    F z = F::Load(in[2] + e);
+    for (int i = 0; i < 3; ++i) {
+      F sum = MulAdd(columns[0][i], x, columns[3][i]);
+      sum = MulAdd(columns[1][i], y, sum);
+      MulAdd(columns[2][i], z, sum).store(out[i] + e);
+    }
+  }
+  return e;
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline size_t ComposeTransformsLanes(
+    const ConstMat4Soa& parents, const ConstMat4Soa& children,
+    const Mat4Soa& out, size_t begin) {
+  size_t n = parents.size;
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    // All of the parent is loaded before anything is stored, so that `out`
+    // may be `parents`. Column j of the child is only read before column j of
+    // the result is stored, so `out` may also be `children`.
+    F parent[16];
+    for (int k = 0; k < 16; ++k) parent[k] = F::Load(parents[k] + e);
+    for (int j = 0; j < 4; ++j) {
+      F child[4];
+      for (int k = 0; k < 4; ++k) child[k] = F::Load(children[4 * j + k] + e);
+      for (int i = 0; i < 4; ++i) {
+        F sum = parent[i] * child[0];
+        sum = MulAdd(parent[4 + i], child[1], sum);
+        sum = MulAdd(parent[8 + i], child[2], sum);
+        MulAdd(parent[12 + i], child[3], sum).store(out[4 * j + i] + e);
+      }
+    }
+  }
+  return e;
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline size_t NormalizeQuatsLanes(const QuatSoa& quats,
+                                                           size_t begin) {
+  size_t n = quats.size;
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    F q[4];
+    for (int k = 0; k < 4; ++k) q[k] = F::Load(quats[k] + e);
+    F length2 = q[0] * q[0];
+    for (int k = 1; k < 4; ++k) length2 = MulAdd(q[k], q[k], length2);
+    F scale = InverseSqrt(length2);
+    for (int k = 0; k < 4; ++k) (q[k] * scale).store(quats[k] + e);
+  }
+  return e;
+}
+
+// Whole kernels: groups of `F::kWidth`, then the rest one at a time.
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline void TransformPointsBatch(
+    const Mat4& m, const ConstVec3Soa& in, const Vec3Soa& out) {
+  size_t e = TransformPointsLanes<F>(m, in, out, 0);
+  TransformPointsLanes<Float1>(m, in, out, e);
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline void ComposeTransformsBatch(
+    const ConstMat4Soa& parents, const ConstMat4Soa& children,
+    const Mat4Soa& out) {
+  size_t e = ComposeTransformsLanes<F>(parents, children, out, 0);
+  ComposeTransformsLanes<Float1>(parents, children, out, e);
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline void NormalizeQuatsBatch(const QuatSoa& quats) {
+  size_t e = NormalizeQuatsLanes<F>(quats, 0);
+  NormalizeQuatsLanes<Float1>(quats, e);
+}
+
+template <typename F>
+y_internal::BatchKernels MakeBatchKernels() {
+  y_internal::BatchKernels kernels;
+  kernels.transform_points = &TransformPointsBatch<F>;
+  kernels.compose_transforms = &ComposeTransformsBatch<F>;
+  kernels.normalize_quats = &NormalizeQuatsBatch<F>;
+  return kernels;
+}
+
+}  // namespace
+}  // namespace y
+#endif  // GAMMA_MATH_BATCH_KERNELS_HPP_
@@ -0,0 +1,199 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/batch.hpp"
+
+#include <random>
+#include <vector>
+
+#include "gamma/math/quat.hpp"
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+// Sizes around every lane width, to cover full groups and tails.
+const size_t kSizes[] = {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 100};
+
+// Owns `N` arrays of `size` random floats.
+template <int N>
+class SoaArrays {
+ public:
+  SoaArrays(size_t size, std::mt19937* rng) : arrays_(N) {
+    std::uniform_real_distribution<float> dist(-2, 2);
+    for (std::vector<float>& array : arrays_) {
+      for (size_t i = 0; i < size; ++i) array.push_back(dist(*rng));
+    }
+  }
+
+  SoaSpan<N> span() {
+    float* components[N];
+    for (int k = 0; k < N; ++k) components[k] = arrays_[k].data();
+    return SoaSpan<N>(components, arrays_[0].size());
+  }
+
+  float get(int component, size_t i) const { return arrays_[component][i]; }
+
+ private:
+  std::vector<std::vector<float>> arrays_;
+};
+
+// Every instruction set this CPU can run.
+template <int N>
+Mat4 GetMat4(const SoaArrays<N>& arrays, size_t e) {
+  Mat4 m;
+  for (int k = 0; k < 16; ++k) m[k / 4][k % 4] = arrays.get(k, e);
+  return m;
+}
+
+// Each test runs the kernels of every instruction set this CPU supports.
+
+void CheckTransformPoints(const y_internal::BatchKernels& kernels,
+                          std::mt19937* rng) {
+  Mat4 m = GetMat4(SoaArrays<16>(1, rng), 0);
+  for (size_t n : kSizes) {
+    SoaArrays<3> in(n, rng);
+    SoaArrays<3> out(n, rng);
+    kernels.transform_points(m, in.span(), out.span());
+    for (size_t e = 0; e < n; ++e) {
+      Vec3 expected =
+          TransformPoint(m, Vec3(in.get(0, e), in.get(1, e), in.get(2, e)));
+      for (int i = 0; i < 3; ++i) {
+        EXPECT_NEAR(out.get(i, e), expected[i], 1e-5f) << n << ", " << e;
+      }
+    }
+
+    // In place.
+    kernels.transform_points(m, in.span(), in.span());
+    for (size_t e = 0; e < n; ++e) {
+      for (int i = 0; i < 3; ++i) EXPECT_EQ(in.get(i, e), out.get(i, e));
+    }
+  }
+}
+
+TEST(BatchTest, TransformPoints) {
+  std::mt19937 rng(1);
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    CheckTransformPoints(y_internal::GetBatchKernels(level), &rng);
+  }
+}
+
+void CheckComposeTransforms(const y_internal::BatchKernels& kernels,
+                            std::mt19937* rng) {
+  for (size_t n : kSizes) {
+    SoaArrays<16> parents(n, rng);
+    SoaArrays<16> children(n, rng);
+    SoaArrays<16> out(n, rng);
+    kernels.compose_transforms(parents.span(), children.span(), out.span());
+    for (size_t e = 0; e < n; ++e) {
+      Mat4 expected = GetMat4(parents, e) * GetMat4(children, e);
+      Mat4 actual = GetMat4(out, e);
+      for (int k = 0; k < 16; ++k) {
+        EXPECT_NEAR(actual[k / 4][k % 4], expected[k / 4][k % 4], 1e-5f)
+            << n << ", " << e;
+      }
+    }
+
+    // Into either input.
+    SoaArrays<16> parents_copy = parents;
+    kernels.compose_transforms(parents.span(), children.span(),
+                               parents.span());
+    kernels.compose_transforms(parents_copy.span(), children.span(),
+                               children.span());
+    for (size_t e = 0; e < n; ++e) {
+      for (int k = 0; k < 16; ++k) {
+        EXPECT_EQ(parents.get(k, e), out.get(k, e));
+        EXPECT_EQ(children.get(k, e), out.get(k, e));
+      }
+    }
+  }
+}
+
+TEST(BatchTest, ComposeTransforms) {
+  std::mt19937 rng(2);
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    CheckComposeTransforms(y_internal::GetBatchKernels(level), &rng);
+  }
+}
+
+void CheckNormalizeQuats(const y_internal::BatchKernels& kernels,
+                         std::mt19937* rng) {
+  for (size_t n : kSizes) {
+    SoaArrays<4> quats(n, rng);
+    SoaArrays<4> original = quats;
+    kernels.normalize_quats(quats.span());
+    for (size_t e = 0; e < n; ++e) {
+      Quat expected = Normalize(Quat(original.get(0, e), original.get(1, e),
+                                     original.get(2, e), original.get(3, e)));
+      EXPECT_NEAR(quats.get(0, e), expected.x, 1e-6f) << n << ", " << e;
+      EXPECT_NEAR(quats.get(1, e), expected.y, 1e-6f) << n << ", " << e;
+      EXPECT_NEAR(quats.get(2, e), expected.z, 1e-6f) << n << ", " << e;
+      EXPECT_NEAR(quats.get(3, e), expected.w, 1e-6f) << n << ", " << e;
+    }
+  }
+}
+
+TEST(BatchTest, NormalizeQuats) {
+  std::mt19937 rng(3);
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    CheckNormalizeQuats(y_internal::GetBatchKernels(level), &rng);
+  }
+}
+
+TEST(BatchTest, DispatchesToActiveLevel) {
+  std::vector<float> x = {1, 2, 3, 4, 5};
+  std::vector<float> y(5, 0.0f);
+  std::vector<float> z(5, 0.0f);
+  Vec3Soa points({x.data(), y.data(), z.data()}, 5);
+  TransformPoints(TranslationMatrix(Vec3(1, 2, 3)), points, points);
+  for (size_t e = 0; e < 5; ++e) {
+    EXPECT_EQ(x[e], e + 2);
+    EXPECT_EQ(y[e], 2);
+    EXPECT_EQ(z[e], 3);
+  }
+}
+
+TEST(BatchTest, ConvertsToConstViews) {
+  std::vector<float> x = {1, 2};
+  std::vector<float> y = {3, 4};
+  std::vector<float> z = {5, 6};
+  Vec3Soa points({x.data(), y.data(), z.data()}, 2);
+  ConstVec3Soa view = points;
+  EXPECT_EQ(view.size, 2u);
+  EXPECT_EQ(view[1][1], 4);
+}
+
+TEST(BatchTest, MismatchedSizesDie) {
+  std::vector<float> a(4);
+  std::vector<float> b(3);
+  Vec3Soa in({a.data(), a.data(), a.data()}, 4);
+  Vec3Soa out({b.data(), b.data(), b.data()}, 3);
+  EXPECT_DEATH_IF_SUPPORTED(TransformPoints(Mat4(1.0f), in, out), "");
+}
+
+TEST(BatchTest, UnsupportedLevelDies) {
+  if (DetectSimdLevel() == SimdLevel::kAvx512) return;
+  EXPECT_DEATH_IF_SUPPORTED(y_internal::GetBatchKernels(SimdLevel::kAvx512),
+                            "");
+}
+
+}  // namespace
+}  // namespace y
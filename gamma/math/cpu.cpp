@@ -0,0 +1,126 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/cpu.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "gamma/common/log.hpp"
+
+#ifdef GAMMA_MATH_DISPATCH
+#include <cpuid.h>
+#endif
+
+namespace y {
+namespace {
+
+#ifdef GAMMA_MATH_DISPATCH
+
+// Register state the operating system saves on context switches.
+uint64_t ReadXcr0() {
+  uint32_t eax, edx;
+  __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return eax | static_cast<uint64_t>(edx) << 32;
+}
+
+constexpr uint64_t kXmmYmmState = 0x6;
+constexpr uint64_t kOpmaskZmmState = 0xe0;
+
+#endif  // GAMMA_MATH_DISPATCH
+
+}  // namespace
+
+SimdLevel DetectSimdLevel() {
+#ifdef GAMMA_MATH_DISPATCH
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return SimdLevel::kScalar;
+  if (!(ecx & bit_SSE4_2)) return SimdLevel::kScalar;
+  bool avx = (ecx & bit_AVX) && (ecx & bit_FMA) && (ecx & bit_F16C) &&
+             (ecx & bit_OSXSAVE);
+  if (!avx) return SimdLevel::kSse42;
+  uint64_t xcr0 = ReadXcr0();
+  if ((xcr0 & kXmmYmmState) != kXmmYmmState) return SimdLevel::kSse42;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return SimdLevel::kSse42;
+  }
+  if (!(ebx & bit_AVX2)) return SimdLevel::kSse42;
+  if (!(ebx & bit_AVX512F)) return SimdLevel::kAvx2;
+  if ((xcr0 & kOpmaskZmmState) != kOpmaskZmmState) return SimdLevel::kAvx2;
+  return SimdLevel::kAvx512;
+#else
+  return SimdLevel::kScalar;
+#endif
+}
+
+std::vector<SimdLevel> SupportedSimdLevels() {
+  std::vector<SimdLevel> levels;
+  for (SimdLevel level : {SimdLevel::kScalar, SimdLevel::kSse42,
+                          SimdLevel::kAvx2, SimdLevel::kAvx512}) {
+    if (level <= DetectSimdLevel()) levels.push_back(level);
+  }
+  return levels;
+}
+
+SimdLevel ActiveSimdLevel() {
+  static const SimdLevel level =
+      SelectSimdLevel(DetectSimdLevel(), std::getenv("GAMMA_MATH_SIMD"));
+  return level;
+}
+
+const char* SimdLevelName(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::kScalar:
+      return "scalar";
+    case SimdLevel::kSse42:
+      return "sse4.2";
+    case SimdLevel::kAvx2:
+      return "avx2";
+    case SimdLevel::kAvx512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+bool ParseSimdLevel(absl::string_view name, SimdLevel* level) {
+  for (SimdLevel candidate : {SimdLevel::kScalar, SimdLevel::kSse42,
+                              SimdLevel::kAvx2, SimdLevel::kAvx512}) {
+    if (name == SimdLevelName(candidate)) {
+      *level = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+SimdLevel SelectSimdLevel(SimdLevel detected, const char* override_name) {
+  if (override_name == nullptr) return detected;
+  SimdLevel level;
+  if (!ParseSimdLevel(override_name, &level)) {
+    YLOG << "ignoring unknown GAMMA_MATH_SIMD level " << override_name;
+    return detected;
+  }
+  if (level > detected) {
+    YLOG << "ignoring GAMMA_MATH_SIMD level " << override_name
+         << ", which this CPU does not support";
+    return detected;
+  }
+  return level;
+}
+
+}  // namespace y
@@ -0,0 +1,82 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_CPU_HPP_
+#define GAMMA_MATH_CPU_HPP_
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+// Kernels in gamma/math are compiled for several instruction sets in one
+// binary, by marking functions with the target attributes below rather than
+// compiling whole files with different flags, and the widest set the CPU
+// supports is picked at run time. This needs the GCC or Clang attribute
+// syntax on x86; elsewhere, and with GAMMA_MATH_NO_SIMD, only the scalar
+// kernels are built.
+//
+// The attributes also force inlining. The files themselves are built for the
+// baseline instruction set, and a call that passes or returns a vector by
+// value between functions with these attributes is not safe: at -O2, GCC
+// clears the upper half of a returned AVX vector with vzeroupper. Marked
+// functions therefore only run inlined into a kernel whose address is taken,
+// and kernels only take and return pointers and scalars.
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__)) && !defined(GAMMA_MATH_NO_SIMD)
+#define GAMMA_MATH_DISPATCH 1
+#define GAMMA_MATH_TARGET_SSE42 \
+  __attribute__((target("sse4.2"), always_inline))
+#define GAMMA_MATH_TARGET_AVX2 \
+  __attribute__((target("avx2,fma,f16c"), always_inline))
+#define GAMMA_MATH_TARGET_AVX512 \
+  __attribute__((target("avx512f,avx2,fma,f16c"), always_inline))
+#endif
+
+namespace y {
+
+// Instruction sets with kernels, from narrowest to widest.
+enum class SimdLevel {
+  kScalar,
+  kSse42,
+  kAvx2,  // Also requires FMA and F16C.
+  kAvx512,  // AVX-512F.
+};
+
+// Widest level that both the CPU and the operating system support, from
+// CPUID and the register state enabled in XCR0.
+SimdLevel DetectSimdLevel();
+
+// Every level up to `DetectSimdLevel()`, from narrowest to widest, for tests
+// and benchmarks that run the kernels of each level.
+std::vector<SimdLevel> SupportedSimdLevels();
+
+// Level used by the dispatched kernels: the detected one, unless the
+// GAMMA_MATH_SIMD environment variable names a narrower one, e.g. for
+// benchmarking. Evaluated once, on first use.
+SimdLevel ActiveSimdLevel();
+
+// "scalar", "sse4.2", "avx2" or "avx512".
+const char* SimdLevelName(SimdLevel level);
+bool ParseSimdLevel(absl::string_view name, SimdLevel* level);
+
+// `detected`, or the level named by `override_name` if it is not null and
+// names a level no wider. Logs and ignores overrides that do not.
+SimdLevel SelectSimdLevel(SimdLevel detected, const char* override_name);
+
+}  // namespace y
+#endif  // GAMMA_MATH_CPU_HPP_
@@ -0,0 +1,65 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/cpu.hpp"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+TEST(CpuTest, NamesRoundTrip) {
+  for (SimdLevel level : {SimdLevel::kScalar, SimdLevel::kSse42,
+                          SimdLevel::kAvx2, SimdLevel::kAvx512}) {
+    SimdLevel parsed = SimdLevel::kScalar;
+    EXPECT_TRUE(ParseSimdLevel(SimdLevelName(level), &parsed));
+    EXPECT_EQ(parsed, level);
+  }
+  SimdLevel parsed;
+  EXPECT_FALSE(ParseSimdLevel("avx", &parsed));
+  EXPECT_FALSE(ParseSimdLevel("", &parsed));
+}
+
+TEST(CpuTest, OverrideNarrowsLevel) {
+  EXPECT_EQ(SelectSimdLevel(SimdLevel::kAvx2, nullptr), SimdLevel::kAvx2);
+  EXPECT_EQ(SelectSimdLevel(SimdLevel::kAvx2, "sse4.2"), SimdLevel::kSse42);
+  EXPECT_EQ(SelectSimdLevel(SimdLevel::kAvx2, "scalar"), SimdLevel::kScalar);
+  EXPECT_EQ(SelectSimdLevel(SimdLevel::kAvx2, "avx2"), SimdLevel::kAvx2);
+}
+
+TEST(CpuTest, IgnoresUnsupportedOverrides) {
+  EXPECT_EQ(SelectSimdLevel(SimdLevel::kAvx2, "avx512"), SimdLevel::kAvx2);
+  EXPECT_EQ(SelectSimdLevel(SimdLevel::kSse42, "fast"), SimdLevel::kSse42);
+}
+
+TEST(CpuTest, SupportedLevelsEndAtDetectedLevel) {
+  std::vector<SimdLevel> levels = SupportedSimdLevels();
+  ASSERT_FALSE(levels.empty());
+  EXPECT_EQ(levels.front(), SimdLevel::kScalar);
+  EXPECT_EQ(levels.back(), DetectSimdLevel());
+  EXPECT_EQ(levels.size(), static_cast<size_t>(DetectSimdLevel()) + 1);
+}
+
+TEST(CpuTest, ActiveLevelIsSupported) {
+  EXPECT_LE(ActiveSimdLevel(), DetectSimdLevel());
+}
+
+}  // namespace
+}  // namespace y
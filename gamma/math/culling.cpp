@@ -0,0 +1,79 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/culling.hpp"
+
+#include "gamma/common/log.hpp"
+
+#define GAMMA_MATH_KERNEL_TARGET
+#include "gamma/math/culling_kernels.hpp"
+
+namespace y_internal {
+
+template <>
+CullingKernels MakeKernels<CullingKernels, y::SimdLevel::kScalar>() {
+  return y::MakeCullingKernels<y::Float1>();
+}
+
+const CullingKernels& GetCullingKernels(y::SimdLevel level) {
+  return GetKernels<CullingKernels>(level);
+}
+
+}  // namespace y_internal
+
+namespace y {
+namespace {
+
+using y_internal::ActiveKernels;
+using y_internal::CullingKernels;
+
+}  // namespace
+
+Frustum ExtractFrustum(const Mat4& view_projection, ClipDepth depth) {
+  // A point is inside when each clip coordinate lies within [-w, w], or z
+  // within [0, w], so each plane is a sum or difference of the matrix rows.
+  Mat4 rows = Transpose(view_projection);
+  Frustum frustum;
+  frustum.planes[Frustum::kLeft] = rows[3] + rows[0];
+  frustum.planes[Frustum::kRight] = rows[3] - rows[0];
+  frustum.planes[Frustum::kBottom] = rows[3] + rows[1];
+  frustum.planes[Frustum::kTop] = rows[3] - rows[1];
+  frustum.planes[Frustum::kNear] =
+      depth == ClipDepth::kZeroToOne ? rows[2] : rows[3] + rows[2];
+  frustum.planes[Frustum::kFar] = rows[3] - rows[2];
+  for (Vec4& plane : frustum.planes) {
+    plane = plane / Length(Vec3(plane.x, plane.y, plane.z));
+  }
+  return frustum;
+}
+
+size_t CullSpheres(const Frustum& frustum, SphereSoa spheres,
+                   absl::Span<uint32_t> visible) {
+  YERR_IF(visible.size() < spheres.size) << "visible list is too small";
+  return ActiveKernels<CullingKernels>().cull_spheres(frustum, spheres,
+                                                      visible.data());
+}
+
+size_t CullAabbs(const Frustum& frustum, AabbSoa boxes,
+                 absl::Span<uint32_t> visible) {
+  YERR_IF(visible.size() < boxes.size) << "visible list is too small";
+  return ActiveKernels<CullingKernels>().cull_aabbs(frustum, boxes,
+                                                    visible.data());
+}
+
+}  // namespace y
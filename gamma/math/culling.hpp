@@ -0,0 +1,80 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_CULLING_HPP_
+#define GAMMA_MATH_CULLING_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/types/span.h"
+#include "gamma/math/cpu.hpp"
+#include "gamma/math/mat4.hpp"
+#include "gamma/math/soa.hpp"
+#include "gamma/math/vec.hpp"
+
+namespace y {
+
+// Depth range of clip space: Vulkan and Direct3D map the near plane to 0,
+// OpenGL to -1.
+enum class ClipDepth {
+  kZeroToOne,
+  kMinusOneToOne,
+};
+
+// The six planes of a view frustum, as (normal, distance) with unit normals
+// pointing inward, so that a point p is inside plane i when
+// Dot(normal, p) + distance >= 0.
+struct Frustum {
+  enum Side { kLeft, kRight, kBottom, kTop, kNear, kFar };
+  Vec4 planes[6];
+};
+
+// Planes of the frustum whose clip space `view_projection` maps to the unit
+// cube, extracted from the matrix rows. Points are in the space that
+// `view_projection` transforms from, usually world space.
+Frustum ExtractFrustum(const Mat4& view_projection,
+                       ClipDepth depth = ClipDepth::kZeroToOne);
+
+// Write the indices of the spheres or boxes that intersect the frustum to the
+// start of `visible`, in increasing order, and return how many there are.
+// The test is conservative: a few objects just outside a corner of the
+// frustum are reported visible. `visible` must have room for every object.
+// Objects are tested 16, 8 or 4 at a time as `ActiveSimdLevel()` allows.
+size_t CullSpheres(const Frustum& frustum, SphereSoa spheres,
+                   absl::Span<uint32_t> visible);
+size_t CullAabbs(const Frustum& frustum, AabbSoa boxes,
+                 absl::Span<uint32_t> visible);
+
+}  // namespace y
+
+namespace y_internal {
+
+// The kernels compiled for one instruction set, without size checks.
+struct CullingKernels {
+  size_t (*cull_spheres)(const y::Frustum& frustum,
+                         const y::SphereSoa& spheres, uint32_t* visible);
+  size_t (*cull_aabbs)(const y::Frustum& frustum, const y::AabbSoa& boxes,
+                       uint32_t* visible);
+};
+
+// Kernels for `level`, which must be no wider than `DetectSimdLevel()`.
+const CullingKernels& GetCullingKernels(y::SimdLevel level);
+
+}  // namespace y_internal
+#endif  // GAMMA_MATH_CULLING_HPP_
@@ -0,0 +1,160 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_CULLING_KERNELS_HPP_
+#define GAMMA_MATH_CULLING_KERNELS_HPP_
+
+// Culling kernels as templates over a lane type; see lanes.hpp.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "gamma/math/culling.hpp"
+#include "gamma/math/dispatch.hpp"
+#include "gamma/math/lanes.hpp"
+
+namespace y_internal {
+
+// Defined in kernels_*.cpp.
+template <>
+CullingKernels MakeKernels<CullingKernels, y::SimdLevel::kSse42>();
+template <>
+CullingKernels MakeKernels<CullingKernels, y::SimdLevel::kAvx2>();
+template <>
+CullingKernels MakeKernels<CullingKernels, y::SimdLevel::kAvx512>();
+
+}  // namespace y_internal
+
+namespace y {
+namespace {
+
+// Dot(normal, center) + distance + radius for every sphere.
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline F SphereDistance(const F plane[4], F x, F y,
+                                                 F z, F r) {
+  F d = MulAdd(plane[0], x, plane[3] + r);
+  d = MulAdd(plane[1], y, d);
+  return MulAdd(plane[2], z, d);
+}
+
+// Signed distance of the corner of every box furthest along the normal.
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline F AabbDistance(const F plane[4],
+                                               const int corner[3],
+                                               const F bounds[6]) {
+  F d = MulAdd(plane[0], bounds[corner[0]], plane[3]);
+  d = MulAdd(plane[1], bounds[corner[1]], d);
+  return MulAdd(plane[2], bounds[corner[2]], d);
+}
+
+// Each kernel tests objects from `begin` in whole groups of `F::kWidth`,
+// appends the visible ones to `visible` after the `*count` found so far, and
+// returns the index of the first object left over. Since at most `begin`
+// objects were visible before a group, writing a whole group of indices never
+// goes past the first `size` entries of `visible`.
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline size_t CullSpheresLanes(
+    const Frustum& frustum, const SphereSoa& spheres, uint32_t* visible,
+    size_t begin, size_t* count) {
+  F planes[6][4];
+  for (int p = 0; p < 6; ++p) {
+    for (int k = 0; k < 4; ++k) planes[p][k] = F::Splat(frustum.planes[p][k]);
+  }
+  const F zero = F::Splat(0.0f);
+  size_t n = spheres.size;
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    F x = F::Load(spheres[0] + e);
+    F y = F::Load(spheres[1] + e);
+    F z = F::Load(spheres[2] + e);
+    F r = F::Load(spheres[3] + e);
+    typename F::Mask inside =
+        GreaterEqual(SphereDistance(planes[0], x, y, z, r), zero);
+    for (int p = 1; p < 6; ++p) {
+      inside = inside &
+               GreaterEqual(SphereDistance(planes[p], x, y, z, r), zero);
+    }
+    *count += StoreSelected(inside, static_cast<uint32_t>(e), visible + *count);
+  }
+  return e;
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline size_t CullAabbsLanes(const Frustum& frustum,
+                                                      const AabbSoa& boxes,
+                                                      uint32_t* visible,
+                                                      size_t begin,
+                                                      size_t* count) {
+  // For each plane, the corner furthest along its normal decides: the max
+  // coordinate on axes where the normal is positive, the min elsewhere.
+  F planes[6][4];
+  int corner[6][3];
+  for (int p = 0; p < 6; ++p) {
+    for (int k = 0; k < 4; ++k) planes[p][k] = F::Splat(frustum.planes[p][k]);
+    for (int k = 0; k < 3; ++k) {
+      corner[p][k] = frustum.planes[p][k] > 0 ? 3 + k : k;
+    }
+  }
+  const F zero = F::Splat(0.0f);
+  size_t n = boxes.size;
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    F bounds[6];
+    for (int k = 0; k < 6; ++k) bounds[k] = F::Load(boxes[k] + e);
+    typename F::Mask inside =
+        GreaterEqual(AabbDistance(planes[0], corner[0], bounds), zero);
+    for (int p = 1; p < 6; ++p) {
+      inside = inside &
+               GreaterEqual(AabbDistance(planes[p], corner[p], bounds), zero);
+    }
+    *count += StoreSelected(inside, static_cast<uint32_t>(e), visible + *count);
+  }
+  return e;
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline size_t CullSpheresBatch(
+    const Frustum& frustum, const SphereSoa& spheres, uint32_t* visible) {
+  size_t count = 0;
+  size_t e = CullSpheresLanes<F>(frustum, spheres, visible, 0, &count);
+  CullSpheresLanes<Float1>(frustum, spheres, visible, e, &count);
+  return count;
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline size_t CullAabbsBatch(const Frustum& frustum,
+                                                      const AabbSoa& boxes,
+                                                      uint32_t* visible) {
+  size_t count = 0;
+  size_t e = CullAabbsLanes<F>(frustum, boxes, visible, 0, &count);
+  CullAabbsLanes<Float1>(frustum, boxes, visible, e, &count);
+  return count;
+}
+
+template <typename F>
+y_internal::CullingKernels MakeCullingKernels() {
+  y_internal::CullingKernels kernels;
+  kernels.cull_spheres = &CullSpheresBatch<F>;
+  kernels.cull_aabbs = &CullAabbsBatch<F>;
+  return kernels;
+}
+
+}  // namespace
+}  // namespace y
+#endif  // GAMMA_MATH_CULLING_KERNELS_HPP_
@@ -0,0 +1,198 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/culling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+// Right-handed perspective projection looking down -z.
+Mat4 Perspective(float fovy, float aspect, float near, float far,
+                 ClipDepth depth) {
+  float f = 1.0f / std::tan(0.5f * fovy);
+  Mat4 m(0.0f);
+  m[0][0] = f / aspect;
+  m[1][1] = f;
+  m[2][3] = -1;
+  if (depth == ClipDepth::kZeroToOne) {
+    m[2][2] = far / (near - far);
+    m[3][2] = -far * near / (far - near);
+  } else {
+    m[2][2] = -(far + near) / (far - near);
+    m[3][2] = -2 * far * near / (far - near);
+  }
+  return m;
+}
+
+bool PointInside(const Frustum& frustum, const Vec3& p) {
+  for (const Vec4& plane : frustum.planes) {
+    if (Dot(Vec3(plane.x, plane.y, plane.z), p) + plane.w < 0) return false;
+  }
+  return true;
+}
+
+TEST(CullingTest, ExtractsFrustumPlanes) {
+  for (ClipDepth depth : {ClipDepth::kZeroToOne, ClipDepth::kMinusOneToOne}) {
+    Mat4 view = TranslationMatrix(Vec3(0, 0, -10));
+    Frustum frustum =
+        ExtractFrustum(Perspective(1.5f, 1.0f, 1, 100, depth) * view, depth);
+    // The camera sits at z = 10 looking toward -z.
+    EXPECT_TRUE(PointInside(frustum, Vec3(0, 0, 0)));
+    EXPECT_TRUE(PointInside(frustum, Vec3(0, 0, 8.9f)));
+    EXPECT_FALSE(PointInside(frustum, Vec3(0, 0, 9.1f)));
+    EXPECT_TRUE(PointInside(frustum, Vec3(0, 0, -89)));
+    EXPECT_FALSE(PointInside(frustum, Vec3(0, 0, -91)));
+    EXPECT_FALSE(PointInside(frustum, Vec3(20, 0, 0)));
+    EXPECT_FALSE(PointInside(frustum, Vec3(0, -20, 0)));
+    for (const Vec4& plane : frustum.planes) {
+      EXPECT_NEAR(Length(Vec3(plane.x, plane.y, plane.z)), 1, 1e-5f);
+    }
+    EXPECT_NEAR(frustum.planes[Frustum::kNear].z, -1, 1e-5f);
+    EXPECT_NEAR(frustum.planes[Frustum::kNear].w, 9, 1e-4f);
+  }
+}
+
+// Signed distance from `plane` to the corner of a box furthest along it,
+// found by trying every corner.
+float FurthestCorner(const Vec4& plane, const float bounds[6]) {
+  float best = -INFINITY;
+  for (int corner = 0; corner < 8; ++corner) {
+    Vec3 p(bounds[(corner & 1) ? 3 : 0], bounds[(corner & 2) ? 4 : 1],
+           bounds[(corner & 4) ? 5 : 2]);
+    best = std::max(best, Dot(Vec3(plane.x, plane.y, plane.z), p) + plane.w);
+  }
+  return best;
+}
+
+// Random spheres or boxes around the frustum, with none so close to a plane
+// that rounding could decide whether it is visible. `reference` gets the
+// indices of those that are.
+template <int N>
+class Objects {
+ public:
+  Objects(const Frustum& frustum, size_t n, std::mt19937* rng)
+      : arrays_(N) {
+    std::uniform_real_distribution<float> position(-60, 60);
+    std::uniform_real_distribution<float> size(0, 5);
+    for (size_t e = 0; e < n;) {
+      float values[N];
+      Vec3 center(position(*rng), position(*rng), position(*rng));
+      float extent = size(*rng);
+      if (N == 4) {
+        values[0] = center.x;
+        values[1] = center.y;
+        values[2] = center.z;
+        values[3] = extent;
+      } else {
+        for (int k = 0; k < 3; ++k) {
+          values[k] = center[k] - extent;
+          values[3 + k] = center[k] + extent * (1 + k);
+        }
+      }
+      bool visible = true;
+      bool ambiguous = false;
+      for (const Vec4& plane : frustum.planes) {
+        float d = N == 4 ? Dot(Vec3(plane.x, plane.y, plane.z), center) +
+                               plane.w + extent
+                         : FurthestCorner(plane, values);
+        visible &= d >= 0;
+        ambiguous |= std::fabs(d) < 1e-3f;
+      }
+      if (ambiguous) continue;
+      for (int k = 0; k < N; ++k) arrays_[k].push_back(values[k]);
+      if (visible) reference.push_back(static_cast<uint32_t>(e));
+      ++e;
+    }
+  }
+
+  SoaSpan<N, const float> span() const {
+    const float* components[N];
+    for (int k = 0; k < N; ++k) components[k] = arrays_[k].data();
+    return SoaSpan<N, const float>(components, arrays_[0].size());
+  }
+
+  std::vector<uint32_t> reference;
+
+ private:
+  std::vector<std::vector<float>> arrays_;
+};
+
+const size_t kSizes[] = {0, 1, 5, 15, 16, 17, 100, 1000};
+
+Frustum TestFrustum() {
+  Mat4 view = TranslationMatrix(Vec3(0, 0, -10));
+  return ExtractFrustum(
+      Perspective(1.2f, 1.5f, 1, 60, ClipDepth::kZeroToOne) * view);
+}
+
+TEST(CullingTest, CullsSpheres) {
+  Frustum frustum = TestFrustum();
+  std::mt19937 rng(1);
+  for (size_t n : kSizes) {
+    Objects<4> spheres(frustum, n, &rng);
+    for (SimdLevel level : SupportedSimdLevels()) {
+      SCOPED_TRACE(SimdLevelName(level));
+      std::vector<uint32_t> visible(n);
+      size_t count = y_internal::GetCullingKernels(level).cull_spheres(
+          frustum, spheres.span(), visible.data());
+      visible.resize(count);
+      EXPECT_EQ(visible, spheres.reference) << n;
+    }
+    std::vector<uint32_t> visible(n);
+    visible.resize(CullSpheres(frustum, spheres.span(),
+                               absl::MakeSpan(visible)));
+    EXPECT_EQ(visible, spheres.reference) << n;
+  }
+}
+
+TEST(CullingTest, CullsAabbs) {
+  Frustum frustum = TestFrustum();
+  std::mt19937 rng(2);
+  for (size_t n : kSizes) {
+    Objects<6> boxes(frustum, n, &rng);
+    for (SimdLevel level : SupportedSimdLevels()) {
+      SCOPED_TRACE(SimdLevelName(level));
+      std::vector<uint32_t> visible(n);
+      size_t count = y_internal::GetCullingKernels(level).cull_aabbs(
+          frustum, boxes.span(), visible.data());
+      visible.resize(count);
+      EXPECT_EQ(visible, boxes.reference) << n;
+    }
+    std::vector<uint32_t> visible(n);
+    visible.resize(CullAabbs(frustum, boxes.span(), absl::MakeSpan(visible)));
+    EXPECT_EQ(visible, boxes.reference) << n;
+  }
+}
+
+TEST(CullingTest, SmallVisibleListDies) {
+  std::mt19937 rng(3);
+  Objects<4> spheres(TestFrustum(), 8, &rng);
+  std::vector<uint32_t> visible(7);
+  EXPECT_DEATH_IF_SUPPORTED(
+      CullSpheres(TestFrustum(), spheres.span(), absl::MakeSpan(visible)), "");
+}
+
+}  // namespace
+}  // namespace y
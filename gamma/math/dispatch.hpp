@@ -0,0 +1,76 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_DISPATCH_HPP_
+#define GAMMA_MATH_DISPATCH_HPP_
+
+// Tables of kernels for each instruction set, shared by the families of
+// kernels in gamma/math; see cpu.hpp.
+
+#include "gamma/common/log.hpp"
+#include "gamma/math/cpu.hpp"
+
+namespace y_internal {
+
+// The table of a family of kernels for `level`. Each family specializes this
+// for the scalar level in its own .cpp file, and for the others in
+// kernels_*.cpp, which only define them with GAMMA_MATH_DISPATCH.
+template <typename Kernels, y::SimdLevel level>
+Kernels MakeKernels();
+
+// Kernels for `level`, which must be no wider than `DetectSimdLevel()`. The
+// tables of every level are made on first use.
+template <typename Kernels>
+const Kernels& GetKernels(y::SimdLevel level);
+
+// Kernels for `ActiveSimdLevel()`, bound on first use.
+template <typename Kernels>
+const Kernels& ActiveKernels();
+
+}  // namespace y_internal
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+namespace y_internal {
+
+template <typename Kernels>
+const Kernels& GetKernels(y::SimdLevel level) {
+  YERR_IF(level > y::DetectSimdLevel())
+      << y::SimdLevelName(level) << " is not supported by this CPU";
+#ifdef GAMMA_MATH_DISPATCH
+  static const Kernels kernels[] = {
+      MakeKernels<Kernels, y::SimdLevel::kScalar>(),
+      MakeKernels<Kernels, y::SimdLevel::kSse42>(),
+      MakeKernels<Kernels, y::SimdLevel::kAvx2>(),
+      MakeKernels<Kernels, y::SimdLevel::kAvx512>()};
+#else
+  static const Kernels kernels[] = {
+      MakeKernels<Kernels, y::SimdLevel::kScalar>()};
+#endif
+  return kernels[static_cast<int>(level)];
+}
+
+template <typename Kernels>
+const Kernels& ActiveKernels() {
+  static const Kernels& kernels = GetKernels<Kernels>(y::ActiveSimdLevel());
+  return kernels;
+}
+
+}  // namespace y_internal
+#endif  // GAMMA_MATH_DISPATCH_HPP_
@@ -0,0 +1,82 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_GLM_INTEROP_HPP_
+#define GAMMA_MATH_GLM_INTEROP_HPP_
+
+#include <cstring>
+
+#include "gamma/math/mat4.hpp"
+#include "gamma/math/quat.hpp"
+#include "gamma/math/vec.hpp"
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+namespace y {
+
+// Conversions between the gamma/math types and glm, for code such as
+// `CameraTransforms` that keeps glm types in its interface. Matrices share
+// their memory layout, so converting one is a 64 byte copy that compiles to
+// a few vector moves.
+
+Mat4 FromGlm(const glm::mat4& m);
+Vec4 FromGlm(const glm::vec4& v);
+Vec3 FromGlm(const glm::vec3& v);
+Quat FromGlm(const glm::quat& q);
+
+glm::mat4 ToGlm(const Mat4& m);
+glm::vec4 ToGlm(const Vec4& v);
+glm::vec3 ToGlm(const Vec3& v);
+glm::quat ToGlm(const Quat& q);
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+static_assert(sizeof(glm::mat4) == sizeof(Mat4),
+              "glm::mat4 must be 16 packed floats");
+
+inline Mat4 FromGlm(const glm::mat4& m) {
+  Mat4 r;
+  std::memcpy(&r, &m[0][0], sizeof(r));
+  return r;
+}
+
+inline Vec4 FromGlm(const glm::vec4& v) { return Vec4(v.x, v.y, v.z, v.w); }
+
+inline Vec3 FromGlm(const glm::vec3& v) { return Vec3(v.x, v.y, v.z); }
+
+inline Quat FromGlm(const glm::quat& q) { return Quat(q.x, q.y, q.z, q.w); }
+
+inline glm::mat4 ToGlm(const Mat4& m) {
+  glm::mat4 r;
+  std::memcpy(&r[0][0], &m, sizeof(m));
+  return r;
+}
+
+inline glm::vec4 ToGlm(const Vec4& v) {
+  return glm::vec4(v.x, v.y, v.z, v.w);
+}
+
+inline glm::vec3 ToGlm(const Vec3& v) { return glm::vec3(v.x, v.y, v.z); }
+
+inline glm::quat ToGlm(const Quat& q) {
+  return glm::quat(q.w, q.x, q.y, q.z);
+}
+
+}  // namespace y
+#endif  // GAMMA_MATH_GLM_INTEROP_HPP_
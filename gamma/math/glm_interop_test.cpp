@@ -0,0 +1,71 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/glm_interop.hpp"
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+TEST(GlmInteropTest, Mat4SharesLayout) {
+  glm::mat4 m(1.0f);
+  for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < 4; ++i) m[j][i] = 4.0f * j + i;
+  }
+  Mat4 converted = FromGlm(m);
+  for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < 4; ++i) EXPECT_EQ(converted[j][i], m[j][i]);
+  }
+  glm::mat4 back = ToGlm(converted * Mat4(1.0f));
+  for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < 4; ++i) EXPECT_EQ(back[j][i], m[j][i]);
+  }
+}
+
+TEST(GlmInteropTest, MatchesGlmProducts) {
+  glm::mat4 a(1.0f);
+  glm::mat4 b(1.0f);
+  for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < 4; ++i) {
+      a[j][i] = 0.5f * j - i;
+      b[j][i] = j * i - 1.5f;
+    }
+  }
+  glm::mat4 expected = a * b;
+  Mat4 product = FromGlm(a) * FromGlm(b);
+  for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < 4; ++i) EXPECT_FLOAT_EQ(product[j][i], expected[j][i]);
+  }
+}
+
+TEST(GlmInteropTest, VectorsAndQuaternions) {
+  Vec3 v3 = FromGlm(glm::vec3(1, 2, 3));
+  EXPECT_EQ(v3.z, 3);
+  Vec4 v4 = FromGlm(ToGlm(Vec4(1, 2, 3, 4)));
+  EXPECT_EQ(v4.w, 4);
+  glm::quat q = ToGlm(Quat(1, 2, 3, 4));
+  EXPECT_EQ(q.x, 1);
+  EXPECT_EQ(q.w, 4);
+  Quat back = FromGlm(q);
+  EXPECT_EQ(back.y, 2);
+  EXPECT_EQ(back.w, 4);
+}
+
+}  // namespace
+}  // namespace y
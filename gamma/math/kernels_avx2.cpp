@@ -0,0 +1,283 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+// Kernels for AVX2 and FMA, eight lanes at a time.
+
+#include "gamma/math/cpu.hpp"
+
+#ifdef GAMMA_MATH_DISPATCH
+
+#include <immintrin.h>
+
+#include <cstring>
+
+#define GAMMA_MATH_KERNEL_TARGET GAMMA_MATH_TARGET_AVX2
+#include "gamma/math/approx_kernels.hpp"
+#include "gamma/math/batch_kernels.hpp"
+#include "gamma/math/culling_kernels.hpp"
+#include "gamma/math/pack_kernels.hpp"
+#include "gamma/math/random_kernels.hpp"
+#include "gamma/math/raycast_kernels.hpp"
+
+namespace y {
+namespace {
+
+struct Uint8 {
+  GAMMA_MATH_KERNEL_TARGET static Uint8 Load(const uint32_t* p) {
+    return {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))};
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(uint32_t* p) const {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+  }
+  __m256i v;
+};
+
+struct Float8 {
+  static constexpr size_t kWidth = 8;
+  using Bits = Uint8;
+  struct Mask {
+    __m256 v;
+  };
+  GAMMA_MATH_KERNEL_TARGET static Float8 Load(const float* p) {
+    return {_mm256_loadu_ps(p)};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float8 Load(const int8_t* p) {
+    return {_mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(Load64(p)))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float8 Load(const uint8_t* p) {
+    return {_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(Load64(p)))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float8 Load(const int16_t* p) {
+    return {_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(Load128(p)))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float8 Load(const uint16_t* p) {
+    return {_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(Load128(p)))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float8 LoadHalf(const uint16_t* p) {
+    return {_mm256_cvtph_ps(Load128(p))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float8 LoadBitField(const uint32_t* p,
+                                                      int shift, int bits,
+                                                      bool is_signed) {
+    __m256i top = _mm256_sll_epi32(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)),
+        _mm_cvtsi32_si128(32 - shift - bits));
+    __m128i down = _mm_cvtsi32_si128(32 - bits);
+    return {_mm256_cvtepi32_ps(is_signed ? _mm256_sra_epi32(top, down)
+                                         : _mm256_srl_epi32(top, down))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float8 Splat(float s) {
+    return {_mm256_set1_ps(s)};
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(float* p) const {
+    _mm256_storeu_ps(p, v);
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(int8_t* p) const {
+    __m128i i = Int16s();
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packs_epi16(i, i));
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(uint8_t* p) const {
+    __m128i i = Int16s();
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(i, i));
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(int16_t* p) const {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), Int16s());
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(uint16_t* p) const {
+    __m256i i = _mm256_cvtps_epi32(v);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                     _mm_packus_epi32(_mm256_castsi256_si128(i),
+                                      _mm256_extracti128_si256(i, 1)));
+  }
+  GAMMA_MATH_KERNEL_TARGET void storeHalf(uint16_t* p) const {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                     _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+  }
+  __m256 v;
+
+ private:
+  GAMMA_MATH_KERNEL_TARGET static __m128i Load64(const void* p) {
+    return _mm_loadl_epi64(static_cast<const __m128i*>(p));
+  }
+  GAMMA_MATH_KERNEL_TARGET static __m128i Load128(const void* p) {
+    return _mm_loadu_si128(static_cast<const __m128i*>(p));
+  }
+  // Rounded and saturated to int16_t, in order.
+  GAMMA_MATH_KERNEL_TARGET __m128i Int16s() const {
+    __m256i i = _mm256_cvtps_epi32(v);
+    return _mm_packs_epi32(_mm256_castsi256_si128(i),
+                           _mm256_extracti128_si256(i, 1));
+  }
+};
+
+GAMMA_MATH_KERNEL_TARGET inline Float8 operator*(Float8 a, Float8 b) {
+  return {_mm256_mul_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float8 operator+(Float8 a, Float8 b) {
+  return {_mm256_add_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float8 operator-(Float8 a, Float8 b) {
+  return {_mm256_sub_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float8 operator/(Float8 a, Float8 b) {
+  return {_mm256_div_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float8 MulAdd(Float8 a, Float8 b, Float8 c) {
+  return {_mm256_fmadd_ps(a.v, b.v, c.v)};
+}
+
+// The hardware estimate refined by one Newton-Raphson step.
+GAMMA_MATH_KERNEL_TARGET inline Float8 InverseSqrt(Float8 a) {
+  Float8 r = {_mm256_rsqrt_ps(a.v)};
+  Float8 half_a = a * Float8::Splat(-0.5f);
+  return r * MulAdd(half_a * r, r, Float8::Splat(1.5f));
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float8 Min(Float8 a, Float8 b) {
+  return {_mm256_min_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float8 Max(Float8 a, Float8 b) {
+  return {_mm256_max_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float8 Abs(Float8 a) {
+  return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float8 FlipSign(Float8 a, Float8 b) {
+  return {_mm256_xor_ps(a.v, _mm256_and_ps(b.v, _mm256_set1_ps(-0.0f)))};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float8 Pow2(Float8 n) {
+  return {_mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_add_epi32(_mm256_cvtps_epi32(n.v), _mm256_set1_epi32(127)), 23))};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float8::Mask GreaterEqual(Float8 a,
+                                                          Float8 b) {
+  return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float8::Mask operator&(Float8::Mask a,
+                                                       Float8::Mask b) {
+  return {_mm256_and_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float8 Select(Float8::Mask m, Float8 a,
+                                              Float8 b) {
+  return {_mm256_blendv_ps(b.v, a.v, m.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline void StoreBitFields(const Float8* fields,
+                                                    const int* bits, int n,
+                                                    uint32_t* p) {
+  __m256i packed = _mm256_setzero_si256();
+  int shift = 0;
+  for (int i = 0; i < n; ++i) {
+    __m256i field = _mm256_and_si256(_mm256_cvtps_epi32(fields[i].v),
+                                     _mm256_set1_epi32((1 << bits[i]) - 1));
+    packed = _mm256_or_si256(
+        packed, _mm256_sll_epi32(field, _mm_cvtsi32_si128(shift)));
+    shift += bits[i];
+  }
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), packed);
+}
+
+GAMMA_MATH_KERNEL_TARGET inline size_t StoreSelected(Float8::Mask m,
+                                                     uint32_t first,
+                                                     uint32_t* out) {
+  int bits = _mm256_movemask_ps(m.v);
+  long long lanes;
+  std::memcpy(&lanes, kSelectedLanes.lanes[bits], sizeof(lanes));
+  __m256i indices =
+      _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_cvtsi64_si128(lanes)),
+                       _mm256_set1_epi32(static_cast<int>(first)));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), indices);
+  return __builtin_popcount(bits);
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Uint8 operator+(Uint8 a, Uint8 b) {
+  return {_mm256_add_epi32(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Uint8 operator^(Uint8 a, Uint8 b) {
+  return {_mm256_xor_si256(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Uint8 operator|(Uint8 a, Uint8 b) {
+  return {_mm256_or_si256(a.v, b.v)};
+}
+
+template <int n>
+GAMMA_MATH_KERNEL_TARGET inline Uint8 ShiftLeft(Uint8 a) {
+  return {_mm256_slli_epi32(a.v, n)};
+}
+
+template <int n>
+GAMMA_MATH_KERNEL_TARGET inline Uint8 ShiftRight(Uint8 a) {
+  return {_mm256_srli_epi32(a.v, n)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float8 UnitFloat(Uint8 a) {
+  return {_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(a.v, 8)),
+                        _mm256_set1_ps(1.0f / (1 << 24)))};
+}
+
+}  // namespace
+}  // namespace y
+
+namespace y_internal {
+
+template <>
+ApproxKernels MakeKernels<ApproxKernels, y::SimdLevel::kAvx2>() {
+  return y::MakeApproxKernels<y::Float8>();
+}
+
+template <>
+BatchKernels MakeKernels<BatchKernels, y::SimdLevel::kAvx2>() {
+  return y::MakeBatchKernels<y::Float8>();
+}
+
+template <>
+CullingKernels MakeKernels<CullingKernels, y::SimdLevel::kAvx2>() {
+  return y::MakeCullingKernels<y::Float8>();
+}
+
+template <>
+PackKernels MakeKernels<PackKernels, y::SimdLevel::kAvx2>() {
+  return y::MakePackKernels<y::Float8>();
+}
+
+template <>
+RandomKernels MakeKernels<RandomKernels, y::SimdLevel::kAvx2>() {
+  return y::MakeRandomKernels<y::Float8>();
+}
+
+template <>
+RaycastKernels MakeKernels<RaycastKernels, y::SimdLevel::kAvx2>() {
+  return y::MakeRaycastKernels<y::Float8>();
+}
+
+}  // namespace y_internal
+
+#endif  // GAMMA_MATH_DISPATCH
@@ -0,0 +1,268 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+// Kernels for AVX-512F, sixteen lanes at a time.
+
+#include "gamma/math/cpu.hpp"
+
+#ifdef GAMMA_MATH_DISPATCH
+
+#include <immintrin.h>
+
+#define GAMMA_MATH_KERNEL_TARGET GAMMA_MATH_TARGET_AVX512
+#include "gamma/math/approx_kernels.hpp"
+#include "gamma/math/batch_kernels.hpp"
+#include "gamma/math/culling_kernels.hpp"
+#include "gamma/math/pack_kernels.hpp"
+#include "gamma/math/random_kernels.hpp"
+#include "gamma/math/raycast_kernels.hpp"
+
+namespace y {
+namespace {
+
+struct Float16 {
+  static constexpr size_t kWidth = 16;
+  struct Mask {
+    __mmask16 v;
+  };
+  GAMMA_MATH_KERNEL_TARGET static Float16 Load(const float* p) {
+    return {_mm512_loadu_ps(p)};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float16 Load(const int8_t* p) {
+    return {ToFloats(_mm512_maskz_cvtepi8_epi32(0xffff, Load128(p)))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float16 Load(const uint8_t* p) {
+    return {ToFloats(_mm512_maskz_cvtepu8_epi32(0xffff, Load128(p)))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float16 Load(const int16_t* p) {
+    return {ToFloats(_mm512_maskz_cvtepi16_epi32(0xffff, Load256(p)))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float16 Load(const uint16_t* p) {
+    return {ToFloats(_mm512_maskz_cvtepu16_epi32(0xffff, Load256(p)))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float16 LoadHalf(const uint16_t* p) {
+    return {_mm512_maskz_cvtph_ps(0xffff, Load256(p))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float16 LoadBitField(const uint32_t* p,
+                                                       int shift, int bits,
+                                                       bool is_signed) {
+    __m512i top =
+        _mm512_maskz_sll_epi32(0xffff, _mm512_loadu_si512(p),
+                               _mm_cvtsi32_si128(32 - shift - bits));
+    __m128i down = _mm_cvtsi32_si128(32 - bits);
+    return {ToFloats(is_signed ? _mm512_maskz_sra_epi32(0xffff, top, down)
+                               : _mm512_maskz_srl_epi32(0xffff, top, down))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float16 Splat(float s) {
+    return {_mm512_set1_ps(s)};
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(float* p) const {
+    _mm512_storeu_ps(p, v);
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(int8_t* p) const {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                     _mm512_maskz_cvtsepi32_epi8(0xffff, Int32s()));
+  }
+  // The unsigned conversions saturate unsigned inputs, so negative ones are
+  // raised to zero first.
+  GAMMA_MATH_KERNEL_TARGET void store(uint8_t* p) const {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p),
+                     _mm512_maskz_cvtusepi32_epi8(0xffff, NonNegativeInt32s()));
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(int16_t* p) const {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p),
+                        _mm512_maskz_cvtsepi32_epi16(0xffff, Int32s()));
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(uint16_t* p) const {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(p),
+        _mm512_maskz_cvtusepi32_epi16(0xffff, NonNegativeInt32s()));
+  }
+  GAMMA_MATH_KERNEL_TARGET void storeHalf(uint16_t* p) const {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(p),
+        _mm512_maskz_cvtps_ph(0xffff, v,
+                              _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+  __m512 v;
+
+ private:
+  GAMMA_MATH_KERNEL_TARGET static __m128i Load128(const void* p) {
+    return _mm_loadu_si128(static_cast<const __m128i*>(p));
+  }
+  GAMMA_MATH_KERNEL_TARGET static __m256i Load256(const void* p) {
+    return _mm256_loadu_si256(static_cast<const __m256i*>(p));
+  }
+  // Zero-masked like InverseSqrt, as are the conversions and shifts above.
+  GAMMA_MATH_KERNEL_TARGET static __m512 ToFloats(__m512i i) {
+    return _mm512_maskz_cvtepi32_ps(0xffff, i);
+  }
+  GAMMA_MATH_KERNEL_TARGET __m512i Int32s() const {
+    return _mm512_maskz_cvtps_epi32(0xffff, v);
+  }
+  GAMMA_MATH_KERNEL_TARGET __m512i NonNegativeInt32s() const {
+    return _mm512_maskz_max_epi32(0xffff, Int32s(), _mm512_setzero_si512());
+  }
+};
+
+GAMMA_MATH_KERNEL_TARGET inline Float16 operator*(Float16 a, Float16 b) {
+  return {_mm512_mul_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float16 operator+(Float16 a, Float16 b) {
+  return {_mm512_add_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float16 operator-(Float16 a, Float16 b) {
+  return {_mm512_sub_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float16 operator/(Float16 a, Float16 b) {
+  return {_mm512_div_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float16 MulAdd(Float16 a, Float16 b,
+                                               Float16 c) {
+  return {_mm512_fmadd_ps(a.v, b.v, c.v)};
+}
+
+// The 14-bit estimate refined by one Newton-Raphson step. The zero-masked
+// form avoids GCC's warning about the undefined passthrough of the plain one.
+GAMMA_MATH_KERNEL_TARGET inline Float16 InverseSqrt(Float16 a) {
+  Float16 r = {_mm512_maskz_rsqrt14_ps(0xffff, a.v)};
+  Float16 half_a = a * Float16::Splat(-0.5f);
+  return r * MulAdd(half_a * r, r, Float16::Splat(1.5f));
+}
+
+// Zero-masked like InverseSqrt.
+GAMMA_MATH_KERNEL_TARGET inline Float16 Min(Float16 a, Float16 b) {
+  return {_mm512_maskz_min_ps(0xffff, a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float16 Max(Float16 a, Float16 b) {
+  return {_mm512_maskz_max_ps(0xffff, a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float16 Abs(Float16 a) {
+  return {_mm512_abs_ps(a.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float16 FlipSign(Float16 a, Float16 b) {
+  return {_mm512_castsi512_ps(_mm512_xor_si512(
+      _mm512_castps_si512(a.v),
+      _mm512_and_si512(_mm512_castps_si512(b.v),
+                       _mm512_set1_epi32(INT32_MIN))))};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float16 Pow2(Float16 n) {
+  __m512i e = _mm512_add_epi32(_mm512_maskz_cvtps_epi32(0xffff, n.v),
+                               _mm512_set1_epi32(127));
+  return {_mm512_castsi512_ps(_mm512_maskz_slli_epi32(0xffff, e, 23))};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float16::Mask GreaterEqual(Float16 a,
+                                                           Float16 b) {
+  return {_mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float16::Mask operator&(Float16::Mask a,
+                                                        Float16::Mask b) {
+  return {static_cast<__mmask16>(a.v & b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float16 Select(Float16::Mask m, Float16 a,
+                                               Float16 b) {
+  return {_mm512_mask_blend_ps(m.v, b.v, a.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline void StoreBitFields(const Float16* fields,
+                                                    const int* bits, int n,
+                                                    uint32_t* p) {
+  __m512i packed = _mm512_setzero_si512();
+  int shift = 0;
+  for (int i = 0; i < n; ++i) {
+    __m512i field =
+        _mm512_and_si512(_mm512_maskz_cvtps_epi32(0xffff, fields[i].v),
+                         _mm512_set1_epi32((1 << bits[i]) - 1));
+    packed = _mm512_or_si512(packed,
+                             _mm512_maskz_sll_epi32(0xffff, field,
+                                                    _mm_cvtsi32_si128(shift)));
+    shift += bits[i];
+  }
+  _mm512_storeu_si512(p, packed);
+}
+
+// Compressing into a register and storing all 16 lanes is faster than a
+// compressing store on some CPUs.
+GAMMA_MATH_KERNEL_TARGET inline size_t StoreSelected(Float16::Mask m,
+                                                     uint32_t first,
+                                                     uint32_t* out) {
+  __m512i indices =
+      _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(first)),
+                       _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+                                         11, 12, 13, 14, 15));
+  _mm512_storeu_si512(out, _mm512_maskz_compress_epi32(m.v, indices));
+  return __builtin_popcount(m.v);
+}
+
+}  // namespace
+}  // namespace y
+
+namespace y_internal {
+
+template <>
+ApproxKernels MakeKernels<ApproxKernels, y::SimdLevel::kAvx512>() {
+  return y::MakeApproxKernels<y::Float16>();
+}
+
+template <>
+BatchKernels MakeKernels<BatchKernels, y::SimdLevel::kAvx512>() {
+  return y::MakeBatchKernels<y::Float16>();
+}
+
+template <>
+CullingKernels MakeKernels<CullingKernels, y::SimdLevel::kAvx512>() {
+  return y::MakeCullingKernels<y::Float16>();
+}
+
+template <>
+PackKernels MakeKernels<PackKernels, y::SimdLevel::kAvx512>() {
+  return y::MakePackKernels<y::Float16>();
+}
+
+// The eight generators fill only half of a register here, so this level
+// keeps the AVX2 kernels.
+template <>
+RandomKernels MakeKernels<RandomKernels, y::SimdLevel::kAvx512>() {
+  return MakeKernels<RandomKernels, y::SimdLevel::kAvx2>();
+}
+
+template <>
+RaycastKernels MakeKernels<RaycastKernels, y::SimdLevel::kAvx512>() {
+  RaycastKernels kernels = y::MakeRaycastKernels<y::Float16>();
+  // Box sets are mostly the 8 children of a BVH node, which 16 lanes would
+  // leave entirely to the scalar tail, so boxes keep the AVX2 kernels.
+  RaycastKernels avx2 = MakeKernels<RaycastKernels, y::SimdLevel::kAvx2>();
+  kernels.intersect_aabbs = avx2.intersect_aabbs;
+  kernels.raycast_aabbs = avx2.raycast_aabbs;
+  return kernels;
+}
+
+}  // namespace y_internal
+
+#endif  // GAMMA_MATH_DISPATCH
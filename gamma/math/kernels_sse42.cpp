@@ -0,0 +1,311 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+// Kernels for SSE4.2, four lanes at a time.
+
+#include "gamma/math/cpu.hpp"
+
+#ifdef GAMMA_MATH_DISPATCH
+
+#include <immintrin.h>
+
+#include <cstring>
+
+#define GAMMA_MATH_KERNEL_TARGET GAMMA_MATH_TARGET_SSE42
+#include "gamma/math/approx_kernels.hpp"
+#include "gamma/math/batch_kernels.hpp"
+#include "gamma/math/culling_kernels.hpp"
+#include "gamma/math/pack_kernels.hpp"
+#include "gamma/math/random_kernels.hpp"
+#include "gamma/math/raycast_kernels.hpp"
+
+namespace y {
+namespace {
+
+struct Uint4 {
+  GAMMA_MATH_KERNEL_TARGET static Uint4 Load(const uint32_t* p) {
+    return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))};
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(uint32_t* p) const {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+  }
+  __m128i v;
+};
+
+struct Float4 {
+  static constexpr size_t kWidth = 4;
+  using Bits = Uint4;
+  struct Mask {
+    __m128 v;
+  };
+  GAMMA_MATH_KERNEL_TARGET static Float4 Load(const float* p) {
+    return {_mm_loadu_ps(p)};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float4 Load(const int8_t* p) {
+    return {_mm_cvtepi32_ps(_mm_cvtepi8_epi32(LoadBytes(p)))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float4 Load(const uint8_t* p) {
+    return {_mm_cvtepi32_ps(_mm_cvtepu8_epi32(LoadBytes(p)))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float4 Load(const int16_t* p) {
+    return {_mm_cvtepi32_ps(_mm_cvtepi16_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float4 Load(const uint16_t* p) {
+    return {_mm_cvtepi32_ps(_mm_cvtepu16_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))))};
+  }
+  // UnpackHalf, lane by lane.
+  GAMMA_MATH_KERNEL_TARGET static Float4 LoadHalf(const uint16_t* p) {
+    __m128i h = _mm_cvtepu16_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+    __m128i magnitude = _mm_and_si128(h, _mm_set1_epi32(0x7fff));
+    __m128 x = _mm_mul_ps(
+        _mm_castsi128_ps(_mm_slli_epi32(magnitude, 13)),
+        _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+    __m128i inf_nan = _mm_and_si128(
+        _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x7bff)),
+        _mm_set1_epi32(255 << 23));
+    __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, magnitude), 16);
+    return {_mm_or_ps(x, _mm_castsi128_ps(_mm_or_si128(sign, inf_nan)))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float4 LoadBitField(const uint32_t* p,
+                                                      int shift, int bits,
+                                                      bool is_signed) {
+    __m128i top =
+        _mm_sll_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                      _mm_cvtsi32_si128(32 - shift - bits));
+    __m128i down = _mm_cvtsi32_si128(32 - bits);
+    return {_mm_cvtepi32_ps(is_signed ? _mm_sra_epi32(top, down)
+                                      : _mm_srl_epi32(top, down))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float4 Splat(float s) {
+    return {_mm_set1_ps(s)};
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(float* p) const { _mm_storeu_ps(p, v); }
+  GAMMA_MATH_KERNEL_TARGET void store(int8_t* p) const {
+    __m128i i = _mm_packs_epi32(_mm_cvtps_epi32(v), _mm_setzero_si128());
+    StoreBytes(_mm_packs_epi16(i, i), p);
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(uint8_t* p) const {
+    __m128i i = _mm_packs_epi32(_mm_cvtps_epi32(v), _mm_setzero_si128());
+    StoreBytes(_mm_packus_epi16(i, i), p);
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(int16_t* p) const {
+    __m128i i = _mm_cvtps_epi32(v);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packs_epi32(i, i));
+  }
+  GAMMA_MATH_KERNEL_TARGET void store(uint16_t* p) const {
+    __m128i i = _mm_cvtps_epi32(v);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi32(i, i));
+  }
+  // PackHalf, computing every case in every lane and blending.
+  GAMMA_MATH_KERNEL_TARGET void storeHalf(uint16_t* p) const {
+    __m128i bits = _mm_castps_si128(v);
+    __m128i sign = _mm_and_si128(bits, _mm_set1_epi32(INT32_MIN));
+    __m128i magnitude = _mm_xor_si128(bits, sign);
+    __m128i is_nan = _mm_castps_si128(_mm_cmpunord_ps(v, v));
+    __m128i inf_nan = _mm_or_si128(
+        _mm_set1_epi32(0x7c00), _mm_and_si128(is_nan, _mm_set1_epi32(0x200)));
+    __m128i too_large =
+        _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(((127 + 16) << 23) - 1));
+    const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32((127 - 1) << 23));
+    __m128i subnormal = _mm_sub_epi32(
+        _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(magnitude), magic)),
+        _mm_castps_si128(magic));
+    __m128i is_subnormal =
+        _mm_cmplt_epi32(magnitude, _mm_set1_epi32((127 - 14) << 23));
+    __m128i odd =
+        _mm_and_si128(_mm_srli_epi32(magnitude, 13), _mm_set1_epi32(1));
+    __m128i rounded = _mm_sub_epi32(
+        magnitude, _mm_set1_epi32(((127 - 15) << 23) - 0xfff));
+    __m128i normal = _mm_srli_epi32(_mm_add_epi32(rounded, odd), 13);
+    __m128i h = _mm_blendv_epi8(normal, subnormal, is_subnormal);
+    h = _mm_blendv_epi8(h, inf_nan, too_large);
+    h = _mm_or_si128(h, _mm_srli_epi32(sign, 16));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi32(h, h));
+  }
+  __m128 v;
+
+ private:
+  GAMMA_MATH_KERNEL_TARGET static __m128i LoadBytes(const void* p) {
+    int bytes;
+    std::memcpy(&bytes, p, sizeof(bytes));
+    return _mm_cvtsi32_si128(bytes);
+  }
+  GAMMA_MATH_KERNEL_TARGET static void StoreBytes(__m128i i, void* p) {
+    int bytes = _mm_cvtsi128_si32(i);
+    std::memcpy(p, &bytes, sizeof(bytes));
+  }
+};
+
+GAMMA_MATH_KERNEL_TARGET inline Float4 operator*(Float4 a, Float4 b) {
+  return {_mm_mul_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float4 operator+(Float4 a, Float4 b) {
+  return {_mm_add_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float4 operator-(Float4 a, Float4 b) {
+  return {_mm_sub_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float4 operator/(Float4 a, Float4 b) {
+  return {_mm_div_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) {
+  return a * b + c;
+}
+
+// The hardware estimate refined by one Newton-Raphson step.
+GAMMA_MATH_KERNEL_TARGET inline Float4 InverseSqrt(Float4 a) {
+  Float4 r = {_mm_rsqrt_ps(a.v)};
+  Float4 half_a = a * Float4::Splat(-0.5f);
+  return r * MulAdd(half_a * r, r, Float4::Splat(1.5f));
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float4 Min(Float4 a, Float4 b) {
+  return {_mm_min_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float4 Max(Float4 a, Float4 b) {
+  return {_mm_max_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float4 Abs(Float4 a) {
+  return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float4 FlipSign(Float4 a, Float4 b) {
+  return {_mm_xor_ps(a.v, _mm_and_ps(b.v, _mm_set1_ps(-0.0f)))};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float4 Pow2(Float4 n) {
+  return {_mm_castsi128_ps(_mm_slli_epi32(
+      _mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127)), 23))};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float4::Mask GreaterEqual(Float4 a,
+                                                          Float4 b) {
+  return {_mm_cmpge_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float4::Mask operator&(Float4::Mask a,
+                                                       Float4::Mask b) {
+  return {_mm_and_ps(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float4 Select(Float4::Mask m, Float4 a,
+                                              Float4 b) {
+  return {_mm_blendv_ps(b.v, a.v, m.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline void StoreBitFields(const Float4* fields,
+                                                    const int* bits, int n,
+                                                    uint32_t* p) {
+  __m128i packed = _mm_setzero_si128();
+  int shift = 0;
+  for (int i = 0; i < n; ++i) {
+    __m128i field = _mm_and_si128(_mm_cvtps_epi32(fields[i].v),
+                                  _mm_set1_epi32((1 << bits[i]) - 1));
+    packed = _mm_or_si128(packed,
+                          _mm_sll_epi32(field, _mm_cvtsi32_si128(shift)));
+    shift += bits[i];
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p), packed);
+}
+
+GAMMA_MATH_KERNEL_TARGET inline size_t StoreSelected(Float4::Mask m,
+                                                     uint32_t first,
+                                                     uint32_t* out) {
+  int bits = _mm_movemask_ps(m.v);
+  int lanes;
+  std::memcpy(&lanes, kSelectedLanes.lanes[bits], sizeof(lanes));
+  __m128i indices = _mm_add_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(lanes)),
+                                  _mm_set1_epi32(static_cast<int>(first)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), indices);
+  return __builtin_popcount(bits);
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Uint4 operator+(Uint4 a, Uint4 b) {
+  return {_mm_add_epi32(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Uint4 operator^(Uint4 a, Uint4 b) {
+  return {_mm_xor_si128(a.v, b.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Uint4 operator|(Uint4 a, Uint4 b) {
+  return {_mm_or_si128(a.v, b.v)};
+}
+
+template <int n>
+GAMMA_MATH_KERNEL_TARGET inline Uint4 ShiftLeft(Uint4 a) {
+  return {_mm_slli_epi32(a.v, n)};
+}
+
+template <int n>
+GAMMA_MATH_KERNEL_TARGET inline Uint4 ShiftRight(Uint4 a) {
+  return {_mm_srli_epi32(a.v, n)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float4 UnitFloat(Uint4 a) {
+  return {_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(a.v, 8)),
+                     _mm_set1_ps(1.0f / (1 << 24)))};
+}
+
+}  // namespace
+}  // namespace y
+
+namespace y_internal {
+
+template <>
+ApproxKernels MakeKernels<ApproxKernels, y::SimdLevel::kSse42>() {
+  return y::MakeApproxKernels<y::Float4>();
+}
+
+template <>
+BatchKernels MakeKernels<BatchKernels, y::SimdLevel::kSse42>() {
+  return y::MakeBatchKernels<y::Float4>();
+}
+
+template <>
+CullingKernels MakeKernels<CullingKernels, y::SimdLevel::kSse42>() {
+  return y::MakeCullingKernels<y::Float4>();
+}
+
+template <>
+PackKernels MakeKernels<PackKernels, y::SimdLevel::kSse42>() {
+  return y::MakePackKernels<y::Float4>();
+}
+
+template <>
+RandomKernels MakeKernels<RandomKernels, y::SimdLevel::kSse42>() {
+  return y::MakeRandomKernels<y::Float4>();
+}
+
+template <>
+RaycastKernels MakeKernels<RaycastKernels, y::SimdLevel::kSse42>() {
+  return y::MakeRaycastKernels<y::Float4>();
+}
+
+}  // namespace y_internal
+
+#endif  // GAMMA_MATH_DISPATCH
@@ -0,0 +1,267 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_LANES_HPP_
+#define GAMMA_MATH_LANES_HPP_
+
+// Lane types for the kernels in gamma/math, which are written once as
+// templates over a lane type `F` and instantiated for every instruction set.
+// A lane type provides
+//
+//   F::kWidth                    Number of lanes.
+//   F::Load(p), F::Splat(s)      `kWidth` floats from `p`, or `s` in each.
+//                                `p` may also point to int8_t, uint8_t,
+//                                int16_t or uint16_t, which are converted.
+//   f.store(p)                   To floats, or to integers of those types,
+//                                rounded to nearest and saturated.
+//   F::LoadHalf(p), f.storeHalf(p)
+//                                Half precision, as PackHalf in pack.hpp.
+//   F::LoadBitField(p, shift, bits, is_signed)
+//                                Bits [shift, shift + bits) of `kWidth`
+//                                uint32_t, sign extended if `is_signed`.
+//   StoreBitFields(fields, bits, n, p)
+//                                Rounds `n` fields, each of which must fit in
+//                                its `bits[i]`, and packs them from the low
+//                                bits of `kWidth` uint32_t up.
+//   f * g, f + g, f - g, f / g
+//   MulAdd(f, g, h)              f * g + h, fused where available.
+//   InverseSqrt(f)               To about 22 bits.
+//   Min(f, g), Max(f, g)         g where either is NaN.
+//   Abs(f)
+//   FlipSign(f, g)               f, negated where g has its sign bit set.
+//   Pow2(n)                      2^n for integral n in [-126, 127].
+//   F::Mask                      One bool per lane, from
+//   GreaterEqual(f, g)           f >= g,
+//   m & n
+//   Select(m, f, g)              m ? f : g in each lane.
+//   StoreSelected(m, first, out) Writes `first + i` for each lane i set in
+//                                `m` to `out`, in order, and returns how
+//                                many. May write up to `kWidth` entries.
+//
+// Lane types of up to 8 lanes also have integer lanes, for the generators in
+// random.hpp:
+//
+//   F::Bits                      `kWidth` uint32_t lanes `u`, with
+//   F::Bits::Load(p), u.store(p) uint32_t loads and stores,
+//   u + v, u ^ v, u | v          wrapping addition and bitwise operations,
+//   ShiftLeft<n>(u), ShiftRight<n>(u)
+//                                shifts by a constant in [1, 31], and
+//   UnitFloat(u)                 the top 24 bits of each lane as an `F` in
+//                                [0, 1).
+//
+// `Float1` is defined here, and the wider types in the kernels_*.cpp files.
+//
+// The including file defines GAMMA_MATH_KERNEL_TARGET as the target attribute
+// of its instruction set, which every function of a lane type and kernel
+// carries so that intrinsics inline into it. Everything is in an unnamed
+// namespace, so that the copies compiled for different targets are never
+// merged by the linker.
+//
+// Lane types must never cross a function call: the target attributes force
+// inlining (see cpu.hpp), so every function that takes or returns one is
+// declared `GAMMA_MATH_KERNEL_TARGET inline`, and kernels are passed to
+// templates as types rather than as function pointers, which GCC will not
+// inline through. Only the entry points in a kernel table are called, and
+// those take and return plain data.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "gamma/math/cpu.hpp"
+#include "gamma/math/pack.hpp"
+
+#ifndef GAMMA_MATH_KERNEL_TARGET
+#error "define GAMMA_MATH_KERNEL_TARGET before including lanes.hpp"
+#endif
+
+namespace y {
+namespace {
+
+// Lanes set in each 8-bit mask, in increasing order, for `StoreSelected`.
+struct SelectedLanes {
+  constexpr SelectedLanes() : lanes() {
+    for (int mask = 0; mask < 256; ++mask) {
+      int count = 0;
+      for (int lane = 0; lane < 8; ++lane) {
+        if (mask & (1 << lane)) lanes[mask][count++] = lane;
+      }
+    }
+  }
+  uint8_t lanes[256][8];
+};
+
+constexpr SelectedLanes kSelectedLanes;
+
+struct Uint1 {
+  GAMMA_MATH_KERNEL_TARGET static Uint1 Load(const uint32_t* p) { return {*p}; }
+  GAMMA_MATH_KERNEL_TARGET void store(uint32_t* p) const { *p = v; }
+  uint32_t v;
+};
+
+// One lane. Also finishes the elements left over by the wider types.
+struct Float1 {
+  static constexpr size_t kWidth = 1;
+  using Bits = Uint1;
+  struct Mask {
+    bool v;
+  };
+  GAMMA_MATH_KERNEL_TARGET static Float1 Load(const float* p) { return {*p}; }
+  template <typename T>
+  GAMMA_MATH_KERNEL_TARGET static Float1 Load(const T* p) {
+    return {static_cast<float>(*p)};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float1 LoadHalf(const uint16_t* p) {
+    return {UnpackHalf(*p)};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float1 LoadBitField(const uint32_t* p,
+                                                      int shift, int bits,
+                                                      bool is_signed) {
+    uint32_t top = *p << (32 - shift - bits);
+    return {static_cast<float>(
+        is_signed ? static_cast<int32_t>(top) >> (32 - bits)
+                  : static_cast<int32_t>(top >> (32 - bits)))};
+  }
+  GAMMA_MATH_KERNEL_TARGET static Float1 Splat(float s) { return {s}; }
+  GAMMA_MATH_KERNEL_TARGET void store(float* p) const { *p = v; }
+  template <typename T>
+  GAMMA_MATH_KERNEL_TARGET void store(T* p) const {
+    int32_t i = y_internal::RoundToInt32(v);
+    i = std::max<int32_t>(i, std::numeric_limits<T>::min());
+    *p = static_cast<T>(std::min<int32_t>(i, std::numeric_limits<T>::max()));
+  }
+  GAMMA_MATH_KERNEL_TARGET void storeHalf(uint16_t* p) const {
+    *p = PackHalf(v);
+  }
+  float v;
+};
+
+GAMMA_MATH_KERNEL_TARGET inline Float1 operator*(Float1 a, Float1 b) {
+  return {a.v * b.v};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1 operator+(Float1 a, Float1 b) {
+  return {a.v + b.v};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1 operator-(Float1 a, Float1 b) {
+  return {a.v - b.v};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1 operator/(Float1 a, Float1 b) {
+  return {a.v / b.v};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1 MulAdd(Float1 a, Float1 b, Float1 c) {
+  return {a.v * b.v + c.v};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1 InverseSqrt(Float1 a) {
+  return {1.0f / std::sqrt(a.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1 Min(Float1 a, Float1 b) {
+  return {a.v < b.v ? a.v : b.v};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1 Max(Float1 a, Float1 b) {
+  return {a.v > b.v ? a.v : b.v};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1 Abs(Float1 a) {
+  return {std::fabs(a.v)};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1 FlipSign(Float1 a, Float1 b) {
+  return {std::copysign(1.0f, b.v) * a.v};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1 Pow2(Float1 n) {
+  int32_t bits = (static_cast<int32_t>(n.v) + 127) << 23;
+  Float1 r;
+  std::memcpy(&r.v, &bits, sizeof(r.v));
+  return r;
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1::Mask GreaterEqual(Float1 a,
+                                                          Float1 b) {
+  return {a.v >= b.v};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1::Mask operator&(Float1::Mask a,
+                                                       Float1::Mask b) {
+  return {a.v && b.v};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1 Select(Float1::Mask m, Float1 a,
+                                               Float1 b) {
+  return m.v ? a : b;
+}
+
+GAMMA_MATH_KERNEL_TARGET inline size_t StoreSelected(Float1::Mask m,
+                                                     uint32_t first,
+                                                     uint32_t* out) {
+  *out = first;
+  return m.v ? 1 : 0;
+}
+
+GAMMA_MATH_KERNEL_TARGET inline void StoreBitFields(const Float1* fields,
+                                                    const int* bits, int n,
+                                                    uint32_t* p) {
+  uint32_t packed = 0;
+  int shift = 0;
+  for (int i = 0; i < n; ++i) {
+    uint32_t field = y_internal::RoundToInt32(fields[i].v);
+    packed |= (field & ((1u << bits[i]) - 1)) << shift;
+    shift += bits[i];
+  }
+  *p = packed;
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Uint1 operator+(Uint1 a, Uint1 b) {
+  return {a.v + b.v};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Uint1 operator^(Uint1 a, Uint1 b) {
+  return {a.v ^ b.v};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Uint1 operator|(Uint1 a, Uint1 b) {
+  return {a.v | b.v};
+}
+
+template <int n>
+GAMMA_MATH_KERNEL_TARGET inline Uint1 ShiftLeft(Uint1 a) {
+  return {a.v << n};
+}
+
+template <int n>
+GAMMA_MATH_KERNEL_TARGET inline Uint1 ShiftRight(Uint1 a) {
+  return {a.v >> n};
+}
+
+GAMMA_MATH_KERNEL_TARGET inline Float1 UnitFloat(Uint1 a) {
+  return {static_cast<float>(a.v >> 8) * (1.0f / (1 << 24))};
+}
+
+}  // namespace
+}  // namespace y
+#endif  // GAMMA_MATH_LANES_HPP_
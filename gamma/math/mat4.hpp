@@ -0,0 +1,340 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_MAT4_HPP_
+#define GAMMA_MATH_MAT4_HPP_
+
+#include "gamma/math/simd.hpp"
+#include "gamma/math/vec.hpp"
+
+namespace y {
+
+// Column-major 4x4 matrix with the same memory layout as glm::mat4, so
+// `columns[j][i]` is the element in row i and column j. Matrices act on
+// column vectors: `a * b` applies `b` first.
+struct alignas(16) Mat4 {
+  Mat4() = default;
+  // Diagonal matrix, so `Mat4(1.0f)` is the identity.
+  explicit Mat4(float diagonal);
+  Mat4(const Vec4& c0, const Vec4& c1, const Vec4& c2, const Vec4& c3);
+
+  Vec4& operator[](int column);
+  const Vec4& operator[](int column) const;
+
+  Vec4 columns[4];
+};
+
+static_assert(sizeof(Mat4) == 64, "");
+
+Mat4 operator*(const Mat4& a, const Mat4& b);
+Vec4 operator*(const Mat4& m, const Vec4& v);
+
+// `m * (p, 1)` and `m * (v, 0)`, without the perspective divide.
+Vec3 TransformPoint(const Mat4& m, const Vec3& p);
+Vec3 TransformVector(const Mat4& m, const Vec3& v);
+
+Mat4 Transpose(const Mat4& m);
+// `m` must be invertible.
+Mat4 Inverse(const Mat4& m);
+
+Mat4 TranslationMatrix(const Vec3& translation);
+Mat4 ScaleMatrix(const Vec3& scale);
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline Mat4::Mat4(float diagonal)
+    : columns{Vec4(diagonal, 0.0f, 0.0f, 0.0f),
+              Vec4(0.0f, diagonal, 0.0f, 0.0f),
+              Vec4(0.0f, 0.0f, diagonal, 0.0f),
+              Vec4(0.0f, 0.0f, 0.0f, diagonal)} {}
+
+inline Mat4::Mat4(const Vec4& c0, const Vec4& c1, const Vec4& c2,
+                  const Vec4& c3)
+    : columns{c0, c1, c2, c3} {}
+
+inline Vec4& Mat4::operator[](int column) { return columns[column]; }
+
+inline const Vec4& Mat4::operator[](int column) const {
+  return columns[column];
+}
+
+}  // namespace y
+
+namespace y_internal {
+
+#ifdef GAMMA_MATH_SSE2
+
+// m * v for a vector already in a register.
+inline __m128 MultiplyColumns(const y::Mat4& m, __m128 v) {
+  __m128 x = _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+  __m128 y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+  __m128 z = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+  __m128 w = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+  __m128 sum = _mm_mul_ps(Load(m[0]), x);
+  sum = _mm_add_ps(sum, _mm_mul_ps(Load(m[1]), y));
+  sum = _mm_add_ps(sum, _mm_mul_ps(Load(m[2]), z));
+  return _mm_add_ps(sum, _mm_mul_ps(Load(m[3]), w));
+}
+
+#endif  // GAMMA_MATH_SSE2
+
+#ifdef GAMMA_MATH_AVX
+
+inline __m256 MultiplyAdd(__m256 a, __m256 b, __m256 c) {
+#ifdef GAMMA_MATH_FMA
+  return _mm256_fmadd_ps(a, b, c);
+#else
+  return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+// Columns j and j + 1 of a * b, from the same columns of `b`.
+inline __m256 MultiplyColumnPair(const __m256 a[4], __m256 b) {
+  __m256 sum = _mm256_mul_ps(a[0], _mm256_shuffle_ps(b, b, 0x00));
+  sum = MultiplyAdd(a[1], _mm256_shuffle_ps(b, b, 0x55), sum);
+  sum = MultiplyAdd(a[2], _mm256_shuffle_ps(b, b, 0xaa), sum);
+  return MultiplyAdd(a[3], _mm256_shuffle_ps(b, b, 0xff), sum);
+}
+
+#endif  // GAMMA_MATH_AVX
+
+}  // namespace y_internal
+
+namespace y {
+
+inline Mat4 operator*(const Mat4& a, const Mat4& b) {
+  Mat4 r;
+#if defined(GAMMA_MATH_AVX)
+  // Each 256-bit register holds two columns; every column of `a` is
+  // duplicated into both halves.
+  const float* lhs = &a[0].x;
+  __m256 columns[4] = {
+      _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs)),
+      _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 4)),
+      _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 8)),
+      _mm256_broadcast_ps(reinterpret_cast<const __m128*>(lhs + 12))};
+  __m256 b01 = _mm256_loadu_ps(&b[0].x);
+  __m256 b23 = _mm256_loadu_ps(&b[2].x);
+  _mm256_storeu_ps(&r[0].x, y_internal::MultiplyColumnPair(columns, b01));
+  _mm256_storeu_ps(&r[2].x, y_internal::MultiplyColumnPair(columns, b23));
+#elif defined(GAMMA_MATH_SSE2)
+  for (int j = 0; j < 4; ++j) {
+    __m128 column = y_internal::MultiplyColumns(a, y_internal::Load(b[j]));
+    _mm_store_ps(&r[j].x, column);
+  }
+#else
+  for (int j = 0; j < 4; ++j) r[j] = a * b[j];
+#endif
+  return r;
+}
+
+inline Vec4 operator*(const Mat4& m, const Vec4& v) {
+#ifdef GAMMA_MATH_SSE2
+  return y_internal::Store<Vec4>(
+      y_internal::MultiplyColumns(m, y_internal::Load(v)));
+#else
+  return m[0] * v.x + m[1] * v.y + m[2] * v.z + m[3] * v.w;
+#endif
+}
+
+inline Vec3 TransformPoint(const Mat4& m, const Vec3& p) {
+  Vec4 r = m * Vec4(p.x, p.y, p.z, 1.0f);
+  return Vec3(r.x, r.y, r.z);
+}
+
+inline Vec3 TransformVector(const Mat4& m, const Vec3& v) {
+  Vec4 r = m * Vec4(v.x, v.y, v.z, 0.0f);
+  return Vec3(r.x, r.y, r.z);
+}
+
+inline Mat4 Transpose(const Mat4& m) {
+#ifdef GAMMA_MATH_SSE2
+  __m128 c0 = y_internal::Load(m[0]);
+  __m128 c1 = y_internal::Load(m[1]);
+  __m128 c2 = y_internal::Load(m[2]);
+  __m128 c3 = y_internal::Load(m[3]);
+  _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+  return Mat4(y_internal::Store<Vec4>(c0), y_internal::Store<Vec4>(c1),
+              y_internal::Store<Vec4>(c2), y_internal::Store<Vec4>(c3));
+#else
+  Mat4 r;
+  for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < 4; ++i) r[j][i] = m[i][j];
+  }
+  return r;
+#endif
+}
+
+}  // namespace y
+
+namespace y_internal {
+
+#ifdef GAMMA_MATH_SSE2
+
+// (a[i0], a[i1], b[i2], b[i3]).
+template <int i0, int i1, int i2, int i3>
+__m128 Shuffle(__m128 a, __m128 b) {
+  return _mm_shuffle_ps(a, b, _MM_SHUFFLE(i3, i2, i1, i0));
+}
+
+template <int i0, int i1, int i2, int i3>
+__m128 Swizzle(__m128 a) {
+  return Shuffle<i0, i1, i2, i3>(a, a);
+}
+
+// 2x2 matrices packed row by row into one register.
+
+// a * b
+inline __m128 Mat2Multiply(__m128 a, __m128 b) {
+  return _mm_add_ps(
+      _mm_mul_ps(a, Swizzle<0, 3, 0, 3>(b)),
+      _mm_mul_ps(Swizzle<1, 0, 3, 2>(a), Swizzle<2, 1, 2, 1>(b)));
+}
+
+// adj(a) * b
+inline __m128 Mat2AdjointMultiply(__m128 a, __m128 b) {
+  return _mm_sub_ps(
+      _mm_mul_ps(Swizzle<3, 3, 0, 0>(a), b),
+      _mm_mul_ps(Swizzle<1, 1, 2, 2>(a), Swizzle<2, 3, 0, 1>(b)));
+}
+
+// a * adj(b)
+inline __m128 Mat2MultiplyAdjoint(__m128 a, __m128 b) {
+  return _mm_sub_ps(
+      _mm_mul_ps(a, Swizzle<3, 0, 3, 0>(b)),
+      _mm_mul_ps(Swizzle<1, 0, 3, 2>(a), Swizzle<2, 1, 2, 1>(b)));
+}
+
+#endif  // GAMMA_MATH_SSE2
+
+}  // namespace y_internal
+
+namespace y {
+
+// Both versions treat columns as rows, which is fine since the inverse of
+// the transpose is the transpose of the inverse.
+inline Mat4 Inverse(const Mat4& m) {
+#ifdef GAMMA_MATH_SSE2
+  // Blockwise inversion over the 2x2 blocks | A B |
+  //                                         | C D |.
+  using y_internal::Mat2AdjointMultiply;
+  using y_internal::Mat2Multiply;
+  using y_internal::Mat2MultiplyAdjoint;
+  using y_internal::Shuffle;
+  using y_internal::Swizzle;
+  __m128 r0 = y_internal::Load(m[0]);
+  __m128 r1 = y_internal::Load(m[1]);
+  __m128 r2 = y_internal::Load(m[2]);
+  __m128 r3 = y_internal::Load(m[3]);
+  __m128 a = Shuffle<0, 1, 0, 1>(r0, r1);
+  __m128 b = Shuffle<2, 3, 2, 3>(r0, r1);
+  __m128 c = Shuffle<0, 1, 0, 1>(r2, r3);
+  __m128 d = Shuffle<2, 3, 2, 3>(r2, r3);
+
+  // (|A|, |B|, |C|, |D|)
+  __m128 dets = _mm_sub_ps(
+      _mm_mul_ps(Shuffle<0, 2, 0, 2>(r0, r2), Shuffle<1, 3, 1, 3>(r1, r3)),
+      _mm_mul_ps(Shuffle<1, 3, 1, 3>(r0, r2), Shuffle<0, 2, 0, 2>(r1, r3)));
+  __m128 det_a = Swizzle<0, 0, 0, 0>(dets);
+  __m128 det_b = Swizzle<1, 1, 1, 1>(dets);
+  __m128 det_c = Swizzle<2, 2, 2, 2>(dets);
+  __m128 det_d = Swizzle<3, 3, 3, 3>(dets);
+
+  __m128 adj_d_c = Mat2AdjointMultiply(d, c);
+  __m128 adj_a_b = Mat2AdjointMultiply(a, b);
+  // The inverse is | X Y | / |M|, with each block computed as its adjugate.
+  //                | Z W |
+  __m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), Mat2Multiply(b, adj_d_c));
+  __m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), Mat2Multiply(c, adj_a_b));
+  __m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), Mat2MultiplyAdjoint(d, adj_a_b));
+  __m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), Mat2MultiplyAdjoint(a, adj_d_c));
+
+  // |M| = |A||D| + |B||C| - tr(adj(A) B adj(D) C)
+  __m128 trace = _mm_mul_ps(adj_a_b, Swizzle<0, 2, 1, 3>(adj_d_c));
+  trace = _mm_add_ps(trace, Swizzle<2, 3, 0, 1>(trace));
+  trace = _mm_add_ps(trace, Swizzle<1, 0, 3, 2>(trace));
+  __m128 det = _mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c));
+  det = _mm_sub_ps(det, trace);
+
+  __m128 scale = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+  x = _mm_mul_ps(x, scale);
+  y = _mm_mul_ps(y, scale);
+  z = _mm_mul_ps(z, scale);
+  w = _mm_mul_ps(w, scale);
+
+  // Taking the adjugates of the blocks and storing them as rows.
+  return Mat4(y_internal::Store<Vec4>(Shuffle<3, 1, 3, 1>(x, y)),
+              y_internal::Store<Vec4>(Shuffle<2, 0, 2, 0>(x, y)),
+              y_internal::Store<Vec4>(Shuffle<3, 1, 3, 1>(z, w)),
+              y_internal::Store<Vec4>(Shuffle<2, 0, 2, 0>(z, w)));
+#else
+  // Cofactor expansion through the 2x2 minors of the first two and last two
+  // rows.
+  const Vec4* a = m.columns;
+  float s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+  float s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+  float s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+  float s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+  float s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+  float s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+  float c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+  float c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+  float c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+  float c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+  float c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+  float c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+  float inv_det = 1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 +
+                          s5 * c0);
+  Mat4 r;
+  r[0][0] = (a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * inv_det;
+  r[0][1] = (-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3) * inv_det;
+  r[0][2] = (a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * inv_det;
+  r[0][3] = (-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3) * inv_det;
+  r[1][0] = (-a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1) * inv_det;
+  r[1][1] = (a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * inv_det;
+  r[1][2] = (-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1) * inv_det;
+  r[1][3] = (a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * inv_det;
+  r[2][0] = (a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0) * inv_det;
+  r[2][1] = (-a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0) * inv_det;
+  r[2][2] = (a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * inv_det;
+  r[2][3] = (-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0) * inv_det;
+  r[3][0] = (-a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0) * inv_det;
+  r[3][1] = (a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0) * inv_det;
+  r[3][2] = (-a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0) * inv_det;
+  r[3][3] = (a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * inv_det;
+  return r;
+#endif
+}
+
+inline Mat4 TranslationMatrix(const Vec3& translation) {
+  Mat4 r(1.0f);
+  r[3] = Vec4(translation.x, translation.y, translation.z, 1.0f);
+  return r;
+}
+
+inline Mat4 ScaleMatrix(const Vec3& scale) {
+  Mat4 r(1.0f);
+  r[0].x = scale.x;
+  r[1].y = scale.y;
+  r[2].z = scale.z;
+  return r;
+}
+
+}  // namespace y
+#endif  // GAMMA_MATH_MAT4_HPP_
@@ -0,0 +1,122 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/mat4.hpp"
+
+#include <random>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+Mat4 RandomMat4(std::mt19937* rng) {
+  std::uniform_real_distribution<float> dist(-2, 2);
+  Mat4 m;
+  for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < 4; ++i) m[j][i] = dist(*rng);
+  }
+  return m;
+}
+
+Mat4 NaiveMultiply(const Mat4& a, const Mat4& b) {
+  Mat4 r;
+  for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < 4; ++i) {
+      r[j][i] = 0;
+      for (int k = 0; k < 4; ++k) r[j][i] += a[k][i] * b[j][k];
+    }
+  }
+  return r;
+}
+
+void ExpectMat4Near(const Mat4& actual, const Mat4& expected, float error) {
+  for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_NEAR(actual[j][i], expected[j][i], error) << j << ", " << i;
+    }
+  }
+}
+
+TEST(Mat4Test, Identity) {
+  Mat4 identity(1.0f);
+  for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < 4; ++i) EXPECT_EQ(identity[j][i], i == j ? 1 : 0);
+  }
+  std::mt19937 rng(1);
+  Mat4 m = RandomMat4(&rng);
+  ExpectMat4Near(identity * m, m, 0);
+  ExpectMat4Near(m * identity, m, 0);
+}
+
+TEST(Mat4Test, MultipliesLikeReference) {
+  std::mt19937 rng(2);
+  for (int n = 0; n < 100; ++n) {
+    Mat4 a = RandomMat4(&rng);
+    Mat4 b = RandomMat4(&rng);
+    ExpectMat4Near(a * b, NaiveMultiply(a, b), 1e-5f);
+
+    Vec4 v = b[0];
+    Vec4 product = a * v;
+    for (int i = 0; i < 4; ++i) {
+      float expected = a[0][i] * v.x + a[1][i] * v.y + a[2][i] * v.z +
+                       a[3][i] * v.w;
+      EXPECT_NEAR(product[i], expected, 1e-5f);
+    }
+  }
+}
+
+TEST(Mat4Test, TransformsPointsAndVectors) {
+  Mat4 m = TranslationMatrix(Vec3(1, 2, 3)) * ScaleMatrix(Vec3(2, 3, 4));
+  Vec3 p = TransformPoint(m, Vec3(1, 1, 1));
+  EXPECT_FLOAT_EQ(p.x, 3);
+  EXPECT_FLOAT_EQ(p.y, 5);
+  EXPECT_FLOAT_EQ(p.z, 7);
+  Vec3 v = TransformVector(m, Vec3(1, 1, 1));
+  EXPECT_FLOAT_EQ(v.x, 2);
+  EXPECT_FLOAT_EQ(v.y, 3);
+  EXPECT_FLOAT_EQ(v.z, 4);
+}
+
+TEST(Mat4Test, Transpose) {
+  std::mt19937 rng(3);
+  Mat4 m = RandomMat4(&rng);
+  Mat4 t = Transpose(m);
+  for (int j = 0; j < 4; ++j) {
+    for (int i = 0; i < 4; ++i) EXPECT_EQ(t[j][i], m[i][j]);
+  }
+}
+
+TEST(Mat4Test, Inverse) {
+  Mat4 m = TranslationMatrix(Vec3(1, 2, 3)) * ScaleMatrix(Vec3(2, 4, 8));
+  Mat4 expected = ScaleMatrix(Vec3(0.5f, 0.25f, 0.125f)) *
+                  TranslationMatrix(Vec3(-1, -2, -3));
+  ExpectMat4Near(Inverse(m), expected, 1e-6f);
+
+  std::mt19937 rng(4);
+  for (int n = 0; n < 100; ++n) {
+    // Diagonally dominant, so well conditioned.
+    Mat4 a = RandomMat4(&rng);
+    for (int i = 0; i < 4; ++i) a[i][i] += 10;
+    ExpectMat4Near(a * Inverse(a), Mat4(1.0f), 1e-5f);
+    ExpectMat4Near(Inverse(a) * a, Mat4(1.0f), 1e-5f);
+  }
+}
+
+}  // namespace
+}  // namespace y
@@ -0,0 +1,665 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+// gamma/math against glm and libm on the same inputs. Each benchmark works
+// through arrays of 1024 operands so that results cannot be constant folded.
+// Build with -c opt, and with --copt=-march=native to enable the AVX and FMA
+// paths.
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "gamma/math/approx.hpp"
+#include "gamma/math/batch.hpp"
+#include "gamma/math/culling.hpp"
+#include "gamma/math/glm_interop.hpp"
+#include "gamma/math/mat4.hpp"
+#include "gamma/math/pack.hpp"
+#include "gamma/math/quat.hpp"
+#include "gamma/math/random.hpp"
+#include "gamma/math/raycast.hpp"
+#include "gamma/math/vec.hpp"
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+namespace y {
+namespace {
+
+constexpr int kCount = 1024;
+
+// Well conditioned random matrices, so that inverses stay finite.
+std::vector<glm::mat4> GlmMatrices(unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  std::vector<glm::mat4> matrices(kCount, glm::mat4(1.0f));
+  for (glm::mat4& m : matrices) {
+    for (int j = 0; j < 4; ++j) {
+      for (int i = 0; i < 4; ++i) m[j][i] = dist(rng) + (i == j ? 4 : 0);
+    }
+  }
+  return matrices;
+}
+
+std::vector<Mat4> Matrices(unsigned seed) {
+  std::vector<Mat4> matrices;
+  for (const glm::mat4& m : GlmMatrices(seed)) matrices.push_back(FromGlm(m));
+  return matrices;
+}
+
+std::vector<glm::quat> GlmQuats(unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(-1, 1);
+  std::vector<glm::quat> quats;
+  for (int i = 0; i < kCount; ++i) {
+    Quat q = Normalize(Quat(dist(rng), dist(rng), dist(rng), 1));
+    quats.push_back(ToGlm(q));
+  }
+  return quats;
+}
+
+std::vector<Quat> Quats(unsigned seed) {
+  std::vector<Quat> quats;
+  for (const glm::quat& q : GlmQuats(seed)) quats.push_back(FromGlm(q));
+  return quats;
+}
+
+template <typename M>
+void Mat4Multiply(benchmark::State& state, const std::vector<M>& a,
+                  const std::vector<M>& b) {
+  std::vector<M> out(kCount);
+  for (auto _ : state) {
+    for (int i = 0; i < kCount; ++i) out[i] = a[i] * b[i];
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+
+void BM_Mat4Multiply(benchmark::State& state) {
+  Mat4Multiply(state, Matrices(1), Matrices(2));
+}
+BENCHMARK(BM_Mat4Multiply);
+
+void BM_GlmMat4Multiply(benchmark::State& state) {
+  Mat4Multiply(state, GlmMatrices(1), GlmMatrices(2));
+}
+BENCHMARK(BM_GlmMat4Multiply);
+
+template <typename M, typename V>
+void Mat4Vec4Multiply(benchmark::State& state, const std::vector<M>& m) {
+  std::vector<V> vectors;
+  for (int i = 0; i < kCount; ++i) vectors.push_back(V(i, 1, -i, 1));
+  std::vector<V> out(kCount);
+  for (auto _ : state) {
+    for (int i = 0; i < kCount; ++i) out[i] = m[i] * vectors[i];
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+
+void BM_Mat4Vec4Multiply(benchmark::State& state) {
+  Mat4Vec4Multiply<Mat4, Vec4>(state, Matrices(1));
+}
+BENCHMARK(BM_Mat4Vec4Multiply);
+
+void BM_GlmMat4Vec4Multiply(benchmark::State& state) {
+  Mat4Vec4Multiply<glm::mat4, glm::vec4>(state, GlmMatrices(1));
+}
+BENCHMARK(BM_GlmMat4Vec4Multiply);
+
+void BM_Mat4Inverse(benchmark::State& state) {
+  std::vector<Mat4> m = Matrices(1);
+  std::vector<Mat4> out(kCount);
+  for (auto _ : state) {
+    for (int i = 0; i < kCount; ++i) out[i] = Inverse(m[i]);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_Mat4Inverse);
+
+void BM_GlmMat4Inverse(benchmark::State& state) {
+  std::vector<glm::mat4> m = GlmMatrices(1);
+  std::vector<glm::mat4> out(kCount);
+  for (auto _ : state) {
+    for (int i = 0; i < kCount; ++i) out[i] = glm::inverse(m[i]);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_GlmMat4Inverse);
+
+template <typename Q>
+void QuatCompose(benchmark::State& state, const std::vector<Q>& a,
+                 const std::vector<Q>& b) {
+  std::vector<Q> out(kCount);
+  for (auto _ : state) {
+    for (int i = 0; i < kCount; ++i) out[i] = a[i] * b[i];
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+
+void BM_QuatCompose(benchmark::State& state) {
+  QuatCompose(state, Quats(1), Quats(2));
+}
+BENCHMARK(BM_QuatCompose);
+
+void BM_GlmQuatCompose(benchmark::State& state) {
+  QuatCompose(state, GlmQuats(1), GlmQuats(2));
+}
+BENCHMARK(BM_GlmQuatCompose);
+
+// Batch kernels against the equivalent loops over AoS data. The kernels use
+// the widest instruction set the CPU supports, unless GAMMA_MATH_SIMD names
+// another one, e.g. GAMMA_MATH_SIMD=sse4.2.
+
+void BM_TransformPoints(benchmark::State& state) {
+  Mat4 m = Matrices(1)[0];
+  std::vector<float> in[3];
+  std::vector<float> out[3];
+  for (int i = 0; i < 3; ++i) {
+    in[i].assign(kCount, 1.0f);
+    out[i].resize(kCount);
+  }
+  ConstVec3Soa points({in[0].data(), in[1].data(), in[2].data()}, kCount);
+  Vec3Soa transformed({out[0].data(), out[1].data(), out[2].data()}, kCount);
+  for (auto _ : state) {
+    TransformPoints(m, points, transformed);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_TransformPoints);
+
+void BM_TransformPointsOneByOne(benchmark::State& state) {
+  Mat4 m = Matrices(1)[0];
+  std::vector<Vec3> points(kCount, Vec3(1.0f));
+  std::vector<Vec3> out(kCount);
+  for (auto _ : state) {
+    for (int i = 0; i < kCount; ++i) out[i] = TransformPoint(m, points[i]);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_TransformPointsOneByOne);
+
+void BM_ComposeTransforms(benchmark::State& state) {
+  std::vector<Mat4> a = Matrices(1);
+  std::vector<Mat4> b = Matrices(2);
+  std::vector<float> arrays[3][16];
+  float* components[3][16];
+  for (int k = 0; k < 16; ++k) {
+    for (int i = 0; i < kCount; ++i) {
+      arrays[0][k].push_back(a[i][k / 4][k % 4]);
+      arrays[1][k].push_back(b[i][k / 4][k % 4]);
+    }
+    arrays[2][k].resize(kCount);
+    for (int m = 0; m < 3; ++m) components[m][k] = arrays[m][k].data();
+  }
+  ConstMat4Soa parents(components[0], kCount);
+  ConstMat4Soa children(components[1], kCount);
+  Mat4Soa out(components[2], kCount);
+  for (auto _ : state) {
+    ComposeTransforms(parents, children, out);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_ComposeTransforms);
+
+void BM_NormalizeQuats(benchmark::State& state) {
+  std::vector<float> arrays[4];
+  for (std::vector<float>& array : arrays) array.assign(kCount, 0.5f);
+  QuatSoa quats({arrays[0].data(), arrays[1].data(), arrays[2].data(),
+                 arrays[3].data()},
+                kCount);
+  for (auto _ : state) {
+    NormalizeQuats(quats);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_NormalizeQuats);
+
+// Culling 100k objects scattered around a frustum, of which about a sixth are
+// visible.
+
+constexpr int kNumObjects = 100000;
+
+Frustum BenchmarkFrustum() {
+  // 90 degree field of view, from 1 to 200 units in front of the origin.
+  const float near = 1, far = 200;
+  Mat4 projection(0.0f);
+  projection[0][0] = 1;
+  projection[1][1] = 1;
+  projection[2][2] = far / (near - far);
+  projection[2][3] = -1;
+  projection[3][2] = -far * near / (far - near);
+  return ExtractFrustum(projection);
+}
+
+template <int N>
+void Cull(benchmark::State& state,
+          size_t (*cull)(const Frustum&, SoaSpan<N, const float>,
+                         absl::Span<uint32_t>)) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> position(-100, 100);
+  std::vector<float> arrays[N];
+  for (int i = 0; i < kNumObjects; ++i) {
+    float x = position(rng), y = position(rng), z = position(rng);
+    float values[6] = {x, y, z, N == 4 ? 1.0f : x + 1, y + 1, z + 1};
+    for (int k = 0; k < N; ++k) arrays[k].push_back(values[k]);
+  }
+  const float* components[N];
+  for (int k = 0; k < N; ++k) components[k] = arrays[k].data();
+  SoaSpan<N, const float> objects(components, kNumObjects);
+  std::vector<uint32_t> visible(kNumObjects);
+  Frustum frustum = BenchmarkFrustum();
+  size_t count = 0;
+  for (auto _ : state) {
+    count = cull(frustum, objects, absl::MakeSpan(visible));
+    benchmark::DoNotOptimize(count);
+  }
+  state.counters["visible"] = count;
+  state.SetItemsProcessed(state.iterations() * kNumObjects);
+}
+
+void BM_CullSpheres(benchmark::State& state) { Cull<4>(state, &CullSpheres); }
+BENCHMARK(BM_CullSpheres);
+
+void BM_CullAabbs(benchmark::State& state) { Cull<6>(state, &CullAabbs); }
+BENCHMARK(BM_CullAabbs);
+
+// Approximations against libm, one value at a time and batched, on inputs in
+// [lo, hi].
+
+std::vector<float> Inputs(float lo, float hi, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(lo, hi);
+  std::vector<float> inputs(kCount);
+  for (float& x : inputs) x = dist(rng);
+  return inputs;
+}
+
+template <float (*f)(float)>
+void Unary(benchmark::State& state, float lo, float hi) {
+  std::vector<float> in = Inputs(lo, hi, 1);
+  std::vector<float> out(kCount);
+  for (auto _ : state) {
+    for (int i = 0; i < kCount; ++i) out[i] = f(in[i]);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+
+void UnaryBatch(benchmark::State& state,
+                void (*f)(absl::Span<const float>, absl::Span<float>),
+                float lo, float hi) {
+  std::vector<float> in = Inputs(lo, hi, 1);
+  std::vector<float> out(kCount);
+  for (auto _ : state) {
+    f(in, absl::MakeSpan(out));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+
+float LibmSin(float x) { return std::sin(x); }
+float LibmCos(float x) { return std::cos(x); }
+float LibmExp(float x) { return std::exp(x); }
+float LibmSqrt(float x) { return std::sqrt(x); }
+
+void BM_LibmSin(benchmark::State& state) { Unary<&LibmSin>(state, -10, 10); }
+BENCHMARK(BM_LibmSin);
+
+void BM_FastSin(benchmark::State& state) { Unary<&FastSin>(state, -10, 10); }
+BENCHMARK(BM_FastSin);
+
+void BM_FastSinBatch(benchmark::State& state) {
+  UnaryBatch(state, &FastSin, -10, 10);
+}
+BENCHMARK(BM_FastSinBatch);
+
+void BM_LibmCos(benchmark::State& state) { Unary<&LibmCos>(state, -10, 10); }
+BENCHMARK(BM_LibmCos);
+
+void BM_FastCos(benchmark::State& state) { Unary<&FastCos>(state, -10, 10); }
+BENCHMARK(BM_FastCos);
+
+void BM_FastCosBatch(benchmark::State& state) {
+  UnaryBatch(state, &FastCos, -10, 10);
+}
+BENCHMARK(BM_FastCosBatch);
+
+void BM_LibmExp(benchmark::State& state) { Unary<&LibmExp>(state, -10, 10); }
+BENCHMARK(BM_LibmExp);
+
+void BM_FastExp(benchmark::State& state) { Unary<&FastExp>(state, -10, 10); }
+BENCHMARK(BM_FastExp);
+
+void BM_FastExpBatch(benchmark::State& state) {
+  UnaryBatch(state, &FastExp, -10, 10);
+}
+BENCHMARK(BM_FastExpBatch);
+
+void BM_LibmSqrt(benchmark::State& state) { Unary<&LibmSqrt>(state, 0, 100); }
+BENCHMARK(BM_LibmSqrt);
+
+void BM_FastSqrtBatch(benchmark::State& state) {
+  UnaryBatch(state, &FastSqrt, 0, 100);
+}
+BENCHMARK(BM_FastSqrtBatch);
+
+void BM_LibmAtan2(benchmark::State& state) {
+  std::vector<float> y = Inputs(-1, 1, 1);
+  std::vector<float> x = Inputs(-1, 1, 2);
+  std::vector<float> out(kCount);
+  for (auto _ : state) {
+    for (int i = 0; i < kCount; ++i) out[i] = std::atan2(y[i], x[i]);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_LibmAtan2);
+
+void BM_FastAtan2(benchmark::State& state) {
+  std::vector<float> y = Inputs(-1, 1, 1);
+  std::vector<float> x = Inputs(-1, 1, 2);
+  std::vector<float> out(kCount);
+  for (auto _ : state) {
+    for (int i = 0; i < kCount; ++i) out[i] = FastAtan2(y[i], x[i]);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_FastAtan2);
+
+void BM_FastAtan2Batch(benchmark::State& state) {
+  std::vector<float> y = Inputs(-1, 1, 1);
+  std::vector<float> x = Inputs(-1, 1, 2);
+  std::vector<float> out(kCount);
+  for (auto _ : state) {
+    FastAtan2(y, x, absl::MakeSpan(out));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_FastAtan2Batch);
+
+void BM_PackHalf(benchmark::State& state) {
+  std::vector<float> in = Inputs(-100, 100, 1);
+  std::vector<uint16_t> out(kCount);
+  for (auto _ : state) {
+    for (int i = 0; i < kCount; ++i) out[i] = PackHalf(in[i]);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_PackHalf);
+
+void BM_PackHalfBatch(benchmark::State& state) {
+  std::vector<float> in = Inputs(-100, 100, 1);
+  std::vector<uint16_t> out(kCount);
+  for (auto _ : state) {
+    PackHalf(in, absl::MakeSpan(out));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_PackHalfBatch);
+
+void BM_UnpackHalfBatch(benchmark::State& state) {
+  std::vector<float> floats = Inputs(-100, 100, 1);
+  std::vector<uint16_t> in(kCount);
+  PackHalf(floats, absl::MakeSpan(in));
+  std::vector<float> out(kCount);
+  for (auto _ : state) {
+    UnpackHalf(in, absl::MakeSpan(out));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_UnpackHalfBatch);
+
+std::vector<Vec3> Normals(unsigned seed) {
+  std::vector<float> x = Inputs(-1, 1, seed);
+  std::vector<float> y = Inputs(-1, 1, seed + 1);
+  std::vector<float> z = Inputs(-1, 1, seed + 2);
+  std::vector<Vec3> normals;
+  for (int i = 0; i < kCount; ++i) {
+    normals.push_back(Normalize(Vec3(x[i], y[i], z[i] + 0.1f)));
+  }
+  return normals;
+}
+
+void BM_PackOctahedral(benchmark::State& state) {
+  std::vector<Vec3> in = Normals(1);
+  std::vector<uint32_t> out(kCount);
+  for (auto _ : state) {
+    for (int i = 0; i < kCount; ++i) out[i] = PackOctahedral(in[i]);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_PackOctahedral);
+
+void BM_PackOctahedralBatch(benchmark::State& state) {
+  std::vector<float> in[3];
+  for (const Vec3& n : Normals(1)) {
+    for (int j = 0; j < 3; ++j) in[j].push_back(n[j]);
+  }
+  ConstVec3Soa normals({in[0].data(), in[1].data(), in[2].data()}, kCount);
+  std::vector<uint32_t> out(kCount);
+  for (auto _ : state) {
+    PackOctahedral(normals, absl::MakeSpan(out));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_PackOctahedralBatch);
+
+void BM_UnpackOctahedralBatch(benchmark::State& state) {
+  std::vector<uint32_t> in;
+  for (const Vec3& n : Normals(1)) in.push_back(PackOctahedral(n));
+  std::vector<float> out[3];
+  for (std::vector<float>& c : out) c.resize(kCount);
+  Vec3Soa normals({out[0].data(), out[1].data(), out[2].data()}, kCount);
+  for (auto _ : state) {
+    UnpackOctahedral(in, normals);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_UnpackOctahedralBatch);
+
+// Raycasts from random points 30 units out toward random points near the
+// origin, against `n` random boxes or triangles around it.
+
+constexpr int kNumRays = 64;
+
+std::vector<Ray> Rays() {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> position(-5, 5);
+  std::normal_distribution<float> normal;
+  std::vector<Ray> rays;
+  for (int i = 0; i < kNumRays; ++i) {
+    Vec3 origin =
+        30 * Normalize(Vec3(normal(rng), normal(rng), normal(rng)));
+    Vec3 aim(position(rng), position(rng), position(rng));
+    rays.push_back({origin, aim - origin});
+  }
+  return rays;
+}
+
+template <int N, typename Result>
+void Raycast(benchmark::State& state, int n,
+             Result (*raycast)(const Ray&, SoaSpan<N, const float>,
+                               absl::Span<float>)) {
+  std::mt19937 rng(2);
+  std::uniform_real_distribution<float> position(-10, 10);
+  std::uniform_real_distribution<float> offset(-2, 2);
+  std::vector<float> arrays[N];
+  for (int i = 0; i < n; ++i) {
+    float corner[3] = {position(rng), position(rng), position(rng)};
+    for (int k = 0; k < N; ++k) {
+      // Boxes get a positive extent, triangles two edges from the corner.
+      float d = offset(rng);
+      arrays[k].push_back(corner[k % 3] + (k < 3 ? 0 : N == 6 ? 2 + d : d));
+    }
+  }
+  const float* components[N];
+  for (int k = 0; k < N; ++k) components[k] = arrays[k].data();
+  SoaSpan<N, const float> objects(components, n);
+  std::vector<float> distances(n);
+  std::vector<Ray> rays = Rays();
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        raycast(rays[i++ % kNumRays], objects, absl::MakeSpan(distances)));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+RayHit ClosestAabb(const Ray& ray, AabbSoa boxes, absl::Span<float>) {
+  return RaycastAabbs(ray, boxes);
+}
+
+RayHit ClosestTriangle(const Ray& ray, TriangleSoa triangles,
+                       absl::Span<float>) {
+  return RaycastTriangles(ray, triangles);
+}
+
+bool AllAabbs(const Ray& ray, AabbSoa boxes, absl::Span<float> distances) {
+  IntersectAabbs(ray, boxes, std::numeric_limits<float>::infinity(),
+                 distances);
+  return true;
+}
+
+// One BVH node.
+void BM_IntersectAabbs8(benchmark::State& state) {
+  Raycast<6>(state, 8, &AllAabbs);
+}
+BENCHMARK(BM_IntersectAabbs8);
+
+void BM_RaycastAabbs8(benchmark::State& state) {
+  Raycast<6>(state, 8, &ClosestAabb);
+}
+BENCHMARK(BM_RaycastAabbs8);
+
+void BM_RaycastAabbs(benchmark::State& state) {
+  Raycast<6>(state, kCount, &ClosestAabb);
+}
+BENCHMARK(BM_RaycastAabbs);
+
+void BM_RaycastTriangles(benchmark::State& state) {
+  Raycast<9>(state, kCount, &ClosestTriangle);
+}
+BENCHMARK(BM_RaycastTriangles);
+
+// Random numbers, from <random> and one or eight xoshiro128++ generators.
+
+void BM_Mt19937Uniform(benchmark::State& state) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> dist(0, 1);
+  std::vector<float> out(kCount);
+  for (auto _ : state) {
+    for (float& x : out) x = dist(rng);
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_Mt19937Uniform);
+
+void BM_Xoshiro128Uniform(benchmark::State& state) {
+  Xoshiro128 rng(1);
+  std::vector<float> out(kCount);
+  for (auto _ : state) {
+    for (float& x : out) x = rng.uniform();
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_Xoshiro128Uniform);
+
+void BM_Xoshiro128x8Fill(benchmark::State& state) {
+  Xoshiro128x8 rng(1);
+  std::vector<uint32_t> out(kCount);
+  for (auto _ : state) {
+    rng.fill(absl::MakeSpan(out));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_Xoshiro128x8Fill);
+
+void BM_Xoshiro128x8FillUniform(benchmark::State& state) {
+  Xoshiro128x8 rng(1);
+  std::vector<float> out(kCount);
+  for (auto _ : state) {
+    rng.fillUniform(absl::MakeSpan(out));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_Xoshiro128x8FillUniform);
+
+void BM_Xoshiro128UnitVector(benchmark::State& state) {
+  Xoshiro128 rng(1);
+  std::vector<Vec3> out(kCount);
+  for (auto _ : state) {
+    for (Vec3& v : out) v = rng.unitVector();
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_Xoshiro128UnitVector);
+
+void BM_Xoshiro128x8FillUnitVectors(benchmark::State& state) {
+  Xoshiro128x8 rng(1);
+  std::vector<float> arrays[3];
+  for (std::vector<float>& a : arrays) a.resize(kCount);
+  Vec3Soa out({arrays[0].data(), arrays[1].data(), arrays[2].data()},
+              kCount);
+  for (auto _ : state) {
+    rng.fillUnitVectors(out);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * kCount);
+}
+BENCHMARK(BM_Xoshiro128x8FillUnitVectors);
+
+}  // namespace
+}  // namespace y
@@ -0,0 +1,124 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/pack.hpp"
+
+#include "gamma/common/log.hpp"
+
+#define GAMMA_MATH_KERNEL_TARGET
+#include "gamma/math/pack_kernels.hpp"
+
+namespace y_internal {
+
+template <>
+PackKernels MakeKernels<PackKernels, y::SimdLevel::kScalar>() {
+  return y::MakePackKernels<y::Float1>();
+}
+
+const PackKernels& GetPackKernels(y::SimdLevel level) {
+  return GetKernels<PackKernels>(level);
+}
+
+}  // namespace y_internal
+
+namespace y {
+namespace {
+
+using y_internal::ActiveKernels;
+using y_internal::PackKernels;
+
+template <typename In, typename Out>
+void Convert(void (*kernel)(const In*, size_t, Out*), absl::Span<const In> in,
+             absl::Span<Out> out) {
+  YERR_IF(out.size() != in.size()) << "mismatched batch sizes";
+  kernel(in.data(), in.size(), out.data());
+}
+
+}  // namespace
+
+void PackHalf(absl::Span<const float> in, absl::Span<uint16_t> out) {
+  Convert(ActiveKernels<PackKernels>().pack_half, in, out);
+}
+
+void UnpackHalf(absl::Span<const uint16_t> in, absl::Span<float> out) {
+  Convert(ActiveKernels<PackKernels>().unpack_half, in, out);
+}
+
+void PackSnorm8(absl::Span<const float> in, absl::Span<int8_t> out) {
+  Convert(ActiveKernels<PackKernels>().pack_snorm8, in, out);
+}
+
+void PackUnorm8(absl::Span<const float> in, absl::Span<uint8_t> out) {
+  Convert(ActiveKernels<PackKernels>().pack_unorm8, in, out);
+}
+
+void PackSnorm16(absl::Span<const float> in, absl::Span<int16_t> out) {
+  Convert(ActiveKernels<PackKernels>().pack_snorm16, in, out);
+}
+
+void PackUnorm16(absl::Span<const float> in, absl::Span<uint16_t> out) {
+  Convert(ActiveKernels<PackKernels>().pack_unorm16, in, out);
+}
+
+void UnpackSnorm8(absl::Span<const int8_t> in, absl::Span<float> out) {
+  Convert(ActiveKernels<PackKernels>().unpack_snorm8, in, out);
+}
+
+void UnpackUnorm8(absl::Span<const uint8_t> in, absl::Span<float> out) {
+  Convert(ActiveKernels<PackKernels>().unpack_unorm8, in, out);
+}
+
+void UnpackSnorm16(absl::Span<const int16_t> in, absl::Span<float> out) {
+  Convert(ActiveKernels<PackKernels>().unpack_snorm16, in, out);
+}
+
+void UnpackUnorm16(absl::Span<const uint16_t> in, absl::Span<float> out) {
+  Convert(ActiveKernels<PackKernels>().unpack_unorm16, in, out);
+}
+
+void PackOctahedral(ConstVec3Soa in, absl::Span<uint32_t> out) {
+  YERR_IF(out.size() != in.size) << "mismatched batch sizes";
+  ActiveKernels<PackKernels>().pack_octahedral(in, out.data());
+}
+
+void UnpackOctahedral(absl::Span<const uint32_t> in, Vec3Soa out) {
+  YERR_IF(out.size != in.size()) << "mismatched batch sizes";
+  ActiveKernels<PackKernels>().unpack_octahedral(in.data(), out);
+}
+
+void PackUnorm1010102(ConstVec4Soa in, absl::Span<uint32_t> out) {
+  YERR_IF(out.size() != in.size) << "mismatched batch sizes";
+  ActiveKernels<PackKernels>().pack_unorm1010102(in, out.data());
+}
+
+void PackSnorm1010102(ConstVec4Soa in, absl::Span<uint32_t> out) {
+  YERR_IF(out.size() != in.size) << "mismatched batch sizes";
+  ActiveKernels<PackKernels>().pack_snorm1010102(in, out.data());
+}
+
+void UnpackUnorm1010102(absl::Span<const uint32_t> in, Vec4Soa out) {
+  YERR_IF(out.size != in.size()) << "mismatched batch sizes";
+  ActiveKernels<PackKernels>().unpack_unorm1010102(in.data(), out);
+}
+
+void UnpackSnorm1010102(absl::Span<const uint32_t> in, Vec4Soa out) {
+  YERR_IF(out.size != in.size()) << "mismatched batch sizes";
+  ActiveKernels<PackKernels>().unpack_snorm1010102(in.data(), out);
+}
+
+}  // namespace y
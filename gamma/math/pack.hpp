@@ -0,0 +1,321 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_PACK_HPP_
+#define GAMMA_MATH_PACK_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "absl/types/span.h"
+#include "gamma/math/cpu.hpp"
+#include "gamma/math/simd.hpp"
+#include "gamma/math/soa.hpp"
+#include "gamma/math/vec.hpp"
+
+namespace y {
+
+// Compact encodings of floats for vertex attributes and network snapshots.
+// Each comes as inline scalar functions and as batched forms that convert 16,
+// 8 or 4 values at a time, as `ActiveSimdLevel()` allows, with identical
+// results except where noted. Rounding is to nearest, ties to even.
+
+// IEEE 754 half precision. Values beyond the half range become infinities,
+// tiny ones subnormals or zeros, and NaNs stay NaNs; conversion back is
+// exact.
+uint16_t PackHalf(float x);
+float UnpackHalf(uint16_t h);
+
+// Normalized integers, as in Vulkan and Direct3D. Snorm maps [-1, 1] to
+// [-max, max] of the integer type and unorm maps [0, 1] to [0, max]. Inputs
+// are clamped first, with NaN giving the lower bound. Unpacking maps the
+// integer back, and -max - 1 to -1, within 1 ulp, so the round-trip error is
+// at most half a step, 1 / (2 * max), plus that.
+int8_t PackSnorm8(float x);
+uint8_t PackUnorm8(float x);
+int16_t PackSnorm16(float x);
+uint16_t PackUnorm16(float x);
+float UnpackSnorm8(int8_t v);
+float UnpackUnorm8(uint8_t v);
+float UnpackSnorm16(int16_t v);
+float UnpackUnorm16(uint16_t v);
+
+// Unit vectors in 32 bits, by projecting onto an octahedron and unfolding it
+// onto a square whose coordinates are stored as snorm16, x in the low bits.
+// `n` need not be normalized but must be nonzero. Unpacking gives a unit
+// vector within 7e-5 radians of the direction of `n`.
+uint32_t PackOctahedral(const Vec3& n);
+Vec3 UnpackOctahedral(uint32_t v);
+
+// Four components as 10, 10, 10 and 2 bit normalized integers, x in the low
+// bits, as in GL_UNSIGNED_INT_2_10_10_10_REV and its signed counterpart.
+// Snorm w is -1, 0 or 1.
+uint32_t PackUnorm1010102(const Vec4& v);
+uint32_t PackSnorm1010102(const Vec4& v);
+Vec4 UnpackUnorm1010102(uint32_t v);
+Vec4 UnpackSnorm1010102(uint32_t v);
+
+// out[i] = Pack*(in[i]) or Unpack*(in[i]). Both views must have the same
+// size. The octahedral results differ from the scalar ones by at most one
+// step, from the reciprocal square root estimate.
+void PackHalf(absl::Span<const float> in, absl::Span<uint16_t> out);
+void UnpackHalf(absl::Span<const uint16_t> in, absl::Span<float> out);
+void PackSnorm8(absl::Span<const float> in, absl::Span<int8_t> out);
+void PackUnorm8(absl::Span<const float> in, absl::Span<uint8_t> out);
+void PackSnorm16(absl::Span<const float> in, absl::Span<int16_t> out);
+void PackUnorm16(absl::Span<const float> in, absl::Span<uint16_t> out);
+void UnpackSnorm8(absl::Span<const int8_t> in, absl::Span<float> out);
+void UnpackUnorm8(absl::Span<const uint8_t> in, absl::Span<float> out);
+void UnpackSnorm16(absl::Span<const int16_t> in, absl::Span<float> out);
+void UnpackUnorm16(absl::Span<const uint16_t> in, absl::Span<float> out);
+void PackOctahedral(ConstVec3Soa in, absl::Span<uint32_t> out);
+void UnpackOctahedral(absl::Span<const uint32_t> in, Vec3Soa out);
+void PackUnorm1010102(ConstVec4Soa in, absl::Span<uint32_t> out);
+void PackSnorm1010102(ConstVec4Soa in, absl::Span<uint32_t> out);
+void UnpackUnorm1010102(absl::Span<const uint32_t> in, Vec4Soa out);
+void UnpackSnorm1010102(absl::Span<const uint32_t> in, Vec4Soa out);
+
+}  // namespace y
+
+namespace y_internal {
+
+// The kernels compiled for one instruction set, without size checks.
+struct PackKernels {
+  void (*pack_half)(const float* in, size_t n, uint16_t* out);
+  void (*unpack_half)(const uint16_t* in, size_t n, float* out);
+  void (*pack_snorm8)(const float* in, size_t n, int8_t* out);
+  void (*pack_unorm8)(const float* in, size_t n, uint8_t* out);
+  void (*pack_snorm16)(const float* in, size_t n, int16_t* out);
+  void (*pack_unorm16)(const float* in, size_t n, uint16_t* out);
+  void (*unpack_snorm8)(const int8_t* in, size_t n, float* out);
+  void (*unpack_unorm8)(const uint8_t* in, size_t n, float* out);
+  void (*unpack_snorm16)(const int16_t* in, size_t n, float* out);
+  void (*unpack_unorm16)(const uint16_t* in, size_t n, float* out);
+  void (*pack_octahedral)(const y::ConstVec3Soa& in, uint32_t* out);
+  void (*unpack_octahedral)(const uint32_t* in, const y::Vec3Soa& out);
+  void (*pack_unorm1010102)(const y::ConstVec4Soa& in, uint32_t* out);
+  void (*pack_snorm1010102)(const y::ConstVec4Soa& in, uint32_t* out);
+  void (*unpack_unorm1010102)(const uint32_t* in, const y::Vec4Soa& out);
+  void (*unpack_snorm1010102)(const uint32_t* in, const y::Vec4Soa& out);
+};
+
+// Kernels for `level`, which must be no wider than `DetectSimdLevel()`.
+const PackKernels& GetPackKernels(y::SimdLevel level);
+
+// Largest value of a normalized integer `bits` wide.
+constexpr float NormMax(int bits, bool is_signed) {
+  return static_cast<float>((1 << (is_signed ? bits - 1 : bits)) - 1);
+}
+
+// Bit widths of the 10:10:10:2 fields, from the lowest.
+constexpr int k1010102Bits[] = {10, 10, 10, 2};
+
+}  // namespace y_internal
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+namespace y_internal {
+
+inline uint32_t FloatBits(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  return bits;
+}
+
+inline float BitsFloat(uint32_t bits) {
+  float x;
+  std::memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+// Rounds to nearest, ties to even, like the SIMD conversions.
+inline int32_t RoundToInt32(float x) {
+#ifdef GAMMA_MATH_SSE2
+  return _mm_cvtss_si32(_mm_set_ss(x));
+#else
+  return static_cast<int32_t>(std::nearbyint(x));
+#endif
+}
+
+// Clamps to [-1, 1] or [0, 1], with NaN giving the lower bound, and scales.
+inline int32_t PackNorm(float x, int bits, bool is_signed) {
+  float lo = is_signed ? -1.0f : 0.0f;
+  x = std::min(std::max(lo, x), 1.0f);
+  return RoundToInt32(x * NormMax(bits, is_signed));
+}
+
+inline float UnpackNorm(int32_t v, int bits, bool is_signed) {
+  float x = static_cast<float>(v) * (1.0f / NormMax(bits, is_signed));
+  return is_signed ? std::max(x, -1.0f) : x;
+}
+
+template <typename T>
+T PackNorm(float x) {
+  return static_cast<T>(PackNorm(x, 8 * sizeof(T), std::is_signed<T>::value));
+}
+
+template <typename T>
+float UnpackNorm(T v) {
+  return UnpackNorm(v, 8 * sizeof(T), std::is_signed<T>::value);
+}
+
+}  // namespace y_internal
+
+namespace y {
+
+// The conversions to and from half follow Fabian Giesen's branch-light
+// versions, which the SSE4.2 kernels vectorize.
+inline uint16_t PackHalf(float x) {
+  namespace yi = y_internal;
+  uint32_t bits = yi::FloatBits(x);
+  uint32_t sign = bits & 0x80000000u;
+  bits ^= sign;
+  uint32_t h;
+  if (bits >= (127u + 16) << 23) {
+    // Too large for half: infinity, or a quiet NaN.
+    h = bits > 255u << 23 ? 0x7e00 : 0x7c00;
+  } else if (bits < (127u - 14) << 23) {
+    // Subnormal or zero: adding 0.5 aligns the mantissa so that the FPU
+    // rounds it, and the result is in the low bits.
+    const float magic = yi::BitsFloat((127u - 1) << 23);
+    h = yi::FloatBits(yi::BitsFloat(bits) + magic) - yi::FloatBits(magic);
+  } else {
+    // Normal: rebias the exponent and round the 13 dropped mantissa bits.
+    uint32_t odd = (bits >> 13) & 1;
+    h = (bits - ((127u - 15) << 23) + 0xfff + odd) >> 13;
+  }
+  return static_cast<uint16_t>(h | sign >> 16);
+}
+
+inline float UnpackHalf(uint16_t h) {
+  namespace yi = y_internal;
+  // Shifting the exponent and mantissa into place and scaling by 2^112
+  // rebiases the exponent and normalizes subnormals, and anything that was
+  // infinity or NaN ends up at least 2^16.
+  float x = yi::BitsFloat(static_cast<uint32_t>(h & 0x7fff) << 13) *
+            yi::BitsFloat((254u - 15) << 23);
+  uint32_t bits = yi::FloatBits(x);
+  if (x >= yi::BitsFloat((127u + 16) << 23)) bits |= 255u << 23;
+  return yi::BitsFloat(bits | static_cast<uint32_t>(h & 0x8000) << 16);
+}
+
+inline int8_t PackSnorm8(float x) {
+  return y_internal::PackNorm<int8_t>(x);
+}
+
+inline uint8_t PackUnorm8(float x) {
+  return y_internal::PackNorm<uint8_t>(x);
+}
+
+inline int16_t PackSnorm16(float x) {
+  return y_internal::PackNorm<int16_t>(x);
+}
+
+inline uint16_t PackUnorm16(float x) {
+  return y_internal::PackNorm<uint16_t>(x);
+}
+
+inline float UnpackSnorm8(int8_t v) { return y_internal::UnpackNorm(v); }
+
+inline float UnpackUnorm8(uint8_t v) { return y_internal::UnpackNorm(v); }
+
+inline float UnpackSnorm16(int16_t v) { return y_internal::UnpackNorm(v); }
+
+inline float UnpackUnorm16(uint16_t v) { return y_internal::UnpackNorm(v); }
+
+inline uint32_t PackOctahedral(const Vec3& n) {
+  // Project onto |x| + |y| + |z| = 1 and fold the lower half outward over
+  // the diagonals of the square.
+  float inverse_l1 = 1.0f / (std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z));
+  float x = n.x * inverse_l1;
+  float y = n.y * inverse_l1;
+  if (n.z < 0) {
+    float folded_x = std::copysign(1.0f - std::fabs(y), x);
+    y = std::copysign(1.0f - std::fabs(x), y);
+    x = folded_x;
+  }
+  return static_cast<uint16_t>(PackSnorm16(x)) |
+         static_cast<uint32_t>(static_cast<uint16_t>(PackSnorm16(y))) << 16;
+}
+
+inline Vec3 UnpackOctahedral(uint32_t v) {
+  float x = UnpackSnorm16(static_cast<int16_t>(v & 0xffff));
+  float y = UnpackSnorm16(static_cast<int16_t>(v >> 16));
+  float z = 1.0f - std::fabs(x) - std::fabs(y);
+  float fold = std::max(-z, 0.0f);
+  x -= std::copysign(fold, x);
+  y -= std::copysign(fold, y);
+  return Normalize(Vec3(x, y, z));
+}
+
+inline uint32_t PackUnorm1010102(const Vec4& v) {
+  uint32_t packed = 0;
+  int shift = 0;
+  for (int i = 0; i < 4; ++i) {
+    int bits = y_internal::k1010102Bits[i];
+    packed |= static_cast<uint32_t>(y_internal::PackNorm(v[i], bits, false))
+              << shift;
+    shift += bits;
+  }
+  return packed;
+}
+
+inline uint32_t PackSnorm1010102(const Vec4& v) {
+  uint32_t packed = 0;
+  int shift = 0;
+  for (int i = 0; i < 4; ++i) {
+    int bits = y_internal::k1010102Bits[i];
+    uint32_t field = y_internal::PackNorm(v[i], bits, true);
+    packed |= (field & ((1u << bits) - 1)) << shift;
+    shift += bits;
+  }
+  return packed;
+}
+
+inline Vec4 UnpackUnorm1010102(uint32_t v) {
+  Vec4 unpacked;
+  for (int i = 0; i < 4; ++i) {
+    int bits = y_internal::k1010102Bits[i];
+    unpacked[i] =
+        y_internal::UnpackNorm(v & ((1u << bits) - 1), bits, false);
+    v >>= bits;
+  }
+  return unpacked;
+}
+
+inline Vec4 UnpackSnorm1010102(uint32_t v) {
+  Vec4 unpacked;
+  int shift = 0;
+  for (int i = 0; i < 4; ++i) {
+    int bits = y_internal::k1010102Bits[i];
+    // Move the field to the top and shift it back down with sign extension.
+    int32_t field =
+        static_cast<int32_t>(v << (32 - shift - bits)) >> (32 - bits);
+    unpacked[i] = y_internal::UnpackNorm(field, bits, true);
+    shift += bits;
+  }
+  return unpacked;
+}
+
+}  // namespace y
+#endif  // GAMMA_MATH_PACK_HPP_
@@ -0,0 +1,248 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_PACK_KERNELS_HPP_
+#define GAMMA_MATH_PACK_KERNELS_HPP_
+
+// Packing kernels as templates over a lane type; see lanes.hpp. Each follows
+// the scalar form of the same name in pack.hpp.
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "gamma/math/dispatch.hpp"
+#include "gamma/math/lanes.hpp"
+#include "gamma/math/pack.hpp"
+
+namespace y_internal {
+
+// Defined in kernels_*.cpp.
+template <>
+PackKernels MakeKernels<PackKernels, y::SimdLevel::kSse42>();
+template <>
+PackKernels MakeKernels<PackKernels, y::SimdLevel::kAvx2>();
+template <>
+PackKernels MakeKernels<PackKernels, y::SimdLevel::kAvx512>();
+
+}  // namespace y_internal
+
+namespace y {
+namespace {
+
+// Conversions of one group of `F::kWidth` values.
+
+struct PackHalfOp {
+  template <typename F>
+  GAMMA_MATH_KERNEL_TARGET static void Run(const float* in, uint16_t* out) {
+    F::Load(in).storeHalf(out);
+  }
+};
+
+struct UnpackHalfOp {
+  template <typename F>
+  GAMMA_MATH_KERNEL_TARGET static void Run(const uint16_t* in, float* out) {
+    F::LoadHalf(in).store(out);
+  }
+};
+
+struct PackNormOp {
+  template <typename F, typename T>
+  GAMMA_MATH_KERNEL_TARGET static void Run(const float* in, T* out) {
+    const bool is_signed = std::is_signed<T>::value;
+    F x = Max(F::Load(in), F::Splat(is_signed ? -1.0f : 0.0f));
+    x = Min(x, F::Splat(1.0f));
+    (x * F::Splat(y_internal::NormMax(8 * sizeof(T), is_signed))).store(out);
+  }
+};
+
+struct UnpackNormOp {
+  template <typename F, typename T>
+  GAMMA_MATH_KERNEL_TARGET static void Run(const T* in, float* out) {
+    const bool is_signed = std::is_signed<T>::value;
+    F x = F::Load(in) *
+          F::Splat(1.0f / y_internal::NormMax(8 * sizeof(T), is_signed));
+    if (is_signed) x = Max(x, F::Splat(-1.0f));
+    x.store(out);
+  }
+};
+
+// Each kernel converts groups of `F::kWidth` elements from `begin` and returns
+// the index of the first element left over.
+
+template <typename F, typename Op, typename In, typename Out>
+GAMMA_MATH_KERNEL_TARGET inline size_t ConvertLanes(const In* in, size_t n,
+                                                    Out* out, size_t begin) {
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    Op::template Run<F>(in + e, out + e);
+  }
+  return e;
+}
+
+template <typename F, typename Op, typename In, typename Out>
+GAMMA_MATH_KERNEL_TARGET inline void ConvertBatch(const In* in, size_t n,
+                                                  Out* out) {
+  size_t e = ConvertLanes<F, Op>(in, n, out, 0);
+  ConvertLanes<Float1, Op>(in, n, out, e);
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline size_t PackOctahedralLanes(
+    const ConstVec3Soa& in, uint32_t* out, size_t begin) {
+  const F zero = F::Splat(0.0f);
+  const F one = F::Splat(1.0f);
+  const F scale = F::Splat(y_internal::NormMax(16, true));
+  const int bits[] = {16, 16};
+  size_t n = in.size;
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    F x = F::Load(in[0] + e);
+    F y = F::Load(in[1] + e);
+    F z = F::Load(in[2] + e);
+    F inverse_l1 = one / (Abs(x) + Abs(y) + Abs(z));
+    x = x * inverse_l1;
+    y = y * inverse_l1;
+    typename F::Mask upper = GreaterEqual(z, zero);
+    F folded_x = FlipSign(one - Abs(y), x);
+    y = Select(upper, y, FlipSign(one - Abs(x), y));
+    x = Select(upper, x, folded_x);
+    F fields[] = {Min(Max(x, F::Splat(-1.0f)), one) * scale,
+                  Min(Max(y, F::Splat(-1.0f)), one) * scale};
+    StoreBitFields(fields, bits, 2, out + e);
+  }
+  return e;
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline size_t UnpackOctahedralLanes(const uint32_t* in,
+                                                             const Vec3Soa& out,
+                                                             size_t begin) {
+  const F zero = F::Splat(0.0f);
+  const F minus_one = F::Splat(-1.0f);
+  const F inverse_scale = F::Splat(1.0f / y_internal::NormMax(16, true));
+  size_t n = out.size;
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    F x = Max(F::LoadBitField(in + e, 0, 16, true) * inverse_scale, minus_one);
+    F y = Max(F::LoadBitField(in + e, 16, 16, true) * inverse_scale, minus_one);
+    F z = F::Splat(1.0f) - Abs(x) - Abs(y);
+    F fold = Max(zero - z, zero);
+    x = x - FlipSign(fold, x);
+    y = y - FlipSign(fold, y);
+    F inverse_length = InverseSqrt(MulAdd(x, x, MulAdd(y, y, z * z)));
+    (x * inverse_length).store(out[0] + e);
+    (y * inverse_length).store(out[1] + e);
+    (z * inverse_length).store(out[2] + e);
+  }
+  return e;
+}
+
+template <typename F, bool kSigned>
+GAMMA_MATH_KERNEL_TARGET inline size_t Pack1010102Lanes(const ConstVec4Soa& in,
+                                                        uint32_t* out,
+                                                        size_t begin) {
+  const F lo = F::Splat(kSigned ? -1.0f : 0.0f);
+  const F hi = F::Splat(1.0f);
+  size_t n = in.size;
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    F fields[4];
+    for (int i = 0; i < 4; ++i) {
+      int bits = y_internal::k1010102Bits[i];
+      F x = Min(Max(F::Load(in[i] + e), lo), hi);
+      fields[i] = x * F::Splat(y_internal::NormMax(bits, kSigned));
+    }
+    StoreBitFields(fields, y_internal::k1010102Bits, 4, out + e);
+  }
+  return e;
+}
+
+template <typename F, bool kSigned>
+GAMMA_MATH_KERNEL_TARGET inline size_t Unpack1010102Lanes(const uint32_t* in,
+                                                          const Vec4Soa& out,
+                                                          size_t begin) {
+  size_t n = out.size;
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    int shift = 0;
+    for (int i = 0; i < 4; ++i) {
+      int bits = y_internal::k1010102Bits[i];
+      F x = F::LoadBitField(in + e, shift, bits, kSigned) *
+            F::Splat(1.0f / y_internal::NormMax(bits, kSigned));
+      if (kSigned) x = Max(x, F::Splat(-1.0f));
+      x.store(out[i] + e);
+      shift += bits;
+    }
+  }
+  return e;
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline void PackOctahedralBatch(const ConstVec3Soa& in,
+                                                         uint32_t* out) {
+  size_t e = PackOctahedralLanes<F>(in, out, 0);
+  PackOctahedralLanes<Float1>(in, out, e);
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline void UnpackOctahedralBatch(const uint32_t* in,
+                                                           const Vec3Soa& out) {
+  size_t e = UnpackOctahedralLanes<F>(in, out, 0);
+  UnpackOctahedralLanes<Float1>(in, out, e);
+}
+
+template <typename F, bool kSigned>
+GAMMA_MATH_KERNEL_TARGET inline void Pack1010102Batch(const ConstVec4Soa& in,
+                                                      uint32_t* out) {
+  size_t e = Pack1010102Lanes<F, kSigned>(in, out, 0);
+  Pack1010102Lanes<Float1, kSigned>(in, out, e);
+}
+
+template <typename F, bool kSigned>
+GAMMA_MATH_KERNEL_TARGET inline void Unpack1010102Batch(const uint32_t* in,
+                                                        const Vec4Soa& out) {
+  size_t e = Unpack1010102Lanes<F, kSigned>(in, out, 0);
+  Unpack1010102Lanes<Float1, kSigned>(in, out, e);
+}
+
+template <typename F>
+y_internal::PackKernels MakePackKernels() {
+  y_internal::PackKernels kernels;
+  kernels.pack_half = &ConvertBatch<F, PackHalfOp, float, uint16_t>;
+  kernels.unpack_half = &ConvertBatch<F, UnpackHalfOp, uint16_t, float>;
+  kernels.pack_snorm8 = &ConvertBatch<F, PackNormOp, float, int8_t>;
+  kernels.pack_unorm8 = &ConvertBatch<F, PackNormOp, float, uint8_t>;
+  kernels.pack_snorm16 = &ConvertBatch<F, PackNormOp, float, int16_t>;
+  kernels.pack_unorm16 = &ConvertBatch<F, PackNormOp, float, uint16_t>;
+  kernels.unpack_snorm8 = &ConvertBatch<F, UnpackNormOp, int8_t, float>;
+  kernels.unpack_unorm8 = &ConvertBatch<F, UnpackNormOp, uint8_t, float>;
+  kernels.unpack_snorm16 = &ConvertBatch<F, UnpackNormOp, int16_t, float>;
+  kernels.unpack_unorm16 = &ConvertBatch<F, UnpackNormOp, uint16_t, float>;
+  kernels.pack_octahedral = &PackOctahedralBatch<F>;
+  kernels.unpack_octahedral = &UnpackOctahedralBatch<F>;
+  kernels.pack_unorm1010102 = &Pack1010102Batch<F, false>;
+  kernels.pack_snorm1010102 = &Pack1010102Batch<F, true>;
+  kernels.unpack_unorm1010102 = &Unpack1010102Batch<F, false>;
+  kernels.unpack_snorm1010102 = &Unpack1010102Batch<F, true>;
+  return kernels;
+}
+
+}  // namespace
+}  // namespace y
+#endif  // GAMMA_MATH_PACK_KERNELS_HPP_
@@ -0,0 +1,344 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/pack.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+uint32_t Bits(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  return bits;
+}
+
+float FromBits(uint32_t bits) {
+  float x;
+  std::memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+// Floats with random bit patterns, which cover every exponent, plus a few
+// edge cases. Odd sizes leave tails for the scalar loops.
+std::vector<float> RandomFloats(size_t n, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::vector<float> floats = {0.0f, -0.0f, 1.0f, -1.0f, 65504.0f, 65520.0f,
+                               std::numeric_limits<float>::infinity(),
+                               std::numeric_limits<float>::quiet_NaN(),
+                               5.96e-8f, 2.98e-8f, 2.99e-8f, 6.1e-5f};
+  while (floats.size() < n) floats.push_back(FromBits(rng()));
+  return floats;
+}
+
+std::vector<float> UniformFloats(size_t n, float lo, float hi,
+                                 unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(lo, hi);
+  std::vector<float> floats(n);
+  for (float& x : floats) x = dist(rng);
+  return floats;
+}
+
+TEST(PackTest, EveryHalfRoundTrips) {
+  std::vector<uint16_t> halves(1 << 16);
+  for (size_t h = 0; h < halves.size(); ++h) {
+    halves[h] = static_cast<uint16_t>(h);
+  }
+  std::vector<float> floats(halves.size());
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    const y_internal::PackKernels& kernels = y_internal::GetPackKernels(level);
+    kernels.unpack_half(halves.data(), halves.size(), floats.data());
+    std::vector<uint16_t> repacked(halves.size());
+    kernels.pack_half(floats.data(), floats.size(), repacked.data());
+    for (size_t h = 0; h < halves.size(); ++h) {
+      float x = UnpackHalf(halves[h]);
+      if (std::isnan(x)) {
+        ASSERT_TRUE(std::isnan(floats[h])) << h;
+        ASSERT_EQ(repacked[h] & 0x7c00, 0x7c00) << h;
+        ASSERT_NE(repacked[h] & 0x3ff, 0) << h;
+        continue;
+      }
+      ASSERT_EQ(Bits(floats[h]), Bits(x)) << h;
+      ASSERT_EQ(PackHalf(x), halves[h]) << h;
+      ASSERT_EQ(repacked[h], halves[h]) << h;
+    }
+  }
+  EXPECT_EQ(UnpackHalf(0x3c00), 1.0f);
+  EXPECT_EQ(UnpackHalf(0xc000), -2.0f);
+  EXPECT_EQ(UnpackHalf(0x7bff), 65504.0f);
+  EXPECT_EQ(UnpackHalf(0x0001), std::ldexp(1.0f, -24));
+}
+
+// Every float rounds to the nearest half, ties to even, and the SIMD kernels
+// agree bit for bit.
+TEST(PackTest, PackHalfRoundsToNearest) {
+  std::vector<float> floats = RandomFloats(100003, 1);
+  std::vector<uint16_t> halves(floats.size());
+  for (size_t i = 0; i < floats.size(); ++i) {
+    float x = floats[i];
+    uint16_t h = PackHalf(x);
+    halves[i] = h;
+    if (std::isnan(x)) {
+      EXPECT_TRUE(std::isnan(UnpackHalf(h)));
+      continue;
+    }
+    EXPECT_EQ(h >> 15, Bits(x) >> 31) << x;
+    if (std::fabs(x) >= 65520.0f) {
+      EXPECT_EQ(h & 0x7fff, 0x7c00) << x;
+      continue;
+    }
+    // The neighbouring halves are no closer, and a tie goes to the even one.
+    double error = std::fabs(static_cast<double>(UnpackHalf(h)) - x);
+    for (int step : {-1, 1}) {
+      uint16_t neighbour = static_cast<uint16_t>((h & 0x7fff) + step);
+      if (neighbour > 0x7bff) continue;
+      double other = std::fabs(
+          static_cast<double>(UnpackHalf(neighbour | (h & 0x8000))) - x);
+      EXPECT_LE(error, other) << x;
+      if (error == other) {
+        EXPECT_EQ(h & 1, 0) << x;
+      }
+    }
+  }
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    std::vector<uint16_t> batched(floats.size());
+    y_internal::GetPackKernels(level).pack_half(floats.data(), floats.size(),
+                                                batched.data());
+    for (size_t i = 0; i < floats.size(); ++i) {
+      if (std::isnan(floats[i])) continue;
+      ASSERT_EQ(batched[i], halves[i]) << floats[i];
+    }
+  }
+}
+
+template <typename T>
+using PackKernel = void (*)(const float* in, size_t n, T* out);
+template <typename T>
+using UnpackKernel = void (*)(const T* in, size_t n, float* out);
+
+// Checks one normalized integer type on every integer and on random floats,
+// for the scalar functions and the kernels of every level.
+template <typename T>
+void CheckNorm(T (*pack)(float), float (*unpack)(T),
+               PackKernel<T> y_internal::PackKernels::*batch_pack,
+               UnpackKernel<T> y_internal::PackKernels::*batch_unpack) {
+  const float max = std::numeric_limits<T>::max();
+  const float lo = std::is_signed<T>::value ? -1.0f : 0.0f;
+
+  // Every integer unpacks to within an ulp of v / max and packs back, except
+  // that the lowest snorm value means -1 too.
+  std::vector<T> ints;
+  for (int v = std::numeric_limits<T>::min();
+       v <= std::numeric_limits<T>::max(); ++v) {
+    ints.push_back(static_cast<T>(v));
+  }
+  for (T v : ints) {
+    float x = unpack(v);
+    ASSERT_NEAR(x, std::max(v / max, lo), 1.2e-7f) << +v;
+    ASSERT_EQ(pack(x), std::max<float>(v, lo * max)) << +v;
+  }
+
+  // Floats round to the nearest step after clamping, and NaN gives the lower
+  // bound.
+  std::vector<float> floats = UniformFloats(100003, -1.5f, 1.5f, 2);
+  floats.push_back(std::numeric_limits<float>::quiet_NaN());
+  std::vector<T> packed(floats.size());
+  for (size_t i = 0; i < floats.size(); ++i) {
+    float x = floats[i];
+    packed[i] = pack(x);
+    float clamped = std::isnan(x) ? lo : std::min(std::max(x, lo), 1.0f);
+    ASSERT_EQ(packed[i], std::nearbyint(clamped * max)) << x;
+    ASSERT_LE(std::fabs(unpack(packed[i]) - clamped), 0.5f / max + 1.2e-7f)
+        << x;
+  }
+
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    const y_internal::PackKernels& kernels = y_internal::GetPackKernels(level);
+    std::vector<float> unpacked(ints.size());
+    (kernels.*batch_unpack)(ints.data(), ints.size(), unpacked.data());
+    for (size_t i = 0; i < ints.size(); ++i) {
+      ASSERT_EQ(unpacked[i], unpack(ints[i])) << +ints[i];
+    }
+    std::vector<T> batched(floats.size());
+    (kernels.*batch_pack)(floats.data(), floats.size(), batched.data());
+    EXPECT_EQ(batched, packed);
+  }
+}
+
+TEST(PackTest, Snorm8) {
+  CheckNorm<int8_t>(&PackSnorm8, &UnpackSnorm8,
+                    &y_internal::PackKernels::pack_snorm8,
+                    &y_internal::PackKernels::unpack_snorm8);
+}
+
+TEST(PackTest, Unorm8) {
+  CheckNorm<uint8_t>(&PackUnorm8, &UnpackUnorm8,
+                     &y_internal::PackKernels::pack_unorm8,
+                     &y_internal::PackKernels::unpack_unorm8);
+}
+
+TEST(PackTest, Snorm16) {
+  CheckNorm<int16_t>(&PackSnorm16, &UnpackSnorm16,
+                     &y_internal::PackKernels::pack_snorm16,
+                     &y_internal::PackKernels::unpack_snorm16);
+}
+
+TEST(PackTest, Unorm16) {
+  CheckNorm<uint16_t>(&PackUnorm16, &UnpackUnorm16,
+                      &y_internal::PackKernels::pack_unorm16,
+                      &y_internal::PackKernels::unpack_unorm16);
+}
+
+// Random directions, including the axes and the folded lower half.
+std::vector<Vec3> Directions(size_t n) {
+  std::mt19937 rng(3);
+  std::normal_distribution<float> dist;
+  std::vector<Vec3> directions = {Vec3(1, 0, 0),  Vec3(0, -1, 0),
+                                  Vec3(0, 0, 1),  Vec3(0, 0, -1),
+                                  Vec3(1, 1, -1), Vec3(-3, 2, -1e-3f)};
+  while (directions.size() < n) {
+    Vec3 v(dist(rng), dist(rng), dist(rng));
+    if (Length(v) > 1e-3f) directions.push_back(v);
+  }
+  return directions;
+}
+
+float Angle(const Vec3& a, const Vec3& b) {
+  return std::atan2(Length(Cross(a, b)), Dot(a, b));
+}
+
+TEST(PackTest, OctahedralRoundTrip) {
+  std::vector<Vec3> directions = Directions(100003);
+  std::vector<float> arrays[3];
+  std::vector<uint32_t> packed;
+  for (const Vec3& n : directions) {
+    for (int k = 0; k < 3; ++k) arrays[k].push_back(n[k]);
+    packed.push_back(PackOctahedral(n));
+    Vec3 unpacked = UnpackOctahedral(packed.back());
+    ASSERT_NEAR(Length(unpacked), 1, 1e-6f);
+    ASSERT_LE(Angle(unpacked, n), 7e-5f) << n.x << " " << n.y << " " << n.z;
+  }
+  ConstVec3Soa in({arrays[0].data(), arrays[1].data(), arrays[2].data()},
+                  directions.size());
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    const y_internal::PackKernels& kernels = y_internal::GetPackKernels(level);
+    std::vector<uint32_t> batched(directions.size());
+    kernels.pack_octahedral(in, batched.data());
+    EXPECT_EQ(batched, packed);
+    std::vector<float> out[3];
+    for (std::vector<float>& array : out) array.resize(directions.size());
+    Vec3Soa unpacked({out[0].data(), out[1].data(), out[2].data()},
+                     directions.size());
+    kernels.unpack_octahedral(packed.data(), unpacked);
+    for (size_t i = 0; i < directions.size(); ++i) {
+      Vec3 v(out[0][i], out[1][i], out[2][i]);
+      ASSERT_NEAR(Length(v), 1, 1e-6f);
+      ASSERT_LE(Angle(v, directions[i]), 7e-5f) << i;
+    }
+  }
+}
+
+void Check1010102(uint32_t (*pack)(const Vec4&), Vec4 (*unpack)(uint32_t),
+                  void (*y_internal::PackKernels::*batch_pack)(
+                      const ConstVec4Soa&, uint32_t*),
+                  void (*y_internal::PackKernels::*batch_unpack)(
+                      const uint32_t*, const Vec4Soa&),
+                  bool is_signed) {
+  const float lo = is_signed ? -1.0f : 0.0f;
+  const float max[] = {is_signed ? 511.0f : 1023.0f,
+                       is_signed ? 511.0f : 1023.0f,
+                       is_signed ? 511.0f : 1023.0f, is_signed ? 1.0f : 3.0f};
+  std::vector<float> floats = UniformFloats(4 * 10003, -1.2f, 1.2f, 4);
+  std::vector<float> arrays[4];
+  std::vector<uint32_t> packed;
+  for (size_t i = 0; i < floats.size(); i += 4) {
+    Vec4 v(floats[i], floats[i + 1], floats[i + 2], floats[i + 3]);
+    for (int k = 0; k < 4; ++k) arrays[k].push_back(v[k]);
+    packed.push_back(pack(v));
+    Vec4 unpacked = unpack(packed.back());
+    for (int k = 0; k < 4; ++k) {
+      float clamped = std::min(std::max(v[k], lo), 1.0f);
+      ASSERT_LE(std::fabs(unpacked[k] - clamped), 0.5f / max[k] + 1.2e-7f)
+          << k << " " << v[k];
+    }
+    ASSERT_EQ(pack(unpacked), packed.back());
+  }
+
+  size_t n = packed.size();
+  ConstVec4Soa in({arrays[0].data(), arrays[1].data(), arrays[2].data(),
+                   arrays[3].data()},
+                  n);
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    const y_internal::PackKernels& kernels = y_internal::GetPackKernels(level);
+    std::vector<uint32_t> batched(n);
+    (kernels.*batch_pack)(in, batched.data());
+    EXPECT_EQ(batched, packed);
+    std::vector<float> out[4];
+    for (std::vector<float>& array : out) array.resize(n);
+    Vec4Soa unpacked({out[0].data(), out[1].data(), out[2].data(),
+                      out[3].data()},
+                     n);
+    (kernels.*batch_unpack)(packed.data(), unpacked);
+    for (size_t i = 0; i < n; ++i) {
+      Vec4 expected = unpack(packed[i]);
+      for (int k = 0; k < 4; ++k) ASSERT_EQ(out[k][i], expected[k]) << i;
+    }
+  }
+}
+
+TEST(PackTest, Unorm1010102) {
+  Check1010102(&PackUnorm1010102, &UnpackUnorm1010102,
+               &y_internal::PackKernels::pack_unorm1010102,
+               &y_internal::PackKernels::unpack_unorm1010102, false);
+  EXPECT_EQ(PackUnorm1010102(Vec4(1, 0, 0, 1)), 0xc00003ffu);
+}
+
+TEST(PackTest, Snorm1010102) {
+  Check1010102(&PackSnorm1010102, &UnpackSnorm1010102,
+               &y_internal::PackKernels::pack_snorm1010102,
+               &y_internal::PackKernels::unpack_snorm1010102, true);
+  EXPECT_EQ(PackSnorm1010102(Vec4(-1, 0, 1, -1)), 0xdff00201u);
+  Vec4 v = UnpackSnorm1010102(0xdff00201u);
+  EXPECT_EQ(v.x, -1.0f);
+  EXPECT_EQ(v.z, 1.0f);
+  EXPECT_EQ(v.w, -1.0f);
+}
+
+TEST(PackTest, MismatchedSizesDie) {
+  std::vector<float> floats(17);
+  std::vector<uint16_t> halves(16);
+  EXPECT_DEATH_IF_SUPPORTED(PackHalf(floats, absl::MakeSpan(halves)), "");
+  EXPECT_DEATH_IF_SUPPORTED(
+      UnpackSnorm16(std::vector<int16_t>(3), absl::MakeSpan(floats)), "");
+}
+
+}  // namespace
+}  // namespace y
@@ -0,0 +1,140 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_QUAT_HPP_
+#define GAMMA_MATH_QUAT_HPP_
+
+#include <cmath>
+
+#include "gamma/math/mat4.hpp"
+#include "gamma/math/simd.hpp"
+#include "gamma/math/vec.hpp"
+
+namespace y {
+
+// Rotation quaternion x i + y j + z k + w. Unlike glm::quat, the constructor
+// takes the components in memory order, with w last.
+struct alignas(16) Quat {
+  Quat() = default;
+  constexpr Quat(float x, float y, float z, float w);
+
+  // The identity rotation.
+  static constexpr Quat Identity();
+
+  float x;
+  float y;
+  float z;
+  float w;
+};
+
+static_assert(sizeof(Quat) == 16, "");
+
+// Rotation by `radians` counterclockwise around the unit vector `axis`.
+Quat AngleAxis(float radians, const Vec3& axis);
+
+// Composition: `a * b` rotates by `b` first, as with glm.
+Quat operator*(const Quat& a, const Quat& b);
+// `v` rotated by the unit quaternion `q`.
+Vec3 operator*(const Quat& q, const Vec3& v);
+
+float Dot(const Quat& a, const Quat& b);
+float Length(const Quat& q);
+Quat Normalize(const Quat& q);
+Quat Conjugate(const Quat& q);
+Quat Inverse(const Quat& q);
+
+// Rotation matrix of the unit quaternion `q`.
+Mat4 RotationMatrix(const Quat& q);
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline constexpr Quat::Quat(float x, float y, float z, float w)
+    : x(x), y(y), z(z), w(w) {}
+
+inline constexpr Quat Quat::Identity() { return Quat(0.0f, 0.0f, 0.0f, 1.0f); }
+
+inline Quat AngleAxis(float radians, const Vec3& axis) {
+  float s = std::sin(0.5f * radians);
+  return Quat(axis.x * s, axis.y * s, axis.z * s, std::cos(0.5f * radians));
+}
+
+inline Quat operator*(const Quat& a, const Quat& b) {
+#ifdef GAMMA_MATH_SSE2
+  // a.w * b + a.x * (b.w, -b.z, b.y, -b.x) + a.y * (b.z, b.w, -b.x, -b.y) +
+  // a.z * (-b.y, b.x, b.w, -b.z)
+  using y_internal::Swizzle;
+  __m128 lhs = y_internal::Load(a);
+  __m128 rhs = y_internal::Load(b);
+  __m128 sum = _mm_mul_ps(Swizzle<3, 3, 3, 3>(lhs), rhs);
+  __m128 x = _mm_mul_ps(Swizzle<0, 0, 0, 0>(lhs), Swizzle<3, 2, 1, 0>(rhs));
+  __m128 y = _mm_mul_ps(Swizzle<1, 1, 1, 1>(lhs), Swizzle<2, 3, 0, 1>(rhs));
+  __m128 z = _mm_mul_ps(Swizzle<2, 2, 2, 2>(lhs), Swizzle<1, 0, 3, 2>(rhs));
+  sum = _mm_add_ps(sum, _mm_xor_ps(x, _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f)));
+  sum = _mm_add_ps(sum, _mm_xor_ps(y, _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f)));
+  sum = _mm_add_ps(sum, _mm_xor_ps(z, _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f)));
+  return y_internal::Store<Quat>(sum);
+#else
+  return Quat(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+              a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+              a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+              a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+#endif
+}
+
+inline Vec3 operator*(const Quat& q, const Vec3& v) {
+  // v + 2 w (u x v) + 2 u x (u x v), with u the vector part of q.
+  Vec3 u(q.x, q.y, q.z);
+  Vec3 t = 2.0f * Cross(u, v);
+  return v + q.w * t + Cross(u, t);
+}
+
+inline float Dot(const Quat& a, const Quat& b) {
+  return Dot(Vec4(a.x, a.y, a.z, a.w), Vec4(b.x, b.y, b.z, b.w));
+}
+
+inline float Length(const Quat& q) { return std::sqrt(Dot(q, q)); }
+
+inline Quat Normalize(const Quat& q) {
+  float s = 1.0f / Length(q);
+  return Quat(q.x * s, q.y * s, q.z * s, q.w * s);
+}
+
+inline Quat Conjugate(const Quat& q) { return Quat(-q.x, -q.y, -q.z, q.w); }
+
+inline Quat Inverse(const Quat& q) {
+  Quat c = Conjugate(q);
+  float s = 1.0f / Dot(q, q);
+  return Quat(c.x * s, c.y * s, c.z * s, c.w * s);
+}
+
+inline Mat4 RotationMatrix(const Quat& q) {
+  float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+  float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+  float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+  return Mat4(Vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz),
+                   2.0f * (xz - wy), 0.0f),
+              Vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz),
+                   2.0f * (yz + wx), 0.0f),
+              Vec4(2.0f * (xz + wy), 2.0f * (yz - wx),
+                   1.0f - 2.0f * (xx + yy), 0.0f),
+              Vec4(0.0f, 0.0f, 0.0f, 1.0f));
+}
+
+}  // namespace y
+#endif  // GAMMA_MATH_QUAT_HPP_
@@ -0,0 +1,78 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/quat.hpp"
+
+#include <cmath>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+constexpr float kPi = 3.14159265f;
+
+void ExpectVec3Near(const Vec3& actual, const Vec3& expected) {
+  EXPECT_NEAR(actual.x, expected.x, 1e-5f);
+  EXPECT_NEAR(actual.y, expected.y, 1e-5f);
+  EXPECT_NEAR(actual.z, expected.z, 1e-5f);
+}
+
+TEST(QuatTest, RotatesVectors) {
+  Quat q = AngleAxis(0.5f * kPi, Vec3(0, 0, 1));
+  ExpectVec3Near(q * Vec3(1, 0, 0), Vec3(0, 1, 0));
+  ExpectVec3Near(q * Vec3(0, 0, 2), Vec3(0, 0, 2));
+  ExpectVec3Near(Quat::Identity() * Vec3(1, 2, 3), Vec3(1, 2, 3));
+  ExpectVec3Near(Inverse(q) * (q * Vec3(1, 2, 3)), Vec3(1, 2, 3));
+}
+
+TEST(QuatTest, ComposesRightToLeft) {
+  Quat a = AngleAxis(0.3f, Normalize(Vec3(1, 2, 3)));
+  Quat b = AngleAxis(-1.2f, Normalize(Vec3(-2, 0.5f, 1)));
+  Vec3 v(0.5f, -1, 2);
+  ExpectVec3Near((a * b) * v, a * (b * v));
+
+  Quat ab = a * b;
+  EXPECT_NEAR(ab.x, a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y, 1e-6f);
+  EXPECT_NEAR(ab.y, a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x, 1e-6f);
+  EXPECT_NEAR(ab.z, a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w, 1e-6f);
+  EXPECT_NEAR(ab.w, a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z, 1e-6f);
+  EXPECT_NEAR(Length(ab), 1, 1e-6f);
+}
+
+TEST(QuatTest, NormalizeAndInverse) {
+  Quat q = Normalize(Quat(1, 2, 3, 4));
+  EXPECT_NEAR(Length(q), 1, 1e-6f);
+  Quat identity = q * Inverse(q);
+  EXPECT_NEAR(identity.x, 0, 1e-6f);
+  EXPECT_NEAR(identity.w, 1, 1e-6f);
+  Quat c = Conjugate(q);
+  EXPECT_EQ(c.x, -q.x);
+  EXPECT_EQ(c.w, q.w);
+}
+
+TEST(QuatTest, RotationMatrixMatchesRotation) {
+  Quat q = AngleAxis(2.0f, Normalize(Vec3(1, -1, 0.5f)));
+  Mat4 m = RotationMatrix(q);
+  Vec3 v(3, -2, 1);
+  ExpectVec3Near(TransformVector(m, v), q * v);
+  ExpectVec3Near(TransformPoint(m, v), q * v);
+}
+
+}  // namespace
+}  // namespace y
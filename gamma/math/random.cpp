@@ -0,0 +1,103 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/random.hpp"
+
+#include "gamma/common/log.hpp"
+
+#define GAMMA_MATH_KERNEL_TARGET
+#include "gamma/math/random_kernels.hpp"
+
+namespace y_internal {
+
+template <>
+RandomKernels MakeKernels<RandomKernels, y::SimdLevel::kScalar>() {
+  return y::MakeRandomKernels<y::Float1>();
+}
+
+const RandomKernels& GetRandomKernels(y::SimdLevel level) {
+  return GetKernels<RandomKernels>(level);
+}
+
+}  // namespace y_internal
+
+namespace y {
+namespace {
+
+using y_internal::ActiveKernels;
+using y_internal::RandomKernels;
+
+// Coefficients of the jump polynomials for 2^64 and 2^96 steps, from the
+// reference implementation.
+constexpr uint32_t kJump[] = {0x8764000b, 0xf542d2d3, 0x6fa035c3,
+                              0x77f2db5b};
+constexpr uint32_t kLongJump[] = {0xb523952e, 0x0b6f099f, 0xccf5a0ef,
+                                  0x1c580662};
+
+}  // namespace
+
+void Xoshiro128::jump() { jump(kJump); }
+
+void Xoshiro128::longJump() { jump(kLongJump); }
+
+// The state after the jump is a sum of the states after each step with a set
+// bit in the polynomial.
+void Xoshiro128::jump(const uint32_t (&polynomial)[4]) {
+  uint32_t s[4] = {0, 0, 0, 0};
+  for (uint32_t word : polynomial) {
+    for (int b = 0; b < 32; ++b) {
+      if (word & (1u << b)) {
+        for (int k = 0; k < 4; ++k) s[k] ^= s_[k];
+      }
+      (*this)();
+    }
+  }
+  for (int k = 0; k < 4; ++k) s_[k] = s[k];
+}
+
+Xoshiro128x8::Xoshiro128x8(uint64_t seed) {
+  Xoshiro128 rng(seed);
+  for (int lane = 0; lane < kLanes; ++lane) {
+    for (int k = 0; k < 4; ++k) s_[k][lane] = rng.s_[k];
+    rng.jump();
+  }
+}
+
+void Xoshiro128x8::longJump() {
+  for (int lane = 0; lane < kLanes; ++lane) {
+    Xoshiro128 rng;
+    for (int k = 0; k < 4; ++k) rng.s_[k] = s_[k][lane];
+    rng.longJump();
+    for (int k = 0; k < 4; ++k) s_[k][lane] = rng.s_[k];
+  }
+}
+
+void Xoshiro128x8::fill(absl::Span<uint32_t> out) {
+  ActiveKernels<RandomKernels>().fill(&s_, out.data(), out.size());
+}
+
+void Xoshiro128x8::fillUniform(absl::Span<float> out, float lo, float hi) {
+  ActiveKernels<RandomKernels>().fill_uniform(&s_, lo, hi, out.data(),
+                                              out.size());
+}
+
+void Xoshiro128x8::fillUnitVectors(Vec3Soa out) {
+  ActiveKernels<RandomKernels>().fill_unit_vectors(&s_, out);
+}
+
+}  // namespace y
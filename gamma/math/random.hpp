@@ -0,0 +1,171 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_RANDOM_HPP_
+#define GAMMA_MATH_RANDOM_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/types/span.h"
+#include "gamma/math/approx.hpp"
+#include "gamma/math/cpu.hpp"
+#include "gamma/math/soa.hpp"
+#include "gamma/math/vec.hpp"
+
+namespace y {
+
+// The xoshiro128++ generator of Blackman and Vigna: 32-bit outputs from 128
+// bits of state, with period 2^128 - 1. Much faster than std::mt19937, and
+// like it a UniformRandomBitGenerator, so it also drives the distributions of
+// <random>. Not for cryptography.
+class Xoshiro128 {
+ public:
+  using result_type = uint32_t;
+
+  // The state is expanded from `seed` with SplitMix64, so that nearby seeds
+  // give unrelated sequences.
+  explicit Xoshiro128(uint64_t seed = 0);
+
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() { return 0xffffffff; }
+  result_type operator()();
+
+  // Uniform in [lo, hi], in 2^24 steps; hi is only reached by rounding.
+  float uniform(float lo = 0, float hi = 1);
+  // Uniform on the unit sphere, with length within 1e-6 of 1.
+  Vec3 unitVector();
+
+  // Advance by 2^64 outputs. Giving each thread a copy jumped once more than
+  // the last gives each its own 2^64 outputs.
+  void jump();
+  // Advance by 2^96 outputs, for streams that are split again by `jump()`.
+  void longJump();
+
+ private:
+  friend class Xoshiro128x8;
+
+  void jump(const uint32_t (&polynomial)[4]);
+
+  uint32_t s_[4];
+};
+
+// Eight xoshiro128++ generators run side by side in SIMD lanes. Generator i
+// starts where Xoshiro128(seed) is after i jumps, so they never overlap. Fills
+// interleave them: element 8 * j + i is output j of generator i, and a last
+// partial row advances only the first generators. Lanes are generated 8 or 4
+// at a time as `ActiveSimdLevel()` allows, with the same results.
+class Xoshiro128x8 {
+ public:
+  static constexpr int kLanes = 8;
+
+  explicit Xoshiro128x8(uint64_t seed = 0);
+
+  // Advance every generator by 2^96 outputs, as Xoshiro128::longJump(). Each
+  // thread can take a copy long jumped once more than the last.
+  void longJump();
+
+  // Uniform bits.
+  void fill(absl::Span<uint32_t> out);
+  // As Xoshiro128::uniform().
+  void fillUniform(absl::Span<float> out, float lo = 0, float hi = 1);
+  // As Xoshiro128::unitVector(), each from two outputs of one generator.
+  void fillUnitVectors(Vec3Soa out);
+
+ private:
+  alignas(32) uint32_t s_[4][kLanes];
+};
+
+}  // namespace y
+
+namespace y_internal {
+
+// The states of the generators of a `Xoshiro128x8`, one row per word.
+using RandomState = uint32_t[4][y::Xoshiro128x8::kLanes];
+
+// The kernels compiled for one instruction set.
+struct RandomKernels {
+  void (*fill)(RandomState* state, uint32_t* out, size_t n);
+  void (*fill_uniform)(RandomState* state, float lo, float hi, float* out,
+                       size_t n);
+  void (*fill_unit_vectors)(RandomState* state, const y::Vec3Soa& out);
+};
+
+// Kernels for `level`, which must be no wider than `DetectSimdLevel()`.
+const RandomKernels& GetRandomKernels(y::SimdLevel level);
+
+}  // namespace y_internal
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+namespace y_internal {
+
+// From Vigna's reference implementation, for seeding.
+inline uint64_t SplitMix64(uint64_t* state) {
+  uint64_t z = (*state += 0x9e3779b97f4a7c15);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+inline uint32_t RotateLeft(uint32_t x, int k) {
+  return (x << k) | (x >> (32 - k));
+}
+
+}  // namespace y_internal
+
+namespace y {
+
+inline Xoshiro128::Xoshiro128(uint64_t seed) {
+  for (int i = 0; i < 4; i += 2) {
+    uint64_t bits = y_internal::SplitMix64(&seed);
+    s_[i] = static_cast<uint32_t>(bits);
+    s_[i + 1] = static_cast<uint32_t>(bits >> 32);
+  }
+}
+
+inline uint32_t Xoshiro128::operator()() {
+  uint32_t result = y_internal::RotateLeft(s_[0] + s_[3], 7) + s_[0];
+  uint32_t t = s_[1] << 9;
+  s_[2] ^= s_[0];
+  s_[3] ^= s_[1];
+  s_[1] ^= s_[2];
+  s_[0] ^= s_[3];
+  s_[2] ^= t;
+  s_[3] = y_internal::RotateLeft(s_[3], 11);
+  return result;
+}
+
+inline float Xoshiro128::uniform(float lo, float hi) {
+  float u = static_cast<float>((*this)() >> 8) * (1.0f / (1 << 24));
+  return lo + (hi - lo) * u;
+}
+
+// Archimedes: z is uniform in [-1, 1] on the unit sphere.
+inline Vec3 Xoshiro128::unitVector() {
+  float z = uniform(1, -1);
+  float phi = uniform(0, 2 * y_internal::kPi);
+  float r = std::sqrt(std::max(0.0f, 1 - z * z));
+  return Vec3(r * FastCos(phi), r * FastSin(phi), z);
+}
+
+}  // namespace y
+#endif  // GAMMA_MATH_RANDOM_HPP_
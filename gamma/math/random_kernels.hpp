@@ -0,0 +1,168 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_RANDOM_KERNELS_HPP_
+#define GAMMA_MATH_RANDOM_KERNELS_HPP_
+
+// Generator kernels as templates over a lane type; see lanes.hpp.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "gamma/math/approx_kernels.hpp"
+#include "gamma/math/dispatch.hpp"
+#include "gamma/math/lanes.hpp"
+#include "gamma/math/random.hpp"
+
+namespace y_internal {
+
+// Defined in kernels_*.cpp.
+template <>
+RandomKernels MakeKernels<RandomKernels, y::SimdLevel::kSse42>();
+template <>
+RandomKernels MakeKernels<RandomKernels, y::SimdLevel::kAvx2>();
+template <>
+RandomKernels MakeKernels<RandomKernels, y::SimdLevel::kAvx512>();
+
+}  // namespace y_internal
+
+namespace y {
+namespace {
+
+using y_internal::RandomState;
+
+constexpr size_t kRandomLanes = Xoshiro128x8::kLanes;
+
+template <int k, typename U>
+GAMMA_MATH_KERNEL_TARGET inline U RotateLeft(U x) {
+  return ShiftLeft<k>(x) | ShiftRight<32 - k>(x);
+}
+
+// One step of xoshiro128++ in every lane, as Xoshiro128::operator().
+template <typename U>
+GAMMA_MATH_KERNEL_TARGET inline U NextBits(U s[4]) {
+  U result = RotateLeft<7>(s[0] + s[3]) + s[0];
+  U t = ShiftLeft<9>(s[1]);
+  s[2] = s[2] ^ s[0];
+  s[3] = s[3] ^ s[1];
+  s[1] = s[1] ^ s[2];
+  s[0] = s[0] ^ s[3];
+  s[2] = s[2] ^ t;
+  s[3] = RotateLeft<11>(s[3]);
+  return result;
+}
+
+// Each op steps the generators `s` of one group of `F::kWidth` lanes and
+// stores what they give for elements `e` onward.
+
+struct BitsOp {
+  template <typename F>
+  GAMMA_MATH_KERNEL_TARGET void run(typename F::Bits s[4], size_t e) const {
+    NextBits(s).store(out + e);
+  }
+  uint32_t* out;
+};
+
+struct UniformOp {
+  template <typename F>
+  GAMMA_MATH_KERNEL_TARGET void run(typename F::Bits s[4], size_t e) const {
+    MulAdd(UnitFloat(NextBits(s)), F::Splat(hi - lo), F::Splat(lo))
+        .store(out + e);
+  }
+  float lo;
+  float hi;
+  float* out;
+};
+
+struct UnitVectorOp {
+  template <typename F>
+  GAMMA_MATH_KERNEL_TARGET void run(typename F::Bits s[4], size_t e) const {
+    F z = MulAdd(UnitFloat(NextBits(s)), F::Splat(-2.0f), F::Splat(1.0f));
+    F phi = UnitFloat(NextBits(s)) * F::Splat(2 * y_internal::kPi);
+    F r = ApproxSqrt(Max(F::Splat(1.0f) - z * z, F::Splat(0.0f)));
+    (r * ApproxCos(phi)).store((*out)[0] + e);
+    (r * ApproxSin(phi)).store((*out)[1] + e);
+    z.store((*out)[2] + e);
+  }
+  const Vec3Soa* out;
+};
+
+// Runs `op` on rows [first_row, end_row) of the generators in lanes
+// [first_lane, end_lane), `F::kWidth` lanes at a time with their state held
+// in registers.
+template <typename F, typename Op>
+GAMMA_MATH_KERNEL_TARGET inline void GenerateLanes(RandomState* state,
+                                                   size_t first_lane,
+                                                   size_t end_lane,
+                                                   size_t first_row,
+                                                   size_t end_row,
+                                                   const Op& op) {
+  static_assert(kRandomLanes % F::kWidth == 0, "lanes must divide the rows");
+  using U = typename F::Bits;
+  for (size_t lane = first_lane; lane + F::kWidth <= end_lane;
+       lane += F::kWidth) {
+    U s[4];
+    for (int k = 0; k < 4; ++k) s[k] = U::Load((*state)[k] + lane);
+    for (size_t row = first_row; row < end_row; ++row) {
+      op.template run<F>(s, kRandomLanes * row + lane);
+    }
+    for (int k = 0; k < 4; ++k) s[k].store((*state)[k] + lane);
+  }
+}
+
+// Whole rows of `F::kWidth` lanes at a time, then the last, partial row one
+// lane at a time.
+template <typename F, typename Op>
+GAMMA_MATH_KERNEL_TARGET inline void Generate(RandomState* state, size_t n,
+                                              const Op& op) {
+  size_t rows = n / kRandomLanes;
+  GenerateLanes<F>(state, 0, kRandomLanes, 0, rows, op);
+  GenerateLanes<Float1>(state, 0, n % kRandomLanes, rows, rows + 1, op);
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline void FillBatch(RandomState* state,
+                                               uint32_t* out, size_t n) {
+  Generate<F>(state, n, BitsOp{out});
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline void FillUniformBatch(RandomState* state,
+                                                      float lo, float hi,
+                                                      float* out, size_t n) {
+  Generate<F>(state, n, UniformOp{lo, hi, out});
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline void FillUnitVectorsBatch(RandomState* state,
+                                                          const Vec3Soa& out) {
+  Generate<F>(state, out.size, UnitVectorOp{&out});
+}
+
+template <typename F>
+y_internal::RandomKernels MakeRandomKernels() {
+  y_internal::RandomKernels kernels;
+  kernels.fill = &FillBatch<F>;
+  kernels.fill_uniform = &FillUniformBatch<F>;
+  kernels.fill_unit_vectors = &FillUnitVectorsBatch<F>;
+  return kernels;
+}
+
+}  // namespace
+}  // namespace y
+#endif  // GAMMA_MATH_RANDOM_KERNELS_HPP_
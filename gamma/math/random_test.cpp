@@ -0,0 +1,305 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/random.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+// xoshiro128++ as in the reference implementation, on an explicit state.
+struct State {
+  uint32_t s[4];
+};
+
+uint32_t Rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+uint32_t Next(State* state) {
+  uint32_t* s = state->s;
+  const uint32_t result = Rotl(s[0] + s[3], 7) + s[0];
+  const uint32_t t = s[1] << 9;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = Rotl(s[3], 11);
+  return result;
+}
+
+// The state `Xoshiro128(seed)` starts from.
+State SeedState(uint64_t seed) {
+  State state;
+  for (int i = 0; i < 4; i += 2) {
+    uint64_t bits = y_internal::SplitMix64(&seed);
+    state.s[i] = static_cast<uint32_t>(bits);
+    state.s[i + 1] = static_cast<uint32_t>(bits >> 32);
+  }
+  return state;
+}
+
+TEST(RandomTest, MatchesReference) {
+  for (uint64_t seed : {0, 1, 2, 12345}) {
+    Xoshiro128 rng(seed);
+    State state = SeedState(seed);
+    for (int i = 0; i < 100; ++i) ASSERT_EQ(rng(), Next(&state)) << i;
+  }
+}
+
+// A step of the generator is linear over GF(2), so a matrix with the states
+// that one step takes each bit to as its columns, squared n times, takes
+// 2^n steps. The jumps must agree with it.
+class StepMatrix {
+ public:
+  StepMatrix() {
+    for (int i = 0; i < 128; ++i) {
+      State state = {{0, 0, 0, 0}};
+      state.s[i / 32] = 1u << (i % 32);
+      Next(&state);
+      columns_[i] = state;
+    }
+  }
+
+  State apply(const State& state) const {
+    State result = {{0, 0, 0, 0}};
+    for (int i = 0; i < 128; ++i) {
+      if (state.s[i / 32] & (1u << (i % 32))) {
+        for (int k = 0; k < 4; ++k) result.s[k] ^= columns_[i].s[k];
+      }
+    }
+    return result;
+  }
+
+  void square() {
+    State columns[128];
+    for (int i = 0; i < 128; ++i) columns[i] = apply(columns_[i]);
+    std::copy(columns, columns + 128, columns_);
+  }
+
+ private:
+  State columns_[128];
+};
+
+TEST(RandomTest, JumpsMatchRepeatedSquaring) {
+  StepMatrix matrix;
+  for (int i = 0; i < 64; ++i) matrix.square();
+  State jumped = matrix.apply(SeedState(7));
+  for (int i = 64; i < 96; ++i) matrix.square();
+  State long_jumped = matrix.apply(SeedState(7));
+
+  Xoshiro128 rng(7);
+  rng.jump();
+  for (int i = 0; i < 10; ++i) EXPECT_EQ(rng(), Next(&jumped)) << i;
+  rng = Xoshiro128(7);
+  rng.longJump();
+  for (int i = 0; i < 10; ++i) EXPECT_EQ(rng(), Next(&long_jumped)) << i;
+}
+
+// Arbitrary states for each lane of a `Xoshiro128x8`.
+void SeedLanes(y_internal::RandomState* lanes, State* states) {
+  for (int lane = 0; lane < 8; ++lane) {
+    states[lane] = SeedState(100 + lane);
+    for (int k = 0; k < 4; ++k) (*lanes)[k][lane] = states[lane].s[k];
+  }
+}
+
+const size_t kSizes[] = {0, 1, 7, 8, 9, 40, 43};
+
+TEST(RandomTest, KernelsInterleaveLanes) {
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    const y_internal::RandomKernels& kernels =
+        y_internal::GetRandomKernels(level);
+    y_internal::RandomState lanes;
+    State states[8];
+    SeedLanes(&lanes, states);
+    // Twice, so that the second fill continues where the partial row left
+    // each generator.
+    for (int pass = 0; pass < 2; ++pass) {
+      for (size_t n : kSizes) {
+        std::vector<uint32_t> out(n);
+        kernels.fill(&lanes, out.data(), n);
+        for (size_t e = 0; e < n; ++e) {
+          ASSERT_EQ(out[e], Next(&states[e % 8])) << n << " " << e;
+        }
+      }
+    }
+    std::vector<float> floats(43);
+    kernels.fill_uniform(&lanes, -2, 6, floats.data(), floats.size());
+    for (size_t e = 0; e < floats.size(); ++e) {
+      float u = static_cast<float>(Next(&states[e % 8]) >> 8) / (1 << 24);
+      EXPECT_FLOAT_EQ(floats[e], -2 + 8 * u) << e;
+    }
+  }
+}
+
+TEST(RandomTest, GeneratorsAreJumpsApart) {
+  Xoshiro128x8 lanes(3);
+  std::vector<Xoshiro128> rngs(1, Xoshiro128(3));
+  for (int lane = 1; lane < 8; ++lane) {
+    rngs.push_back(rngs.back());
+    rngs.back().jump();
+  }
+  std::vector<uint32_t> out(8 * 10);
+  lanes.fill(absl::MakeSpan(out));
+  for (size_t e = 0; e < out.size(); ++e) {
+    ASSERT_EQ(out[e], rngs[e % 8]()) << e;
+  }
+
+  lanes.longJump();
+  for (Xoshiro128& rng : rngs) rng.longJump();
+  lanes.fill(absl::MakeSpan(out));
+  for (size_t e = 0; e < out.size(); ++e) {
+    ASSERT_EQ(out[e], rngs[e % 8]()) << e;
+  }
+}
+
+// Statistical sanity checks, with bounds about six standard deviations out.
+
+constexpr int kSamples = 100000;
+
+void CheckUniform(const std::vector<float>& samples) {
+  const int kBins = 64;
+  std::vector<int> bins(kBins);
+  double sum = 0, sum2 = 0;
+  for (float u : samples) {
+    ASSERT_GE(u, 0);
+    ASSERT_LT(u, 1);
+    ++bins[static_cast<int>(u * kBins)];
+    sum += u;
+    sum2 += u * u;
+  }
+  double n = samples.size();
+  EXPECT_NEAR(sum / n, 0.5, 0.006);
+  EXPECT_NEAR(sum2 / n - (sum / n) * (sum / n), 1.0 / 12, 0.002);
+  double expected = n / kBins;
+  double chi2 = 0;
+  for (int count : bins) {
+    chi2 += (count - expected) * (count - expected) / expected;
+  }
+  // 63 degrees of freedom.
+  EXPECT_LT(chi2, 130);
+}
+
+TEST(RandomTest, UniformFloatsAreUniform) {
+  Xoshiro128 rng(11);
+  std::vector<float> samples;
+  for (int i = 0; i < kSamples; ++i) samples.push_back(rng.uniform());
+  CheckUniform(samples);
+
+  Xoshiro128x8 lanes(11);
+  lanes.fillUniform(absl::MakeSpan(samples));
+  CheckUniform(samples);
+
+  for (int i = 0; i < 1000; ++i) {
+    float x = rng.uniform(-3, 5);
+    EXPECT_GE(x, -3);
+    EXPECT_LE(x, 5);
+  }
+}
+
+TEST(RandomTest, BitsAreBalanced) {
+  Xoshiro128x8 lanes(13);
+  std::vector<uint32_t> samples(kSamples);
+  lanes.fill(absl::MakeSpan(samples));
+  for (int b = 0; b < 32; ++b) {
+    int ones = 0;
+    for (uint32_t x : samples) ones += (x >> b) & 1;
+    EXPECT_NEAR(ones, kSamples / 2, 0.01 * kSamples) << b;
+  }
+  // Successive outputs of a generator, and neighboring generators, should
+  // not be correlated.
+  for (size_t offset : {1, 8}) {
+    double sum = 0;
+    for (size_t e = offset; e < samples.size(); ++e) {
+      sum += (samples[e] / 4294967296.0 - 0.5) *
+             (samples[e - offset] / 4294967296.0 - 0.5);
+    }
+    EXPECT_NEAR(sum / (samples.size() - offset), 0, 0.002) << offset;
+  }
+}
+
+void CheckUnitVectors(const std::vector<Vec3>& vectors) {
+  Vec3 mean(0, 0, 0);
+  float z2 = 0;
+  for (const Vec3& v : vectors) {
+    ASSERT_NEAR(Length(v), 1, 1e-6f);
+    mean = mean + v;
+    z2 += v.z * v.z;
+  }
+  mean = mean / static_cast<float>(vectors.size());
+  EXPECT_LT(Length(mean), 0.01f);
+  // Each coordinate of a uniform unit vector has variance 1/3.
+  EXPECT_NEAR(z2 / vectors.size(), 1.0f / 3, 0.006);
+}
+
+TEST(RandomTest, UnitVectorsAreUniform) {
+  Xoshiro128 rng(17);
+  std::vector<Vec3> vectors;
+  for (int i = 0; i < kSamples; ++i) vectors.push_back(rng.unitVector());
+  CheckUnitVectors(vectors);
+
+  std::vector<float> arrays[3];
+  for (std::vector<float>& a : arrays) a.resize(kSamples);
+  Vec3Soa out({arrays[0].data(), arrays[1].data(), arrays[2].data()},
+              kSamples);
+  Xoshiro128x8(17).fillUnitVectors(out);
+  for (int i = 0; i < kSamples; ++i) {
+    vectors[i] = Vec3(arrays[0][i], arrays[1][i], arrays[2][i]);
+  }
+  CheckUnitVectors(vectors);
+}
+
+TEST(RandomTest, UnitVectorsAgreeAcrossLevels) {
+  std::vector<float> expected[3];
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    y_internal::RandomState lanes;
+    State states[8];
+    SeedLanes(&lanes, states);
+    std::vector<float> arrays[3];
+    for (std::vector<float>& a : arrays) a.resize(43);
+    Vec3Soa out({arrays[0].data(), arrays[1].data(), arrays[2].data()}, 43);
+    y_internal::GetRandomKernels(level).fill_unit_vectors(&lanes, out);
+    if (level == SimdLevel::kScalar) {
+      for (int k = 0; k < 3; ++k) expected[k] = arrays[k];
+    }
+    for (int k = 0; k < 3; ++k) {
+      for (size_t e = 0; e < 43; ++e) {
+        EXPECT_NEAR(arrays[k][e], expected[k][e], 1e-6f) << k << " " << e;
+      }
+    }
+  }
+}
+
+TEST(RandomTest, DrivesStandardDistributions) {
+  Xoshiro128 rng(19);
+  std::uniform_int_distribution<int> dice(1, 6);
+  int counts[7] = {};
+  for (int i = 0; i < 6000; ++i) ++counts[dice(rng)];
+  EXPECT_EQ(counts[0], 0);
+  for (int face = 1; face <= 6; ++face) EXPECT_NEAR(counts[face], 1000, 200);
+}
+
+}  // namespace
+}  // namespace y
@@ -0,0 +1,63 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/raycast.hpp"
+
+#include "gamma/common/log.hpp"
+
+#define GAMMA_MATH_KERNEL_TARGET
+#include "gamma/math/raycast_kernels.hpp"
+
+namespace y_internal {
+
+template <>
+RaycastKernels MakeKernels<RaycastKernels, y::SimdLevel::kScalar>() {
+  return y::MakeRaycastKernels<y::Float1>();
+}
+
+const RaycastKernels& GetRaycastKernels(y::SimdLevel level) {
+  return GetKernels<RaycastKernels>(level);
+}
+
+}  // namespace y_internal
+
+namespace y {
+namespace {
+
+using y_internal::ActiveKernels;
+using y_internal::RaycastKernels;
+
+}  // namespace
+
+void IntersectAabbs(const Ray& ray, AabbSoa boxes, float max_t,
+                    absl::Span<float> distances) {
+  YERR_IF(distances.size() != boxes.size) << "mismatched batch sizes";
+  ActiveKernels<RaycastKernels>().intersect_aabbs(ray, boxes, max_t,
+                                                  distances.data());
+}
+
+RayHit RaycastAabbs(const Ray& ray, AabbSoa boxes, float max_t) {
+  return ActiveKernels<RaycastKernels>().raycast_aabbs(ray, boxes, max_t);
+}
+
+RayHit RaycastTriangles(const Ray& ray, TriangleSoa triangles, float max_t) {
+  return ActiveKernels<RaycastKernels>().raycast_triangles(ray, triangles,
+                                                           max_t);
+}
+
+}  // namespace y
@@ -0,0 +1,93 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_RAYCAST_HPP_
+#define GAMMA_MATH_RAYCAST_HPP_
+
+#include <cstdint>
+#include <limits>
+
+#include "absl/types/span.h"
+#include "gamma/math/cpu.hpp"
+#include "gamma/math/soa.hpp"
+#include "gamma/math/vec.hpp"
+
+namespace y {
+
+// The points origin + t * direction for t >= 0. `direction` need not be unit
+// length; t measures distance in multiples of its length.
+struct Ray {
+  Vec3 origin;
+  Vec3 direction;
+};
+
+// `RayHit::index` when nothing is hit.
+constexpr uint32_t kNoHit = 0xffffffff;
+
+// The first object hit by a ray, at origin + t * direction. On a triangle
+// with vertices v0, v1 and v2, that point is also
+// (1 - u - v) * v0 + u * v1 + v * v2; `u` and `v` are 0 for boxes.
+struct RayHit {
+  uint32_t index;
+  float t;
+  float u;
+  float v;
+};
+
+// Set `distances[i]` to the t at which `ray` enters box i, 0 if it starts
+// inside, or infinity if it misses the box or enters beyond `max_t`. A BVH
+// visits the children whose distance is finite, nearest first, with `max_t`
+// the t of the closest hit found so far. A ray lying in the plane of a face
+// may hit or miss the box.
+void IntersectAabbs(const Ray& ray, AabbSoa boxes, float max_t,
+                    absl::Span<float> distances);
+
+// The box or triangle that `ray` hits first, with t in [0, max_t], or a hit
+// with index `kNoHit` and t `max_t`. Of objects hit at the same t, the one
+// with the lowest index wins. Triangles are hit from either side, unless the
+// ray lies in their plane.
+RayHit RaycastAabbs(const Ray& ray, AabbSoa boxes,
+                    float max_t = std::numeric_limits<float>::infinity());
+RayHit RaycastTriangles(const Ray& ray, TriangleSoa triangles,
+                        float max_t = std::numeric_limits<float>::infinity());
+
+// Boxes are tested 8 or 4 at a time, so that the 8 children of a BVH node
+// take one AVX2 test, and triangles 16, 8 or 4 at a time, as
+// `ActiveSimdLevel()` allows. Groups that hit nothing closer than the closest
+// hit so far cost no more than the test itself.
+
+}  // namespace y
+
+namespace y_internal {
+
+// The kernels compiled for one instruction set, without size checks.
+struct RaycastKernels {
+  void (*intersect_aabbs)(const y::Ray& ray, const y::AabbSoa& boxes,
+                          float max_t, float* distances);
+  y::RayHit (*raycast_aabbs)(const y::Ray& ray, const y::AabbSoa& boxes,
+                             float max_t);
+  y::RayHit (*raycast_triangles)(const y::Ray& ray,
+                                 const y::TriangleSoa& triangles,
+                                 float max_t);
+};
+
+// Kernels for `level`, which must be no wider than `DetectSimdLevel()`.
+const RaycastKernels& GetRaycastKernels(y::SimdLevel level);
+
+}  // namespace y_internal
+#endif  // GAMMA_MATH_RAYCAST_HPP_
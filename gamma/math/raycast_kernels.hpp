@@ -0,0 +1,239 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_RAYCAST_KERNELS_HPP_
+#define GAMMA_MATH_RAYCAST_KERNELS_HPP_
+
+// Ray intersection kernels as templates over a lane type; see lanes.hpp.
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "gamma/math/dispatch.hpp"
+#include "gamma/math/lanes.hpp"
+#include "gamma/math/raycast.hpp"
+
+namespace y_internal {
+
+// Defined in kernels_*.cpp.
+template <>
+RaycastKernels MakeKernels<RaycastKernels, y::SimdLevel::kSse42>();
+template <>
+RaycastKernels MakeKernels<RaycastKernels, y::SimdLevel::kAvx2>();
+template <>
+RaycastKernels MakeKernels<RaycastKernels, y::SimdLevel::kAvx512>();
+
+}  // namespace y_internal
+
+namespace y {
+namespace {
+
+// A ray in every lane, with the reciprocal of its direction for slab tests.
+template <typename F>
+struct RayLanes {
+  F origin[3];
+  F direction[3];
+  F inverse[3];
+};
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline RayLanes<F> SplatRay(const Ray& ray) {
+  RayLanes<F> lanes;
+  for (int k = 0; k < 3; ++k) {
+    lanes.origin[k] = F::Splat(ray.origin[k]);
+    lanes.direction[k] = F::Splat(ray.direction[k]);
+    lanes.inverse[k] = F::Splat(1 / ray.direction[k]);
+  }
+  return lanes;
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline F Dot(const F a[3], const F b[3]) {
+  return MulAdd(a[2], b[2], MulAdd(a[1], b[1], a[0] * b[0]));
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline void Cross(const F a[3], const F b[3],
+                                           F out[3]) {
+  out[0] = a[1] * b[2] - a[2] * b[1];
+  out[1] = a[2] * b[0] - a[0] * b[2];
+  out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// Whether the ray overlaps each box for some t in [0, max_t], and the first
+// such t. An axis the ray is parallel to gives infinite t outside the slab
+// and NaN on its planes, which Min and Max pass over.
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline typename F::Mask SlabTest(
+    const RayLanes<F>& ray, const F bounds[6], F max_t, F* entry) {
+  F near = F::Splat(0.0f);
+  F far = max_t;
+  for (int k = 0; k < 3; ++k) {
+    F t0 = (bounds[k] - ray.origin[k]) * ray.inverse[k];
+    F t1 = (bounds[3 + k] - ray.origin[k]) * ray.inverse[k];
+    near = Max(Min(t0, t1), near);
+    far = Min(Max(t0, t1), far);
+  }
+  *entry = near;
+  return GreaterEqual(far, near);
+}
+
+// Moves `*hit` to the closest of the lanes set in `hits`, which belong to the
+// group of objects from `first`. Only lanes hit no further than `hit->t` may
+// be set, so most groups return after `StoreSelected`.
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline void UpdateClosest(typename F::Mask hits,
+                                                   uint32_t first, F t, F u,
+                                                   F v, RayHit* hit) {
+  uint32_t lanes[F::kWidth];
+  size_t count = StoreSelected(hits, 0, lanes);
+  if (count == 0) return;
+  float ts[F::kWidth], us[F::kWidth], vs[F::kWidth];
+  t.store(ts);
+  u.store(us);
+  v.store(vs);
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t lane = lanes[i];
+    if (hit->index == kNoHit || ts[lane] < hit->t) {
+      *hit = {first + lane, ts[lane], us[lane], vs[lane]};
+    }
+  }
+}
+
+// Each kernel tests objects from `begin` in whole groups of `F::kWidth`, and
+// returns the index of the first object left over.
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline size_t IntersectAabbsLanes(const Ray& ray,
+                                                           const AabbSoa& boxes,
+                                                           float max_t,
+                                                           float* distances,
+                                                           size_t begin) {
+  RayLanes<F> lanes = SplatRay<F>(ray);
+  const F far = F::Splat(max_t);
+  const F miss = F::Splat(std::numeric_limits<float>::infinity());
+  size_t n = boxes.size;
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    F bounds[6];
+    for (int k = 0; k < 6; ++k) bounds[k] = F::Load(boxes[k] + e);
+    F entry;
+    typename F::Mask hits = SlabTest(lanes, bounds, far, &entry);
+    Select(hits, entry, miss).store(distances + e);
+  }
+  return e;
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline size_t RaycastAabbsLanes(const Ray& ray,
+                                                         const AabbSoa& boxes,
+                                                         size_t begin,
+                                                         RayHit* hit) {
+  RayLanes<F> lanes = SplatRay<F>(ray);
+  const F zero = F::Splat(0.0f);
+  size_t n = boxes.size;
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    F bounds[6];
+    for (int k = 0; k < 6; ++k) bounds[k] = F::Load(boxes[k] + e);
+    F entry;
+    typename F::Mask hits =
+        SlabTest(lanes, bounds, F::Splat(hit->t), &entry);
+    UpdateClosest(hits, static_cast<uint32_t>(e), entry, zero, zero, hit);
+  }
+  return e;
+}
+
+// Moller and Trumbore, "Fast, Minimum Storage Ray/Triangle Intersection".
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline size_t RaycastTrianglesLanes(
+    const Ray& ray, const TriangleSoa& triangles, size_t begin, RayHit* hit) {
+  RayLanes<F> lanes = SplatRay<F>(ray);
+  const F zero = F::Splat(0.0f);
+  const F one = F::Splat(1.0f);
+  size_t n = triangles.size;
+  size_t e = begin;
+  for (; e + F::kWidth <= n; e += F::kWidth) {
+    F v0[3], edge1[3], edge2[3];
+    for (int k = 0; k < 3; ++k) {
+      v0[k] = F::Load(triangles[k] + e);
+      edge1[k] = F::Load(triangles[3 + k] + e) - v0[k];
+      edge2[k] = F::Load(triangles[6 + k] + e) - v0[k];
+    }
+    // A ray in the plane of the triangle has a zero determinant, which makes
+    // u infinite or NaN and so fails the tests below.
+    F p[3], q[3], s[3];
+    Cross(lanes.direction, edge2, p);
+    F inverse_det = one / Dot(edge1, p);
+    for (int k = 0; k < 3; ++k) s[k] = lanes.origin[k] - v0[k];
+    Cross(s, edge1, q);
+    F u = Dot(s, p) * inverse_det;
+    F v = Dot(lanes.direction, q) * inverse_det;
+    F t = Dot(edge2, q) * inverse_det;
+    typename F::Mask hits = GreaterEqual(u, zero) & GreaterEqual(v, zero) &
+                            GreaterEqual(one, u + v) &
+                            GreaterEqual(t, zero) &
+                            GreaterEqual(F::Splat(hit->t), t);
+    UpdateClosest(hits, static_cast<uint32_t>(e), t, u, v, hit);
+  }
+  return e;
+}
+
+// Whole kernels: groups of `F::kWidth`, then the rest one at a time.
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline void IntersectAabbsBatch(const Ray& ray,
+                                                         const AabbSoa& boxes,
+                                                         float max_t,
+                                                         float* distances) {
+  size_t e = IntersectAabbsLanes<F>(ray, boxes, max_t, distances, 0);
+  IntersectAabbsLanes<Float1>(ray, boxes, max_t, distances, e);
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline RayHit RaycastAabbsBatch(const Ray& ray,
+                                                         const AabbSoa& boxes,
+                                                         float max_t) {
+  RayHit hit = {kNoHit, max_t, 0, 0};
+  size_t e = RaycastAabbsLanes<F>(ray, boxes, 0, &hit);
+  RaycastAabbsLanes<Float1>(ray, boxes, e, &hit);
+  return hit;
+}
+
+template <typename F>
+GAMMA_MATH_KERNEL_TARGET inline RayHit RaycastTrianglesBatch(
+    const Ray& ray, const TriangleSoa& triangles, float max_t) {
+  RayHit hit = {kNoHit, max_t, 0, 0};
+  size_t e = RaycastTrianglesLanes<F>(ray, triangles, 0, &hit);
+  RaycastTrianglesLanes<Float1>(ray, triangles, e, &hit);
+  return hit;
+}
+
+template <typename F>
+y_internal::RaycastKernels MakeRaycastKernels() {
+  y_internal::RaycastKernels kernels;
+  kernels.intersect_aabbs = &IntersectAabbsBatch<F>;
+  kernels.raycast_aabbs = &RaycastAabbsBatch<F>;
+  kernels.raycast_triangles = &RaycastTrianglesBatch<F>;
+  return kernels;
+}
+
+}  // namespace
+}  // namespace y
+#endif  // GAMMA_MATH_RAYCAST_KERNELS_HPP_
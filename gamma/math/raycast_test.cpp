@@ -0,0 +1,341 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/raycast.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+// Objects of `N` floats each, stored as the SoA spans take them.
+template <int N>
+class Objects {
+ public:
+  Objects() : arrays_(N) {}
+
+  void add(const float (&values)[N]) {
+    for (int k = 0; k < N; ++k) arrays_[k].push_back(values[k]);
+  }
+  float get(size_t e, int k) const { return arrays_[k][e]; }
+
+  SoaSpan<N, const float> span() const {
+    const float* components[N];
+    for (int k = 0; k < N; ++k) components[k] = arrays_[k].data();
+    return SoaSpan<N, const float>(components, arrays_[0].size());
+  }
+
+ private:
+  std::vector<std::vector<float>> arrays_;
+};
+
+// Double precision references, returning whether the object is hit and
+// setting `*t` (and `*u`, `*v`) when it is.
+
+bool ReferenceAabb(const Ray& ray, const Objects<6>& boxes, size_t e,
+                   double max_t, double* t) {
+  double near = 0;
+  double far = max_t;
+  for (int k = 0; k < 3; ++k) {
+    double o = ray.origin[k];
+    double d = ray.direction[k];
+    double lo = boxes.get(e, k);
+    double hi = boxes.get(e, 3 + k);
+    if (d == 0) {
+      if (o < lo || o > hi) return false;
+      continue;
+    }
+    double t0 = (lo - o) / d;
+    double t1 = (hi - o) / d;
+    near = std::max(near, std::min(t0, t1));
+    far = std::min(far, std::max(t0, t1));
+  }
+  *t = near;
+  return near <= far;
+}
+
+bool ReferenceTriangle(const Ray& ray, const Objects<9>& triangles, size_t e,
+                       double max_t, double* t, double* u, double* v) {
+  double v0[3], edge1[3], edge2[3], o[3], d[3];
+  for (int k = 0; k < 3; ++k) {
+    v0[k] = triangles.get(e, k);
+    edge1[k] = triangles.get(e, 3 + k) - v0[k];
+    edge2[k] = triangles.get(e, 6 + k) - v0[k];
+    o[k] = ray.origin[k] - v0[k];
+    d[k] = ray.direction[k];
+  }
+  auto cross = [](const double a[3], const double b[3], double out[3]) {
+    out[0] = a[1] * b[2] - a[2] * b[1];
+    out[1] = a[2] * b[0] - a[0] * b[2];
+    out[2] = a[0] * b[1] - a[1] * b[0];
+  };
+  auto dot = [](const double a[3], const double b[3]) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+  };
+  double p[3], q[3];
+  cross(d, edge2, p);
+  double det = dot(edge1, p);
+  if (det == 0) return false;
+  cross(o, edge1, q);
+  *u = dot(o, p) / det;
+  *v = dot(d, q) / det;
+  *t = dot(edge2, q) / det;
+  return *u >= 0 && *v >= 0 && *u + *v <= 1 && *t >= 0 && *t <= max_t;
+}
+
+Ray XRay(float x, float y, float z) {
+  return {Vec3(x, y, z), Vec3(1, 0, 0)};
+}
+
+TEST(RaycastTest, HitsAabbs) {
+  Objects<6> boxes;
+  boxes.add({0, 0, 0, 1, 1, 1});
+  boxes.add({3, 0, 0, 4, 2, 1});
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    const y_internal::RaycastKernels& kernels =
+        y_internal::GetRaycastKernels(level);
+    RayHit hit = kernels.raycast_aabbs(XRay(-1, 0.5f, 0.5f), boxes.span(),
+                                       kInfinity);
+    EXPECT_EQ(hit.index, 0u);
+    EXPECT_EQ(hit.t, 1);
+    // Starting inside the first box, and past it.
+    hit = kernels.raycast_aabbs(XRay(0.5f, 0.5f, 0.5f), boxes.span(),
+                                kInfinity);
+    EXPECT_EQ(hit.index, 0u);
+    EXPECT_EQ(hit.t, 0);
+    hit = kernels.raycast_aabbs(XRay(2, 0.5f, 0.5f), boxes.span(), kInfinity);
+    EXPECT_EQ(hit.index, 1u);
+    EXPECT_EQ(hit.t, 1);
+    // Only the second box is this high, and only the first within reach.
+    hit = kernels.raycast_aabbs(XRay(-1, 1.5f, 0.5f), boxes.span(),
+                                kInfinity);
+    EXPECT_EQ(hit.index, 1u);
+    EXPECT_EQ(hit.t, 4);
+    hit = kernels.raycast_aabbs(XRay(-1, 1.5f, 0.5f), boxes.span(), 3.5f);
+    EXPECT_EQ(hit.index, kNoHit);
+    EXPECT_EQ(hit.t, 3.5f);
+    // Parallel to the boxes but beside them.
+    hit = kernels.raycast_aabbs(XRay(-1, 0.5f, 2), boxes.span(), kInfinity);
+    EXPECT_EQ(hit.index, kNoHit);
+    // Pointing away.
+    hit = kernels.raycast_aabbs({Vec3(-1, 0.5f, 0.5f), Vec3(-1, 0, 0)},
+                                boxes.span(), kInfinity);
+    EXPECT_EQ(hit.index, kNoHit);
+
+    float distances[2];
+    kernels.intersect_aabbs(XRay(-1, 0.5f, 0.5f), boxes.span(), kInfinity,
+                            distances);
+    EXPECT_EQ(distances[0], 1);
+    EXPECT_EQ(distances[1], 4);
+    kernels.intersect_aabbs(XRay(-1, 0.5f, 0.5f), boxes.span(), 2, distances);
+    EXPECT_EQ(distances[0], 1);
+    EXPECT_EQ(distances[1], kInfinity);
+  }
+}
+
+TEST(RaycastTest, HitsTriangles) {
+  Objects<9> triangles;
+  triangles.add({0, 0, 0, 1, 0, 0, 0, 1, 0});
+  triangles.add({0, 0, -1, 2, 0, -1, 0, 2, -1});
+  for (SimdLevel level : SupportedSimdLevels()) {
+    SCOPED_TRACE(SimdLevelName(level));
+    const y_internal::RaycastKernels& kernels =
+        y_internal::GetRaycastKernels(level);
+    Ray down = {Vec3(0.25f, 0.5f, 1), Vec3(0, 0, -1)};
+    RayHit hit = kernels.raycast_triangles(down, triangles.span(), kInfinity);
+    EXPECT_EQ(hit.index, 0u);
+    EXPECT_FLOAT_EQ(hit.t, 1);
+    EXPECT_FLOAT_EQ(hit.u, 0.25f);
+    EXPECT_FLOAT_EQ(hit.v, 0.5f);
+    // From below, the second triangle is first.
+    Ray up = {Vec3(0.25f, 0.5f, -2), Vec3(0, 0, 2)};
+    hit = kernels.raycast_triangles(up, triangles.span(), kInfinity);
+    EXPECT_EQ(hit.index, 1u);
+    EXPECT_FLOAT_EQ(hit.t, 0.5f);
+    EXPECT_FLOAT_EQ(hit.u, 0.125f);
+    EXPECT_FLOAT_EQ(hit.v, 0.25f);
+    // Outside the first triangle but inside the larger second one.
+    down.origin = Vec3(0.75f, 0.75f, 1);
+    hit = kernels.raycast_triangles(down, triangles.span(), kInfinity);
+    EXPECT_EQ(hit.index, 1u);
+    EXPECT_FLOAT_EQ(hit.t, 2);
+    hit = kernels.raycast_triangles(down, triangles.span(), 1.5f);
+    EXPECT_EQ(hit.index, kNoHit);
+    // In the plane of the first triangle, and below the second.
+    hit = kernels.raycast_triangles(XRay(-1, 0.25f, 0), triangles.span(),
+                                    kInfinity);
+    EXPECT_EQ(hit.index, kNoHit);
+  }
+}
+
+// Random boxes or triangles within 12 of the origin, and rays from further
+// out, most of them aimed at the center of one of the objects.
+const size_t kSizes[] = {0, 1, 5, 8, 15, 16, 17, 100, 1000};
+constexpr int kRays = 20;
+
+template <int N>
+Ray RandomRay(const Objects<N>& objects, size_t n, std::mt19937* rng) {
+  std::uniform_real_distribution<float> position(-5, 5);
+  std::normal_distribution<float> normal;
+  Vec3 origin = 30 * Normalize(Vec3(normal(*rng), normal(*rng), normal(*rng)));
+  Vec3 aim(position(*rng), position(*rng), position(*rng));
+  if (n > 0 && (*rng)() % 4 != 0) {
+    size_t e = (*rng)() % n;
+    for (int k = 0; k < 3; ++k) {
+      aim[k] = 0;
+      for (int corner = k; corner < N; corner += 3) {
+        aim[k] += objects.get(e, corner) / (N / 3);
+      }
+    }
+  }
+  return {origin, 0.5f * (aim - origin)};
+}
+
+TEST(RaycastTest, MatchesReferenceOnAabbs) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> position(-10, 10);
+  std::uniform_real_distribution<float> size(0.1f, 2);
+  for (size_t n : kSizes) {
+    Objects<6> boxes;
+    for (size_t e = 0; e < n; ++e) {
+      float values[6];
+      for (int k = 0; k < 3; ++k) {
+        values[k] = position(rng);
+        values[3 + k] = values[k] + size(rng);
+      }
+      boxes.add(values);
+    }
+    for (int r = 0; r < kRays; ++r) {
+      Ray ray = RandomRay(boxes, n, &rng);
+      float max_t = r % 2 ? kInfinity : 1.8f;
+      uint32_t closest = kNoHit;
+      double closest_t = max_t;
+      std::vector<float> expected(n, kInfinity);
+      for (size_t e = 0; e < n; ++e) {
+        double t;
+        if (!ReferenceAabb(ray, boxes, e, max_t, &t)) continue;
+        expected[e] = static_cast<float>(t);
+        if (closest == kNoHit || t < closest_t) {
+          closest = static_cast<uint32_t>(e);
+          closest_t = t;
+        }
+      }
+      for (SimdLevel level : SupportedSimdLevels()) {
+        SCOPED_TRACE(SimdLevelName(level));
+        const y_internal::RaycastKernels& kernels =
+            y_internal::GetRaycastKernels(level);
+        RayHit hit = kernels.raycast_aabbs(ray, boxes.span(), max_t);
+        // Boxes entered at nearly the same t may come out in either order.
+        if (closest == kNoHit) {
+          EXPECT_EQ(hit.index, kNoHit) << n << " " << r;
+          EXPECT_EQ(hit.t, max_t) << n << " " << r;
+        } else if (hit.index == kNoHit) {
+          ADD_FAILURE() << n << " " << r;
+        } else {
+          EXPECT_NEAR(hit.t, closest_t, 1e-5 * closest_t) << n << " " << r;
+          EXPECT_NEAR(expected[hit.index], closest_t, 1e-5 * closest_t);
+        }
+        std::vector<float> distances(n);
+        kernels.intersect_aabbs(ray, boxes.span(), max_t, distances.data());
+        for (size_t e = 0; e < n; ++e) {
+          if (expected[e] == kInfinity) {
+            EXPECT_EQ(distances[e], kInfinity) << n << " " << r << " " << e;
+          } else {
+            EXPECT_NEAR(distances[e], expected[e], 1e-5 * expected[e])
+                << n << " " << r << " " << e;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(RaycastTest, MatchesReferenceOnTriangles) {
+  std::mt19937 rng(2);
+  std::uniform_real_distribution<float> position(-10, 10);
+  std::uniform_real_distribution<float> offset(-2, 2);
+  for (size_t n : kSizes) {
+    Objects<9> triangles;
+    for (size_t e = 0; e < n; ++e) {
+      float values[9];
+      for (int k = 0; k < 3; ++k) {
+        values[k] = position(rng);
+        values[3 + k] = values[k] + offset(rng);
+        values[6 + k] = values[k] + offset(rng);
+      }
+      triangles.add(values);
+    }
+    for (int r = 0; r < kRays; ++r) {
+      Ray ray = RandomRay(triangles, n, &rng);
+      float max_t = r % 2 ? kInfinity : 1.8f;
+      uint32_t closest = kNoHit;
+      double closest_t = max_t;
+      std::vector<double> t(n), u(n), v(n);
+      for (size_t e = 0; e < n; ++e) {
+        if (!ReferenceTriangle(ray, triangles, e, max_t, &t[e], &u[e], &v[e]))
+          continue;
+        if (closest == kNoHit || t[e] < closest_t) {
+          closest = static_cast<uint32_t>(e);
+          closest_t = t[e];
+        }
+      }
+      for (SimdLevel level : SupportedSimdLevels()) {
+        SCOPED_TRACE(SimdLevelName(level));
+        RayHit hit = y_internal::GetRaycastKernels(level).raycast_triangles(
+            ray, triangles.span(), max_t);
+        EXPECT_EQ(hit.index, closest) << n << " " << r;
+        if (closest == kNoHit) {
+          EXPECT_EQ(hit.t, max_t) << n << " " << r;
+        } else if (hit.index == closest) {
+          EXPECT_NEAR(hit.t, closest_t, 1e-4 * closest_t) << n << " " << r;
+          EXPECT_NEAR(hit.u, u[closest], 1e-4) << n << " " << r;
+          EXPECT_NEAR(hit.v, v[closest], 1e-4) << n << " " << r;
+        }
+      }
+    }
+  }
+}
+
+TEST(RaycastTest, PublicFunctionsUseActiveKernels) {
+  Objects<6> boxes;
+  boxes.add({0, 0, 0, 1, 1, 1});
+  Objects<9> triangles;
+  triangles.add({2, 0, 0, 2, 1, 0, 2, 0, 1});
+  Ray ray = XRay(-1, 0.25f, 0.25f);
+  EXPECT_EQ(RaycastAabbs(ray, boxes.span()).t, 1);
+  EXPECT_EQ(RaycastTriangles(ray, triangles.span()).t, 3);
+  EXPECT_EQ(RaycastTriangles(ray, triangles.span(), 2).index, kNoHit);
+  float distance;
+  IntersectAabbs(ray, boxes.span(), kInfinity, absl::MakeSpan(&distance, 1));
+  EXPECT_EQ(distance, 1);
+  float distances[2];
+  EXPECT_DEATH_IF_SUPPORTED(
+      IntersectAabbs(ray, boxes.span(), kInfinity, absl::MakeSpan(distances)),
+      "");
+}
+
+}  // namespace
+}  // namespace y
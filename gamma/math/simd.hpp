@@ -0,0 +1,52 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_SIMD_HPP_
+#define GAMMA_MATH_SIMD_HPP_
+
+// Instruction sets used by gamma/math.
+//
+// x86-64 always has SSE2, which the types use by default. SSE4.1, AVX, FMA and
+// AVX-512 paths are enabled when the compiler targets them, for example with
+// --copt=-march=haswell. Defining GAMMA_MATH_NO_SIMD selects the portable
+// scalar code instead, which is also used on other architectures.
+
+#if defined(__SSE2__) && !defined(GAMMA_MATH_NO_SIMD)
+#define GAMMA_MATH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(GAMMA_MATH_SSE2) && defined(__SSE4_1__)
+#define GAMMA_MATH_SSE4_1 1
+#include <smmintrin.h>
+#endif
+
+#if defined(GAMMA_MATH_SSE2) && defined(__AVX__)
+#define GAMMA_MATH_AVX 1
+#include <immintrin.h>
+#endif
+
+#if defined(GAMMA_MATH_AVX) && defined(__FMA__)
+#define GAMMA_MATH_FMA 1
+#endif
+
+#if defined(GAMMA_MATH_AVX) && defined(__AVX512F__)
+#define GAMMA_MATH_AVX512 1
+#endif
+
+#endif  // GAMMA_MATH_SIMD_HPP_
@@ -0,0 +1,90 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_SOA_HPP_
+#define GAMMA_MATH_SOA_HPP_
+
+#include <cstddef>
+#include <type_traits>
+
+namespace y {
+
+// View of `size` elements of `N` floats each, stored as one array per
+// component rather than one struct per element, so that batch kernels can
+// load the same component of consecutive elements into one SIMD register.
+// `T` is `float`, or `const float` for read-only views.
+template <int N, typename T = float>
+struct SoaSpan {
+  SoaSpan() : components{}, size(0) {}
+  SoaSpan(T* const (&components)[N], size_t size);
+  // Mutable views convert to read-only ones.
+  template <typename U, typename = typename std::enable_if<
+                            std::is_same<const U, T>::value>::type>
+  SoaSpan(const SoaSpan<N, U>& other);
+
+  T* operator[](int component) const;
+
+  T* components[N];
+  size_t size;
+};
+
+// Points or directions as x, y and z arrays.
+using Vec3Soa = SoaSpan<3>;
+using ConstVec3Soa = SoaSpan<3, const float>;
+
+// Four-component vectors as x, y, z and w arrays.
+using Vec4Soa = SoaSpan<4>;
+using ConstVec4Soa = SoaSpan<4, const float>;
+
+// Quaternions as x, y, z and w arrays.
+using QuatSoa = SoaSpan<4>;
+using ConstQuatSoa = SoaSpan<4, const float>;
+
+// Matrices as 16 arrays, one per element. Component `4 * j + i` holds the
+// element in row i and column j, matching the layout of `Mat4`.
+using Mat4Soa = SoaSpan<16>;
+using ConstMat4Soa = SoaSpan<16, const float>;
+
+// Spheres as center x, y, z and radius arrays.
+using SphereSoa = SoaSpan<4, const float>;
+// Axis-aligned boxes as min x, y, z and max x, y, z arrays.
+using AabbSoa = SoaSpan<6, const float>;
+// Triangles as x, y and z arrays of their first, second and third vertices.
+using TriangleSoa = SoaSpan<9, const float>;
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+template <int N, typename T>
+SoaSpan<N, T>::SoaSpan(T* const (&components)[N], size_t size) : size(size) {
+  for (int i = 0; i < N; ++i) this->components[i] = components[i];
+}
+
+template <int N, typename T>
+template <typename U, typename>
+SoaSpan<N, T>::SoaSpan(const SoaSpan<N, U>& other) : size(other.size) {
+  for (int i = 0; i < N; ++i) components[i] = other.components[i];
+}
+
+template <int N, typename T>
+T* SoaSpan<N, T>::operator[](int component) const {
+  return components[component];
+}
+
+}  // namespace y
+#endif  // GAMMA_MATH_SOA_HPP_
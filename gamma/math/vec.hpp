@@ -0,0 +1,316 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#ifndef GAMMA_MATH_VEC_HPP_
+#define GAMMA_MATH_VEC_HPP_
+
+#include <cmath>
+
+#include "gamma/math/simd.hpp"
+
+namespace y {
+
+// Four floats, aligned for SIMD loads. Default construction leaves the
+// components uninitialized so that arrays of vectors are cheap to allocate.
+struct alignas(16) Vec4 {
+  Vec4() = default;
+  constexpr Vec4(float x, float y, float z, float w);
+  // All components set to `s`.
+  explicit constexpr Vec4(float s);
+
+  float& operator[](int i);
+  const float& operator[](int i) const;
+
+  float x;
+  float y;
+  float z;
+  float w;
+};
+
+// Three floats padded to the size and alignment of a `Vec4`, so that vectors
+// are loaded and stored whole. The padding lane is zeroed by the constructors
+// and ignored by every operation.
+struct alignas(16) Vec3 {
+  Vec3() = default;
+  constexpr Vec3(float x, float y, float z);
+  explicit constexpr Vec3(float s);
+
+  float& operator[](int i);
+  const float& operator[](int i) const;
+
+  float x;
+  float y;
+  float z;
+
+ private:
+  float pad_;
+};
+
+static_assert(sizeof(Vec4) == 16, "");
+static_assert(sizeof(Vec3) == 16, "");
+
+// Componentwise arithmetic.
+Vec4 operator+(const Vec4& a, const Vec4& b);
+Vec4 operator-(const Vec4& a, const Vec4& b);
+Vec4 operator*(const Vec4& a, const Vec4& b);
+Vec4 operator/(const Vec4& a, const Vec4& b);
+Vec4 operator*(const Vec4& v, float s);
+Vec4 operator*(float s, const Vec4& v);
+Vec4 operator/(const Vec4& v, float s);
+Vec4 operator-(const Vec4& v);
+Vec4& operator+=(Vec4& a, const Vec4& b);
+Vec4& operator-=(Vec4& a, const Vec4& b);
+Vec4& operator*=(Vec4& v, float s);
+
+Vec3 operator+(const Vec3& a, const Vec3& b);
+Vec3 operator-(const Vec3& a, const Vec3& b);
+Vec3 operator*(const Vec3& a, const Vec3& b);
+Vec3 operator/(const Vec3& a, const Vec3& b);
+Vec3 operator*(const Vec3& v, float s);
+Vec3 operator*(float s, const Vec3& v);
+Vec3 operator/(const Vec3& v, float s);
+Vec3 operator-(const Vec3& v);
+Vec3& operator+=(Vec3& a, const Vec3& b);
+Vec3& operator-=(Vec3& a, const Vec3& b);
+Vec3& operator*=(Vec3& v, float s);
+
+Vec4 Min(const Vec4& a, const Vec4& b);
+Vec4 Max(const Vec4& a, const Vec4& b);
+Vec3 Min(const Vec3& a, const Vec3& b);
+Vec3 Max(const Vec3& a, const Vec3& b);
+
+float Dot(const Vec4& a, const Vec4& b);
+float Dot(const Vec3& a, const Vec3& b);
+Vec3 Cross(const Vec3& a, const Vec3& b);
+
+float Length(const Vec4& v);
+float Length(const Vec3& v);
+// `v` must not be zero.
+Vec4 Normalize(const Vec4& v);
+Vec3 Normalize(const Vec3& v);
+
+// -----------------------------------------------------------------------------
+//                      Implementation Details Follow
+
+inline constexpr Vec4::Vec4(float x, float y, float z, float w)
+    : x(x), y(y), z(z), w(w) {}
+
+inline constexpr Vec4::Vec4(float s) : x(s), y(s), z(s), w(s) {}
+
+inline float& Vec4::operator[](int i) { return (&x)[i]; }
+
+inline const float& Vec4::operator[](int i) const { return (&x)[i]; }
+
+inline constexpr Vec3::Vec3(float x, float y, float z)
+    : x(x), y(y), z(z), pad_(0.0f) {}
+
+inline constexpr Vec3::Vec3(float s) : x(s), y(s), z(s), pad_(0.0f) {}
+
+inline float& Vec3::operator[](int i) { return (&x)[i]; }
+
+inline const float& Vec3::operator[](int i) const { return (&x)[i]; }
+
+}  // namespace y
+
+namespace y_internal {
+
+// Lanewise operations on the four floats of a `Vec4` or `Vec3`.
+
+template <typename V>
+const float* Lanes(const V& v) {
+  return reinterpret_cast<const float*>(&v);
+}
+
+template <typename V>
+float* Lanes(V* v) {
+  return reinterpret_cast<float*>(v);
+}
+
+#ifdef GAMMA_MATH_SSE2
+
+template <typename V>
+__m128 Load(const V& v) {
+  return _mm_load_ps(Lanes(v));
+}
+
+template <typename V>
+V Store(__m128 m) {
+  V v;
+  _mm_store_ps(Lanes(&v), m);
+  return v;
+}
+
+// Sum of the four lanes of `m`, in lane 0.
+inline __m128 HorizontalSum(__m128 m) {
+  __m128 sum = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_add_ss(sum, _mm_movehl_ps(sum, sum));
+}
+
+#define GAMMA_MATH_LANEWISE(name, expr, intrinsic)        \
+  template <typename V>                                   \
+  V name(const V& a, const V& b) {                        \
+    return Store<V>(intrinsic(Load(a), Load(b)));         \
+  }
+
+#else  // GAMMA_MATH_SSE2
+
+#define GAMMA_MATH_LANEWISE(name, expr, intrinsic)        \
+  template <typename V>                                   \
+  V name(const V& a, const V& b) {                        \
+    V r;                                                  \
+    const float* x = Lanes(a);                            \
+    const float* y = Lanes(b);                            \
+    float* out = Lanes(&r);                               \
+    for (int i = 0; i < 4; ++i) out[i] = expr;            \
+    return r;                                             \
+  }
+
+#endif  // GAMMA_MATH_SSE2
+
+GAMMA_MATH_LANEWISE(Add, x[i] + y[i], _mm_add_ps)
+GAMMA_MATH_LANEWISE(Sub, x[i] - y[i], _mm_sub_ps)
+GAMMA_MATH_LANEWISE(Mul, x[i] * y[i], _mm_mul_ps)
+GAMMA_MATH_LANEWISE(Div, x[i] / y[i], _mm_div_ps)
+GAMMA_MATH_LANEWISE(Min, y[i] < x[i] ? y[i] : x[i], _mm_min_ps)
+GAMMA_MATH_LANEWISE(Max, x[i] < y[i] ? y[i] : x[i], _mm_max_ps)
+
+#undef GAMMA_MATH_LANEWISE
+
+}  // namespace y_internal
+
+namespace y {
+
+inline Vec4 operator+(const Vec4& a, const Vec4& b) {
+  return y_internal::Add(a, b);
+}
+
+inline Vec4 operator-(const Vec4& a, const Vec4& b) {
+  return y_internal::Sub(a, b);
+}
+
+inline Vec4 operator*(const Vec4& a, const Vec4& b) {
+  return y_internal::Mul(a, b);
+}
+
+inline Vec4 operator/(const Vec4& a, const Vec4& b) {
+  return y_internal::Div(a, b);
+}
+
+inline Vec4 operator*(const Vec4& v, float s) { return v * Vec4(s); }
+
+inline Vec4 operator*(float s, const Vec4& v) { return v * Vec4(s); }
+
+inline Vec4 operator/(const Vec4& v, float s) { return v * (1.0f / s); }
+
+inline Vec4 operator-(const Vec4& v) { return v * -1.0f; }
+
+inline Vec4& operator+=(Vec4& a, const Vec4& b) { return a = a + b; }
+
+inline Vec4& operator-=(Vec4& a, const Vec4& b) { return a = a - b; }
+
+inline Vec4& operator*=(Vec4& v, float s) { return v = v * s; }
+
+inline Vec3 operator+(const Vec3& a, const Vec3& b) {
+  return y_internal::Add(a, b);
+}
+
+inline Vec3 operator-(const Vec3& a, const Vec3& b) {
+  return y_internal::Sub(a, b);
+}
+
+inline Vec3 operator*(const Vec3& a, const Vec3& b) {
+  return y_internal::Mul(a, b);
+}
+
+inline Vec3 operator/(const Vec3& a, const Vec3& b) {
+  return y_internal::Div(a, b);
+}
+
+inline Vec3 operator*(const Vec3& v, float s) { return v * Vec3(s); }
+
+inline Vec3 operator*(float s, const Vec3& v) { return v * Vec3(s); }
+
+inline Vec3 operator/(const Vec3& v, float s) { return v * (1.0f / s); }
+
+inline Vec3 operator-(const Vec3& v) { return v * -1.0f; }
+
+inline Vec3& operator+=(Vec3& a, const Vec3& b) { return a = a + b; }
+
+inline Vec3& operator-=(Vec3& a, const Vec3& b) { return a = a - b; }
+
+inline Vec3& operator*=(Vec3& v, float s) { return v = v * s; }
+
+inline Vec4 Min(const Vec4& a, const Vec4& b) { return y_internal::Min(a, b); }
+
+inline Vec4 Max(const Vec4& a, const Vec4& b) { return y_internal::Max(a, b); }
+
+inline Vec3 Min(const Vec3& a, const Vec3& b) { return y_internal::Min(a, b); }
+
+inline Vec3 Max(const Vec3& a, const Vec3& b) { return y_internal::Max(a, b); }
+
+inline float Dot(const Vec4& a, const Vec4& b) {
+#if defined(GAMMA_MATH_SSE4_1)
+  __m128 dot = _mm_dp_ps(y_internal::Load(a), y_internal::Load(b), 0xf1);
+  return _mm_cvtss_f32(dot);
+#elif defined(GAMMA_MATH_SSE2)
+  __m128 product = _mm_mul_ps(y_internal::Load(a), y_internal::Load(b));
+  return _mm_cvtss_f32(y_internal::HorizontalSum(product));
+#else
+  return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+#endif
+}
+
+inline float Dot(const Vec3& a, const Vec3& b) {
+#if defined(GAMMA_MATH_SSE4_1)
+  __m128 dot = _mm_dp_ps(y_internal::Load(a), y_internal::Load(b), 0x71);
+  return _mm_cvtss_f32(dot);
+#elif defined(GAMMA_MATH_SSE2)
+  const __m128 xyz = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  __m128 product = _mm_mul_ps(y_internal::Load(a), y_internal::Load(b));
+  return _mm_cvtss_f32(y_internal::HorizontalSum(_mm_and_ps(product, xyz)));
+#else
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+#endif
+}
+
+inline Vec3 Cross(const Vec3& a, const Vec3& b) {
+#ifdef GAMMA_MATH_SSE2
+  // a * b.yzx - a.yzx * b is the cross product rotated to zxy.
+  __m128 lhs = y_internal::Load(a);
+  __m128 rhs = y_internal::Load(b);
+  __m128 lhs_yzx = _mm_shuffle_ps(lhs, lhs, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 rhs_yzx = _mm_shuffle_ps(rhs, rhs, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 zxy = _mm_sub_ps(_mm_mul_ps(lhs, rhs_yzx), _mm_mul_ps(lhs_yzx, rhs));
+  return y_internal::Store<Vec3>(
+      _mm_shuffle_ps(zxy, zxy, _MM_SHUFFLE(3, 0, 2, 1)));
+#else
+  return Vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+              a.x * b.y - a.y * b.x);
+#endif
+}
+
+inline float Length(const Vec4& v) { return std::sqrt(Dot(v, v)); }
+
+inline float Length(const Vec3& v) { return std::sqrt(Dot(v, v)); }
+
+inline Vec4 Normalize(const Vec4& v) { return v / Length(v); }
+
+inline Vec3 Normalize(const Vec3& v) { return v / Length(v); }
+
+}  // namespace y
+#endif  // GAMMA_MATH_VEC_HPP_
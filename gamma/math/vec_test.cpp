@@ -0,0 +1,96 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/math/vec.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+TEST(VecTest, Vec4Arithmetic) {
+  Vec4 a(1, 2, 3, 4);
+  Vec4 b(4, 3, 2, 1);
+  Vec4 sum = a + b;
+  Vec4 product = a * b;
+  Vec4 quotient = a / b;
+  Vec4 scaled = 2.0f * a - b / 2.0f;
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_FLOAT_EQ(sum[i], 5);
+    EXPECT_FLOAT_EQ(product[i], a[i] * b[i]);
+    EXPECT_FLOAT_EQ(quotient[i], a[i] / b[i]);
+    EXPECT_FLOAT_EQ(scaled[i], 2 * a[i] - b[i] / 2);
+    EXPECT_FLOAT_EQ((-a)[i], -a[i]);
+    EXPECT_FLOAT_EQ(Min(a, b)[i], std::min(a[i], b[i]));
+    EXPECT_FLOAT_EQ(Max(a, b)[i], std::max(a[i], b[i]));
+  }
+  a += b;
+  a -= Vec4(1);
+  a *= 3;
+  EXPECT_FLOAT_EQ(a.x, 12);
+  EXPECT_FLOAT_EQ(a.w, 12);
+}
+
+TEST(VecTest, Vec4Geometry) {
+  Vec4 v(1, 2, 2, 4);
+  EXPECT_FLOAT_EQ(Dot(v, Vec4(1, 1, 1, 1)), 9);
+  EXPECT_FLOAT_EQ(Length(v), 5);
+  Vec4 n = Normalize(v);
+  EXPECT_FLOAT_EQ(n.x, 0.2f);
+  EXPECT_FLOAT_EQ(n.w, 0.8f);
+}
+
+TEST(VecTest, Vec3Geometry) {
+  Vec3 x(1, 0, 0);
+  Vec3 y(0, 1, 0);
+  Vec3 z = Cross(x, y);
+  EXPECT_FLOAT_EQ(z.x, 0);
+  EXPECT_FLOAT_EQ(z.y, 0);
+  EXPECT_FLOAT_EQ(z.z, 1);
+
+  Vec3 a(1, 2, 3);
+  Vec3 b(-2, 0.5f, 4);
+  Vec3 c = Cross(a, b);
+  EXPECT_FLOAT_EQ(c.x, 2 * 4 - 3 * 0.5f);
+  EXPECT_FLOAT_EQ(c.y, 3 * -2 - 1 * 4);
+  EXPECT_FLOAT_EQ(c.z, 1 * 0.5f - 2 * -2);
+  EXPECT_NEAR(Dot(c, a), 0, 1e-5f);
+  EXPECT_NEAR(Dot(c, b), 0, 1e-5f);
+
+  EXPECT_FLOAT_EQ(Dot(a, b), -2 + 1 + 12);
+  EXPECT_FLOAT_EQ(Length(Vec3(2, 3, 6)), 7);
+  Vec3 n = Normalize(Vec3(0, 3, 4));
+  EXPECT_FLOAT_EQ(n.y, 0.6f);
+  EXPECT_FLOAT_EQ(n.z, 0.8f);
+}
+
+TEST(VecTest, Vec3IgnoresPadding) {
+  // Dividing by a Vec3 leaves NaN in the padding lane, which must not leak
+  // into dot products or lengths.
+  Vec3 v = Vec3(2, 4, 6) / Vec3(2, 2, 2);
+  EXPECT_FLOAT_EQ(v.x, 1);
+  EXPECT_FLOAT_EQ(v.z, 3);
+  EXPECT_FLOAT_EQ(Dot(v, v), 1 + 4 + 9);
+  EXPECT_FLOAT_EQ(Length(v * 2.0f), std::sqrt(56.0f));
+}
+
+}  // namespace
+}  // namespace y
@@ -0,0 +1,49 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/scripting/lua/compile.hpp"
+
+#include "gamma/common/log.hpp"
+#include "lua.hpp"
+
+namespace y {
+namespace {
+
+int AppendChunk(lua_State* /* unused */, const void* data, size_t size,
+                void* chunk) {
+  static_cast<std::string*>(chunk)->append(static_cast<const char*>(data),
+                                           size);
+  return 0;
+}
+
+}  // namespace
+
+std::string LuaCompileFile(const std::string& path) {
+  lua_State* L = luaL_newstate();
+  std::string chunk;
+  if (luaL_loadfile(L, path.c_str())) {
+    YLOG << lua_tostring(L, -1);
+  } else if (lua_dump(L, &AppendChunk, &chunk) != 0) {
+    YLOG << "failed to dump '" << path << "'";
+    chunk.clear();
+  }
+  lua_close(L);
+  return chunk;
+}
+
+}  // namespace y
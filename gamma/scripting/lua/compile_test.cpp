@@ -0,0 +1,61 @@
+// Copyright (c) 2018-2019 Aleksey Strelnikov
+//
+// This software is provided 'as-is', without any express or implied
+// warranty. In no event will the authors be held liable for any damages
+// arising from the use of this software.
+//
+// Permission is granted to anyone to use this software for any purpose,
+// including commercial applications, and to alter it and redistribute it
+// freely, subject to the following restrictions:
+//
+// 1. The origin of this software must not be misrepresented; you must not
+//    claim that you wrote the original software. If you use this software
+//    in a product, an acknowledgment in the product documentation would be
+//    appreciated but is not required.
+// 2. Altered source versions must be plainly marked as such, and must not be
+//    misrepresented as being the original software.
+// 3. This notice may not be removed or altered from any source distribution.
+
+#include "gamma/scripting/lua/compile.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "gamma/scripting/lua/run.hpp"
+#include "gamma/scripting/lua/test_base.hpp"
+#include "gtest/gtest.h"
+
+namespace y {
+namespace {
+
+class LuaCompileTest : public LuaTestBase {};
+
+std::string WriteScript(const std::string& name, const char* source) {
+  const char* dir = std::getenv("TEST_TMPDIR");
+  std::string path = std::string(dir != nullptr ? dir : "/tmp") + "/" + name;
+  FILE* file = fopen(path.c_str(), "w");
+  EXPECT_NE(nullptr, file);
+  fputs(source, file);
+  fclose(file);
+  return path;
+}
+
+TEST_F(LuaCompileTest, CompiledChunkRuns) {
+  std::string path = WriteScript("x.lua", "x = 40 + 2");
+
+  std::string chunk = LuaCompileFile(path);
+  EXPECT_FALSE(chunk.empty());
+
+  LuaRunSource(L, path, chunk);
+  lua_getglobal(L, "x");
+  EXPECT_EQ(42, lua_tointeger(L, -1));
+}
+
+TEST_F(LuaCompileTest, ErrorsGiveEmptyChunk) {
+  EXPECT_TRUE(LuaCompileFile(WriteScript("bad.lua", "x = = 1")).empty());
+  EXPECT_TRUE(LuaCompileFile("/nonexistent/x.lua").empty());
+}
+
+}  // namespace
+}  // namespace y